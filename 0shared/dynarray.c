@@ -5,6 +5,7 @@
 
 #include "dynarray.h"
 #include <assert.h>
+#include <limits.h>
 #include <stdlib.h>
 
 /*--------------------------------------------------------------------*/
@@ -272,6 +273,16 @@ static void DynArray_qsort(
    /* This function uses pointers instead of indices to avoid
       complications with using unsigned integers as array indices. */
 
+   /* Rather than recurring on both partitions, this function defers
+      the larger one on a stack of its own and loops on the smaller.
+      Each deferred partition is then no more than half as large as
+      the one below it on the stack, so a stack with one entry per bit
+      of a size_t is always enough, however unbalanced the pivots. */
+   enum {MAX_DEFERRED = sizeof(size_t) * CHAR_BIT};
+   const void **appvDeferredLo[MAX_DEFERRED];
+   const void **appvDeferredHi[MAX_DEFERRED];
+   size_t uDeferred = 0;
+
    const void **ppvRight;
    const void **ppvLeft;
    const void *pvPivot;
@@ -281,32 +292,61 @@ static void DynArray_qsort(
    assert(ppvHi != NULL);
    assert(pfCompare != NULL);
 
-   ppvRight = ppvLo;
-   ppvLeft = ppvHi;
-   pvPivot = *(ppvLo + ((ppvHi - ppvLo) / 2));
-
-   while (ppvRight <= ppvLeft)
+   for (;;)
    {
-      while ((*pfCompare)(*ppvRight, pvPivot) < 0)
-         ppvRight++;
-      while ((*pfCompare)(pvPivot, *ppvLeft) < 0)
-         ppvLeft--;
-      if (ppvRight <= ppvLeft)
+      ppvRight = ppvLo;
+      ppvLeft = ppvHi;
+      pvPivot = *(ppvLo + ((ppvHi - ppvLo) / 2));
+
+      while (ppvRight <= ppvLeft)
       {
-         /* Swap *ppvRight and *ppvLeft. */
-         pvTemp = *ppvRight;
-         *ppvRight = *ppvLeft;
-         *ppvLeft = pvTemp;
+         while ((*pfCompare)(*ppvRight, pvPivot) < 0)
+            ppvRight++;
+         while ((*pfCompare)(pvPivot, *ppvLeft) < 0)
+            ppvLeft--;
+         if (ppvRight <= ppvLeft)
+         {
+            /* Swap *ppvRight and *ppvLeft. */
+            pvTemp = *ppvRight;
+            *ppvRight = *ppvLeft;
+            *ppvLeft = pvTemp;
+
+            ppvRight++;
+            ppvLeft--;
+         }
+      }
 
-         ppvRight++;
-         ppvLeft--;
+      if (ppvLo < ppvLeft && ppvRight < ppvHi)
+      {
+         /* Defer the larger partition and go on with the smaller. */
+         assert(uDeferred < MAX_DEFERRED);
+         if (ppvLeft - ppvLo > ppvHi - ppvRight)
+         {
+            appvDeferredLo[uDeferred] = ppvLo;
+            appvDeferredHi[uDeferred] = ppvLeft;
+            ppvLo = ppvRight;
+         }
+         else
+         {
+            appvDeferredLo[uDeferred] = ppvRight;
+            appvDeferredHi[uDeferred] = ppvHi;
+            ppvHi = ppvLeft;
+         }
+         uDeferred++;
       }
+      else if (ppvLo < ppvLeft)
+         ppvHi = ppvLeft;
+      else if (ppvRight < ppvHi)
+         ppvLo = ppvRight;
+      else if (uDeferred != 0)
+      {
+         uDeferred--;
+         ppvLo = appvDeferredLo[uDeferred];
+         ppvHi = appvDeferredHi[uDeferred];
+      }
+      else
+         return;
    }
-
-   if (ppvLo < ppvLeft)
-      DynArray_qsort(ppvLo, ppvLeft, pfCompare);
-   if (ppvRight < ppvHi)
-      DynArray_qsort(ppvRight, ppvHi, pfCompare);
 }
 
 /*--------------------------------------------------------------------*/
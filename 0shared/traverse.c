@@ -0,0 +1,238 @@
+/*--------------------------------------------------------------------*/
+/* traverse.c                                                         */
+/* Author: Hugh Peterson                                              */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "a4def.h"
+#include "traverse.h"
+
+/*--------------------------------------------------------------------*/
+
+/* A node on the path from the root down to the node being walked */
+struct traverseFrame {
+   /* the node */
+   void *pvNode;
+   /* the index of its next child to walk */
+   size_t ulNext;
+};
+
+/*--------------------------------------------------------------------*/
+
+/*
+  Doubles the room for elements of ulSize bytes in the array at
+  *ppvArray, which has room for *pulCapacity of them, updating both.
+  Returns SUCCESS, or MEMORY_ERROR, leaving the array as it was, if
+  memory could not be allocated.
+*/
+static int Traverse_grow(void **ppvArray, size_t *pulCapacity,
+                         size_t ulSize) {
+   enum {GROWTH_FACTOR = 2};
+   void *array;
+
+   assert(ppvArray != NULL);
+   assert(pulCapacity != NULL);
+
+   array = realloc(*ppvArray, *pulCapacity * GROWTH_FACTOR * ulSize);
+   if(array == NULL)
+      return MEMORY_ERROR;
+   *ppvArray = array;
+   *pulCapacity *= GROWTH_FACTOR;
+   return SUCCESS;
+}
+
+/*
+  Walks the tree rooted at pvRoot depth first, with a stack of frames
+  for the nodes between the root and the node being walked, passing
+  each node to pfVisit before its children if isPreOrder is TRUE and
+  after them otherwise. Otherwise as described for Traverse_walk.
+*/
+static int Traverse_depthFirst(void *pvRoot, boolean isPreOrder,
+                               size_t (*pfGetNumChildren)(void *),
+                               int (*pfGetChild)(void *, size_t,
+                                                 void **),
+                               int (*pfVisit)(void *, void *),
+                               void *pvExtra) {
+   enum {MIN_FRAMES = 16};
+   struct traverseFrame *frames;
+   struct traverseFrame *top;
+   size_t capacity = MIN_FRAMES;
+   size_t depth = 0;
+   void *child;
+   int status = SUCCESS;
+
+   assert(pvRoot != NULL);
+
+   frames = malloc(capacity * sizeof(struct traverseFrame));
+   if(frames == NULL)
+      return MEMORY_ERROR;
+
+   if(isPreOrder)
+      status = pfVisit(pvRoot, pvExtra);
+   frames[0].pvNode = pvRoot;
+   frames[0].ulNext = 0;
+   depth = 1;
+
+   while(status == SUCCESS && depth != 0) {
+      top = &frames[depth - 1];
+
+      /* a node whose children are all walked is done */
+      if(top->ulNext == pfGetNumChildren(top->pvNode)) {
+         if(!isPreOrder)
+            status = pfVisit(top->pvNode, pvExtra);
+         depth--;
+         continue;
+      }
+
+      status = pfGetChild(top->pvNode, top->ulNext, &child);
+      top->ulNext++;
+      if(status != SUCCESS)
+         break;
+      if(isPreOrder)
+         status = pfVisit(child, pvExtra);
+      if(status == SUCCESS && depth == capacity)
+         status = Traverse_grow((void **) &frames, &capacity,
+                                sizeof(struct traverseFrame));
+      if(status != SUCCESS)
+         break;
+      frames[depth].pvNode = child;
+      frames[depth].ulNext = 0;
+      depth++;
+   }
+
+   free(frames);
+   return status;
+}
+
+/*
+  Walks the tree rooted at pvRoot level by level, with a queue of the
+  nodes visited whose children are not yet queued, passing each node
+  to pfVisit. Otherwise as described for Traverse_walk.
+*/
+static int Traverse_breadthFirst(void *pvRoot,
+                                 size_t (*pfGetNumChildren)(void *),
+                                 int (*pfGetChild)(void *, size_t,
+                                                   void **),
+                                 int (*pfVisit)(void *, void *),
+                                 void *pvExtra) {
+   enum {MIN_QUEUE = 16};
+   void **queue;
+   size_t capacity = MIN_QUEUE;
+   size_t head = 0;
+   size_t tail = 0;
+   size_t count;
+   size_t i;
+   void *node;
+   void *child;
+   int status;
+
+   assert(pvRoot != NULL);
+
+   queue = malloc(capacity * sizeof(void *));
+   if(queue == NULL)
+      return MEMORY_ERROR;
+
+   status = pfVisit(pvRoot, pvExtra);
+   queue[tail++] = pvRoot;
+
+   while(status == SUCCESS && head != tail) {
+      node = queue[head++];
+      count = pfGetNumChildren(node);
+      for(i = 0; status == SUCCESS && i < count; i++) {
+         status = pfGetChild(node, i, &child);
+         if(status == SUCCESS)
+            status = pfVisit(child, pvExtra);
+         if(status != SUCCESS)
+            break;
+
+         /* reuse the room before the head before making more */
+         if(tail == capacity && head != 0) {
+            memmove(queue, queue + head,
+                    (tail - head) * sizeof(void *));
+            tail -= head;
+            head = 0;
+         }
+         if(tail == capacity)
+            status = Traverse_grow((void **) &queue, &capacity,
+                                   sizeof(void *));
+         if(status == SUCCESS)
+            queue[tail++] = child;
+      }
+   }
+
+   free(queue);
+   return status;
+}
+
+/*--------------------------------------------------------------------*/
+
+/*
+  Passes each node of the tree rooted at pvRoot to pfVisit, along with
+  pvExtra, in order eOrder. pfGetNumChildren returns the number of
+  children of a node, and pfGetChild sets *ppvChild to the child of a
+  node with index ulIndex and returns SUCCESS, or returns another
+  status if there is none. pfVisit must not link or unlink nodes.
+  Does nothing if pvRoot is NULL. Returns SUCCESS if every node was
+  visited. Otherwise, stops and returns MEMORY_ERROR if memory could
+  not be allocated, or the first status other than SUCCESS that
+  pfGetChild or pfVisit returned, such as TRAVERSE_STOP.
+*/
+int Traverse_walk(void *pvRoot, enum traverseOrder eOrder,
+                  size_t (*pfGetNumChildren)(void *pvNode),
+                  int (*pfGetChild)(void *pvNode, size_t ulIndex,
+                                    void **ppvChild),
+                  int (*pfVisit)(void *pvNode, void *pvExtra),
+                  void *pvExtra) {
+   assert(pfGetNumChildren != NULL);
+   assert(pfGetChild != NULL);
+   assert(pfVisit != NULL);
+
+   if(pvRoot == NULL)
+      return SUCCESS;
+
+   if(eOrder == TRAVERSE_LEVEL_ORDER)
+      return Traverse_breadthFirst(pvRoot, pfGetNumChildren,
+                                   pfGetChild, pfVisit, pvExtra);
+   return Traverse_depthFirst(pvRoot,
+                              (boolean) (eOrder == TRAVERSE_PRE_ORDER),
+                              pfGetNumChildren, pfGetChild, pfVisit,
+                              pvExtra);
+}
+
+/*
+  Passes each node of the tree rooted at pvRoot to pfFree, along with
+  pvExtra, children before their parents, in constant space, so that
+  freeing a tree can neither overflow the stack nor fail for want of
+  memory. pfRemoveChild unlinks and returns one child of a node, or
+  returns NULL if it has none left, and pfGetParent returns the node a
+  child was removed from. Each node passed to pfFree has had all its
+  children removed, and is not looked at again.
+*/
+void Traverse_dismantle(void *pvRoot,
+                        void *(*pfRemoveChild)(void *pvNode),
+                        void *(*pfGetParent)(void *pvNode),
+                        void (*pfFree)(void *pvNode, void *pvExtra),
+                        void *pvExtra) {
+   void *node = pvRoot;
+   void *next;
+
+   assert(pfRemoveChild != NULL);
+   assert(pfGetParent != NULL);
+   assert(pfFree != NULL);
+
+   /* the parent links stand in for a stack: descend until a node has
+      no children left, free it, and climb back to its parent */
+   while(node != NULL) {
+      next = pfRemoveChild(node);
+      if(next != NULL) {
+         node = next;
+         continue;
+      }
+      next = node == pvRoot ? NULL : pfGetParent(node);
+      pfFree(node, pvExtra);
+      node = next;
+   }
+}
@@ -0,0 +1,68 @@
+/*--------------------------------------------------------------------*/
+/* traverse.h                                                         */
+/* Author: Hugh Peterson                                              */
+/*--------------------------------------------------------------------*/
+
+#ifndef TRAVERSE_INCLUDED
+#define TRAVERSE_INCLUDED
+
+#include <stddef.h>
+#include "a4def.h"
+
+/*
+  The traversal engine walks trees of any shape and depth without
+  recursion, so that a deep tree cannot overflow the call stack. A
+  tree is given by its root and functions that reach a node's
+  children; the engine keeps its own stack or queue on the heap,
+  growing with the tree's depth (or, in level order, its width).
+*/
+
+/* The orders in which Traverse_walk visits the nodes of a tree */
+enum traverseOrder {
+   /* each node before its descendants, children in order */
+   TRAVERSE_PRE_ORDER,
+   /* each node after its descendants, children in order */
+   TRAVERSE_POST_ORDER,
+   /* shallowest first, and left to right within a depth */
+   TRAVERSE_LEVEL_ORDER
+};
+
+/* A status that pfVisit may return to stop a walk, which differs from
+   every status of a4def.h, so that stopping early on purpose is not
+   mistaken for an error */
+enum {TRAVERSE_STOP = -1};
+
+/*
+  Passes each node of the tree rooted at pvRoot to pfVisit, along with
+  pvExtra, in order eOrder. pfGetNumChildren returns the number of
+  children of a node, and pfGetChild sets *ppvChild to the child of a
+  node with index ulIndex and returns SUCCESS, or returns another
+  status if there is none. pfVisit must not link or unlink nodes.
+  Does nothing if pvRoot is NULL. Returns SUCCESS if every node was
+  visited. Otherwise, stops and returns MEMORY_ERROR if memory could
+  not be allocated, or the first status other than SUCCESS that
+  pfGetChild or pfVisit returned, such as TRAVERSE_STOP.
+*/
+int Traverse_walk(void *pvRoot, enum traverseOrder eOrder,
+                  size_t (*pfGetNumChildren)(void *pvNode),
+                  int (*pfGetChild)(void *pvNode, size_t ulIndex,
+                                    void **ppvChild),
+                  int (*pfVisit)(void *pvNode, void *pvExtra),
+                  void *pvExtra);
+
+/*
+  Passes each node of the tree rooted at pvRoot to pfFree, along with
+  pvExtra, children before their parents, in constant space, so that
+  freeing a tree can neither overflow the stack nor fail for want of
+  memory. pfRemoveChild unlinks and returns one child of a node, or
+  returns NULL if it has none left, and pfGetParent returns the node a
+  child was removed from. Each node passed to pfFree has had all its
+  children removed, and is not looked at again.
+*/
+void Traverse_dismantle(void *pvRoot,
+                        void *(*pfRemoveChild)(void *pvNode),
+                        void *(*pfGetParent)(void *pvNode),
+                        void (*pfFree)(void *pvNode, void *pvExtra),
+                        void *pvExtra);
+
+#endif
@@ -9,6 +9,7 @@
 #include "checkerDT.h"
 #include "dynarray.h"
 #include "path.h"
+#include "traverse.h"
 
 
 
@@ -31,6 +32,10 @@ boolean CheckerDT_Node_isValid(Node_T oNNode) {
       oPNPath = Node_getPath(oNNode);
       oPPPath = Node_getPath(oNParent);
 
+      /* a path that cannot be built now cannot be checked now */
+      if(oPNPath == NULL || oPPPath == NULL)
+         return TRUE;
+
       if(Path_getSharedPrefixDepth(oPNPath, oPPPath) !=
          Path_getDepth(oPNPath) - 1) {
          fprintf(stderr, "P-C nodes don't have P-C paths: (%s) (%s)\n",
@@ -42,78 +47,110 @@ boolean CheckerDT_Node_isValid(Node_T oNNode) {
    return TRUE;
 }
 
+/* The state of a check of every node by CheckerDT_treeCheck */
+struct treeCheck {
+   /* the number of nodes checked so far */
+   size_t ulNodeCount;
+   /* TRUE once a broken invariant has been found and reported */
+   boolean bIsBroken;
+};
+
+/* Returns the number of children of pvNode, for Traverse_walk. */
+static size_t CheckerDT_getNumChildren(void *pvNode) {
+   return Node_getNumChildren(pvNode);
+}
+
 /*
-   Performs a pre-order traversal of the tree rooted at oNNode.
-   Returns FALSE if a broken invariant is found and
-   returns TRUE otherwise.
+   Sets *ppvChild to the child of pvNode with index ulIndex, for
+   Traverse_walk, and returns Node_getChild's status.
+*/
+static int CheckerDT_getChild(void *pvNode, size_t ulIndex,
+                              void **ppvChild) {
+   Node_T oNChild = NULL;
+   int iStatus;
+
+   iStatus = Node_getChild(pvNode, ulIndex, &oNChild);
+   *ppvChild = oNChild;
+   return iStatus;
+}
 
-   You may want to change this function's return type or
-   parameter list to facilitate constructing your checks.
-   If you do, you should update this function comment.
+/*
+   Checks the node pvNode and the order of its children, for a
+   pre-order Traverse_walk of the tree, adding 1 to the node count of
+   the check pvCheck. Returns SUCCESS if no broken invariant is found,
+   and otherwise reports it on stderr, records it in pvCheck, and
+   returns TRAVERSE_STOP, which stops the traversal.
 */
-static boolean CheckerDT_treeCheck(Node_T oNNode, size_t *nodeCount) {
+static int CheckerDT_treeCheck(void *pvNode, void *pvCheck) {
+   Node_T oNNode = pvNode;
+   struct treeCheck *psCheck = pvCheck;
    size_t ulIndex;
 
-   if(oNNode!= NULL) {
+   /* update node count */
+   psCheck->ulNodeCount++;
 
-      /* update node count */
-      *nodeCount = *nodeCount + 1;
-      
-      /* Sample check on each node: node must be valid */
-      /* If not, pass that failure back up immediately */
-      if(!CheckerDT_Node_isValid(oNNode))
-         return FALSE;
+   /* Sample check on each node: node must be valid */
+   /* If not, mark the check broken and stop the whole walk here */
+   if(!CheckerDT_Node_isValid(oNNode)) {
+      psCheck->bIsBroken = TRUE;
+      return TRAVERSE_STOP;
+   }
 
-      /* Recur on every child of oNNode */
-      for(ulIndex = 0; ulIndex < Node_getNumChildren(oNNode); ulIndex++)
-      {
-         Node_T oNChild = NULL;
-         Node_T next = NULL;
-         int iStatus = Node_getChild(oNNode, ulIndex, &oNChild);
-         int comp;
-
-         if(iStatus != SUCCESS) {
-            fprintf(stderr, "getNumChildren claims more children than getChild returns\n");
-            return FALSE;
-         }
+   /* Check every child of oNNode; the traversal then visits each */
+   for(ulIndex = 0; ulIndex < Node_getNumChildren(oNNode); ulIndex++)
+   {
+      Node_T oNChild = NULL;
+      Node_T next = NULL;
+      Path_T oPChild;
+      Path_T oPNext;
+      int iStatus = Node_getChild(oNNode, ulIndex, &oNChild);
+      int comp;
+
+      if(iStatus != SUCCESS) {
+         fprintf(stderr, "getNumChildren claims more children than getChild returns\n");
+         psCheck->bIsBroken = TRUE;
+         return TRAVERSE_STOP;
+      }
 
-         /* checks for next child node */
-         if (ulIndex + 1 < Node_getNumChildren(oNNode)) {
-            Node_getChild(oNNode, ulIndex + 1, &next);
-            
-            /* check if there is a duplicate node next */
-            comp = Node_compare(oNChild, next);
-            if (comp == 0) {
-               fprintf(stderr, "Duplicate node detected (%s)\n",
-                       Path_getPathname(Node_getPath(oNChild)));
-               return FALSE;
-            }
-
-            /* check if the next node follows lexicographically */
-            comp = strcmp(Path_getPathname(Node_getPath(oNChild)),
-                          Path_getPathname(Node_getPath(next)));
-            if (comp > 0) {
-               fprintf(stderr, "Children are not in lexicographic order (%s > %s)\n"
-                       , Path_getPathname(Node_getPath(oNChild)),
-                          Path_getPathname(Node_getPath(next)));
-               return FALSE;
-            }
+      /* checks for next child node */
+      if (ulIndex + 1 < Node_getNumChildren(oNNode)) {
+         Node_getChild(oNNode, ulIndex + 1, &next);
+
+         /* paths that cannot be built now cannot be checked now */
+         oPChild = Node_getPath(oNChild);
+         oPNext = Node_getPath(next);
+         if(oPChild == NULL || oPNext == NULL)
+            continue;
+
+         /* check if there is a duplicate node next */
+         comp = Node_compare(oNChild, next);
+         if (comp == 0) {
+            fprintf(stderr, "Duplicate node detected (%s)\n",
+                    Path_getPathname(oPChild));
+            psCheck->bIsBroken = TRUE;
+            return TRAVERSE_STOP;
          }
 
-         /* if recurring down one subtree results in a failed check
-            farther down, passes the failure back up immediately */
-         if(!CheckerDT_treeCheck(oNChild, nodeCount))
-            return FALSE;
+         /* check if the next node follows lexicographically */
+         comp = strcmp(Path_getPathname(oPChild),
+                       Path_getPathname(oPNext));
+         if (comp > 0) {
+            fprintf(stderr, "Children are not in lexicographic order (%s > %s)\n"
+                    , Path_getPathname(oPChild),
+                       Path_getPathname(oPNext));
+            psCheck->bIsBroken = TRUE;
+            return TRAVERSE_STOP;
+         }
       }
    }
-   return TRUE;
+   return SUCCESS;
 }
 
 /* see checkerDT.h for specification */
 boolean CheckerDT_isValid(boolean bIsInitialized, Node_T oNRoot,
                           size_t ulCount) {
-   size_t nodeCount = 0;
-   boolean result;
+   struct treeCheck sCheck;
+   int iStatus;
 
    /* Sample check on a top-level data structure invariant:
       if the DT is not initialized, its count should be 0. */
@@ -123,18 +160,32 @@ boolean CheckerDT_isValid(boolean bIsInitialized, Node_T oNRoot,
          return FALSE;
       }
 
-   /* Now checks invariants recursively at each node from the root. */
-   result = CheckerDT_treeCheck(oNRoot, &nodeCount);
-   if(result == FALSE) {
-      return result;
+   /* Now checks invariants at each node from the root, in pre-order
+      and without recursion, so that a deep tree cannot overflow the
+      stack. */
+   sCheck.ulNodeCount = 0;
+   sCheck.bIsBroken = FALSE;
+   iStatus = Traverse_walk(oNRoot, TRAVERSE_PRE_ORDER,
+                           CheckerDT_getNumChildren,
+                           CheckerDT_getChild, CheckerDT_treeCheck,
+                           &sCheck);
+   if(sCheck.bIsBroken)
+      return FALSE;
+   if(iStatus == MEMORY_ERROR) {
+      fprintf(stderr, "Out of memory while traversing the tree\n");
+      return FALSE;
+   }
+   if(iStatus != SUCCESS) {
+      fprintf(stderr, "getChild failed while traversing the tree\n");
+      return FALSE;
    }
 
    /* Check if ulCount != nodes reached during tree traversal */
-   if (nodeCount != ulCount) {
+   if (sCheck.ulNodeCount != ulCount) {
       fprintf(stderr, "Tree size (%ld) does not match number of nodes reachable (%ld)\n"
-              , ulCount, nodeCount);
+              , ulCount, sCheck.ulNodeCount);
       return FALSE;
    }
    
-   return result;
+   return TRUE;
 }
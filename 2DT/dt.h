@@ -44,6 +44,26 @@ boolean DT_contains(const char *pcPath);
 */
 int DT_rm(const char *pcPath);
 
+/*
+  Moves the directory with absolute path pcSrc, with everything below
+  it, to absolute path pcDest, whose parent must already be in the DT.
+  Only the moved directory is relinked and renamed, so the time a move
+  takes does not depend on the size of its subtree.
+  Returns SUCCESS if moved. Otherwise, leaves the DT unchanged and
+  returns:
+  * INITIALIZATION_ERROR if the DT is not in an initialized state
+  * BAD_PATH if pcSrc or pcDest does not represent a well-formatted
+             path
+  * CONFLICTING_PATH if the root exists but is not a prefix of pcSrc
+                     or pcDest, if pcSrc is the root, or if pcDest
+                     lies below pcSrc
+  * NO_SUCH_PATH if pcSrc or the parent of pcDest does not exist in
+                 the DT
+  * ALREADY_IN_TREE if pcDest is already in the DT
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int DT_move(const char *pcSrc, const char *pcDest);
+
 /*
   Sets the DT data structure to an initialized state.
   The data structure is initially empty.
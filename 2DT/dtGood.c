@@ -13,6 +13,7 @@
 #include "path.h"
 #include "nodeDT.h"
 #include "checkerDT.h"
+#include "traverse.h"
 #include "dt.h"
 
 
@@ -41,13 +42,15 @@ static size_t ulCount;
 /*
   Traverses the DT starting at the root as far as possible towards
   absolute path oPPath. If able to traverse, returns an int SUCCESS
-  status and sets *poNFurthest to the furthest node reached (which may
-  be only a prefix of oPPath, or even NULL if the root is NULL).
+  status, sets *poNFurthest to the furthest node reached (which may
+  be only a prefix of oPPath, or even NULL if the root is NULL) and
+  *pulDepth to that node's depth (0 if it is NULL).
   Otherwise, sets *poNFurthest to NULL and returns with status:
   * CONFLICTING_PATH if the root's path is not a prefix of oPPath
   * MEMORY_ERROR if memory could not be allocated to complete request
 */
-static int DT_traversePath(Path_T oPPath, Node_T *poNFurthest) {
+static int DT_traversePath(Path_T oPPath, Node_T *poNFurthest,
+                           size_t *pulDepth) {
    int iStatus;
    Path_T oPPrefix = NULL;
    Node_T oNCurr;
@@ -58,8 +61,10 @@ static int DT_traversePath(Path_T oPPath, Node_T *poNFurthest) {
 
    assert(oPPath != NULL);
    assert(poNFurthest != NULL);
+   assert(pulDepth != NULL);
 
    /* root is NULL -> won't find anything */
+   *pulDepth = 0;
    if(oNRoot == NULL) {
       *poNFurthest = NULL;
       return SUCCESS;
@@ -107,6 +112,7 @@ static int DT_traversePath(Path_T oPPath, Node_T *poNFurthest) {
 
    Path_free(oPPrefix);
    *poNFurthest = oNCurr;
+   *pulDepth = i - 1;
    return SUCCESS;
 }
 
@@ -123,6 +129,7 @@ static int DT_traversePath(Path_T oPPath, Node_T *poNFurthest) {
 static int DT_findNode(const char *pcPath, Node_T *poNResult) {
    Path_T oPPath = NULL;
    Node_T oNFound = NULL;
+   size_t ulFoundDepth;
    int iStatus;
 
    assert(pcPath != NULL);
@@ -139,7 +146,7 @@ static int DT_findNode(const char *pcPath, Node_T *poNResult) {
       return iStatus;
    }
 
-   iStatus = DT_traversePath(oPPath, &oNFound);
+   iStatus = DT_traversePath(oPPath, &oNFound, &ulFoundDepth);
    if(iStatus != SUCCESS)
    {
       Path_free(oPPath);
@@ -153,7 +160,7 @@ static int DT_findNode(const char *pcPath, Node_T *poNResult) {
       return NO_SUCH_PATH;
    }
 
-   if(Path_comparePath(Node_getPath(oNFound), oPPath) != 0) {
+   if(ulFoundDepth != Path_getDepth(oPPath)) {
       Path_free(oPPath);
       *poNResult = NULL;
       return NO_SUCH_PATH;
@@ -171,7 +178,7 @@ int DT_insert(const char *pcPath) {
    Path_T oPPath = NULL;
    Node_T oNFirstNew = NULL;
    Node_T oNCurr = NULL;
-   size_t ulDepth, ulIndex;
+   size_t ulDepth, ulIndex, ulCurrDepth;
    size_t ulNewNodes = 0;
 
    assert(pcPath != NULL);
@@ -186,7 +193,7 @@ int DT_insert(const char *pcPath) {
       return iStatus;
 
    /* find the closest ancestor of oPPath already in the tree */
-   iStatus= DT_traversePath(oPPath, &oNCurr);
+   iStatus= DT_traversePath(oPPath, &oNCurr, &ulCurrDepth);
    if(iStatus != SUCCESS)
    {
       Path_free(oPPath);
@@ -204,11 +211,10 @@ int DT_insert(const char *pcPath) {
    if(oNCurr == NULL) /* new root! */
       ulIndex = 1;
    else {
-      ulIndex = Path_getDepth(Node_getPath(oNCurr))+1;
+      ulIndex = ulCurrDepth+1;
 
       /* oNCurr is the node we're trying to insert */
-      if(ulIndex == ulDepth+1 && !Path_comparePath(oPPath,
-                                       Node_getPath(oNCurr))) {
+      if(ulIndex == ulDepth+1) {
          Path_free(oPPath);
          return ALREADY_IN_TREE;
       }
@@ -290,6 +296,49 @@ int DT_rm(const char *pcPath) {
    return SUCCESS;
 }
 
+int DT_move(const char *pcSrc, const char *pcDest) {
+   int iStatus;
+   Path_T oPDest = NULL;
+   Node_T oNSrc = NULL;
+   Node_T oNParent = NULL;
+   size_t ulDepth, ulParentDepth;
+
+   assert(pcSrc != NULL);
+   assert(pcDest != NULL);
+   assert(CheckerDT_isValid(bIsInitialized, oNRoot, ulCount));
+
+   iStatus = DT_findNode(pcSrc, &oNSrc);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   iStatus = Path_new(pcDest, &oPDest);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   /* the parent of pcDest must already be in the tree */
+   iStatus = DT_traversePath(oPDest, &oNParent, &ulParentDepth);
+   if(iStatus != SUCCESS) {
+      Path_free(oPDest);
+      return iStatus;
+   }
+   ulDepth = Path_getDepth(oPDest);
+   if(ulParentDepth == ulDepth) {
+      Path_free(oPDest);
+      return ALREADY_IN_TREE;
+   }
+   if(ulParentDepth + 1 != ulDepth) {
+      Path_free(oPDest);
+      return NO_SUCH_PATH;
+   }
+
+   iStatus = Node_move(oNSrc, oNParent,
+                       Path_getComponent(oPDest, ulDepth - 1));
+   Path_free(oPDest);
+
+   assert(CheckerDT_isValid(bIsInitialized, oNRoot, ulCount));
+   return iStatus;
+}
+
 int DT_init(void) {
    assert(CheckerDT_isValid(bIsInitialized, oNRoot, ulCount));
 
@@ -328,28 +377,62 @@ int DT_destroy(void) {
   string representation of the DT.
 */
 
+/* Where DT_insertNode inserts the nodes it is passed */
+struct listing {
+   /* the array receiving the nodes */
+   DynArray_T d;
+   /* the index at which to insert the next one */
+   size_t i;
+};
+
+/* Returns the number of children of n, for Traverse_walk. */
+static size_t DT_getNumChildren(void *n) {
+   return Node_getNumChildren(n);
+}
+
 /*
-  Performs a pre-order traversal of the tree rooted at n,
-  inserting each payload to DynArray_T d beginning at index i.
-  Returns the next unused index in d after the insertion(s).
+  Sets *c to the child of n with index i, for Traverse_walk, and
+  returns Node_getChild's status.
 */
-static size_t DT_preOrderTraversal(Node_T n, DynArray_T d, size_t i) {
-   size_t c;
+static int DT_getChild(void *n, size_t i, void **c) {
+   Node_T oNChild = NULL;
+   int iStatus;
+
+   assert(c != NULL);
+
+   iStatus = Node_getChild(n, i, &oNChild);
+   *c = oNChild;
+   return iStatus;
+}
+
+/*
+  Inserts n into the listing l at its next index, for Traverse_walk.
+  Returns SUCCESS.
+*/
+static int DT_insertNode(void *n, void *l) {
+   struct listing *psListing = l;
+
+   assert(psListing != NULL);
+
+   (void) DynArray_set(psListing->d, psListing->i, n);
+   psListing->i++;
+   return SUCCESS;
+}
+
+/*
+  Performs a pre-order traversal of the tree rooted at n, without
+  recursion, inserting each payload to DynArray_T d beginning at
+  index 0. Returns SUCCESS, or MEMORY_ERROR if allocation fails.
+*/
+static int DT_preOrderTraversal(Node_T n, DynArray_T d) {
+   struct listing l;
 
    assert(d != NULL);
 
-   if(n != NULL) {
-      (void) DynArray_set(d, i, n);
-      i++;
-      for(c = 0; c < Node_getNumChildren(n); c++) {
-         int iStatus;
-         Node_T oNChild = NULL;
-         iStatus = Node_getChild(n,c, &oNChild);
-         assert(iStatus == SUCCESS);
-         i = DT_preOrderTraversal(oNChild, d, i);
-      }
-   }
-   return i;
+   l.d = d;
+   l.i = 0;
+   return Traverse_walk(n, TRAVERSE_PRE_ORDER, DT_getNumChildren,
+                        DT_getChild, DT_insertNode, &l);
 }
 
 /*
@@ -383,12 +466,26 @@ char *DT_toString(void) {
    DynArray_T nodes;
    size_t totalStrlen = 1;
    char *result = NULL;
+   size_t i;
 
    if(!bIsInitialized)
       return NULL;
 
    nodes = DynArray_new(ulCount);
-   (void) DT_preOrderTraversal(oNRoot, nodes, 0);
+   if(nodes == NULL)
+      return NULL;
+   if(DT_preOrderTraversal(oNRoot, nodes) != SUCCESS) {
+      DynArray_free(nodes);
+      return NULL;
+   }
+
+   /* build again any path a move left out of date, so that neither
+      accumulation below can fail */
+   for(i = 0; i < ulCount; i++)
+      if(Node_getPath(DynArray_get(nodes, i)) == NULL) {
+         DynArray_free(nodes);
+         return NULL;
+      }
 
    DynArray_map(nodes, (void (*)(void *, void*)) DT_strlenAccumulate,
                 (void*) &totalStrlen);
@@ -35,12 +35,17 @@ int Node_new(Path_T oPPath, Node_T oNParent, Node_T *poNResult);
 */
 size_t Node_free(Node_T oNNode);
 
-/* Returns the path object representing oNNode's absolute path. */
+/*
+  Returns the path object representing oNNode's absolute path, or NULL
+  if a move left it out of date and there is an allocation error
+  building it again. The object stays owned by oNNode.
+*/
 Path_T Node_getPath(Node_T oNNode);
 
 /*
   Returns TRUE if oNParent has a child with path oPPath. Returns
-  FALSE if it does not.
+  FALSE if it does not. oPPath must lie directly below oNParent's
+  path, since only its last component is compared.
 
   If oNParent has such a child, stores in *pulChildID the child's
   identifier (as used in Node_getChild). If oNParent does not have
@@ -69,12 +74,30 @@ int Node_getChild(Node_T oNParent, size_t ulChildID,
 Node_T Node_getParent(Node_T oNNode);
 
 /*
-  Compares oNFirst and oNSecond lexicographically based on their paths.
+  Compares oNFirst and oNSecond lexicographically based on their names,
+  which orders siblings the same way as their paths.
   Returns <0, 0, or >0 if onFirst is "less than", "equal to", or
   "greater than" oNSecond, respectively.
 */
 int Node_compare(Node_T oNFirst, Node_T oNSecond);
 
+/*
+  Moves oNNode, with its whole subtree, to be the child of oNNewParent
+  named pcNewName. Since no node stores its ancestors' names, only
+  oNNode itself is relinked and renamed: finding its old and new
+  places takes O(log n) comparisons among n siblings, and no
+  descendant is touched. Returns SUCCESS if successful. Otherwise,
+  leaves the tree unchanged and returns status:
+  * BAD_PATH if pcNewName is empty or contains a '/'
+  * MEMORY_ERROR if memory could not be allocated to complete request
+  * CONFLICTING_PATH if oNNode is the root, or oNNewParent is oNNode
+                     or one of its descendants
+  * ALREADY_IN_TREE if oNNewParent already has a child named
+                    pcNewName (which may be oNNode itself)
+*/
+int Node_move(Node_T oNNode, Node_T oNNewParent,
+              const char *pcNewName);
+
 /*
   Returns a string representation for oNNode, or NULL if
   there is an allocation error.
@@ -9,17 +9,30 @@
 #include "dynarray.h"
 #include "nodeDT.h"
 #include "checkerDT.h"
+#include "traverse.h"
 
 /* A node in a DT */
 struct node {
-   /* the object corresponding to the node's absolute path */
+   /* this node's name, the last component of its path */
+   char *pcName;
+   /* the object corresponding to the node's absolute path, as last
+      built, or NULL */
    Path_T oPPath;
+   /* the value of ulMoves when oPPath was built */
+   unsigned long ulPathStamp;
    /* this node's parent */
    Node_T oNParent;
    /* the object containing links to this node's children */
    DynArray_T oDChildren;
 };
 
+/*
+  The number of moves made so far. A move changes the path of every
+  node below the moved one, so a node's stored path is only known to
+  be current while no move has been made since it was built.
+*/
+static unsigned long ulMoves;
+
 
 /*
   Links new child oNChild into oNParent's children array at index
@@ -38,8 +51,8 @@ static int Node_addChild(Node_T oNParent, Node_T oNChild,
 }
 
 /*
-  Compares the string representation of oNfirst with a string
-  pcSecond representing a node's path.
+  Compares the name of oNFirst with a string pcSecond representing a
+  node's name.
   Returns <0, 0, or >0 if oNFirst is "less than", "equal to", or
   "greater than" pcSecond, respectively.
 */
@@ -48,7 +61,21 @@ static int Node_compareString(const Node_T oNFirst,
    assert(oNFirst != NULL);
    assert(pcSecond != NULL);
 
-   return Path_compareString(oNFirst->oPPath, pcSecond);
+   return strcmp(oNFirst->pcName, pcSecond);
+}
+
+/*
+  Returns a copy of the string pcName, or NULL if allocation fails.
+*/
+static char *Node_copyName(const char *pcName) {
+   char *pcCopy;
+
+   assert(pcName != NULL);
+
+   pcCopy = malloc(strlen(pcName) + 1);
+   if(pcCopy == NULL)
+      return NULL;
+   return strcpy(pcCopy, pcName);
 }
 
 
@@ -89,12 +116,19 @@ int Node_new(Path_T oPPath, Node_T oNParent, Node_T *poNResult) {
       return iStatus;
    }
    psNew->oPPath = oPNewPath;
+   psNew->ulPathStamp = ulMoves;
 
    /* validate and set the new node's parent */
    if(oNParent != NULL) {
       size_t ulSharedDepth;
 
-      oPParentPath = oNParent->oPPath;
+      oPParentPath = Node_getPath(oNParent);
+      if(oPParentPath == NULL) {
+         Path_free(psNew->oPPath);
+         free(psNew);
+         *poNResult = NULL;
+         return MEMORY_ERROR;
+      }
       ulParentDepth = Path_getDepth(oPParentPath);
       ulSharedDepth = Path_getSharedPrefixDepth(psNew->oPPath,
                                                 oPParentPath);
@@ -134,9 +168,20 @@ int Node_new(Path_T oPPath, Node_T oNParent, Node_T *poNResult) {
    }
    psNew->oNParent = oNParent;
 
+   /* set the new node's name */
+   psNew->pcName = Node_copyName(Path_getComponent(
+      psNew->oPPath, Path_getDepth(psNew->oPPath) - 1));
+   if(psNew->pcName == NULL) {
+      Path_free(psNew->oPPath);
+      free(psNew);
+      *poNResult = NULL;
+      return MEMORY_ERROR;
+   }
+
    /* initialize the new node */
    psNew->oDChildren = DynArray_new(0);
    if(psNew->oDChildren == NULL) {
+      free(psNew->pcName);
       Path_free(psNew->oPPath);
       free(psNew);
       *poNResult = NULL;
@@ -147,6 +192,8 @@ int Node_new(Path_T oPPath, Node_T oNParent, Node_T *poNResult) {
    if(oNParent != NULL) {
       iStatus = Node_addChild(oNParent, psNew, ulIndex);
       if(iStatus != SUCCESS) {
+         DynArray_free(psNew->oDChildren);
+         free(psNew->pcName);
          Path_free(psNew->oPPath);
          free(psNew);
          *poNResult = NULL;
@@ -162,6 +209,48 @@ int Node_new(Path_T oPPath, Node_T oNParent, Node_T *poNResult) {
    return SUCCESS;
 }
 
+/*
+  Unlinks and returns the last child of oNNode, or returns NULL if it
+  has no children left, for Traverse_dismantle.
+*/
+static void *Node_popChild(void *pvNode) {
+   Node_T oNNode = pvNode;
+   size_t ulLength;
+
+   assert(oNNode != NULL);
+
+   ulLength = DynArray_getLength(oNNode->oDChildren);
+   if(ulLength == 0)
+      return NULL;
+   return DynArray_removeAt(oNNode->oDChildren, ulLength - 1);
+}
+
+/* Returns the parent of pvNode, for Traverse_dismantle. */
+static void *Node_parentOf(void *pvNode) {
+   assert(pvNode != NULL);
+
+   return ((Node_T) pvNode)->oNParent;
+}
+
+/*
+  Frees the struct node pvNode, which has no children left, and what
+  it owns, for Traverse_dismantle, and adds 1 to the count of nodes
+  freed at pvCount.
+*/
+static void Node_freeOne(void *pvNode, void *pvCount) {
+   Node_T oNNode = pvNode;
+
+   assert(oNNode != NULL);
+   assert(pvCount != NULL);
+
+   DynArray_free(oNNode->oDChildren);
+   if(oNNode->oPPath != NULL)
+      Path_free(oNNode->oPPath);
+   free(oNNode->pcName);
+   free(oNNode);
+   (*(size_t *) pvCount)++;
+}
+
 size_t Node_free(Node_T oNNode) {
    size_t ulIndex;
    size_t ulCount = 0;
@@ -180,25 +269,55 @@ size_t Node_free(Node_T oNNode) {
                                   ulIndex);
    }
 
-   /* recursively remove children */
-   while(DynArray_getLength(oNNode->oDChildren) != 0) {
-      ulCount += Node_free(DynArray_get(oNNode->oDChildren, 0));
-   }
-   DynArray_free(oNNode->oDChildren);
-
-   /* remove path */
-   Path_free(oNNode->oPPath);
-
-   /* finally, free the struct node */
-   free(oNNode);
-   ulCount++;
+   /* remove the subtree, children before parents, without recursion */
+   Traverse_dismantle(oNNode, Node_popChild, Node_parentOf,
+                      Node_freeOne, &ulCount);
    return ulCount;
 }
 
 Path_T Node_getPath(Node_T oNNode) {
+   Node_T oNAncestor;
+   Path_T oPNew = NULL;
+   size_t ulLength = 0;
+   size_t ulName;
+   char *pcPath;
+   char *pcEnd;
+   int iStatus;
+
    assert(oNNode != NULL);
 
-   return oNNode->oPPath;
+   /* a root's path never changes, since a root cannot be moved */
+   if(oNNode->oPPath != NULL && (oNNode->oNParent == NULL ||
+                                 oNNode->ulPathStamp == ulMoves))
+      return oNNode->oPPath;
+
+   /* write the names from oNNode up to the root, back to front */
+   for(oNAncestor = oNNode; oNAncestor != NULL;
+       oNAncestor = oNAncestor->oNParent)
+      ulLength += strlen(oNAncestor->pcName) + 1;
+   pcPath = malloc(ulLength);
+   if(pcPath == NULL)
+      return NULL;
+   pcEnd = pcPath + ulLength - 1;
+   *pcEnd = '\0';
+   for(oNAncestor = oNNode; oNAncestor != NULL;
+       oNAncestor = oNAncestor->oNParent) {
+      ulName = strlen(oNAncestor->pcName);
+      pcEnd -= ulName;
+      memcpy(pcEnd, oNAncestor->pcName, ulName);
+      if(pcEnd != pcPath)
+         *--pcEnd = '/';
+   }
+
+   iStatus = Path_new(pcPath, &oPNew);
+   free(pcPath);
+   if(iStatus != SUCCESS)
+      return NULL;
+   if(oNNode->oPPath != NULL)
+      Path_free(oNNode->oPPath);
+   oNNode->oPPath = oPNew;
+   oNNode->ulPathStamp = ulMoves;
+   return oPNew;
 }
 
 boolean Node_hasChild(Node_T oNParent, Path_T oPPath,
@@ -209,7 +328,9 @@ boolean Node_hasChild(Node_T oNParent, Path_T oPPath,
 
    /* *pulChildID is the index into oNParent->oDChildren */
    return DynArray_bsearch(oNParent->oDChildren,
-            (char*) Path_getPathname(oPPath), pulChildID,
+            (char*) Path_getComponent(oPPath,
+                                      Path_getDepth(oPPath) - 1),
+            pulChildID,
             (int (*)(const void*,const void*)) Node_compareString);
 }
 
@@ -246,17 +367,73 @@ int Node_compare(Node_T oNFirst, Node_T oNSecond) {
    assert(oNFirst != NULL);
    assert(oNSecond != NULL);
 
-   return Path_comparePath(oNFirst->oPPath, oNSecond->oPPath);
+   return strcmp(oNFirst->pcName, oNSecond->pcName);
+}
+
+int Node_move(Node_T oNNode, Node_T oNNewParent,
+              const char *pcNewName) {
+   Node_T oNOldParent;
+   Node_T oNAncestor;
+   char *pcName;
+   size_t ulOldIndex;
+   size_t ulNewIndex;
+
+   assert(oNNode != NULL);
+   assert(oNNewParent != NULL);
+   assert(pcNewName != NULL);
+
+   if(*pcNewName == '\0' || strchr(pcNewName, '/') != NULL)
+      return BAD_PATH;
+   oNOldParent = oNNode->oNParent;
+   if(oNOldParent == NULL)
+      return CONFLICTING_PATH;
+   for(oNAncestor = oNNewParent; oNAncestor != NULL;
+       oNAncestor = oNAncestor->oNParent)
+      if(oNAncestor == oNNode)
+         return CONFLICTING_PATH;
+   if(DynArray_bsearch(oNNewParent->oDChildren, (char *) pcNewName,
+            &ulNewIndex,
+            (int (*)(const void*,const void*)) Node_compareString))
+      return ALREADY_IN_TREE;
+
+   pcName = Node_copyName(pcNewName);
+   if(pcName == NULL)
+      return MEMORY_ERROR;
+
+   /* unlink from the old parent; relinking there at the old index
+      cannot fail, since removing oNNode left room for it */
+   (void) DynArray_bsearch(oNOldParent->oDChildren, oNNode,
+            &ulOldIndex,
+            (int (*)(const void *, const void *)) Node_compare);
+   (void) DynArray_removeAt(oNOldParent->oDChildren, ulOldIndex);
+   if(oNOldParent == oNNewParent && ulNewIndex > ulOldIndex)
+      ulNewIndex--;
+   if(!DynArray_addAt(oNNewParent->oDChildren, ulNewIndex, oNNode)) {
+      (void) DynArray_addAt(oNOldParent->oDChildren, ulOldIndex,
+                            oNNode);
+      free(pcName);
+      return MEMORY_ERROR;
+   }
+
+   free(oNNode->pcName);
+   oNNode->pcName = pcName;
+   oNNode->oNParent = oNNewParent;
+   ulMoves++;
+   return SUCCESS;
 }
 
 char *Node_toString(Node_T oNNode) {
+   Path_T oPPath;
    char *copyPath;
 
    assert(oNNode != NULL);
 
-   copyPath = malloc(Path_getStrLength(Node_getPath(oNNode))+1);
+   oPPath = Node_getPath(oNNode);
+   if(oPPath == NULL)
+      return NULL;
+   copyPath = malloc(Path_getStrLength(oPPath)+1);
    if(copyPath == NULL)
       return NULL;
    else
-      return strcpy(copyPath, Path_getPathname(Node_getPath(oNNode)));
+      return strcpy(copyPath, Path_getPathname(oPPath));
 }
@@ -0,0 +1 @@
+../0shared/traverse.c
\ No newline at end of file
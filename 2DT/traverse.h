@@ -0,0 +1 @@
+../0shared/traverse.h
\ No newline at end of file
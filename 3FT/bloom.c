@@ -0,0 +1,215 @@
+/*-------------------------------------------------------------------*/
+/* bloom.c                                                           */
+/* Author: Hugh Peterson                                             */
+/*-------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <limits.h>
+#include <stdlib.h>
+
+#include "a4def.h"
+#include "bloom.h"
+
+/*-------------------------------------------------------------------*/
+
+/* The number of counters each hash picks, and the number kept for
+   each hash the filter is sized for; together they let about 2% of
+   absent hashes through at the expected load */
+enum {PROBES = 4, COUNTERS_PER_HASH = 8};
+
+/*
+  The path filter is an abstract object with 4 state variables:
+*/
+
+/* 1. the counters, or NULL if the filter is not kept, and the mask
+      that picks one out of a hash (their number less 1, a power of
+      2) */
+static unsigned char *pucCounters;
+static unsigned long ulMask;
+/* 2. the number of hashes the filter is sized for */
+static size_t ulExpected;
+/* 3. the number of hashes in the filter */
+static size_t ulHashes;
+/* 4. the numbers of queries and of those answered with FALSE */
+static size_t ulQueries;
+static size_t ulRejections;
+
+/*-------------------------------------------------------------------*/
+
+/*
+  Returns the index of the ulProbe'th counter picked by ulHash, using
+  its low and high halves as the start and (odd) stride of a walk over
+  the counters.
+*/
+static size_t Bloom_index(unsigned long ulHash, size_t ulProbe) {
+   unsigned long stride = (ulHash >> 32) | 1;
+
+   return (size_t) ((ulHash + ulProbe * stride) & ulMask);
+}
+
+/*
+  Allocates counters, all 0, for ulSize hashes, and sets *pulCounters
+  to their number. Returns them, or NULL if memory could not be
+  allocated.
+*/
+static unsigned char *Bloom_alloc(size_t ulSize,
+                                  size_t *pulCounters) {
+   enum {MIN_COUNTERS = 64};
+   size_t counters = MIN_COUNTERS;
+
+   assert(pulCounters != NULL);
+
+   while(counters / COUNTERS_PER_HASH < ulSize)
+      counters *= 2;
+   *pulCounters = counters;
+   return calloc(counters, sizeof(unsigned char));
+}
+
+/*-------------------------------------------------------------------*/
+
+/*
+  Starts keeping the filter, empty, sized for ulSize hashes, which must
+  be at least 1, stopping it first if it is already kept.
+  Returns SUCCESS, or MEMORY_ERROR if memory could not be allocated.
+*/
+int Bloom_start(size_t ulSize) {
+   size_t counters;
+
+   assert(ulSize != 0);
+
+   Bloom_stop();
+
+   pucCounters = Bloom_alloc(ulSize, &counters);
+   if(pucCounters == NULL)
+      return MEMORY_ERROR;
+
+   ulMask = (unsigned long) (counters - 1);
+   ulExpected = ulSize;
+   ulHashes = 0;
+   ulQueries = 0;
+   ulRejections = 0;
+   return SUCCESS;
+}
+
+/* Stops keeping the filter and frees it. */
+void Bloom_stop(void) {
+   free(pucCounters);
+   pucCounters = NULL;
+   ulHashes = 0;
+}
+
+/* Returns TRUE if the filter is kept and FALSE otherwise. */
+boolean Bloom_isStarted(void) {
+   return (boolean) (pucCounters != NULL);
+}
+
+/*
+  Empties the filter, which must be kept, and resizes it for twice the
+  hashes it was sized for, keeping its counts of queries. Returns
+  SUCCESS, or MEMORY_ERROR, leaving the filter as it was, if memory
+  could not be allocated.
+*/
+int Bloom_grow(void) {
+   enum {GROWTH_FACTOR = 2};
+   unsigned char *counters;
+   size_t count;
+
+   assert(pucCounters != NULL);
+
+   counters = Bloom_alloc(ulExpected * GROWTH_FACTOR, &count);
+   if(counters == NULL)
+      return MEMORY_ERROR;
+
+   free(pucCounters);
+   pucCounters = counters;
+   ulMask = (unsigned long) (count - 1);
+   ulExpected *= GROWTH_FACTOR;
+   ulHashes = 0;
+   return SUCCESS;
+}
+
+/*
+  Returns TRUE if the filter, which must be kept, holds more hashes
+  than it was sized for, and FALSE otherwise.
+*/
+boolean Bloom_isCrowded(void) {
+   assert(pucCounters != NULL);
+
+   return (boolean) (ulHashes > ulExpected);
+}
+
+/* Adds ulHash to the filter, which must be kept. */
+void Bloom_add(unsigned long ulHash) {
+   unsigned char *counter;
+   size_t i;
+
+   assert(pucCounters != NULL);
+
+   for(i = 0; i < PROBES; i++) {
+      counter = &pucCounters[Bloom_index(ulHash, i)];
+      if(*counter != UCHAR_MAX)
+         (*counter)++;
+   }
+   ulHashes++;
+}
+
+/*
+  Removes ulHash, which must have been added and not since removed,
+  from the filter, which must be kept.
+*/
+void Bloom_remove(unsigned long ulHash) {
+   unsigned char *counter;
+   size_t i;
+
+   assert(pucCounters != NULL);
+   assert(ulHashes != 0);
+
+   for(i = 0; i < PROBES; i++) {
+      counter = &pucCounters[Bloom_index(ulHash, i)];
+      assert(*counter != 0);
+      /* a saturated counter may stand for more hashes than it can
+         count, so it must stay as it is */
+      if(*counter != UCHAR_MAX)
+         (*counter)--;
+   }
+   ulHashes--;
+}
+
+/*
+  Returns FALSE if ulHash is certainly not in the filter, which must
+  be kept, and TRUE if it may be.
+*/
+boolean Bloom_mayContain(unsigned long ulHash) {
+   size_t i;
+
+   assert(pucCounters != NULL);
+
+   ulQueries++;
+   for(i = 0; i < PROBES; i++) {
+      if(pucCounters[Bloom_index(ulHash, i)] == 0) {
+         ulRejections++;
+         return FALSE;
+      }
+   }
+   return TRUE;
+}
+
+/*
+  Sets *pulHashes to the number of hashes in the filter, *pulCounters
+  to its number of counters, and *pulQueries and *pulRejections to
+  the numbers of queries made of it and those it answered with FALSE
+  since it was started. The filter must be kept.
+*/
+void Bloom_getStats(size_t *pulHashes, size_t *pulCounters,
+                    size_t *pulQueries, size_t *pulRejections) {
+   assert(pulHashes != NULL);
+   assert(pulCounters != NULL);
+   assert(pulQueries != NULL);
+   assert(pulRejections != NULL);
+   assert(pucCounters != NULL);
+
+   *pulHashes = ulHashes;
+   *pulCounters = (size_t) ulMask + 1;
+   *pulQueries = ulQueries;
+   *pulRejections = ulRejections;
+}
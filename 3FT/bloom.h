@@ -0,0 +1,76 @@
+/*-------------------------------------------------------------------*/
+/* bloom.h                                                           */
+/* Author: Hugh Peterson                                             */
+/*-------------------------------------------------------------------*/
+
+#ifndef BLOOM_INCLUDED
+#define BLOOM_INCLUDED
+
+#include <stddef.h>
+#include "a4def.h"
+
+/*
+  The path filter is a counting Bloom filter over a multiset of
+  hashes. Each hash picks a few of its counters, and is added by
+  incrementing them and removed by decrementing them, so a hash none
+  of whose counters is 0 may be in the multiset and one with a counter
+  at 0 is certainly not. A counter that reaches its largest value is
+  never decremented again, which can only let more hashes through.
+  The filter is sized for an expected number of hashes, beyond which
+  it lets more and more through, and a client should then grow it.
+*/
+
+/*-------------------------------------------------------------------*/
+
+/*
+  Starts keeping the filter, empty, sized for ulSize hashes, which must
+  be at least 1, stopping it first if it is already kept.
+  Returns SUCCESS, or MEMORY_ERROR if memory could not be allocated.
+*/
+int Bloom_start(size_t ulSize);
+
+/* Stops keeping the filter and frees it. */
+void Bloom_stop(void);
+
+/* Returns TRUE if the filter is kept and FALSE otherwise. */
+boolean Bloom_isStarted(void);
+
+/*
+  Empties the filter, which must be kept, and resizes it for twice the
+  hashes it was sized for, keeping its counts of queries. Returns
+  SUCCESS, or MEMORY_ERROR, leaving the filter as it was, if memory
+  could not be allocated.
+*/
+int Bloom_grow(void);
+
+/*
+  Returns TRUE if the filter, which must be kept, holds more hashes
+  than it was sized for, and FALSE otherwise.
+*/
+boolean Bloom_isCrowded(void);
+
+/* Adds ulHash to the filter, which must be kept. */
+void Bloom_add(unsigned long ulHash);
+
+/*
+  Removes ulHash, which must have been added and not since removed,
+  from the filter, which must be kept.
+*/
+void Bloom_remove(unsigned long ulHash);
+
+/*
+  Returns FALSE if ulHash is certainly not in the filter, which must
+  be kept, and TRUE if it may be.
+*/
+boolean Bloom_mayContain(unsigned long ulHash);
+
+/*
+  Sets *pulHashes to the number of hashes in the filter, *pulCounters
+  to its number of counters, and *pulQueries and *pulRejections to
+  the numbers of queries made of it and those it answered with FALSE
+  since it was started. The filter must be kept.
+*/
+void Bloom_getStats(size_t *pulHashes, size_t *pulCounters,
+                    size_t *pulQueries, size_t *pulRejections);
+
+#endif
@@ -0,0 +1,295 @@
+/*-------------------------------------------------------------------*/
+/* dcache.c                                                          */
+/* Author: Hugh Peterson                                             */
+/*-------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "a4def.h"
+#include "dcache.h"
+
+/*-------------------------------------------------------------------*/
+
+/* An entry of the cache */
+struct dcacheEntry {
+   /* the cached path, or NULL if the entry is free */
+   char *pcPath;
+   /* the hash of the path */
+   unsigned long ulHash;
+   /* what the path names, and the stamp its client gave it */
+   void *pvValue;
+   unsigned long ulStamp;
+   /* Flag to indicate whether the entry was hit since the clock hand
+      last passed it */
+   boolean isReferenced;
+   /* the next entry in the same bucket */
+   struct dcacheEntry *psNext;
+};
+
+/*
+  The lookup cache is an abstract object with 6 state variables:
+*/
+
+/* 1. the entries, or NULL if the cache is not kept, and their number */
+static struct dcacheEntry *psEntries;
+static size_t ulCapacity;
+/* 2. the buckets, chaining entries by hash, and the mask that picks a
+      bucket out of a hash (their number less 1, a power of 2) */
+static struct dcacheEntry **ppsBuckets;
+static unsigned long ulMask;
+/* 3. the index of the entry the clock hand points to */
+static size_t ulHand;
+/* 4. the number of entries in use */
+static size_t ulUsed;
+/* 5. the numbers of hits, misses, evictions, and entries compared */
+static size_t ulHits;
+static size_t ulMisses;
+static size_t ulEvictions;
+static size_t ulProbes;
+/* 6. the client's functions that check a hit and are told of a
+      dropped entry */
+static boolean (*pfCurrent)(void *pvValue, unsigned long ulStamp);
+static void (*pfDrop)(void *pvValue);
+
+/*-------------------------------------------------------------------*/
+
+/* Returns the 64-bit FNV-1a hash of the string pcPath. */
+static unsigned long Dcache_hash(const char *pcPath) {
+   unsigned long hash = 14695981039346656037UL;
+
+   assert(pcPath != NULL);
+
+   while(*pcPath != '\0') {
+      hash ^= (unsigned char) *pcPath++;
+      hash *= 1099511628211UL;
+   }
+   return hash;
+}
+
+/* Unlinks entry psEntry, which must be in use, and frees it. */
+static void Dcache_drop(struct dcacheEntry *psEntry) {
+   struct dcacheEntry **link;
+
+   assert(psEntry != NULL);
+   assert(psEntry->pcPath != NULL);
+
+   link = &ppsBuckets[psEntry->ulHash & ulMask];
+   while(*link != psEntry)
+      link = &(*link)->psNext;
+   *link = psEntry->psNext;
+
+   free(psEntry->pcPath);
+   psEntry->pcPath = NULL;
+   psEntry->psNext = NULL;
+   ulUsed--;
+}
+
+/*
+  Returns a free entry, sweeping the clock hand past referenced
+  entries, clearing their flags, until it meets one that is free or
+  not referenced, which it drops.
+*/
+static struct dcacheEntry *Dcache_claim(void) {
+   struct dcacheEntry *entry;
+
+   for(;;) {
+      entry = &psEntries[ulHand];
+      ulHand = (ulHand + 1) % ulCapacity;
+
+      if(entry->pcPath == NULL)
+         return entry;
+      if(!entry->isReferenced) {
+         pfDrop(entry->pvValue);
+         Dcache_drop(entry);
+         ulEvictions++;
+         return entry;
+      }
+      entry->isReferenced = FALSE;
+   }
+}
+
+/*-------------------------------------------------------------------*/
+
+/*
+  Starts keeping the cache, empty, with room for ulEntries entries,
+  which must be at least 1, stopping it first if it is already kept.
+  Hits are checked with pfIsCurrent, which is passed the value and
+  stamp of the entry hit and returns TRUE if its path still names its
+  value, and pfDropped is passed the value of each entry dropped other
+  than by Dcache_remove. Returns SUCCESS, or MEMORY_ERROR if memory
+  could not be allocated.
+*/
+int Dcache_start(size_t ulEntries,
+                 boolean (*pfIsCurrent)(void *pvValue,
+                                        unsigned long ulStamp),
+                 void (*pfDropped)(void *pvValue)) {
+   size_t buckets = 1;
+
+   assert(ulEntries != 0);
+   assert(pfIsCurrent != NULL);
+   assert(pfDropped != NULL);
+
+   Dcache_stop();
+
+   /* at least as many buckets as entries keeps chains short */
+   while(buckets < ulEntries)
+      buckets *= 2;
+
+   psEntries = calloc(ulEntries, sizeof(struct dcacheEntry));
+   ppsBuckets = calloc(buckets, sizeof(struct dcacheEntry *));
+   if(psEntries == NULL || ppsBuckets == NULL) {
+      free(psEntries);
+      free(ppsBuckets);
+      psEntries = NULL;
+      ppsBuckets = NULL;
+      return MEMORY_ERROR;
+   }
+
+   pfCurrent = pfIsCurrent;
+   pfDrop = pfDropped;
+   ulCapacity = ulEntries;
+   ulMask = (unsigned long) (buckets - 1);
+   ulHand = 0;
+   ulUsed = 0;
+   ulHits = 0;
+   ulMisses = 0;
+   ulEvictions = 0;
+   ulProbes = 0;
+   return SUCCESS;
+}
+
+/*
+  Stops keeping the cache and frees it, passing the value of each
+  entry still cached to pfDropped.
+*/
+void Dcache_stop(void) {
+   size_t i;
+
+   if(psEntries == NULL)
+      return;
+
+   for(i = 0; i < ulCapacity; i++) {
+      if(psEntries[i].pcPath != NULL)
+         pfDrop(psEntries[i].pvValue);
+      free(psEntries[i].pcPath);
+   }
+   free(psEntries);
+   free(ppsBuckets);
+   psEntries = NULL;
+   ppsBuckets = NULL;
+   ulCapacity = 0;
+   ulUsed = 0;
+}
+
+/* Returns TRUE if the cache is kept and FALSE otherwise. */
+boolean Dcache_isStarted(void) {
+   return (boolean) (psEntries != NULL);
+}
+
+/*
+  Returns what path pcPath was cached as naming, if it still names it,
+  or NULL if it is not cached or no longer does, in which case its
+  entry is dropped. The cache must be kept.
+*/
+void *Dcache_lookup(const char *pcPath) {
+   struct dcacheEntry *entry;
+   unsigned long hash;
+
+   assert(pcPath != NULL);
+   assert(psEntries != NULL);
+
+   hash = Dcache_hash(pcPath);
+   for(entry = ppsBuckets[hash & ulMask]; entry != NULL;
+       entry = entry->psNext) {
+      ulProbes++;
+      if(entry->ulHash == hash && !strcmp(entry->pcPath, pcPath))
+         break;
+   }
+
+   if(entry != NULL && !pfCurrent(entry->pvValue, entry->ulStamp)) {
+      pfDrop(entry->pvValue);
+      Dcache_drop(entry);
+      entry = NULL;
+   }
+   if(entry == NULL) {
+      ulMisses++;
+      return NULL;
+   }
+
+   entry->isReferenced = TRUE;
+   ulHits++;
+   return entry->pvValue;
+}
+
+/*
+  Caches path pcPath as naming pvValue, which must not be NULL, with
+  the stamp ulStamp, evicting another entry if the cache is full. The
+  path must not be cached already. The cache must be kept. Returns a
+  handle to the new entry, for Dcache_remove, or NULL if memory for a
+  copy of the path could not be allocated.
+*/
+void *Dcache_insert(const char *pcPath, void *pvValue,
+                    unsigned long ulStamp) {
+   struct dcacheEntry *entry;
+   struct dcacheEntry **bucket;
+
+   assert(pcPath != NULL);
+   assert(pvValue != NULL);
+   assert(psEntries != NULL);
+
+   entry = Dcache_claim();
+   entry->pcPath = malloc(strlen(pcPath) + 1);
+   if(entry->pcPath == NULL)
+      return NULL;
+   strcpy(entry->pcPath, pcPath);
+
+   /* a new entry starts unreferenced, so that one never hit again is
+      the first to go */
+   entry->ulHash = Dcache_hash(pcPath);
+   entry->pvValue = pvValue;
+   entry->ulStamp = ulStamp;
+   entry->isReferenced = FALSE;
+   bucket = &ppsBuckets[entry->ulHash & ulMask];
+   entry->psNext = *bucket;
+   *bucket = entry;
+   ulUsed++;
+   return entry;
+}
+
+/*
+  Removes the entry with handle pvEntry, from Dcache_insert, which
+  must still be cached, without passing its value to pfDropped. The
+  cache must be kept.
+*/
+void Dcache_remove(void *pvEntry) {
+   assert(pvEntry != NULL);
+   assert(psEntries != NULL);
+
+   Dcache_drop(pvEntry);
+}
+
+/*
+  Sets *pulEntries to the number of entries cached, *pulHits and
+  *pulMisses to the numbers of lookups that found an entry and did
+  not, *pulEvictions to the number of entries evicted to make room,
+  and *pulProbes to the number of entries compared over all lookups,
+  each since the cache was started. The cache must be kept.
+*/
+void Dcache_getStats(size_t *pulEntries, size_t *pulHits,
+                     size_t *pulMisses, size_t *pulEvictions,
+                     size_t *pulProbes) {
+   assert(pulEntries != NULL);
+   assert(pulHits != NULL);
+   assert(pulMisses != NULL);
+   assert(pulEvictions != NULL);
+   assert(pulProbes != NULL);
+   assert(psEntries != NULL);
+
+   *pulEntries = ulUsed;
+   *pulHits = ulHits;
+   *pulMisses = ulMisses;
+   *pulEvictions = ulEvictions;
+   *pulProbes = ulProbes;
+}
@@ -0,0 +1,87 @@
+/*-------------------------------------------------------------------*/
+/* dcache.h                                                          */
+/* Author: Hugh Peterson                                             */
+/*-------------------------------------------------------------------*/
+
+#ifndef DCACHE_INCLUDED
+#define DCACHE_INCLUDED
+
+#include <stddef.h>
+#include "a4def.h"
+
+/*
+  The lookup cache maps path strings, exactly as a client passed them,
+  to what they were found to name, so that a repeated lookup costs one
+  hash and one string comparison. Each entry carries a stamp from its
+  client, and before a hit is returned a function of the client's
+  checks, from the value and the stamp, that the path still names the
+  value; entries that fail the check are dropped, so only the paths
+  that changed are invalidated. The client can also remove an entry
+  itself, through the handle Dcache_insert returns, and is told of
+  every entry dropped any other way. The cache holds a fixed number of
+  entries and makes room for new ones with the CLOCK algorithm: a
+  hand sweeps the entries, giving each that was hit since it last
+  passed a second chance.
+*/
+
+/*-------------------------------------------------------------------*/
+
+/*
+  Starts keeping the cache, empty, with room for ulEntries entries,
+  which must be at least 1, stopping it first if it is already kept.
+  Hits are checked with pfIsCurrent, which is passed the value and
+  stamp of the entry hit and returns TRUE if its path still names its
+  value, and pfDropped is passed the value of each entry dropped other
+  than by Dcache_remove. Returns SUCCESS, or MEMORY_ERROR if memory
+  could not be allocated.
+*/
+int Dcache_start(size_t ulEntries,
+                 boolean (*pfIsCurrent)(void *pvValue,
+                                        unsigned long ulStamp),
+                 void (*pfDropped)(void *pvValue));
+
+/*
+  Stops keeping the cache and frees it, passing the value of each
+  entry still cached to pfDropped.
+*/
+void Dcache_stop(void);
+
+/* Returns TRUE if the cache is kept and FALSE otherwise. */
+boolean Dcache_isStarted(void);
+
+/*
+  Returns what path pcPath was cached as naming, if it still names it,
+  or NULL if it is not cached or no longer does, in which case its
+  entry is dropped. The cache must be kept.
+*/
+void *Dcache_lookup(const char *pcPath);
+
+/*
+  Caches path pcPath as naming pvValue, which must not be NULL, with
+  the stamp ulStamp, evicting another entry if the cache is full. The
+  path must not be cached already. The cache must be kept. Returns a
+  handle to the new entry, for Dcache_remove, or NULL if memory for a
+  copy of the path could not be allocated.
+*/
+void *Dcache_insert(const char *pcPath, void *pvValue,
+                    unsigned long ulStamp);
+
+/*
+  Removes the entry with handle pvEntry, from Dcache_insert, which
+  must still be cached, without passing its value to pfDropped. The
+  cache must be kept.
+*/
+void Dcache_remove(void *pvEntry);
+
+/*
+  Sets *pulEntries to the number of entries cached, *pulHits and
+  *pulMisses to the numbers of lookups that found an entry and did
+  not, *pulEvictions to the number of entries evicted to make room,
+  and *pulProbes to the number of entries compared over all lookups,
+  each since the cache was started. The cache must be kept.
+*/
+void Dcache_getStats(size_t *pulEntries, size_t *pulHits,
+                     size_t *pulMisses, size_t *pulEvictions,
+                     size_t *pulProbes);
+
+#endif
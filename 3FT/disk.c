@@ -0,0 +1,608 @@
+/*-------------------------------------------------------------------*/
+/* disk.c                                                            */
+/* Author: Hugh Peterson                                             */
+/*-------------------------------------------------------------------*/
+
+#define _XOPEN_SOURCE 700
+
+#include <assert.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "a4def.h"
+#include "dynarray.h"
+#include "path.h"
+#include "nodeFT.h"
+#include "disk.h"
+
+/*-------------------------------------------------------------------*/
+
+/* The most directory descriptors an import or export holds at once */
+enum {DISK_MAX_OPEN = 32};
+
+/* A directory being imported or exported */
+struct diskFrame {
+   /* its node */
+   Node_T oNDir;
+   /* an open descriptor for it, or -1 while it is closed to keep the
+      number open bounded */
+   int iFd;
+   /* its device and inode numbers, to check it when it is reopened */
+   dev_t device;
+   ino_t inode;
+   /* for an import, the names of its entries, sorted, or NULL */
+   DynArray_T oDNames;
+   /* the index of the next entry or child to visit */
+   size_t ulNext;
+};
+
+/*
+  The state of an import or export: a stack of the directories on the
+  path to the one being visited, instead of recursion, so that neither
+  the call stack nor the number of open descriptors grows with depth
+*/
+struct diskWalk {
+   /* the directories from the one the walk started at down to the
+      one being visited, their number, and the number allocated */
+   struct diskFrame *psFrames;
+   size_t ulDepth;
+   size_t ulCap;
+   /* the index of the first directory still open: those after it
+      are all open, and those before it all closed */
+   size_t ulFirstOpen;
+};
+
+/* Compares the names pvFirst and pvSecond, for DynArray_sort. */
+static int Disk_compareNames(const void *pvFirst,
+                             const void *pvSecond) {
+   return strcmp((const char *) pvFirst, (const char *) pvSecond);
+}
+
+/* Frees the name pvName, for DynArray_map. */
+static void Disk_freeName(void *pvName, void *pvExtra) {
+   free(pvName);
+}
+
+/*
+  Reads up to ulSize bytes from the open file iFile into a new heap
+  buffer, with as few reads as the kernel allows, and sets
+  *ppvContents to the buffer (NULL if nothing was read) and
+  *pulLength to the number of bytes read. Returns SUCCESS, or
+  MEMORY_ERROR or IO_ERROR if the buffer could not be allocated or
+  filled.
+*/
+static int Disk_readBody(int iFile, size_t ulSize, void **ppvContents,
+                         size_t *pulLength) {
+   char *buffer;
+   size_t length = 0;
+   ssize_t nRead;
+
+   assert(ppvContents != NULL);
+   assert(pulLength != NULL);
+
+   *ppvContents = NULL;
+   *pulLength = 0;
+   if(ulSize == 0)
+      return SUCCESS;
+
+   buffer = malloc(ulSize);
+   if(buffer == NULL)
+      return MEMORY_ERROR;
+
+   /* the file may shrink while it is read, but never grows past the
+      size it had when it was examined */
+   while(length != ulSize) {
+      nRead = read(iFile, buffer + length, ulSize - length);
+      if(nRead < 0) {
+         free(buffer);
+         return IO_ERROR;
+      }
+      if(nRead == 0)
+         break;
+      length += (size_t) nRead;
+   }
+
+   if(length == 0) {
+      free(buffer);
+      return SUCCESS;
+   }
+   *ppvContents = buffer;
+   *pulLength = length;
+   return SUCCESS;
+}
+
+/*
+  Reads the names of the entries of the open directory iDir, other
+  than "." and "..", into a new DynArray_T, sorted, and sets
+  *poDNames to it. Leaves iDir open. Returns SUCCESS, or IO_ERROR or
+  MEMORY_ERROR if the names could not be read or kept, in which case
+  *poDNames is set to NULL.
+*/
+static int Disk_readNames(int iDir, DynArray_T *poDNames) {
+   DIR *dir;
+   struct dirent *entry;
+   DynArray_T names;
+   char *name;
+   int stream;
+   int status = SUCCESS;
+
+   assert(poDNames != NULL);
+
+   *poDNames = NULL;
+   /* the stream gets a descriptor of its own, so that iDir outlives
+      it */
+   stream = dup(iDir);
+   if(stream == -1)
+      return IO_ERROR;
+   dir = fdopendir(stream);
+   if(dir == NULL) {
+      (void) close(stream);
+      return IO_ERROR;
+   }
+   names = DynArray_new(0);
+   if(names == NULL) {
+      (void) closedir(dir);
+      return MEMORY_ERROR;
+   }
+
+   errno = 0;
+   while((entry = readdir(dir)) != NULL) {
+      if(!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, ".."))
+         continue;
+      name = malloc(strlen(entry->d_name) + 1);
+      if(name == NULL || !DynArray_add(names, name)) {
+         free(name);
+         status = MEMORY_ERROR;
+         break;
+      }
+      strcpy(name, entry->d_name);
+   }
+   if(status == SUCCESS && errno != 0)
+      status = IO_ERROR;
+   (void) closedir(dir);
+
+   if(status != SUCCESS) {
+      DynArray_map(names, Disk_freeName, NULL);
+      DynArray_free(names);
+      return status;
+   }
+   DynArray_sort(names, Disk_compareNames);
+   *poDNames = names;
+   return SUCCESS;
+}
+
+/*
+  Enters directory node oNDir's directory on the walk psWalk, with
+  the open descriptor iDir, which the walk then owns and closes. If
+  the walk already holds DISK_MAX_OPEN descriptors, first closes that
+  of the first directory on the walk still open. Returns SUCCESS, or
+  IO_ERROR or MEMORY_ERROR if the directory could not be entered, in
+  which case iDir is closed.
+*/
+static int Disk_pushDir(struct diskWalk *psWalk, Node_T oNDir,
+                        int iDir) {
+   struct diskFrame *frame;
+   struct diskFrame *grown;
+   struct stat info;
+   size_t newCap;
+
+   assert(psWalk != NULL);
+   assert(oNDir != NULL);
+
+   if(fstat(iDir, &info) != 0) {
+      (void) close(iDir);
+      return IO_ERROR;
+   }
+   if(psWalk->ulDepth == psWalk->ulCap) {
+      newCap = psWalk->ulCap * 2 + 16;
+      grown = realloc(psWalk->psFrames, newCap * sizeof(*grown));
+      if(grown == NULL) {
+         (void) close(iDir);
+         return MEMORY_ERROR;
+      }
+      psWalk->psFrames = grown;
+      psWalk->ulCap = newCap;
+   }
+   if(psWalk->ulDepth - psWalk->ulFirstOpen == DISK_MAX_OPEN) {
+      (void) close(psWalk->psFrames[psWalk->ulFirstOpen].iFd);
+      psWalk->psFrames[psWalk->ulFirstOpen].iFd = -1;
+      psWalk->ulFirstOpen++;
+   }
+
+   frame = &psWalk->psFrames[psWalk->ulDepth++];
+   frame->oNDir = oNDir;
+   frame->iFd = iDir;
+   frame->device = info.st_dev;
+   frame->inode = info.st_ino;
+   frame->oDNames = NULL;
+   frame->ulNext = 0;
+   return SUCCESS;
+}
+
+/*
+  Closes the last directory on the walk psWalk and returns to its
+  parent, reopening the parent through ".." if its descriptor was
+  closed and checking that it is still the same directory. Returns
+  SUCCESS, or IO_ERROR if the parent could not be reopened.
+*/
+static int Disk_popDir(struct diskWalk *psWalk) {
+   struct diskFrame *top;
+   struct diskFrame *parent;
+   struct stat info;
+   int status = SUCCESS;
+
+   assert(psWalk != NULL);
+   assert(psWalk->ulDepth != 0);
+
+   top = &psWalk->psFrames[psWalk->ulDepth - 1];
+   if(psWalk->ulDepth > 1 &&
+      psWalk->ulFirstOpen == psWalk->ulDepth - 1) {
+      parent = top - 1;
+      parent->iFd = openat(top->iFd, "..", O_RDONLY | O_DIRECTORY);
+      if(parent->iFd == -1)
+         status = IO_ERROR;
+      else if(fstat(parent->iFd, &info) != 0 ||
+              info.st_dev != parent->device ||
+              info.st_ino != parent->inode) {
+         (void) close(parent->iFd);
+         parent->iFd = -1;
+         status = IO_ERROR;
+      }
+      if(status == SUCCESS)
+         psWalk->ulFirstOpen--;
+   }
+
+   (void) close(top->iFd);
+   if(top->oDNames != NULL) {
+      DynArray_map(top->oDNames, Disk_freeName, NULL);
+      DynArray_free(top->oDNames);
+   }
+   psWalk->ulDepth--;
+   if(psWalk->ulFirstOpen > psWalk->ulDepth)
+      psWalk->ulFirstOpen = psWalk->ulDepth;
+   return status;
+}
+
+/*
+  Closes every directory still on the walk psWalk, frees their names,
+  and frees the walk's stack.
+*/
+static void Disk_endWalk(struct diskWalk *psWalk) {
+   struct diskFrame *top;
+
+   assert(psWalk != NULL);
+
+   while(psWalk->ulDepth != 0) {
+      top = &psWalk->psFrames[--psWalk->ulDepth];
+      if(top->iFd != -1)
+         (void) close(top->iFd);
+      if(top->oDNames != NULL) {
+         DynArray_map(top->oDNames, Disk_freeName, NULL);
+         DynArray_free(top->oDNames);
+      }
+   }
+   free(psWalk->psFrames);
+}
+
+/*
+  Builds the entry pcName of the open directory iDir as a new child of
+  directory node oNDir, adding 1 to *pulNodes if it is built. If the
+  entry is a subdirectory, sets *poNSub to its node and *piSub to an
+  open descriptor for it, whose entries are for the caller to build
+  next; otherwise, sets *poNSub to NULL and *piSub to -1. Returns the
+  same statuses as Disk_import.
+*/
+static int Disk_importEntry(int iDir, const char *pcName, Node_T oNDir,
+                            size_t *pulNodes, Node_T *poNSub,
+                            int *piSub) {
+   struct stat info;
+   int file;
+   void *contents;
+   size_t length;
+   Node_T node = NULL;
+   int status;
+
+   assert(pcName != NULL);
+   assert(oNDir != NULL);
+   assert(pulNodes != NULL);
+   assert(poNSub != NULL);
+   assert(piSub != NULL);
+
+   *poNSub = NULL;
+   *piSub = -1;
+   if(fstatat(iDir, pcName, &info, AT_SYMLINK_NOFOLLOW) != 0)
+      return IO_ERROR;
+
+   if(S_ISDIR(info.st_mode)) {
+      status = Node_checkQuota(oNDir, 1, 0);
+      if(status != SUCCESS)
+         return status;
+      file = openat(iDir, pcName, O_RDONLY | O_DIRECTORY);
+      if(file == -1)
+         return IO_ERROR;
+      status = Node_newChild(oNDir, pcName, FALSE, &node);
+      if(status != SUCCESS) {
+         (void) close(file);
+         return status;
+      }
+      (*pulNodes)++;
+      *poNSub = node;
+      *piSub = file;
+      return SUCCESS;
+   }
+
+   if(!S_ISREG(info.st_mode))
+      return SUCCESS;
+
+   /* a file too big for the quotas above is not even read */
+   status = Node_checkQuota(oNDir, 1, (size_t) info.st_size);
+   if(status != SUCCESS)
+      return status;
+   file = openat(iDir, pcName, O_RDONLY);
+   if(file == -1)
+      return IO_ERROR;
+   status = Disk_readBody(file, (size_t) info.st_size, &contents,
+                          &length);
+   (void) close(file);
+   if(status != SUCCESS)
+      return status;
+
+   status = Node_newChild(oNDir, pcName, TRUE, &node);
+   if(status != SUCCESS) {
+      free(contents);
+      return status;
+   }
+   (*pulNodes)++;
+   Node_adoptContents(node, contents, length);
+   return SUCCESS;
+}
+
+/*
+  Creates (or overwrites) the file for file node oNFile in the open
+  directory iDir and writes the node's contents into it, adding its
+  length to *pulBytes, and, once it is all written, adding 1 to
+  *pulFiles. Returns SUCCESS, or IO_ERROR if the file could not be
+  written or the contents could not be brought into memory.
+*/
+static int Disk_writeFile(int iDir, Node_T oNFile, size_t *pulFiles,
+                          size_t *pulBytes) {
+   int file;
+   const char *contents;
+   size_t length;
+   size_t written = 0;
+   ssize_t nWritten;
+   int status = SUCCESS;
+
+   assert(oNFile != NULL);
+   assert(pulFiles != NULL);
+   assert(pulBytes != NULL);
+
+   length = Node_getLength(oNFile);
+   contents = Node_getContents(oNFile);
+   if(contents == NULL && length != 0)
+      return IO_ERROR;
+
+   file = openat(iDir, Node_getName(oNFile),
+                 O_WRONLY | O_CREAT | O_TRUNC, 0666);
+   if(file == -1)
+      return IO_ERROR;
+   while(written != length) {
+      nWritten = write(file, contents + written, length - written);
+      if(nWritten <= 0) {
+         status = IO_ERROR;
+         break;
+      }
+      written += (size_t) nWritten;
+   }
+   if(close(file) != 0)
+      status = IO_ERROR;
+
+   *pulBytes += written;
+   if(status == SUCCESS)
+      (*pulFiles)++;
+   return status;
+}
+
+/*
+  Writes the children of directory node oNDir that need no descent
+  into the open directory iDir: first creates every subdirectory, and
+  then writes every file. Adds the number of files and bytes written
+  to *pulFiles and *pulBytes. Returns the same statuses as
+  Disk_export.
+*/
+static int Disk_exportChildren(int iDir, Node_T oNDir,
+                               size_t *pulFiles, size_t *pulBytes) {
+   size_t numChildren;
+   size_t i;
+   Node_T child = NULL;
+   int status = SUCCESS;
+
+   assert(oNDir != NULL);
+   assert(pulFiles != NULL);
+   assert(pulBytes != NULL);
+
+   numChildren = Node_getNumChildren(oNDir);
+
+   for(i = 0; status == SUCCESS && i < numChildren; i++) {
+      (void) Node_getChild(oNDir, i, &child);
+      if(!Node_isFile(child) &&
+         mkdirat(iDir, Node_getName(child), 0777) != 0 &&
+         errno != EEXIST)
+         status = IO_ERROR;
+   }
+
+   for(i = 0; status == SUCCESS && i < numChildren; i++) {
+      (void) Node_getChild(oNDir, i, &child);
+      if(Node_isFile(child))
+         status = Disk_writeFile(iDir, child, pulFiles, pulBytes);
+   }
+   return status;
+}
+
+/*-------------------------------------------------------------------*/
+
+/*
+  Builds the contents of the local directory pcDir as new children of
+  the empty directory node oNDir: a directory node for every
+  subdirectory and a file node for every regular file, whose contents
+  are read in one go into a heap buffer owned by the node. Other
+  entries, such as symbolic links, are skipped. Each directory's
+  entries are built in sorted order. Sets *pulNodes to the number of
+  nodes built. Returns SUCCESS, or:
+  * IO_ERROR if pcDir or anything in it could not be read
+  * MEMORY_ERROR if memory could not be allocated to complete request
+  * QUOTA_EXCEEDED if the next node would take oNDir or a directory
+                   above it past its quota
+  in which case the nodes built so far are left in place.
+*/
+int Disk_import(const char *pcDir, Node_T oNDir, size_t *pulNodes) {
+   struct diskWalk walk;
+   struct diskFrame *last;
+   Node_T sub = NULL;
+   int dir;
+   int status;
+
+   assert(pcDir != NULL);
+   assert(oNDir != NULL);
+   assert(!Node_isFile(oNDir));
+   assert(pulNodes != NULL);
+
+   *pulNodes = 0;
+   dir = open(pcDir, O_RDONLY | O_DIRECTORY);
+   if(dir == -1)
+      return IO_ERROR;
+
+   walk.psFrames = NULL;
+   walk.ulDepth = 0;
+   walk.ulCap = 0;
+   walk.ulFirstOpen = 0;
+   status = Disk_pushDir(&walk, oNDir, dir);
+
+   /* each directory's names are read as soon as it is entered, and
+      its entries are built in turn, descending into each
+      subdirectory as it is built */
+   while(status == SUCCESS && walk.ulDepth != 0) {
+      last = &walk.psFrames[walk.ulDepth - 1];
+      if(last->oDNames == NULL)
+         status = Disk_readNames(last->iFd, &last->oDNames);
+      else if(last->ulNext == DynArray_getLength(last->oDNames))
+         status = Disk_popDir(&walk);
+      else {
+         status = Disk_importEntry(last->iFd,
+                                   DynArray_get(last->oDNames,
+                                                last->ulNext++),
+                                   last->oNDir, pulNodes, &sub, &dir);
+         if(status == SUCCESS && sub != NULL)
+            status = Disk_pushDir(&walk, sub, dir);
+      }
+   }
+
+   Disk_endWalk(&walk);
+   return status;
+}
+
+/*
+  Writes the tree rooted at oNRoot into the local directory pcDir
+  (created if it does not exist), as a directory or file named after
+  oNRoot holding a directory or file for every node below it.
+  Existing directories are reused and existing files overwritten. Each
+  directory's subdirectories are all created before its files are
+  written and before any of them is descended into, and every
+  directory and file is created relative to an open descriptor for
+  its parent. File contents are written straight from where the FT
+  keeps them. Sets *pulFiles and *pulBytes to the number of files and
+  bytes written, and *pdSeconds to the wall-clock time the export
+  took. Returns SUCCESS, or IO_ERROR if something could not be
+  created or written, in which case whatever was written so far is
+  left in place.
+*/
+int Disk_export(Node_T oNRoot, const char *pcDir, size_t *pulFiles,
+                size_t *pulBytes, double *pdSeconds) {
+   struct timespec start, end;
+   struct diskWalk walk;
+   struct diskFrame *last;
+   Node_T child = NULL;
+   int dir;
+   int sub;
+   int status;
+
+   assert(oNRoot != NULL);
+   assert(pcDir != NULL);
+   assert(pulFiles != NULL);
+   assert(pulBytes != NULL);
+   assert(pdSeconds != NULL);
+
+   *pulFiles = 0;
+   *pulBytes = 0;
+   *pdSeconds = 0;
+   (void) clock_gettime(CLOCK_MONOTONIC, &start);
+
+   if(mkdir(pcDir, 0777) != 0 && errno != EEXIST)
+      return IO_ERROR;
+   dir = open(pcDir, O_RDONLY | O_DIRECTORY);
+   if(dir == -1)
+      return IO_ERROR;
+
+   walk.psFrames = NULL;
+   walk.ulDepth = 0;
+   walk.ulCap = 0;
+   walk.ulFirstOpen = 0;
+   if(Node_isFile(oNRoot)) {
+      status = Disk_writeFile(dir, oNRoot, pulFiles, pulBytes);
+      (void) close(dir);
+   }
+   else if(mkdirat(dir, Node_getName(oNRoot), 0777) != 0 &&
+           errno != EEXIST) {
+      status = IO_ERROR;
+      (void) close(dir);
+   }
+   else {
+      sub = openat(dir, Node_getName(oNRoot), O_RDONLY | O_DIRECTORY);
+      (void) close(dir);
+      if(sub == -1)
+         return IO_ERROR;
+      status = Disk_pushDir(&walk, oNRoot, sub);
+      if(status == SUCCESS)
+         status = Disk_exportChildren(sub, oNRoot, pulFiles, pulBytes);
+   }
+
+   /* each directory's subdirectories and files are written as soon
+      as it is entered, and then its subdirectories are descended
+      into in turn */
+   while(status == SUCCESS && walk.ulDepth != 0) {
+      last = &walk.psFrames[walk.ulDepth - 1];
+      while(last->ulNext < Node_getNumChildren(last->oNDir)) {
+         (void) Node_getChild(last->oNDir, last->ulNext, &child);
+         if(!Node_isFile(child))
+            break;
+         last->ulNext++;
+      }
+      if(last->ulNext == Node_getNumChildren(last->oNDir)) {
+         status = Disk_popDir(&walk);
+         continue;
+      }
+
+      last->ulNext++;
+      sub = openat(last->iFd, Node_getName(child),
+                   O_RDONLY | O_DIRECTORY);
+      if(sub == -1)
+         status = IO_ERROR;
+      else
+         status = Disk_pushDir(&walk, child, sub);
+      if(status == SUCCESS)
+         status = Disk_exportChildren(sub, child, pulFiles, pulBytes);
+   }
+   Disk_endWalk(&walk);
+
+   (void) clock_gettime(CLOCK_MONOTONIC, &end);
+   *pdSeconds = (double) (end.tv_sec - start.tv_sec) +
+                (double) (end.tv_nsec - start.tv_nsec) / 1e9;
+   return status;
+}
@@ -0,0 +1,57 @@
+/*-------------------------------------------------------------------*/
+/* disk.h                                                            */
+/* Author: Hugh Peterson                                             */
+/*-------------------------------------------------------------------*/
+
+#ifndef DISK_INCLUDED
+#define DISK_INCLUDED
+
+#include <stddef.h>
+#include "a4def.h"
+#include "nodeFT.h"
+
+/*
+  The disk module moves whole hierarchies between a File Tree and the
+  local file system. It walks directories through descriptors, with
+  openat and friends, so that no full path is ever resolved twice. The
+  walks keep their own stacks and hold only a bounded number of
+  descriptors open, however deep the hierarchy.
+*/
+
+/*-------------------------------------------------------------------*/
+
+/*
+  Builds the contents of the local directory pcDir as new children of
+  the empty directory node oNDir: a directory node for every
+  subdirectory and a file node for every regular file, whose contents
+  are read in one go into a heap buffer owned by the node. Other
+  entries, such as symbolic links, are skipped. Each directory's
+  entries are built in sorted order. Sets *pulNodes to the number of
+  nodes built. Returns SUCCESS, or:
+  * IO_ERROR if pcDir or anything in it could not be read
+  * MEMORY_ERROR if memory could not be allocated to complete request
+  * QUOTA_EXCEEDED if the next node would take oNDir or a directory
+                   above it past its quota
+  in which case the nodes built so far are left in place.
+*/
+int Disk_import(const char *pcDir, Node_T oNDir, size_t *pulNodes);
+
+/*
+  Writes the tree rooted at oNRoot into the local directory pcDir
+  (created if it does not exist), as a directory or file named after
+  oNRoot holding a directory or file for every node below it.
+  Existing directories are reused and existing files overwritten. Each
+  directory's subdirectories are all created before its files are
+  written and before any of them is descended into, and every
+  directory and file is created relative to an open descriptor for
+  its parent. File contents are written straight from where the FT
+  keeps them. Sets *pulFiles and *pulBytes to the number of files and
+  bytes written, and *pdSeconds to the wall-clock time the export
+  took. Returns SUCCESS, or IO_ERROR if something could not be
+  created or written, in which case whatever was written so far is
+  left in place.
+*/
+int Disk_export(Node_T oNRoot, const char *pcDir, size_t *pulFiles,
+                size_t *pulBytes, double *pdSeconds);
+
+#endif
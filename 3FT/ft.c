@@ -8,18 +8,72 @@
 #include <string.h>
 #include <stdlib.h>
 
+#include "dynarray.h"
 #include "path.h"
 #include "nodeFT.h"
+#include "spill.h"
+#include "snapshot.h"
+#include "journal.h"
+#include "disk.h"
+#include "watch.h"
+#include "glob.h"
+#include "dcache.h"
+#include "traverse.h"
 #include "a4def.h"
 #include "ft.h"
 
 /*-------------------------------------------------------------------*/
 
+/* A read-only view of the FT as it was when FT_snapshot was called */
+struct ftSnapshot {
+   /* the view of the FT's tree (see Node_openView), or NULL if the FT
+      was empty or has since been destroyed */
+   Node_View_T oVView;
+   /* the next and previous snapshots not yet released */
+   struct ftSnapshot *psNext;
+   struct ftSnapshot *psPrev;
+};
+
+/* A handle on a directory of the FT, opened by FT_openDirHandle */
+struct ftDirHandle {
+   /* the directory, which the handle keeps pinned */
+   Node_T oNDir;
+   /* the generation (see Node_getGeneration) in which the directory
+      was last found to be in the FT */
+   unsigned long ulGeneration;
+};
+
+/* The kinds of change that a transaction can take back */
+enum ftChangeKind {
+   /* nodes were inserted, or copied */
+   CHANGE_INSERT,
+   /* a subtree was removed, and is held unlinked until commit */
+   CHANGE_REMOVE,
+   /* a subtree was moved */
+   CHANGE_MOVE,
+   /* a file's contents were replaced or written */
+   CHANGE_CONTENTS
+};
+
+/* A change made by the open transaction, and what taking it back
+   needs */
+struct ftChange {
+   enum ftChangeKind eKind;
+   /* the top inserted node, the removed or moved node, or the changed
+      file */
+   Node_T oNNode;
+   /* the removed or moved node's old parent (NULL for the root), or a
+      detached node holding the changed file's old contents */
+   Node_T oNOther;
+   /* the moved node's old name, or NULL */
+   char *pcName;
+};
+
 /*
   A File Tree is a representation of a hierarchy of directories and
   files: the File Tree is rooted at a directory, directories
   may be internal nodes or leaves, and files are always leaves. A File 
-  Tree is represented as an abstract object with 3 state variables:
+  Tree is represented as an abstract object with 8 state variables:
 */
 
 /* 1. a flag for being in an initialized state (TRUE) or not (FALSE) */
@@ -28,22 +82,39 @@ static boolean isInitialized;
 static Node_T root;
 /* 3. a counter of the number of nodes in the hierarchy */
 static size_t count;
+/* 4. the mapping of the snapshot loaded by FT_loadMapped, which file
+      contents may still refer to, or NULL, and its length */
+static void *pvMap;
+static size_t ulMapLength;
+/* 5. the snapshot file that FT_checkpoint writes, or NULL if changes
+      are not being journaled */
+static char *pcCheckpointFile;
+/* 6. the first of the snapshots not yet released, or NULL */
+static struct ftSnapshot *psSnapshots;
+/* 7. the changes made by the open transaction, oldest first, or NULL
+      if no transaction is open */
+static DynArray_T oDChanges;
+/* 8. the number of transactions opened so far, with which the open
+      one marks the files whose contents it has kept (see
+      Node_setMark) */
+static unsigned long ulTransactions;
 
 /*-------------------------------------------------------------------*/
 
 /*
-  Traverses the FT starting at the root as far as possible towards
-  absolute path oPPath. If able to traverse, returns an int SUCCESS
-  status and sets *poNFurthest to the furthest node reached (which may
-  be only a prefix of oPPath, or even NULL if the root is NULL).
-  Otherwise, sets *poNFurthest to NULL and returns with status:
+  Traverses the tree rooted at oNRoot, the root of the FT or of a
+  snapshot of it, as far as possible towards absolute path oPPath,
+  matching one component of oPPath against the children's names at
+  each level. If able to traverse, returns an int SUCCESS status, sets
+  *poNFurthest to the furthest node reached (which may be only a
+  prefix of oPPath, or even NULL if oNRoot is NULL), and sets
+  *pulDepth to that node's depth (0 if it is NULL). Otherwise, sets
+  *poNFurthest to NULL and returns with status:
   * CONFLICTING_PATH if the root's path is not a prefix of oPPath
-  * MEMORY_ERROR if memory could not be allocated to complete request
 */
-static int FT_traversePath(Path_T oPPath, Node_T *poNFurthest) {
-   int status;
+static int FT_traversePath(Node_T oNRoot, Path_T oPPath,
+                           Node_T *poNFurthest, size_t *pulDepth) {
    size_t i;
-   Path_T prefix;
    Node_T current;
    Node_T child;
    size_t depth;
@@ -51,286 +122,4322 @@ static int FT_traversePath(Path_T oPPath, Node_T *poNFurthest) {
 
    assert(oPPath != NULL);
    assert(poNFurthest != NULL);
+   assert(pulDepth != NULL);
+
+   *pulDepth = 0;
 
    /* Won't find anything if the root is NULL */
-   if (root == NULL) {
+   if (oNRoot == NULL) {
       *poNFurthest = NULL;
       return SUCCESS;
    }
 
-   /* check the root */
-   status = Path_prefix(oPPath, 1, &prefix);
-   if(status != SUCCESS) {
-      *poNFurthest = NULL;
-      return status;
-   }
-
    /* is the root consistent? */
-   if(Path_comparePath(Node_getPath(root), prefix)) {
-      Path_free(prefix);
+   if (strcmp(Node_getName(oNRoot), Path_getComponent(oPPath, 0))) {
       *poNFurthest = NULL;
       return CONFLICTING_PATH;
    }
-   Path_free(prefix);
-   prefix = NULL;
 
    /* traverse the tree */
-   current = root;
+   current = oNRoot;
    depth = Path_getDepth(oPPath);
-   for (i = 2; i <= depth; i++) {   
-      /* get prefix to depth i */
-      status = Path_prefix(oPPath, i, &prefix);
-      if(status != SUCCESS) {
-         *poNFurthest = NULL;
-         return status;
-      }
-
-      /* check if current has the child with path prefix */
-      if (Node_hasChild(current, prefix, &childID)) {
-         /* set current to that child and continue with next prefix */
-         Path_free(prefix);
-         prefix = NULL;
-         
-         status = Node_getChild(current, childID, &child);
-         if(status != SUCCESS) {
-            *poNFurthest = NULL;
-            return status;
-         }
-         current = child;
-      }
-      else {
-         /* current doesn't have child with path oPPrefix:
-            this is as far as we can go */
+   for (i = 1; i < depth; i++) {
+      /* check if current has the child named by component i */
+      if (!Node_hasChild(current, Path_getComponent(oPPath, i),
+                         &childID)) {
+         /* this is as far as we can go */
          break;
       }
+      (void) Node_getChild(current, childID, &child);
+      current = child;
    }
 
-   /* clean things up and return when finished */
-   Path_free(prefix);
    *poNFurthest = current;
+   *pulDepth = i;
    return SUCCESS;
 }
 
-/*-------------------------------------------------------------------*/
 
 /*
-   Inserts a new directory into the FT with absolute path pcPath.
-   Returns SUCCESS if the new directory is inserted successfully.
-   Otherwise, returns:
-   * INITIALIZATION_ERROR if the FT is not in an initialized state
-   * BAD_PATH if pcPath does not represent a well-formatted path
-   * CONFLICTING_PATH if the root exists but is not a prefix of pcPath
-   * NOT_A_DIRECTORY if a proper prefix of pcPath exists as a file
-   * ALREADY_IN_TREE if pcPath is already in the FT (as dir or file)
-   * MEMORY_ERROR if memory could not be allocated to complete request
+  Returns TRUE if node pvNode, cached in the lookup cache in generation
+  ulGeneration (see Node_getGeneration), is still in the FT at the
+  same path, for Dcache_lookup.
 */
-int FT_insertDir(const char *pcPath) {
-   Path_T newPath = NULL;
-   Node_T ancestorNode = NULL;
+static boolean FT_isCacheCurrent(void *pvNode,
+                                 unsigned long ulGeneration) {
+   return Node_isLinkedSince(pvNode, root, ulGeneration);
+}
+
+/* Forgets the entry of node pvNode that the lookup cache dropped. */
+static void FT_forgetCached(void *pvNode) {
+   Node_setCacheEntry(pvNode, NULL);
+}
+
+/*
+  Caches absolute path pcPath in the lookup cache as naming node
+  oNNode, which it was just found to name, in place of any entry the
+  node had for a path it has since left.
+*/
+static void FT_cachePath(const char *pcPath, Node_T oNNode) {
+   assert(pcPath != NULL);
+   assert(oNNode != NULL);
+
+   if (Node_getCacheEntry(oNNode) != NULL) {
+      Dcache_remove(Node_getCacheEntry(oNNode));
+   }
+   Node_setCacheEntry(oNNode, Dcache_insert(pcPath, oNNode,
+                                            Node_getGeneration()));
+}
+
+/*
+  Traverses the tree rooted at oNRoot, the root of the FT or of a
+  snapshot of it, to find a node with absolute path pcPath, first
+  trying the lookup cache (see FT_enableLookupCache) for the FT's own
+  tree (which a snapshot shares until the FT changes), and caching
+  what it finds there. Returns an int SUCCESS
+  status and sets *poNResult to be the node, if found. Otherwise,
+  sets *poNResult to NULL and returns with status:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * CONFLICTING_PATH if the root's path is not a prefix of pcPath
+  * NO_SUCH_PATH if no node with pcPath exists in the hierarchy
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+static int FT_findNode(Node_T oNRoot, const char *pcPath,
+                       Node_T *poNResult) {
+   Path_T path = NULL;
+   Node_T found = NULL;
+   size_t reached;
+   boolean isCached;
    int status;
 
    assert(pcPath != NULL);
+   assert(poNResult != NULL);
 
    if (!isInitialized) {
+      *poNResult = NULL;
       return INITIALIZATION_ERROR;
    }
 
-   /* make new path */
-   status = Path_new(pcPath, &newPath);
+   /* a hit skips parsing and traversal entirely */
+   isCached = (boolean) (oNRoot != NULL && oNRoot == root &&
+                         Dcache_isStarted());
+   if (isCached) {
+      found = Dcache_lookup(pcPath);
+      if (found != NULL) {
+         *poNResult = found;
+         return SUCCESS;
+      }
+   }
+
+   status = Path_new(pcPath, &path);
    if (status != SUCCESS) {
+      *poNResult = NULL;
       return status;
    }
 
-   /* find ancestor node */
-   status = FT_traversePath(newPath, &ancestorNode);
+   status = FT_traversePath(oNRoot, path, &found, &reached);
    if (status != SUCCESS) {
-      Path_free(newPath);
+      Path_free(path);
+      *poNResult = NULL;
       return status;
    }
 
-   
+   /* the furthest node reached must be the node itself */
+   if (found == NULL || reached != Path_getDepth(path)) {
+      Path_free(path);
+      *poNResult = NULL;
+      return NO_SUCH_PATH;
+   }
 
-   
+   Path_free(path);
+   if (isCached) {
+      FT_cachePath(pcPath, found);
+   }
+   *poNResult = found;
+   return SUCCESS;
 }
 
 /*
-  Returns TRUE if the FT contains a directory with absolute path
-  pcPath and FALSE if not or if there is an error while checking.
+  Like FT_findNode, but additionally sets *poNResult to NULL and
+  returns NOT_A_FILE if pcPath is in the FT as a directory.
 */
-boolean FT_containsDir(const char *pcPath) {
+static int FT_findFile(Node_T oNRoot, const char *pcPath,
+                       Node_T *poNResult) {
+   int status;
 
    assert(pcPath != NULL);
+   assert(poNResult != NULL);
 
-   /* Return FALSE if FT is uninitialized */
-   if (!isInitialized) {
-      return FALSE;
+   status = FT_findNode(oNRoot, pcPath, poNResult);
+   if (status != SUCCESS) {
+      return status;
    }
+
+   if (!Node_isFile(*poNResult)) {
+      *poNResult = NULL;
+      return NOT_A_FILE;
+   }
+   return SUCCESS;
 }
 
 /*
-  Removes the FT hierarchy (subtree) at the directory with absolute
-  path pcPath. Returns SUCCESS if found and removed.
-  Otherwise, returns:
-  * INITIALIZATION_ERROR if the FT is not in an initialized state
-  * BAD_PATH if pcPath does not represent a well-formatted path
-  * CONFLICTING_PATH if the root exists but is not a prefix of pcPath
-  * NO_SUCH_PATH if absolute path pcPath does not exist in the FT
-  * NOT_A_DIRECTORY if pcPath is in the FT as a file not a directory
-  * MEMORY_ERROR if memory could not be allocated to complete request
+  If a transaction is open, notes a change of kind eKind to oNNode,
+  with oNOther and pcName as struct ftChange describes, so that
+  FT_abort can take it back; pcName is then owned by the note.
+  Returns SUCCESS, or MEMORY_ERROR if the change could not be noted.
 */
-int FT_rmDir(const char *pcPath) {
+static int FT_noteChange(enum ftChangeKind eKind, Node_T oNNode,
+                         Node_T oNOther, char *pcName) {
+   struct ftChange *change;
 
-   assert(pcPath != NULL);
-   
-   /* Return INITIALIZATION_ERROR if FT is uninitialized */
-   if (!isInitialized) {
-      return INITIALIZATION_ERROR;
+   assert(oNNode != NULL);
+
+   if (oDChanges == NULL) {
+      return SUCCESS;
+   }
+
+   change = malloc(sizeof(struct ftChange));
+   if (change == NULL) {
+      return MEMORY_ERROR;
+   }
+   change->eKind = eKind;
+   change->oNNode = oNNode;
+   change->oNOther = oNOther;
+   change->pcName = pcName;
+   if (!DynArray_add(oDChanges, change)) {
+      free(change);
+      return MEMORY_ERROR;
    }
+   return SUCCESS;
 }
 
+/* Forgets the change noted last, which must exist. */
+static void FT_forgetChange(void) {
+   size_t last;
+   struct ftChange *change;
+
+   assert(oDChanges != NULL);
+   assert(DynArray_getLength(oDChanges) != 0);
+
+   last = DynArray_getLength(oDChanges) - 1;
+   change = DynArray_removeAt(oDChanges, last);
+   free(change->pcName);
+   free(change);
+}
 
 /*
-   Inserts a new file into the FT with absolute path pcPath, with
-   file contents pvContents of size ulLength bytes.
-   Returns SUCCESS if the new file is inserted successfully.
-   Otherwise, returns:
-   * INITIALIZATION_ERROR if the FT is not in an initialized state
-   * BAD_PATH if pcPath does not represent a well-formatted path
-   * CONFLICTING_PATH if the root exists but is not a prefix of pcPath,
-                      or if the new file would be the FT root
-   * NOT_A_DIRECTORY if a proper prefix of pcPath exists as a file
-   * ALREADY_IN_TREE if pcPath is already in the FT (as dir or file)
-   * MEMORY_ERROR if memory could not be allocated to complete request
+  Takes back the insertion noted last in the open transaction, which
+  must have been made by FT_insert and not yet reported to anyone,
+  freeing the nodes it built.
 */
-int FT_insertFile(const char *pcPath, void *pvContents,
-                  size_t ulLength) {
+static void FT_dropInsert(void) {
+   struct ftChange *change;
 
-   assert(pcPath != NULL);
+   assert(oDChanges != NULL);
+   assert(DynArray_getLength(oDChanges) != 0);
 
-   /* Return INITIALIZATION_ERROR if FT is uninitialized */
-   if (!isInitialized) {
-      return INITIALIZATION_ERROR;
+   change = DynArray_get(oDChanges, DynArray_getLength(oDChanges) - 1);
+   assert(change->eKind == CHANGE_INSERT);
+   if (change->oNNode == root) {
+      root = NULL;
    }
+   count -= Node_free(change->oNNode);
+   FT_forgetChange();
 }
 
 /*
-  Returns TRUE if the FT contains a file with absolute path
-  pcPath and FALSE if not or if there is an error while checking.
+  Returns SUCCESS if file oNFile's contents may become ulNewLength
+  bytes long, or QUOTA_EXCEEDED if growing to that length would take a
+  directory above the file past its quota. Shrinking is always
+  allowed.
 */
-boolean FT_containsFile(const char *pcPath) {
+static int FT_checkGrowth(Node_T oNFile, size_t ulNewLength) {
+   size_t length;
 
-   assert(pcPath != NULL);
-   
-   /* Return FALSE if FT is uninitialized */
-   if (!isInitialized) {
-      return FALSE;
+   assert(oNFile != NULL);
+
+   length = Node_getLength(oNFile);
+   if (ulNewLength <= length) {
+      return SUCCESS;
    }
+   return Node_checkQuota(oNFile, 0, ulNewLength - length);
 }
 
 /*
-  Removes the FT file with absolute path pcPath.
-  Returns SUCCESS if found and removed.
-  Otherwise, returns:
-  * INITIALIZATION_ERROR if the FT is not in an initialized state
-  * BAD_PATH if pcPath does not represent a well-formatted path
-  * CONFLICTING_PATH if the root exists but is not a prefix of pcPath
-  * NO_SUCH_PATH if absolute path pcPath does not exist in the FT
-  * NOT_A_FILE if pcPath is in the FT as a directory not a file
-  * MEMORY_ERROR if memory could not be allocated to complete request
+  If a transaction is open and has not yet changed file oNFile, keeps
+  the file's contents in a detached copy that shares them, so that
+  FT_abort can put them back. Returns SUCCESS, or MEMORY_ERROR if they
+  could not be kept.
 */
-int FT_rmFile(const char *pcPath) {
+static int FT_keepContents(Node_T oNFile) {
+   Node_T saved = NULL;
+   size_t copied;
+   int status;
 
-   assert(pcPath != NULL);
-   
-   /* Return INITIALIZATION_ERROR if FT is uninitialized */
-   if (!isInitialized) {
-      return INITIALIZATION_ERROR;
+   assert(oNFile != NULL);
+
+   if (oDChanges == NULL) {
+      return SUCCESS;
    }
-}
 
-/*
-  Returns the contents of the file with absolute path pcPath.
-  Returns NULL if unable to complete the request for any reason.
+   /* only the contents from before the transaction are needed, and
+      a file marked with it has already had them kept */
+   if (Node_getMark(oNFile) == ulTransactions) {
+      return SUCCESS;
+   }
 
-  Note: checking for a non-NULL return is not an appropriate
-  contains check, because the contents of a file may be NULL.
-*/
-void *FT_getFileContents(const char *pcPath);
+   status = Node_copy(oNFile, NULL, Node_getName(oNFile), &saved,
+                      &copied);
+   if (status != SUCCESS) {
+      return status;
+   }
+   status = FT_noteChange(CHANGE_CONTENTS, oNFile, saved, NULL);
+   if (status != SUCCESS) {
+      (void) Node_free(saved);
+      return status;
+   }
+   Node_setMark(oNFile, ulTransactions);
+   return SUCCESS;
+}
 
 /*
-  Replaces current contents of the file with absolute path pcPath with
-  the parameter pvNewContents of size ulNewLength bytes.
-  Returns the old contents if successful. (Note: contents may be NULL.)
-  Returns NULL if unable to complete the request for any reason.
+  Reports a change of kind uiKind at node oNNode to the watches, if
+  anything is being watched, flagging an overflow if oNNode's path
+  could not be built.
 */
-void *FT_replaceFileContents(const char *pcPath, void *pvNewContents,
-                             size_t ulNewLength);
+static void FT_notifyNode(unsigned int uiKind, Node_T oNNode) {
+   char *path;
 
-/*
-  Returns SUCCESS if pcPath exists in the hierarchy,
-  Otherwise, returns:
-  * INITIALIZATION_ERROR if the FT is not in an initialized state
-  * BAD_PATH if pcPath does not represent a well-formatted path
-  * CONFLICTING_PATH if the root's path is not a prefix of pcPath
-  * NO_SUCH_PATH if absolute path pcPath does not exist in the FT
-  * MEMORY_ERROR if memory could not be allocated to complete request
+   assert(oNNode != NULL);
 
-  When returning SUCCESS,
-  if path is a directory: sets *pbIsFile to FALSE, *pulSize unchanged
-  if path is a file: sets *pbIsFile to TRUE, and
-                     sets *pulSize to the length of file's contents
+   if (!Watch_isActive()) {
+      return;
+   }
 
-  When returning another status, *pbIsFile and *pulSize are unchanged.
+   path = Node_toString(oNNode);
+   if (path == NULL) {
+      Watch_lose();
+      return;
+   }
+   Watch_notify(uiKind, path);
+   free(path);
+}
+
+/*
+  Takes back the change psChange, as the last change of the open
+  transaction not yet taken back.
 */
-int FT_stat(const char *pcPath, boolean *pbIsFile, size_t *pulSize);
+static void FT_undoChange(struct ftChange *psChange) {
+   assert(psChange != NULL);
+
+   switch (psChange->eKind) {
+      case CHANGE_INSERT:
+         FT_notifyNode(FT_EVENT_REMOVE, psChange->oNNode);
+         if (psChange->oNNode == root) {
+            root = NULL;
+         }
+         count -= Node_free(psChange->oNNode);
+         break;
+      case CHANGE_REMOVE:
+         /* the removed node's name and its place among its old
+            siblings are free again, so reattaching cannot fail */
+         if (psChange->oNOther == NULL) {
+            root = psChange->oNNode;
+            Node_indexRoot(root);
+         }
+         else {
+            (void) Node_attach(psChange->oNNode, psChange->oNOther);
+         }
+         count += Node_countNodes(psChange->oNNode);
+         FT_notifyNode(FT_EVENT_CREATE, psChange->oNNode);
+         break;
+      case CHANGE_MOVE:
+         FT_notifyNode(FT_EVENT_REMOVE, psChange->oNNode);
+         Node_detach(psChange->oNNode);
+         free(Node_setName(psChange->oNNode, psChange->pcName));
+         psChange->pcName = NULL;
+         (void) Node_attach(psChange->oNNode, psChange->oNOther);
+         FT_notifyNode(FT_EVENT_CREATE, psChange->oNNode);
+         break;
+      default:
+         Node_swapContents(psChange->oNNode, psChange->oNOther);
+         (void) Node_free(psChange->oNOther);
+         FT_notifyNode(FT_EVENT_MODIFY, psChange->oNNode);
+         break;
+   }
+}
 
 /*
-  Sets the FT data structure to an initialized state.
-  The data structure is initially empty.
-  Returns INITIALIZATION_ERROR if already initialized,
-  and SUCCESS otherwise.
+  Ends the open transaction, keeping its changes: frees the subtrees
+  it removed, the old contents it kept, and its notes.
 */
-int FT_init(void) {
-   /* If FT is already initialized, return INITIALIZATION_ERROR */
-   if(isInitialized)
-      return INITIALIZATION_ERROR;
+static void FT_endTransaction(void) {
+   struct ftChange *change;
+   size_t i;
 
-   isInitialized = TRUE;
-   root = NULL;
-   count = 0;
+   assert(oDChanges != NULL);
 
-   return SUCCESS;
+   for (i = 0; i < DynArray_getLength(oDChanges); i++) {
+      change = DynArray_get(oDChanges, i);
+      if (change->eKind == CHANGE_REMOVE ||
+          change->eKind == CHANGE_CONTENTS) {
+         (void) Node_free(change->eKind == CHANGE_REMOVE ?
+                          change->oNNode : change->oNOther);
+      }
+      free(change->pcName);
+      free(change);
+   }
+   DynArray_free(oDChanges);
+   oDChanges = NULL;
 }
 
 /*
-  Removes all contents of the data structure and
-  returns it to an uninitialized state.
-  Returns INITIALIZATION_ERROR if not already initialized,
-  and SUCCESS otherwise.
+  Inserts a new node into the FT with absolute path pcPath, creating
+  any missing ancestors as directories. The new node is a file with
+  contents pvContents of size ulLength bytes if isFile is TRUE, and a
+  directory otherwise. Returns SUCCESS or an error status as described
+  for FT_insertDir and FT_insertFile.
 */
-int FT_destroy(void) {
-   /* Return INITIALIZATION_ERROR if FT is uninitialized */
+static int FT_insert(const char *pcPath, boolean isFile,
+                     void *pvContents, size_t ulLength) {
+   Path_T newPath = NULL;
+   Node_T current = NULL;
+   Node_T firstNew = NULL;
+   size_t depth;
+   size_t index;
+   size_t level;
+   size_t newNodes = 0;
+   int status;
+
+   assert(pcPath != NULL);
+
    if (!isInitialized) {
       return INITIALIZATION_ERROR;
    }
-}
 
-/*
-  Returns a string representation of the
-  data structure, or NULL if the structure is
-  not initialized or there is an allocation error.
+   /* make new path */
+   status = Path_new(pcPath, &newPath);
+   if (status != SUCCESS) {
+      return status;
+   }
+   depth = Path_getDepth(newPath);
 
-  The representation is depth-first with files
-  before directories at any given level, and nodes
-  of the same type ordered lexicographically.
+   /* a file can never be the root */
+   if (isFile && depth == 1) {
+      Path_free(newPath);
+      return CONFLICTING_PATH;
+   }
 
-  Allocates memory for the returned string,
-  which is then owned by client!
-*/
-char *FT_toString(void) {
-   /* Return NULL if FT is uninitialized */
-   if (!isInitialized) {
-      return NULL;
+   /* find the closest ancestor already in the tree */
+   status = FT_traversePath(root, newPath, &current, &index);
+   if (status != SUCCESS) {
+      Path_free(newPath);
+      return status;
+   }
+
+   /* no ancestor found, so if the root exists pcPath is not under it */
+   if (current == NULL && root != NULL) {
+      Path_free(newPath);
+      return CONFLICTING_PATH;
    }
-}
 
+   /* the next level to build is the one below current (or the root) */
+   index++;
+   if (current != NULL) {
+      /* current is the node we are trying to insert */
+      if (index == depth + 1) {
+         Path_free(newPath);
+         return ALREADY_IN_TREE;
+      }
+
+      /* files cannot have children */
+      if (Node_isFile(current)) {
+         Path_free(newPath);
+         return NOT_A_DIRECTORY;
+      }
+
+      /* the levels still to build must fit within the quotas above */
+      status = Node_checkQuota(current, depth - index + 1,
+                               isFile ? ulLength : 0);
+      if (status != SUCCESS) {
+         Path_free(newPath);
+         return status;
+      }
+   }
+
+   /* build the rest of the path bottom up while it is detached, so
+      each level is linked under a node with no parent yet and the
+      finished chain's totals go up current's ancestors only once:
+      directories for every level but the last */
+   level = depth;
+   while (status == SUCCESS && level >= index) {
+      Node_T newNode = NULL;
+
+      status = Node_newChild(NULL,
+                             Path_getComponent(newPath, level - 1),
+                             (boolean) (isFile && level == depth),
+                             &newNode);
+      if (status == SUCCESS && isFile && level == depth) {
+         (void) Node_replaceContents(newNode, pvContents, ulLength);
+      }
+      if (status == SUCCESS && firstNew != NULL) {
+         status = Node_attach(firstNew, newNode);
+         if (status != SUCCESS) {
+            (void) Node_free(newNode);
+         }
+      }
+
+      /* set up for next level */
+      if (status == SUCCESS) {
+         firstNew = newNode;
+         newNodes++;
+         level--;
+      }
+   }
+   if (status == SUCCESS && current != NULL) {
+      status = Node_attach(firstNew, current);
+   }
+   if (status != SUCCESS) {
+      Path_free(newPath);
+      if (firstNew != NULL) {
+         (void) Node_free(firstNew);
+      }
+      return status;
+   }
+
+   /* update FT state variables to reflect insertion */
+   Path_free(newPath);
+   status = FT_noteChange(CHANGE_INSERT, firstNew, NULL, NULL);
+   if (status != SUCCESS) {
+      (void) Node_free(firstNew);
+      return status;
+   }
+   if (root == NULL) {
+      root = firstNew;
+      Node_indexRoot(root);
+   }
+   count += newNodes;
+
+   return SUCCESS;
+}
+
+/*
+  Removes node oNNode of the FT and its subtree. Returns SUCCESS, or
+  MEMORY_ERROR if a transaction is open and the removal could not be
+  noted.
+*/
+static int FT_rmNode(Node_T oNNode) {
+   int status;
+
+   assert(oNNode != NULL);
+
+   /* inside a transaction, the subtree is only unlinked until commit,
+      so that FT_abort can link it back in */
+   if (oDChanges != NULL) {
+      status = FT_noteChange(CHANGE_REMOVE, oNNode,
+                             Node_getParent(oNNode), NULL);
+      if (status != SUCCESS) {
+         return status;
+      }
+      Node_detach(oNNode);
+      count -= Node_countNodes(oNNode);
+   }
+   else {
+      count -= Node_free(oNNode);
+   }
+   if (count == 0) {
+      root = NULL;
+   }
+
+   return SUCCESS;
+}
+
+/*
+  Removes the FT node with absolute path pcPath and its subtree if it
+  is a file (when isFile is TRUE) or a directory (otherwise). Returns
+  SUCCESS or an error status as described for FT_rmDir and FT_rmFile.
+*/
+static int FT_rm(const char *pcPath, boolean isFile) {
+   Node_T found = NULL;
+   int status;
+
+   assert(pcPath != NULL);
+
+   status = FT_findNode(root, pcPath, &found);
+   if (status != SUCCESS) {
+      return status;
+   }
+
+   if (isFile && !Node_isFile(found)) {
+      return NOT_A_FILE;
+   }
+   if (!isFile && Node_isFile(found)) {
+      return NOT_A_DIRECTORY;
+   }
+
+   return FT_rmNode(found);
+}
+
+/*
+  If a transaction is open, notes that oNNode is about to be moved,
+  setting *ppcOldName to the copy of its old name that the note keeps
+  (or to NULL if no transaction is open). Returns SUCCESS, or
+  MEMORY_ERROR if the move could not be noted.
+*/
+static int FT_noteMove(Node_T oNNode, char **ppcOldName) {
+   char *oldName;
+   int status;
+
+   assert(oNNode != NULL);
+   assert(ppcOldName != NULL);
+
+   *ppcOldName = NULL;
+   if (oDChanges == NULL) {
+      return SUCCESS;
+   }
+
+   oldName = malloc(strlen(Node_getName(oNNode)) + 1);
+   if (oldName == NULL) {
+      return MEMORY_ERROR;
+   }
+   strcpy(oldName, Node_getName(oNNode));
+   status = FT_noteChange(CHANGE_MOVE, oNNode, Node_getParent(oNNode),
+                          oldName);
+   if (status != SUCCESS) {
+      free(oldName);
+      return status;
+   }
+   *ppcOldName = oldName;
+   return SUCCESS;
+}
+
+/*
+  Moves the FT node with absolute path pcSrc, and its subtree, to
+  absolute path pcDest if isCopy is FALSE, or builds a copy of them
+  there sharing their file contents if isCopy is TRUE. Returns SUCCESS
+  or an error status as described for FT_move and FT_copy.
+*/
+static int FT_relocate(const char *pcSrc, const char *pcDest,
+                       boolean isCopy) {
+   Path_T destPath = NULL;
+   Node_T source = NULL;
+   Node_T parent = NULL;
+   Node_T copy = NULL;
+   char *oldName = NULL;
+   size_t depth;
+   size_t reached;
+   size_t copied;
+   size_t files, dirs, bytes;
+   int status;
+
+   assert(pcSrc != NULL);
+   assert(pcDest != NULL);
+
+   status = FT_findNode(root, pcSrc, &source);
+   if (status != SUCCESS) {
+      return status;
+   }
+
+   status = Path_new(pcDest, &destPath);
+   if (status != SUCCESS) {
+      return status;
+   }
+   depth = Path_getDepth(destPath);
+
+   /* the furthest node reached must be pcDest's parent */
+   status = FT_traversePath(root, destPath, &parent, &reached);
+   if (status == SUCCESS) {
+      if (reached == depth) {
+         status = ALREADY_IN_TREE;
+      }
+      else if (Node_isFile(parent)) {
+         status = NOT_A_DIRECTORY;
+      }
+      else if (reached + 1 < depth) {
+         status = NO_SUCH_PATH;
+      }
+      else if (!isCopy) {
+         status = Node_checkMove(source, parent);
+         if (status == SUCCESS) {
+            status = FT_noteMove(source, &oldName);
+         }
+         if (status == SUCCESS) {
+            status = Node_move(source, parent,
+                               Path_getComponent(destPath, depth - 1));
+            if (status != SUCCESS && oldName != NULL) {
+               FT_forgetChange();
+            }
+         }
+      }
+      else {
+         Node_getTotals(source, &files, &dirs, &bytes);
+         status = Node_checkQuota(parent, files + dirs, bytes);
+         if (status == SUCCESS) {
+            status = Node_copy(source, parent,
+                               Path_getComponent(destPath, depth - 1),
+                               &copy, &copied);
+         }
+         if (status == SUCCESS) {
+            status = FT_noteChange(CHANGE_INSERT, copy, NULL, NULL);
+            if (status != SUCCESS) {
+               (void) Node_free(copy);
+            }
+            else {
+               count += copied;
+            }
+         }
+      }
+   }
+
+   Path_free(destPath);
+   return status;
+}
+
+/*-------------------------------------------------------------------*/
+
+/*
+  If changes are being journaled, appends a record of the change eOp
+  to pcPath, with offset ulOffset and the ulLength bytes at pvData as
+  its kind requires, to the journal, ahead of the change itself, which
+  must then be settled with FT_settleLog. Returns SUCCESS, or
+  MEMORY_ERROR if the record could not be appended, in which case the
+  change must not be made.
+*/
+static int FT_log(enum journalOp eOp, const char *pcPath,
+                  size_t ulOffset, const void *pvData, size_t ulLength) {
+   struct journalRecord record;
+
+   assert(pcPath != NULL);
+
+   if (!Journal_isOpen()) {
+      return SUCCESS;
+   }
+
+   record.eOp = eOp;
+   record.pcPath = pcPath;
+   record.ulOffset = ulOffset;
+   record.pvData = pvData;
+   record.ulLength = ulLength;
+   return Journal_append(&record);
+}
+
+/*
+  Settles the record that FT_log appended for a change that then
+  returned iStatus: takes the record back if the change failed, and
+  otherwise completes a group commit if one is due. A failed group
+  commit does not fail the change, which is made and recorded; its
+  records stay buffered for the next commit to retry, and FT_sync
+  reports the failure. Returns iStatus.
+*/
+static int FT_settleLog(int iStatus) {
+   if (!Journal_isOpen()) {
+      return iStatus;
+   }
+
+   if (iStatus != SUCCESS) {
+      Journal_retract();
+   }
+   else {
+      (void) Journal_commit();
+   }
+   return iStatus;
+}
+
+/*
+   Inserts a new directory into the FT with absolute path pcPath.
+   Returns SUCCESS if the new directory is inserted successfully.
+   Otherwise, returns:
+   * INITIALIZATION_ERROR if the FT is not in an initialized state
+   * BAD_PATH if pcPath does not represent a well-formatted path
+   * CONFLICTING_PATH if the root exists but is not a prefix of pcPath
+   * NOT_A_DIRECTORY if a proper prefix of pcPath exists as a file
+   * ALREADY_IN_TREE if pcPath is already in the FT (as dir or file)
+   * MEMORY_ERROR if memory could not be allocated to complete request
+   * QUOTA_EXCEEDED if the directories to build would take one above
+                    them past its quota (see FT_setQuota)
+*/
+int FT_insertDir(const char *pcPath) {
+   int status;
+
+   assert(pcPath != NULL);
+
+   status = FT_log(JOURNAL_INSERT_DIR, pcPath, 0, NULL, 0);
+   if (status == SUCCESS) {
+      status = FT_settleLog(FT_insert(pcPath, FALSE, NULL, 0));
+   }
+   if (status == SUCCESS) {
+      Watch_notify(FT_EVENT_CREATE, pcPath);
+   }
+   return status;
+}
+
+/*
+  Returns TRUE if the FT contains a directory with absolute path
+  pcPath and FALSE if not or if there is an error while checking.
+*/
+boolean FT_containsDir(const char *pcPath) {
+   Node_T found = NULL;
+
+   assert(pcPath != NULL);
+
+   if (!Node_mayHavePath(pcPath)) {
+      return FALSE;
+   }
+   if (FT_findNode(root, pcPath, &found) != SUCCESS) {
+      return FALSE;
+   }
+   return (boolean) !Node_isFile(found);
+}
+
+/*
+  Removes the FT hierarchy (subtree) at the directory with absolute
+  path pcPath. Returns SUCCESS if found and removed.
+  Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * CONFLICTING_PATH if the root exists but is not a prefix of pcPath
+  * NO_SUCH_PATH if absolute path pcPath does not exist in the FT
+  * NOT_A_DIRECTORY if pcPath is in the FT as a file not a directory
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_rmDir(const char *pcPath) {
+   int status;
+
+   assert(pcPath != NULL);
+
+   status = FT_log(JOURNAL_RM_DIR, pcPath, 0, NULL, 0);
+   if (status == SUCCESS) {
+      status = FT_settleLog(FT_rm(pcPath, FALSE));
+   }
+   if (status == SUCCESS) {
+      Watch_notify(FT_EVENT_REMOVE, pcPath);
+   }
+   return status;
+}
+
+
+/*
+   Inserts a new file into the FT with absolute path pcPath, with
+   file contents pvContents of size ulLength bytes.
+   Returns SUCCESS if the new file is inserted successfully.
+   Otherwise, returns:
+   * INITIALIZATION_ERROR if the FT is not in an initialized state
+   * BAD_PATH if pcPath does not represent a well-formatted path
+   * CONFLICTING_PATH if the root exists but is not a prefix of pcPath,
+                      or if the new file would be the FT root
+   * NOT_A_DIRECTORY if a proper prefix of pcPath exists as a file
+   * ALREADY_IN_TREE if pcPath is already in the FT (as dir or file)
+   * MEMORY_ERROR if memory could not be allocated to complete request
+   * QUOTA_EXCEEDED if the file, with any directories to build for it,
+                    would take a directory above it past its quota
+*/
+int FT_insertFile(const char *pcPath, void *pvContents,
+                  size_t ulLength) {
+   int status;
+
+   assert(pcPath != NULL);
+
+   status = FT_log(JOURNAL_INSERT_FILE, pcPath, 0, pvContents,
+                   ulLength);
+   if (status == SUCCESS) {
+      status = FT_settleLog(FT_insert(pcPath, TRUE, pvContents,
+                                      ulLength));
+   }
+   if (status == SUCCESS) {
+      Watch_notify(FT_EVENT_CREATE, pcPath);
+   }
+   return status;
+}
+
+/*
+  Returns TRUE if the FT contains a file with absolute path
+  pcPath and FALSE if not or if there is an error while checking.
+*/
+boolean FT_containsFile(const char *pcPath) {
+   Node_T found = NULL;
+
+   assert(pcPath != NULL);
+
+   if (!Node_mayHavePath(pcPath)) {
+      return FALSE;
+   }
+   return (boolean) (FT_findFile(root, pcPath, &found) == SUCCESS);
+}
+
+/*
+  Removes the FT file with absolute path pcPath.
+  Returns SUCCESS if found and removed.
+  Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * CONFLICTING_PATH if the root exists but is not a prefix of pcPath
+  * NO_SUCH_PATH if absolute path pcPath does not exist in the FT
+  * NOT_A_FILE if pcPath is in the FT as a directory not a file
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_rmFile(const char *pcPath) {
+   int status;
+
+   assert(pcPath != NULL);
+
+   status = FT_log(JOURNAL_RM_FILE, pcPath, 0, NULL, 0);
+   if (status == SUCCESS) {
+      status = FT_settleLog(FT_rm(pcPath, TRUE));
+   }
+   if (status == SUCCESS) {
+      Watch_notify(FT_EVENT_REMOVE, pcPath);
+   }
+   return status;
+}
+
+/*
+  Returns the contents of the file with absolute path pcPath.
+  Returns NULL if unable to complete the request for any reason.
+
+  Note: checking for a non-NULL return is not an appropriate
+  contains check, because the contents of a file may be NULL.
+*/
+void *FT_getFileContents(const char *pcPath) {
+   Node_T found = NULL;
+
+   assert(pcPath != NULL);
+
+   if (FT_findFile(root, pcPath, &found) != SUCCESS) {
+      return NULL;
+   }
+   return Node_getContents(found);
+}
+
+/*
+  Replaces current contents of the file with absolute path pcPath with
+  the parameter pvNewContents of size ulNewLength bytes.
+  Returns the old contents if successful. (Note: contents may be NULL.)
+  Returns NULL if unable to complete the request for any reason,
+  including longer contents that would take a directory above the
+  file past its quota (see FT_setQuota).
+*/
+void *FT_replaceFileContents(const char *pcPath, void *pvNewContents,
+                             size_t ulNewLength) {
+   Node_T found = NULL;
+   void *oldContents;
+
+   assert(pcPath != NULL);
+
+   if (FT_findFile(root, pcPath, &found) != SUCCESS) {
+      return NULL;
+   }
+   if (FT_checkGrowth(found, ulNewLength) != SUCCESS) {
+      return NULL;
+   }
+   if (FT_keepContents(found) != SUCCESS) {
+      return NULL;
+   }
+   /* logged first, since a failed replacement is not reported */
+   if (FT_log(JOURNAL_REPLACE, pcPath, 0, pvNewContents, ulNewLength)
+       != SUCCESS) {
+      return NULL;
+   }
+   oldContents = Node_replaceContents(found, pvNewContents,
+                                      ulNewLength);
+   (void) FT_settleLog(SUCCESS);
+   Watch_notify(FT_EVENT_MODIFY, pcPath);
+   return oldContents;
+}
+
+/*
+  Copies up to ulLength bytes of the contents of the file with absolute
+  path pcPath, starting at byte ulOffset, into pvBuf, and sets
+  *pulRead to the number of bytes copied (fewer than ulLength if the
+  contents end first). Returns SUCCESS if successful.
+  Otherwise, leaves *pulRead unchanged and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * CONFLICTING_PATH if the root's path is not a prefix of pcPath
+  * NO_SUCH_PATH if absolute path pcPath does not exist in the FT
+  * NOT_A_FILE if pcPath is in the FT as a directory not a file
+  * MEMORY_ERROR if memory could not be allocated to complete request
+  * IO_ERROR if spilled contents could not be read back
+*/
+int FT_readFileRange(const char *pcPath, size_t ulOffset, void *pvBuf,
+                     size_t ulLength, size_t *pulRead) {
+   Node_T found = NULL;
+   int status;
+
+   assert(pcPath != NULL);
+   assert(pvBuf != NULL || ulLength == 0);
+   assert(pulRead != NULL);
+
+   status = FT_findFile(root, pcPath, &found);
+   if (status != SUCCESS) {
+      return status;
+   }
+
+   return Node_readRange(found, ulOffset, pvBuf, ulLength, pulRead);
+}
+
+/*
+  Overwrites ulLength bytes of the contents of the file with absolute
+  path pcPath, starting at byte ulOffset, with the bytes at pvData,
+  extending the file if needed (and zero-filling any gap past its old
+  end). Returns SUCCESS if successful.
+  Otherwise, leaves the contents unchanged and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * CONFLICTING_PATH if the root's path is not a prefix of pcPath
+  * NO_SUCH_PATH if absolute path pcPath does not exist in the FT
+  * NOT_A_FILE if pcPath is in the FT as a directory not a file
+  * MEMORY_ERROR if memory could not be allocated to complete request
+  * IO_ERROR if spilled contents could not be written
+  * QUOTA_EXCEEDED if extending the file would take a directory above
+                   it past its quota (see FT_setQuota)
+*/
+int FT_writeFileRange(const char *pcPath, size_t ulOffset,
+                      const void *pvData, size_t ulLength) {
+   Node_T found = NULL;
+   int status;
+
+   assert(pcPath != NULL);
+   assert(pvData != NULL || ulLength == 0);
+
+   status = FT_findFile(root, pcPath, &found);
+   if (status == SUCCESS) {
+      status = FT_checkGrowth(found, ulOffset + ulLength);
+   }
+   if (status == SUCCESS) {
+      status = FT_keepContents(found);
+   }
+   if (status != SUCCESS) {
+      return status;
+   }
+
+   status = FT_log(JOURNAL_WRITE, pcPath, ulOffset, pvData, ulLength);
+   if (status == SUCCESS) {
+      status = FT_settleLog(Node_writeRange(found, ulOffset, pvData,
+                                            ulLength));
+   }
+   if (status == SUCCESS) {
+      Watch_notify(FT_EVENT_MODIFY, pcPath);
+   }
+   return status;
+}
+
+/*
+  Appends the ulLength bytes at pvData to the end of the contents of
+  the file with absolute path pcPath. Returns SUCCESS if successful,
+  or otherwise one of the statuses listed for FT_writeFileRange.
+*/
+int FT_appendFile(const char *pcPath, const void *pvData,
+                  size_t ulLength) {
+   Node_T found = NULL;
+   size_t offset;
+   int status;
+
+   assert(pcPath != NULL);
+   assert(pvData != NULL || ulLength == 0);
+
+   status = FT_findFile(root, pcPath, &found);
+   if (status == SUCCESS) {
+      status = FT_checkGrowth(found,
+                              Node_getLength(found) + ulLength);
+   }
+   if (status == SUCCESS) {
+      status = FT_keepContents(found);
+   }
+   if (status != SUCCESS) {
+      return status;
+   }
+
+   offset = Node_getLength(found);
+   status = FT_log(JOURNAL_WRITE, pcPath, offset, pvData, ulLength);
+   if (status == SUCCESS) {
+      status = FT_settleLog(Node_writeRange(found, offset, pvData,
+                                            ulLength));
+   }
+   if (status == SUCCESS) {
+      Watch_notify(FT_EVENT_MODIFY, pcPath);
+   }
+   return status;
+}
+
+/*
+  Looks up absolute path pcPath in the tree rooted at oNRoot, the root
+  of the FT or of a snapshot of it, as described for FT_stat.
+*/
+static int FT_statIn(Node_T oNRoot, const char *pcPath,
+                     boolean *pbIsFile, size_t *pulSize) {
+   Node_T found = NULL;
+   int status;
+
+   assert(pcPath != NULL);
+   assert(pbIsFile != NULL);
+   assert(pulSize != NULL);
+
+   status = FT_findNode(oNRoot, pcPath, &found);
+   if (status != SUCCESS) {
+      return status;
+   }
+
+   if (Node_isFile(found)) {
+      *pbIsFile = TRUE;
+      *pulSize = Node_getLength(found);
+   }
+   else {
+      *pbIsFile = FALSE;
+   }
+   return SUCCESS;
+}
+
+/*
+  Returns SUCCESS if pcPath exists in the hierarchy,
+  Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * CONFLICTING_PATH if the root's path is not a prefix of pcPath
+  * NO_SUCH_PATH if absolute path pcPath does not exist in the FT
+  * MEMORY_ERROR if memory could not be allocated to complete request
+
+  When returning SUCCESS,
+  if path is a directory: sets *pbIsFile to FALSE, *pulSize unchanged
+  if path is a file: sets *pbIsFile to TRUE, and
+                     sets *pulSize to the length of file's contents
+
+  When returning another status, *pbIsFile and *pulSize are unchanged.
+*/
+int FT_stat(const char *pcPath, boolean *pbIsFile, size_t *pulSize) {
+   assert(pcPath != NULL);
+   assert(pbIsFile != NULL);
+   assert(pulSize != NULL);
+
+   return FT_statIn(root, pcPath, pbIsFile, pulSize);
+}
+
+/*
+  Sets *pulHash to the hash of the subtree at absolute path pcPath: for
+  a file, of its contents, and for a directory, of its children's
+  names, types, and hashes in name order, recursively. Two subtrees,
+  in this FT or another, with equal hashes hold the same directories
+  and files below their roots (barring a 64-bit collision), so a
+  comparison of replicas can skip them without looking inside. Every
+  node keeps its hash, and a change only marks the hashes along its
+  chain of ancestors out of date, so this call rehashes just what
+  changed since it was last made. Returns SUCCESS if successful.
+  Otherwise, leaves *pulHash unchanged and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * CONFLICTING_PATH if the root's path is not a prefix of pcPath
+  * NO_SUCH_PATH if absolute path pcPath does not exist in the FT
+  * MEMORY_ERROR if memory could not be allocated to complete request
+  * IO_ERROR if spilled contents could not be read
+*/
+int FT_subtreeHash(const char *pcPath, unsigned long *pulHash) {
+   Node_T found = NULL;
+   int status;
+
+   assert(pcPath != NULL);
+   assert(pulHash != NULL);
+
+   status = FT_findNode(root, pcPath, &found);
+   if (status != SUCCESS) {
+      return status;
+   }
+
+   return Node_getHash(found, pulHash);
+}
+
+/*
+  Sets *pulFiles and *pulDirs to the numbers of files and directories
+  in the subtree at absolute path pcPath, itself included, and
+  *pulBytes to the total length of the files' contents. Every
+  directory keeps these totals for its subtree, and each change
+  updates them along its chain of ancestors, so the call takes time
+  proportional to the depth of pcPath rather than to the size of the
+  subtree. Returns SUCCESS if successful. Otherwise, leaves the
+  totals unchanged and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * CONFLICTING_PATH if the root's path is not a prefix of pcPath
+  * NO_SUCH_PATH if absolute path pcPath does not exist in the FT
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_statTree(const char *pcPath, size_t *pulFiles, size_t *pulDirs,
+                size_t *pulBytes) {
+   Node_T found = NULL;
+   int status;
+
+   assert(pcPath != NULL);
+   assert(pulFiles != NULL);
+   assert(pulDirs != NULL);
+   assert(pulBytes != NULL);
+
+   status = FT_findNode(root, pcPath, &found);
+   if (status != SUCCESS) {
+      return status;
+   }
+
+   Node_getTotals(found, pulFiles, pulDirs, pulBytes);
+   return SUCCESS;
+}
+
+/*
+  Gives the directory with absolute path pcPath a quota of at most
+  ulMaxNodes directories and files and ulMaxBytes bytes of file
+  contents in its subtree, itself included, with 0 meaning no limit
+  (so both 0 removes the quota). Inserts, copies, moves, and writes
+  that would take the subtree past either limit then fail with
+  QUOTA_EXCEEDED, checked against totals kept along the chain of
+  ancestors (see FT_statTree) in time proportional to the depth of
+  the change, or in constant time while no quota is set. A quota may
+  be set below what the subtree already holds, which only stops it
+  from growing. Quotas take effect at once, even inside a
+  transaction, and are not saved in snapshots or copied with their
+  directories. Returns SUCCESS if successful. Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * CONFLICTING_PATH if the root's path is not a prefix of pcPath
+  * NO_SUCH_PATH if absolute path pcPath does not exist in the FT
+  * NOT_A_DIRECTORY if pcPath is in the FT as a file not a directory
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_setQuota(const char *pcPath, size_t ulMaxNodes,
+                size_t ulMaxBytes) {
+   Node_T found = NULL;
+   int status;
+
+   assert(pcPath != NULL);
+
+   status = FT_findNode(root, pcPath, &found);
+   if (status != SUCCESS) {
+      return status;
+   }
+   if (Node_isFile(found)) {
+      return NOT_A_DIRECTORY;
+   }
+
+   Node_setQuota(found, ulMaxNodes, ulMaxBytes);
+   return SUCCESS;
+}
+
+/*
+  Sets *pulMaxNodes and *pulMaxBytes to the quota of the directory or
+  file with absolute path pcPath (see FT_setQuota), each 0 if there is
+  no limit. Returns SUCCESS if successful. Otherwise, leaves them
+  unchanged and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * CONFLICTING_PATH if the root's path is not a prefix of pcPath
+  * NO_SUCH_PATH if absolute path pcPath does not exist in the FT
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_getQuota(const char *pcPath, size_t *pulMaxNodes,
+                size_t *pulMaxBytes) {
+   Node_T found = NULL;
+   int status;
+
+   assert(pcPath != NULL);
+   assert(pulMaxNodes != NULL);
+   assert(pulMaxBytes != NULL);
+
+   status = FT_findNode(root, pcPath, &found);
+   if (status != SUCCESS) {
+      return status;
+   }
+
+   Node_getQuota(found, pulMaxNodes, pulMaxBytes);
+   return SUCCESS;
+}
+
+/*
+  Moves the file or directory with absolute path pcSrc, with everything
+  below it, to absolute path pcDest, whose parent must already be a
+  directory in the FT. Only the moved node is relinked and renamed, so
+  the time a move takes does not depend on the size of its subtree.
+  Returns SUCCESS if moved. Otherwise, leaves the FT unchanged and
+  returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcSrc or pcDest does not represent a well-formatted
+             path
+  * CONFLICTING_PATH if the root exists but is not a prefix of pcSrc
+                     or pcDest, if pcSrc is the root, or if pcDest
+                     lies below pcSrc
+  * NO_SUCH_PATH if pcSrc or the parent of pcDest does not exist in
+                 the FT
+  * NOT_A_DIRECTORY if a proper prefix of pcDest exists as a file
+  * ALREADY_IN_TREE if pcDest is already in the FT (as dir or file)
+  * MEMORY_ERROR if memory could not be allocated to complete request
+  * QUOTA_EXCEEDED if the subtree would take a directory above pcDest,
+                   but not above pcSrc, past its quota
+*/
+int FT_move(const char *pcSrc, const char *pcDest) {
+   int status;
+
+   assert(pcSrc != NULL);
+   assert(pcDest != NULL);
+
+   status = FT_log(JOURNAL_MOVE, pcSrc, 0, pcDest, strlen(pcDest));
+   if (status == SUCCESS) {
+      status = FT_settleLog(FT_relocate(pcSrc, pcDest, FALSE));
+   }
+   if (status == SUCCESS) {
+      Watch_notify(FT_EVENT_REMOVE, pcSrc);
+      Watch_notify(FT_EVENT_CREATE, pcDest);
+   }
+   return status;
+}
+
+/*
+  Builds a copy of the file or directory with absolute path pcSrc,
+  with everything below it, at absolute path pcDest, whose parent must
+  already be a directory in the FT. The copy shares file contents
+  with the original rather than copying them: contents owned by the
+  client stay owned by the client, and contents owned by the FT are
+  copied only when first changed through either path (with
+  FT_writeFileRange or FT_appendFile), so copying takes time
+  proportional to the number of directories and files copied, not to
+  the size of their contents. The directories and files themselves
+  are not shared, since each copy is a live part of the FT that can be
+  changed, moved, and looked up on its own; to keep a read-only image
+  of a subtree in constant time, take an FT_snapshot instead. Returns
+  SUCCESS if copied. Otherwise, leaves the FT unchanged and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcSrc or pcDest does not represent a well-formatted
+             path
+  * CONFLICTING_PATH if the root exists but is not a prefix of pcSrc
+                     or pcDest, or if pcDest lies below pcSrc
+  * NO_SUCH_PATH if pcSrc or the parent of pcDest does not exist in
+                 the FT
+  * NOT_A_DIRECTORY if a proper prefix of pcDest exists as a file
+  * ALREADY_IN_TREE if pcDest is already in the FT (as dir or file)
+  * MEMORY_ERROR if memory could not be allocated to complete request
+  * QUOTA_EXCEEDED if the copy would take a directory above pcDest
+                   past its quota
+*/
+int FT_copy(const char *pcSrc, const char *pcDest) {
+   int status;
+
+   assert(pcSrc != NULL);
+   assert(pcDest != NULL);
+
+   status = FT_log(JOURNAL_COPY, pcSrc, 0, pcDest, strlen(pcDest));
+   if (status == SUCCESS) {
+      status = FT_settleLog(FT_relocate(pcSrc, pcDest, TRUE));
+   }
+   if (status == SUCCESS) {
+      Watch_notify(FT_EVENT_CREATE, pcDest);
+   }
+   return status;
+}
+
+/*
+  Opens a transaction: the changes made from now on until FT_commit or
+  FT_abort take effect in the FT at once, as usual, but each is noted
+  so that FT_abort can take all of them back together. Removed
+  subtrees are only unlinked, and the old contents of changed files
+  are kept in copies that share them (see FT_copy), until the
+  transaction ends. While changes are being journaled, their records
+  are held back and written at commit as a single record with one
+  checksum, so that after a crash the journal replays either all of a
+  transaction's changes or none of them. Returns SUCCESS, or:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state or
+                         a transaction is already open
+  * MEMORY_ERROR if memory could not be allocated to complete request
+
+  Contents returned by FT_replaceFileContents inside a transaction are
+  put back by FT_abort, so the client must keep them until the
+  transaction ends. FT_load, FT_loadMapped, FT_openJournal, and
+  FT_checkpoint refuse to run while a transaction is open, and
+  FT_destroy ends it, keeping its changes but not its records.
+*/
+int FT_begin(void) {
+   if (!isInitialized || oDChanges != NULL) {
+      return INITIALIZATION_ERROR;
+   }
+
+   oDChanges = DynArray_new(0);
+   if (oDChanges == NULL) {
+      return MEMORY_ERROR;
+   }
+   ulTransactions++;
+   if (Journal_isOpen()) {
+      Journal_beginBatch();
+   }
+   return SUCCESS;
+}
+
+/*
+  Ends the open transaction, taking back all of its changes, newest
+  first, and discarding their journal records, so that the FT is as it
+  was when FT_begin was called. Returns SUCCESS, or
+  INITIALIZATION_ERROR if the FT is not in an initialized state or no
+  transaction is open.
+*/
+int FT_abort(void) {
+   size_t i;
+
+   if (!isInitialized || oDChanges == NULL) {
+      return INITIALIZATION_ERROR;
+   }
+
+   for (i = DynArray_getLength(oDChanges); i > 0; i--) {
+      FT_undoChange(DynArray_get(oDChanges, i - 1));
+   }
+   if (Journal_isOpen()) {
+      Journal_abortBatch();
+   }
+
+   /* every change is taken back, so only the notes are left */
+   while (DynArray_getLength(oDChanges) != 0) {
+      FT_forgetChange();
+   }
+   DynArray_free(oDChanges);
+   oDChanges = NULL;
+   return SUCCESS;
+}
+
+/*
+  Ends the open transaction, keeping all of its changes and writing
+  their records to the journal, if changes are being journaled, as one
+  record (completing a group commit if this fills the commit window).
+  Returns SUCCESS, or:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state or
+                         no transaction is open
+  * MEMORY_ERROR if memory could not be allocated to complete request,
+                 in which case the transaction is aborted instead
+  * IO_ERROR if the group commit failed, in which case the changes are
+             kept and their record stays buffered for the next flush
+*/
+int FT_commit(void) {
+   int status = SUCCESS;
+
+   if (!isInitialized || oDChanges == NULL) {
+      return INITIALIZATION_ERROR;
+   }
+
+   if (Journal_isOpen()) {
+      status = Journal_endBatch();
+      if (status == MEMORY_ERROR) {
+         (void) FT_abort();
+         return status;
+      }
+   }
+   FT_endTransaction();
+   return status;
+}
+
+/* Returns the number of children of pvNode, for Traverse_walk. */
+static size_t FT_getNumChildren(void *pvNode) {
+   return Node_getNumChildren(pvNode);
+}
+
+/*
+  Sets *ppvChild to the child of pvNode with index ulIndex, for
+  Traverse_walk, and returns Node_getChild's status.
+*/
+static int FT_getChild(void *pvNode, size_t ulIndex, void **ppvChild) {
+   Node_T child = NULL;
+   int status;
+
+   assert(ppvChild != NULL);
+
+   status = Node_getChild(pvNode, ulIndex, &child);
+   *ppvChild = child;
+   return status;
+}
+
+/*
+  Moves the heap-owned contents of pvNode, if it is a file longer than
+  the spill threshold, into the spill store, for a Traverse_walk.
+  Contents that cannot be moved stay on the heap. Returns SUCCESS.
+*/
+static int FT_spillNode(void *pvNode, void *pvExtra) {
+   assert(pvNode != NULL);
+
+   if (Node_isFile(pvNode) &&
+       Node_getLength(pvNode) > Spill_getThreshold()) {
+      (void) Node_spillContents(pvNode);
+   }
+   return SUCCESS;
+}
+
+/*
+  Keeps FT-owned file contents longer than ulThreshold bytes out of
+  the heap, in the append-only backing file pcBackingFile, from now
+  until FT_destroy. Returns SUCCESS if the spill store was opened.
+  Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+                         or spilling is already enabled
+  * IO_ERROR if the backing file could not be created
+*/
+int FT_enableSpill(const char *pcBackingFile, size_t ulThreshold) {
+   int status;
+
+   assert(pcBackingFile != NULL);
+
+   if (!isInitialized) {
+      return INITIALIZATION_ERROR;
+   }
+
+   status = Spill_open(pcBackingFile, ulThreshold);
+   if (status != SUCCESS) {
+      return status;
+   }
+
+   /* files the walk does not reach for want of memory just keep their
+      contents on the heap */
+   (void) Traverse_walk(root, TRAVERSE_PRE_ORDER, FT_getNumChildren,
+                        FT_getChild, FT_spillNode, NULL);
+   return SUCCESS;
+}
+
+/*
+  Caps the heap memory used by FT-owned file contents at ulBytes,
+  evicting the least recently used contents to the spill store when
+  the cap is exceeded, or removes the cap if ulBytes is 0. Resets the
+  counters reported by FT_getCacheStats. Returns SUCCESS, or
+  INITIALIZATION_ERROR if the FT is not in an initialized state or
+  spilling has not been enabled with FT_enableSpill.
+*/
+int FT_setMemoryBudget(size_t ulBytes) {
+   if (!isInitialized || !Spill_isOpen()) {
+      return INITIALIZATION_ERROR;
+   }
+
+   Node_setBudget(ulBytes);
+   return SUCCESS;
+}
+
+/*
+  Sets *pulResident to the number of heap bytes currently used by
+  FT-owned file contents, and *pulHits, *pulMisses, and *pulEvictions
+  to the number of content accesses that found the contents resident,
+  that had to fault evicted contents back in, and the number of
+  evictions, since the budget was last set. Returns SUCCESS, or
+  INITIALIZATION_ERROR if the FT is not in an initialized state.
+*/
+int FT_getCacheStats(size_t *pulResident, size_t *pulHits,
+                     size_t *pulMisses, size_t *pulEvictions) {
+   assert(pulResident != NULL);
+   assert(pulHits != NULL);
+   assert(pulMisses != NULL);
+   assert(pulEvictions != NULL);
+
+   if (!isInitialized) {
+      return INITIALIZATION_ERROR;
+   }
+
+   Node_getCacheStats(pulResident, pulHits, pulMisses, pulEvictions);
+   return SUCCESS;
+}
+
+/*
+  Gives the file with absolute path pcPath FT-owned contents copied
+  from the ulLength bytes at pvData. Returns SUCCESS, MEMORY_ERROR if
+  memory could not be allocated, or the status of finding the file.
+*/
+static int FT_restoreContents(const char *pcPath, const void *pvData,
+                              size_t ulLength) {
+   Node_T found = NULL;
+   void *contents = NULL;
+   int status;
+
+   assert(pcPath != NULL);
+
+   status = FT_findFile(root, pcPath, &found);
+   if (status != SUCCESS) {
+      return status;
+   }
+
+   if (ulLength != 0) {
+      contents = malloc(ulLength);
+      if (contents == NULL) {
+         return MEMORY_ERROR;
+      }
+      memcpy(contents, pvData, ulLength);
+   }
+   Node_adoptContents(found, contents, ulLength);
+   return SUCCESS;
+}
+
+/*
+  Replays the change psRecord from the journal. Only changes that
+  succeeded were recorded, so they succeed again unless memory or the
+  spill store runs out. Returns SUCCESS, or MEMORY_ERROR or IO_ERROR
+  if the change could not be replayed.
+*/
+static int FT_applyRecord(const struct journalRecord *psRecord) {
+   const char *path;
+   char *dest;
+   Node_T found = NULL;
+   int status;
+
+   assert(psRecord != NULL);
+
+   path = psRecord->pcPath;
+   switch (psRecord->eOp) {
+      case JOURNAL_INSERT_DIR:
+         status = FT_insert(path, FALSE, NULL, 0);
+         break;
+      case JOURNAL_INSERT_FILE:
+         status = FT_insert(path, TRUE, NULL, 0);
+         if (status == SUCCESS) {
+            status = FT_restoreContents(path, psRecord->pvData,
+                                        psRecord->ulLength);
+         }
+         break;
+      case JOURNAL_RM_DIR:
+         status = FT_rm(path, FALSE);
+         break;
+      case JOURNAL_RM_FILE:
+         status = FT_rm(path, TRUE);
+         break;
+      case JOURNAL_REPLACE:
+         status = FT_restoreContents(path, psRecord->pvData,
+                                     psRecord->ulLength);
+         break;
+      case JOURNAL_MOVE:
+      case JOURNAL_COPY:
+         dest = malloc(psRecord->ulLength + 1);
+         if (dest == NULL) {
+            return MEMORY_ERROR;
+         }
+         memcpy(dest, psRecord->pvData, psRecord->ulLength);
+         dest[psRecord->ulLength] = '\0';
+         status = FT_relocate(path, dest, (boolean)
+                              (psRecord->eOp == JOURNAL_COPY));
+         free(dest);
+         break;
+      default:
+         status = FT_findFile(root, path, &found);
+         if (status == SUCCESS) {
+            status = Node_writeRange(found, psRecord->ulOffset,
+                                     psRecord->pvData,
+                                     psRecord->ulLength);
+         }
+         break;
+   }
+
+   if (status == MEMORY_ERROR || status == IO_ERROR) {
+      return status;
+   }
+   return SUCCESS;
+}
+
+/*
+  Writes a compact binary snapshot of the FT to the file pcFile,
+  replacing it, so that it can later be rebuilt with FT_load. Returns
+  SUCCESS if the snapshot was written. Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * IO_ERROR if the file could not be written
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_save(const char *pcFile) {
+   assert(pcFile != NULL);
+
+   if (!isInitialized) {
+      return INITIALIZATION_ERROR;
+   }
+
+   return Snapshot_save(pcFile, root, count,
+                        Journal_isOpen() ? Journal_getGeneration() : 0);
+}
+
+/*
+  Rebuilds the FT from the snapshot in the file pcFile, written by
+  FT_save. The FT must be empty. The nodes are built directly under
+  their parents, and file contents are read into memory owned by the
+  FT (see FT_replaceFileContents). Returns SUCCESS if the FT was
+  rebuilt. Otherwise, leaves the FT empty and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * CONFLICTING_PATH if the FT is not empty, is being journaled, or
+                     has a transaction open
+  * IO_ERROR if the file could not be read or is not a valid snapshot
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_load(const char *pcFile) {
+   int status;
+
+   assert(pcFile != NULL);
+
+   if (!isInitialized) {
+      return INITIALIZATION_ERROR;
+   }
+   if (root != NULL || Journal_isOpen() || oDChanges != NULL) {
+      return CONFLICTING_PATH;
+   }
+
+   status = Snapshot_load(pcFile, &root, &count);
+   if (status == SUCCESS && root != NULL) {
+      Node_indexRoot(root);
+   }
+   return status;
+}
+
+/*
+  Rebuilds the FT from the snapshot in the file pcFile like FT_load,
+  but without reading file contents up front: the file is mapped
+  privately into memory until FT_destroy, and each file's contents are
+  read in place from the mapping, paged in when first touched and
+  shared with other processes mapping the same snapshot. Contents are
+  copied into FT-owned memory only when first changed with
+  FT_writeFileRange or FT_appendFile. Returns the same statuses as
+  FT_load, and also CONFLICTING_PATH if a snapshot is already mapped.
+
+  The directories and files themselves are still built in memory, in
+  one pass over the snapshot, so loading takes time proportional to
+  their number: each keeps state that changes with the tree around it
+  (its parent, subtree totals and hash, and its links into the indexes
+  and caches), which a read-only mapping cannot hold.
+*/
+int FT_loadMapped(const char *pcFile) {
+   int status;
+
+   assert(pcFile != NULL);
+
+   if (!isInitialized) {
+      return INITIALIZATION_ERROR;
+   }
+   if (root != NULL || pvMap != NULL || Journal_isOpen() ||
+       oDChanges != NULL) {
+      return CONFLICTING_PATH;
+   }
+
+   status = Snapshot_map(pcFile, &root, &count, &pvMap, &ulMapLength);
+   if (status == SUCCESS && root != NULL) {
+      Node_indexRoot(root);
+   }
+   return status;
+}
+
+/*
+  Starts journaling changes to the FT, which must be empty. First
+  rebuilds the FT from the checkpoint snapshot in the file pcSnapshot
+  (if there is one) and then replays the changes recorded after it in
+  the journal in the file pcJournal (if there is one). From then on,
+  every successful FT_insertDir, FT_insertFile, FT_rmDir, FT_rmFile,
+  FT_move, FT_copy, FT_replaceFileContents, FT_writeFileRange, and
+  FT_appendFile is recorded in the journal, and the records are
+  flushed to disk as a group once every ulCommitWindow changes (or
+  after every change if ulCommitWindow is 0), by FT_sync, and by
+  FT_destroy. A crash loses at most the changes made since the last
+  flush. File contents rebuilt from the snapshot or journal are owned
+  by the FT (see FT_replaceFileContents). Returns SUCCESS if
+  journaling started. Otherwise, leaves the FT empty and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state,
+                         changes are already being journaled, or a
+                         transaction is open
+  * CONFLICTING_PATH if the FT is not empty
+  * IO_ERROR if the snapshot or journal could not be read or written
+  * MEMORY_ERROR if memory could not be allocated to complete request
+
+  While journaling, each change's record is appended before the change
+  is made, and watches hear of it only after both: a change that
+  cannot be recorded is not made, and its function returns
+  MEMORY_ERROR (FT_replaceFileContents returns NULL). A group commit
+  that fails does not fail the change that filled the window, which
+  is made and recorded; the records stay buffered for the next group
+  commit to retry, and FT_sync reports the failure.
+*/
+int FT_openJournal(const char *pcSnapshot, const char *pcJournal,
+                   size_t ulCommitWindow) {
+   size_t generation = 0;
+   int status;
+
+   assert(pcSnapshot != NULL);
+   assert(pcJournal != NULL);
+
+   if (!isInitialized || Journal_isOpen() || oDChanges != NULL) {
+      return INITIALIZATION_ERROR;
+   }
+   if (root != NULL || pvMap != NULL) {
+      return CONFLICTING_PATH;
+   }
+
+   pcCheckpointFile = malloc(strlen(pcSnapshot) + 1);
+   if (pcCheckpointFile == NULL) {
+      return MEMORY_ERROR;
+   }
+   strcpy(pcCheckpointFile, pcSnapshot);
+
+   status = Snapshot_getGeneration(pcSnapshot, &generation);
+   if (status == SUCCESS) {
+      status = Snapshot_load(pcSnapshot, &root, &count);
+      if (status == SUCCESS && root != NULL) {
+         Node_indexRoot(root);
+      }
+   }
+   else if (status == NO_SUCH_PATH) {
+      status = SUCCESS;
+   }
+   if (status == SUCCESS) {
+      status = Journal_open(pcJournal, generation, ulCommitWindow,
+                            FT_applyRecord);
+   }
+
+   if (status != SUCCESS) {
+      if (root != NULL) {
+         count -= Node_free(root);
+         root = NULL;
+      }
+      free(pcCheckpointFile);
+      pcCheckpointFile = NULL;
+   }
+   return status;
+}
+
+/*
+  Flushes the journal's buffered records to disk, completing a group
+  commit early. Returns SUCCESS, INITIALIZATION_ERROR if the FT is not
+  in an initialized state or changes are not being journaled, or
+  IO_ERROR if the records could not be flushed.
+*/
+int FT_sync(void) {
+   if (!isInitialized || !Journal_isOpen()) {
+      return INITIALIZATION_ERROR;
+   }
+
+   return Journal_sync();
+}
+
+/*
+  Writes the whole FT as a new checkpoint snapshot to the snapshot
+  file given to FT_openJournal, replacing the old one, and then starts
+  a new, empty journal, so that the journal never needs to replay
+  changes older than the last checkpoint. A crash part way through
+  leaves either the old snapshot and journal or the new ones. Returns
+  SUCCESS, or:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state,
+                         changes are not being journaled, or a
+                         transaction is open
+  * IO_ERROR if the snapshot or new journal could not be written
+  * MEMORY_ERROR if memory could not be allocated to complete request
+  If the snapshot was written but the new journal was not, journaling
+  stops, since the old journal no longer follows the snapshot.
+*/
+int FT_checkpoint(void) {
+   size_t generation;
+   int status;
+
+   if (!isInitialized || !Journal_isOpen() || oDChanges != NULL) {
+      return INITIALIZATION_ERROR;
+   }
+
+   generation = Journal_getGeneration() + 1;
+   status = Snapshot_save(pcCheckpointFile, root, count, generation);
+   if (status != SUCCESS) {
+      return status;
+   }
+
+   status = Journal_reset(generation);
+   if (status != SUCCESS) {
+      (void) Journal_close();
+      free(pcCheckpointFile);
+      pcCheckpointFile = NULL;
+   }
+   return status;
+}
+
+/*
+  Appends a record to the journal that inserts node pvNode, for a
+  pre-order Traverse_walk. Returns SUCCESS, or MEMORY_ERROR or
+  IO_ERROR if the record could not be appended.
+*/
+static int FT_logNode(void *pvNode, void *pvExtra) {
+   char *path;
+   void *contents;
+   int status;
+
+   assert(pvNode != NULL);
+
+   path = Node_toString(pvNode);
+   if (path == NULL) {
+      return MEMORY_ERROR;
+   }
+   if (Node_isFile(pvNode)) {
+      contents = Node_getContents(pvNode);
+      if (contents == NULL && Node_getLength(pvNode) != 0) {
+         status = IO_ERROR;
+      }
+      else {
+         status = FT_log(JOURNAL_INSERT_FILE, path, 0, contents,
+                         Node_getLength(pvNode));
+      }
+   }
+   else {
+      status = FT_log(JOURNAL_INSERT_DIR, path, 0, NULL, 0);
+   }
+   free(path);
+   return status;
+}
+
+/*
+  Appends records to the journal, if changes are being journaled, that
+  insert the subtree rooted at oNNode, parents before children.
+  Returns SUCCESS, or MEMORY_ERROR or IO_ERROR if a record could not be
+  appended.
+*/
+static int FT_logSubtree(Node_T oNNode) {
+   assert(oNNode != NULL);
+
+   if (!Journal_isOpen()) {
+      return SUCCESS;
+   }
+   return Traverse_walk(oNNode, TRAVERSE_PRE_ORDER, FT_getNumChildren,
+                        FT_getChild, FT_logNode, NULL);
+}
+
+/*
+  Imports the local directory pcDir, with everything in it, as a new
+  directory of the FT with absolute path pcPath (inserted as with
+  FT_insertDir). Subdirectories and regular files become directories
+  and files of the FT, with file contents read into memory owned by
+  the FT (see FT_replaceFileContents); other entries, such as symbolic
+  links, are skipped. Returns SUCCESS if the directory was imported.
+  Otherwise, returns one of the statuses of FT_insertDir, or:
+  * IO_ERROR if pcDir or anything in it could not be read
+  * MEMORY_ERROR if memory could not be allocated to complete request
+  * QUOTA_EXCEEDED if what pcDir holds would take a directory above
+                   pcPath past its quota
+  in which case pcPath is removed again.
+*/
+int FT_importFromDisk(const char *pcDir, const char *pcPath) {
+   Node_T target = NULL;
+   size_t added;
+   int status;
+
+   assert(pcDir != NULL);
+   assert(pcPath != NULL);
+
+   status = FT_insert(pcPath, FALSE, NULL, 0);
+   if (status != SUCCESS) {
+      return status;
+   }
+   (void) FT_findNode(root, pcPath, &target);
+
+   status = Disk_import(pcDir, target, &added);
+   count += added;
+   /* the imported contents are only known once read, so their
+      records follow them, and the import is taken back if they cannot
+      all be appended */
+   if (status == SUCCESS) {
+      status = FT_logSubtree(target);
+      if (status != SUCCESS) {
+         (void) FT_log(JOURNAL_RM_DIR, pcPath, 0, NULL, 0);
+      }
+      (void) FT_settleLog(SUCCESS);
+   }
+
+   if (status != SUCCESS) {
+      (void) FT_rm(pcPath, FALSE);
+   }
+   else {
+      Watch_notify(FT_EVENT_CREATE, pcPath);
+   }
+   return status;
+}
+
+/*
+  Exports the whole FT into the local directory pcDir (created if it
+  does not exist): the root becomes a directory of pcDir, and every
+  directory and file below it a directory or file below that. Existing
+  directories are reused and existing files overwritten. Sets
+  *pulFiles and *pulBytes to the number of files and bytes written,
+  and *pdSeconds to the time the export took, from which throughput
+  in files/s and bytes/s follows. Returns SUCCESS if the FT was
+  exported. Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * IO_ERROR if something could not be created or written
+*/
+int FT_exportToDisk(const char *pcDir, size_t *pulFiles,
+                    size_t *pulBytes, double *pdSeconds) {
+   assert(pcDir != NULL);
+   assert(pulFiles != NULL);
+   assert(pulBytes != NULL);
+   assert(pdSeconds != NULL);
+
+   if (!isInitialized) {
+      return INITIALIZATION_ERROR;
+   }
+
+   if (root == NULL) {
+      *pulFiles = 0;
+      *pulBytes = 0;
+      *pdSeconds = 0;
+      return SUCCESS;
+   }
+   return Disk_export(root, pcDir, pulFiles, pulBytes, pdSeconds);
+}
+
+/*
+  Sets the FT data structure to an initialized state.
+  The data structure is initially empty.
+  Returns INITIALIZATION_ERROR if already initialized,
+  and SUCCESS otherwise.
+*/
+int FT_init(void) {
+   /* If FT is already initialized, return INITIALIZATION_ERROR */
+   if(isInitialized)
+      return INITIALIZATION_ERROR;
+
+   isInitialized = TRUE;
+   root = NULL;
+   count = 0;
+
+   return SUCCESS;
+}
+
+/*
+  Removes all contents of the data structure and
+  returns it to an uninitialized state.
+  Returns INITIALIZATION_ERROR if not already initialized,
+  and SUCCESS otherwise.
+*/
+int FT_destroy(void) {
+   struct ftSnapshot *snapshot;
+
+   /* Return INITIALIZATION_ERROR if FT is uninitialized */
+   if (!isInitialized) {
+      return INITIALIZATION_ERROR;
+   }
+
+   /* snapshots still held become empty, since their contents may lie
+      in the mapping or the spill store closed below; closing them
+      first leaves freeing the tree nothing to copy into them */
+   while (psSnapshots != NULL) {
+      snapshot = psSnapshots;
+      psSnapshots = snapshot->psNext;
+      if (snapshot->oVView != NULL) {
+         Node_closeView(snapshot->oVView);
+         snapshot->oVView = NULL;
+      }
+      snapshot->psNext = NULL;
+      snapshot->psPrev = NULL;
+   }
+
+   /* an open transaction's changes are dropped with the tree, and its
+      records with the journal below */
+   if (oDChanges != NULL) {
+      FT_endTransaction();
+   }
+   if (root != NULL) {
+      count -= Node_free(root);
+      root = NULL;
+   }
+   (void) Journal_close();
+   Watch_clear();
+   free(pcCheckpointFile);
+   pcCheckpointFile = NULL;
+   if (pvMap != NULL) {
+      Snapshot_unmap(pvMap, ulMapLength);
+      pvMap = NULL;
+   }
+   Node_stopIndex();
+   Dcache_stop();
+   Node_setBudget(0);
+   Spill_close();
+
+   isInitialized = FALSE;
+   return SUCCESS;
+}
+
+/*-------------------------------------------------------------------*/
+
+/* The absolute path of the node a walk of a tree is at */
+struct ftPathBuf {
+   /* the path, NUL-terminated, its length, and the number of bytes
+      allocated for it */
+   char *pcPath;
+   size_t ulLength;
+   size_t ulCapacity;
+};
+
+/*
+  Extends the path psBuf with the component pcName, preceded by a '/'
+  unless the path is empty. Returns SUCCESS, or MEMORY_ERROR if the
+  path could not be grown. FT_pathLeave undoes it.
+*/
+static int FT_pathEnter(struct ftPathBuf *psBuf, const char *pcName) {
+   enum {MIN_CAPACITY = 64, GROWTH_FACTOR = 2};
+   size_t needed;
+   size_t newCapacity;
+   char *grown;
+
+   assert(psBuf != NULL);
+   assert(pcName != NULL);
+
+   needed = psBuf->ulLength + 1 + strlen(pcName) + 1;
+   if (needed > psBuf->ulCapacity) {
+      newCapacity = psBuf->ulCapacity < MIN_CAPACITY ?
+                    MIN_CAPACITY : psBuf->ulCapacity;
+      while (newCapacity < needed) {
+         newCapacity *= GROWTH_FACTOR;
+      }
+      grown = realloc(psBuf->pcPath, newCapacity);
+      if (grown == NULL) {
+         return MEMORY_ERROR;
+      }
+      psBuf->pcPath = grown;
+      psBuf->ulCapacity = newCapacity;
+   }
+
+   if (psBuf->ulLength != 0) {
+      psBuf->pcPath[psBuf->ulLength++] = '/';
+   }
+   strcpy(psBuf->pcPath + psBuf->ulLength, pcName);
+   psBuf->ulLength += strlen(pcName);
+   return SUCCESS;
+}
+
+/* Cuts the path psBuf back to its first ulLength bytes. */
+static void FT_pathLeave(struct ftPathBuf *psBuf, size_t ulLength) {
+   assert(psBuf != NULL);
+
+   psBuf->ulLength = ulLength;
+   psBuf->pcPath[ulLength] = '\0';
+}
+
+/*-------------------------------------------------------------------*/
+
+/*
+  The following auxiliary functions are used for generating the
+  string representation of the FT.
+*/
+
+/*
+  Appends a newly allocated copy of pcPath, which is then owned by the
+  caller, to oDPaths. Returns SUCCESS, or MEMORY_ERROR if there is an
+  allocation error.
+*/
+static int FT_addPath(DynArray_T oDPaths, const char *pcPath) {
+   char *copy;
+
+   assert(oDPaths != NULL);
+   assert(pcPath != NULL);
+
+   copy = malloc(strlen(pcPath) + 1);
+   if (copy == NULL) {
+      return MEMORY_ERROR;
+   }
+   strcpy(copy, pcPath);
+   if (!DynArray_add(oDPaths, copy)) {
+      free(copy);
+      return MEMORY_ERROR;
+   }
+   return SUCCESS;
+}
+
+/*
+  Appends to oDPaths the path of directory oNDir, which psPath holds,
+  followed by the paths of its file children in sorted order, as by
+  FT_addPath. Returns SUCCESS, or MEMORY_ERROR if there is an
+  allocation error.
+*/
+static int FT_listDir(DynArray_T oDPaths, struct ftPathBuf *psPath,
+                      Node_T oNDir) {
+   size_t length;
+   size_t i;
+   Node_T child = NULL;
+   int status;
+
+   assert(oDPaths != NULL);
+   assert(psPath != NULL);
+   assert(oNDir != NULL);
+
+   length = psPath->ulLength;
+   status = FT_addPath(oDPaths, psPath->pcPath);
+   for (i = 0; status == SUCCESS && i < Node_getNumChildren(oNDir);
+        i++) {
+      (void) Node_getChild(oNDir, i, &child);
+      if (Node_isFile(child)) {
+         status = FT_pathEnter(psPath, Node_getName(child));
+         if (status == SUCCESS) {
+            status = FT_addPath(oDPaths, psPath->pcPath);
+            FT_pathLeave(psPath, length);
+         }
+      }
+   }
+   return status;
+}
+
+/*
+  Returns the first directory child of oNDir with an identifier of at
+  least ulChildID, or NULL if there is none.
+*/
+static Node_T FT_nextDir(Node_T oNDir, size_t ulChildID) {
+   Node_T child = NULL;
+
+   assert(oNDir != NULL);
+
+   for (; ulChildID < Node_getNumChildren(oNDir); ulChildID++) {
+      (void) Node_getChild(oNDir, ulChildID, &child);
+      if (!Node_isFile(child)) {
+         return child;
+      }
+   }
+   return NULL;
+}
+
+/*
+  Appends to oDPaths, as by FT_addPath, the path of each node in the
+  tree rooted at oNRoot, in pre-order with each directory's files
+  before its directories. The paths are built on the way down, with a
+  stack of the directories above the one being listed, rather than
+  from parent links, which lead from the nodes a snapshot shares with
+  the FT into the FT's tree. Returns SUCCESS, or MEMORY_ERROR if
+  there is an allocation error, in which case the paths appended so
+  far are left in oDPaths.
+*/
+static int FT_listPaths(Node_T oNRoot, DynArray_T oDPaths) {
+   struct ftPathBuf path;
+   DynArray_T above;
+   Node_T dir = oNRoot;
+   Node_T next;
+   size_t index;
+   int status;
+
+   assert(oDPaths != NULL);
+
+   if (oNRoot == NULL) {
+      return SUCCESS;
+   }
+   above = DynArray_new(0);
+   if (above == NULL) {
+      return MEMORY_ERROR;
+   }
+   path.pcPath = NULL;
+   path.ulLength = 0;
+   path.ulCapacity = 0;
+
+   status = FT_pathEnter(&path, Node_getName(oNRoot));
+   while (status == SUCCESS) {
+      status = FT_listDir(oDPaths, &path, dir);
+      if (status != SUCCESS) {
+         break;
+      }
+
+      /* go down to dir's first directory child, or else back up to
+         the next one of the nearest directory above that has one */
+      next = FT_nextDir(dir, 0);
+      while (next == NULL && DynArray_getLength(above) != 0) {
+         FT_pathLeave(&path, path.ulLength -
+                      strlen(Node_getName(dir)) - 1);
+         next = DynArray_removeAt(above,
+                                  DynArray_getLength(above) - 1);
+         (void) Node_hasChild(next, Node_getName(dir), &index);
+         dir = next;
+         next = FT_nextDir(dir, index + 1);
+      }
+      if (next == NULL) {
+         break;
+      }
+
+      if (!DynArray_add(above, dir)) {
+         status = MEMORY_ERROR;
+      }
+      else {
+         status = FT_pathEnter(&path, Node_getName(next));
+         dir = next;
+      }
+   }
+
+   free(path.pcPath);
+   DynArray_free(above);
+   return status;
+}
+
+/*
+  Alternate version of strlen that uses pulAcc as an in-out parameter
+  to accumulate a string length, rather than returning the length of
+  pcPath, and also always adds one addition byte to the sum.
+*/
+static void FT_strlenAccumulate(char *pcPath, size_t *pulAcc) {
+   assert(pulAcc != NULL);
+
+   if (pcPath != NULL) {
+      *pulAcc += (strlen(pcPath) + 1);
+   }
+}
+
+/*
+  Alternate version of strcat that inverts the typical argument
+  order, appending pcPath onto pcAcc, and also always adds one
+  newline at the end of the concatenated string.
+*/
+static void FT_strcatAccumulate(char *pcPath, char *pcAcc) {
+   assert(pcAcc != NULL);
+
+   if (pcPath != NULL) {
+      strcat(pcAcc, pcPath);
+      strcat(pcAcc, "\n");
+   }
+}
+
+/* Frees the path pvPath, for DynArray_map. */
+static void FT_freePath(void *pvPath, void *pvExtra) {
+   free(pvPath);
+}
+
+/*
+  Returns a string representation of the tree rooted at oNRoot, as
+  described for FT_toString, or NULL if there is an allocation error.
+*/
+static char *FT_treeToString(Node_T oNRoot) {
+   DynArray_T paths;
+   size_t totalStrlen = 1;
+   char *result = NULL;
+
+   paths = DynArray_new(0);
+   if (paths == NULL) {
+      return NULL;
+   }
+   if (FT_listPaths(oNRoot, paths) != SUCCESS) {
+      DynArray_map(paths, FT_freePath, NULL);
+      DynArray_free(paths);
+      return NULL;
+   }
+
+   DynArray_map(paths, (void (*)(void *, void *)) FT_strlenAccumulate,
+                (void *) &totalStrlen);
+
+   result = malloc(totalStrlen);
+   if (result == NULL) {
+      DynArray_map(paths, FT_freePath, NULL);
+      DynArray_free(paths);
+      return NULL;
+   }
+   *result = '\0';
+
+   DynArray_map(paths, (void (*)(void *, void *)) FT_strcatAccumulate,
+                (void *) result);
+
+   DynArray_map(paths, FT_freePath, NULL);
+   DynArray_free(paths);
+   return result;
+}
+
+/*-------------------------------------------------------------------*/
+
+/*
+  Returns a string representation of the
+  data structure, or NULL if the structure is
+  not initialized or there is an allocation error.
+
+  The representation is depth-first with files
+  before directories at any given level, and nodes
+  of the same type ordered lexicographically.
+
+  Allocates memory for the returned string,
+  which is then owned by client!
+*/
+char *FT_toString(void) {
+   /* Return NULL if FT is uninitialized */
+   if (!isInitialized) {
+      return NULL;
+   }
+
+   return FT_treeToString(root);
+}
+
+/*-------------------------------------------------------------------*/
+
+/*
+  Takes a snapshot of the FT: a read-only view of the FT as it is now,
+  which later changes to the FT do not affect. Taking it costs
+  constant time, since the snapshot shares the FT's tree: a change to
+  a node that a snapshot still sees first copies the node into it,
+  with each of its ancestors not yet copied, sharing their contents
+  and other children as described for FT_copy, and so costs time
+  proportional to the depth of the change for each snapshot held.
+  Sets *poSResult to the snapshot, which must be released with
+  FT_releaseSnapshot, and returns SUCCESS. Otherwise, sets *poSResult
+  to NULL and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * MEMORY_ERROR if memory could not be allocated to complete request
+
+  Changes to the FT never fail for want of memory to copy nodes into a
+  snapshot; the snapshot is lost instead, and reading it then fails
+  with MEMORY_ERROR. Contents owned by the client are shared by
+  pointer, so the client must leave them unchanged while a snapshot
+  may refer to them. A snapshot still held when the FT is destroyed
+  becomes empty.
+*/
+int FT_snapshot(FT_Snapshot_T *poSResult) {
+   struct ftSnapshot *snapshot;
+   int status;
+
+   assert(poSResult != NULL);
+
+   *poSResult = NULL;
+   if (!isInitialized) {
+      return INITIALIZATION_ERROR;
+   }
+
+   snapshot = malloc(sizeof(struct ftSnapshot));
+   if (snapshot == NULL) {
+      return MEMORY_ERROR;
+   }
+   snapshot->oVView = NULL;
+   if (root != NULL) {
+      status = Node_openView(root, &snapshot->oVView);
+      if (status != SUCCESS) {
+         free(snapshot);
+         return status;
+      }
+   }
+
+   snapshot->psPrev = NULL;
+   snapshot->psNext = psSnapshots;
+   if (psSnapshots != NULL) {
+      psSnapshots->psPrev = snapshot;
+   }
+   psSnapshots = snapshot;
+
+   *poSResult = snapshot;
+   return SUCCESS;
+}
+
+/*
+  Sets *poNResult to the root of snapshot oSSnapshot's tree, or to
+  NULL if the tree is empty, and returns SUCCESS, or returns
+  MEMORY_ERROR if the snapshot was lost (see FT_snapshot).
+*/
+static int FT_snapshotRoot(FT_Snapshot_T oSSnapshot,
+                           Node_T *poNResult) {
+   assert(oSSnapshot != NULL);
+   assert(poNResult != NULL);
+
+   *poNResult = NULL;
+   if (oSSnapshot->oVView == NULL) {
+      return SUCCESS;
+   }
+   *poNResult = Node_getViewRoot(oSSnapshot->oVView);
+   if (*poNResult == NULL) {
+      return MEMORY_ERROR;
+   }
+   return SUCCESS;
+}
+
+/*
+  Looks up absolute path pcPath in snapshot oSSnapshot, returning the
+  statuses and setting *pbIsFile and *pulSize as described for
+  FT_stat, or returning MEMORY_ERROR if the snapshot was lost.
+*/
+int FT_snapshotStat(FT_Snapshot_T oSSnapshot, const char *pcPath,
+                    boolean *pbIsFile, size_t *pulSize) {
+   Node_T snapshotRoot = NULL;
+   int status;
+
+   assert(oSSnapshot != NULL);
+   assert(pcPath != NULL);
+   assert(pbIsFile != NULL);
+   assert(pulSize != NULL);
+
+   status = FT_snapshotRoot(oSSnapshot, &snapshotRoot);
+   if (status != SUCCESS) {
+      return status;
+   }
+   return FT_statIn(snapshotRoot, pcPath, pbIsFile, pulSize);
+}
+
+/*
+  Copies up to ulLength bytes of the contents of the file with
+  absolute path pcPath in snapshot oSSnapshot, starting at byte
+  ulOffset, into pvBuf, returning the statuses and setting *pulRead as
+  described for FT_readFileRange, or returning MEMORY_ERROR if the
+  snapshot was lost.
+*/
+int FT_snapshotRead(FT_Snapshot_T oSSnapshot, const char *pcPath,
+                    size_t ulOffset, void *pvBuf, size_t ulLength,
+                    size_t *pulRead) {
+   Node_T snapshotRoot = NULL;
+   Node_T found = NULL;
+   int status;
+
+   assert(oSSnapshot != NULL);
+   assert(pcPath != NULL);
+   assert(pvBuf != NULL || ulLength == 0);
+   assert(pulRead != NULL);
+
+   status = FT_snapshotRoot(oSSnapshot, &snapshotRoot);
+   if (status == SUCCESS) {
+      status = FT_findFile(snapshotRoot, pcPath, &found);
+   }
+   if (status != SUCCESS) {
+      return status;
+   }
+
+   return Node_readRange(found, ulOffset, pvBuf, ulLength, pulRead);
+}
+
+/*
+  Returns a string representation of snapshot oSSnapshot, as described
+  for FT_toString, or NULL if there is an allocation error or the
+  snapshot was lost.
+
+  Allocates memory for the returned string,
+  which is then owned by client!
+*/
+char *FT_snapshotToString(FT_Snapshot_T oSSnapshot) {
+   Node_T snapshotRoot = NULL;
+
+   assert(oSSnapshot != NULL);
+
+   if (FT_snapshotRoot(oSSnapshot, &snapshotRoot) != SUCCESS) {
+      return NULL;
+   }
+   return FT_treeToString(snapshotRoot);
+}
+
+/*
+  Releases snapshot oSSnapshot, freeing its copies of the FT's nodes
+  and the nodes removed from the FT that it was the last to see.
+  Contents it shared with the FT are freed once nothing else shares
+  them.
+*/
+void FT_releaseSnapshot(FT_Snapshot_T oSSnapshot) {
+   assert(oSSnapshot != NULL);
+
+   if (oSSnapshot->psPrev != NULL) {
+      oSSnapshot->psPrev->psNext = oSSnapshot->psNext;
+   }
+   else if (psSnapshots == oSSnapshot) {
+      psSnapshots = oSSnapshot->psNext;
+   }
+   if (oSSnapshot->psNext != NULL) {
+      oSSnapshot->psNext->psPrev = oSSnapshot->psPrev;
+   }
+
+   if (oSSnapshot->oVView != NULL) {
+      Node_closeView(oSSnapshot->oVView);
+   }
+   free(oSSnapshot);
+}
+
+/*-------------------------------------------------------------------*/
+
+/* The state of a walk of two trees by FT_diff */
+struct ftDiffWalk {
+   /* the absolute path of the nodes being compared */
+   struct ftPathBuf sPath;
+   /* the nodes above those being compared, from the top of the walk
+      down (for FT_diffNodes, the pairs of directories being merged,
+      each from-node before its to-node), kept on a stack because the
+      parent links of the nodes a snapshot shares with the FT lead into
+      the FT's tree instead */
+   DynArray_T oDAbove;
+   /* the function to report differences to, and its extra argument */
+   int (*pfReport)(const struct ftDiffRecord *, void *);
+   void *pvExtra;
+};
+
+/*
+  Reports a difference of kind eKind at node oNNode, whose path is
+  the path of walk psWalk, with oNNode's contents for an added or
+  modified file. Returns SUCCESS, IO_ERROR if the contents could not
+  be read, or the status pfReport returned.
+*/
+static int FT_diffReport(struct ftDiffWalk *psWalk,
+                         enum ftDiffKind eKind, Node_T oNNode) {
+   struct ftDiffRecord record;
+
+   assert(psWalk != NULL);
+   assert(oNNode != NULL);
+
+   record.eKind = eKind;
+   record.pcPath = psWalk->sPath.pcPath;
+   record.isFile = Node_isFile(oNNode);
+   record.pvContents = NULL;
+   record.ulLength = 0;
+   if (record.isFile && eKind != FT_DIFF_REMOVE) {
+      record.pvContents = Node_getContents(oNNode);
+      record.ulLength = Node_getLength(oNNode);
+      if (record.pvContents == NULL && record.ulLength != 0) {
+         return IO_ERROR;
+      }
+   }
+   return psWalk->pfReport(&record, psWalk->pvExtra);
+}
+
+/*
+  Pops the parent of node oNNode off the stack of walk psWalk, sets
+  *pulIndex to oNNode's index among the parent's children, and returns
+  the parent.
+*/
+static Node_T FT_diffPop(struct ftDiffWalk *psWalk, Node_T oNNode,
+                         size_t *pulIndex) {
+   Node_T parent;
+
+   assert(psWalk != NULL);
+   assert(oNNode != NULL);
+   assert(pulIndex != NULL);
+
+   parent = DynArray_removeAt(psWalk->oDAbove,
+                              DynArray_getLength(psWalk->oDAbove) - 1);
+   (void) Node_hasChild(parent, Node_getName(oNNode), pulIndex);
+   return parent;
+}
+
+/*
+  Takes the path of walk psWalk from that of node oNNode back up to
+  that of its parent, which is popped off the walk's stack, sets
+  *pulIndex to oNNode's index among the parent's children, and returns
+  the parent.
+*/
+static Node_T FT_diffClimb(struct ftDiffWalk *psWalk, Node_T oNNode,
+                           size_t *pulIndex) {
+   assert(psWalk != NULL);
+   assert(oNNode != NULL);
+   assert(pulIndex != NULL);
+
+   FT_pathLeave(&psWalk->sPath, psWalk->sPath.ulLength -
+                strlen(Node_getName(oNNode)) - 1);
+   return FT_diffPop(psWalk, oNNode, pulIndex);
+}
+
+/*
+  Reports node oNNode, whose path is the path of walk psWalk, and
+  everything below it as added, parents first, keeping the nodes
+  above the one reported on the walk's stack instead of recursing.
+  Returns the statuses of FT_diff.
+*/
+static int FT_diffAdd(struct ftDiffWalk *psWalk, Node_T oNNode) {
+   size_t length;
+   size_t index;
+   Node_T node = oNNode;
+   Node_T child = NULL;
+   int status;
+
+   assert(psWalk != NULL);
+   assert(oNNode != NULL);
+
+   length = psWalk->sPath.ulLength;
+   status = FT_diffReport(psWalk, FT_DIFF_ADD, node);
+   while (status == SUCCESS) {
+      /* go down to node's first child, or else back up to the next
+         child of the nearest node on the way up that has one */
+      index = 0;
+      while (index == Node_getNumChildren(node)) {
+         if (node == oNNode) {
+            return SUCCESS;
+         }
+         node = FT_diffClimb(psWalk, node, &index);
+         index++;
+      }
+
+      (void) Node_getChild(node, index, &child);
+      if (!DynArray_add(psWalk->oDAbove, node)) {
+         status = MEMORY_ERROR;
+         break;
+      }
+      status = FT_pathEnter(&psWalk->sPath, Node_getName(child));
+      if (status == SUCCESS) {
+         node = child;
+         status = FT_diffReport(psWalk, FT_DIFF_ADD, node);
+      }
+   }
+   FT_pathLeave(&psWalk->sPath, length);
+   return status;
+}
+
+/*
+  Reports the differences between oNFrom and oNTo, which have the same
+  name and whose path is the path of walk psWalk, that can be told
+  without comparing their children, skipping them if their hashes are
+  equal. Sets *pisDiffering to TRUE if they are directories whose
+  children differ, which are left to the caller, and to FALSE
+  otherwise. Returns the statuses of FT_diff.
+*/
+static int FT_diffPair(struct ftDiffWalk *psWalk, Node_T oNFrom,
+                       Node_T oNTo, boolean *pisDiffering) {
+   unsigned long fromHash, toHash;
+   int status;
+
+   assert(psWalk != NULL);
+   assert(oNFrom != NULL);
+   assert(oNTo != NULL);
+   assert(pisDiffering != NULL);
+
+   *pisDiffering = FALSE;
+   if (Node_isFile(oNFrom) != Node_isFile(oNTo)) {
+      status = FT_diffReport(psWalk, FT_DIFF_REMOVE, oNFrom);
+      if (status == SUCCESS) {
+         status = FT_diffAdd(psWalk, oNTo);
+      }
+      return status;
+   }
+
+   status = Node_getHash(oNFrom, &fromHash);
+   if (status == SUCCESS) {
+      status = Node_getHash(oNTo, &toHash);
+   }
+   if (status != SUCCESS || fromHash == toHash) {
+      return status;
+   }
+   if (Node_isFile(oNTo)) {
+      return FT_diffReport(psWalk, FT_DIFF_MODIFY, oNTo);
+   }
+   *pisDiffering = TRUE;
+   return SUCCESS;
+}
+
+/*
+  Reports the differences between the subtrees rooted at oNFrom and
+  oNTo, which have the same name and whose path is the path of walk
+  psWalk, skipping them if their hashes are equal. Descends into
+  differing pairs of directories and climbs back out of them by the
+  walk's stack, instead of recursing. Returns the statuses of
+  FT_diff.
+*/
+static int FT_diffNodes(struct ftDiffWalk *psWalk, Node_T oNFrom,
+                        Node_T oNTo) {
+   size_t length;
+   size_t childLength;
+   size_t i = 0, j = 0;
+   size_t numFrom, numTo;
+   Node_T from = oNFrom;
+   Node_T to = oNTo;
+   Node_T fromChild = NULL;
+   Node_T toChild = NULL;
+   boolean isDiffering;
+   int comparison;
+   int status;
+
+   assert(psWalk != NULL);
+   assert(oNFrom != NULL);
+   assert(oNTo != NULL);
+
+   status = FT_diffPair(psWalk, from, to, &isDiffering);
+   if (status != SUCCESS || !isDiffering) {
+      return status;
+   }
+
+   /* merge the sorted arrays of children of from and to, the pair of
+      differing directories being compared */
+   length = psWalk->sPath.ulLength;
+   while (status == SUCCESS) {
+      numFrom = Node_getNumChildren(from);
+      numTo = Node_getNumChildren(to);
+
+      /* a merged pair is done, so go back up to its parents' merge,
+         which goes on after it */
+      if (i == numFrom && j == numTo) {
+         if (from == oNFrom) {
+            break;
+         }
+         to = FT_diffPop(psWalk, to, &j);
+         from = FT_diffClimb(psWalk, from, &i);
+         i++;
+         j++;
+         continue;
+      }
+
+      if (i < numFrom) {
+         (void) Node_getChild(from, i, &fromChild);
+      }
+      if (j < numTo) {
+         (void) Node_getChild(to, j, &toChild);
+      }
+      if (i == numFrom) {
+         comparison = 1;
+      }
+      else if (j == numTo) {
+         comparison = -1;
+      }
+      else {
+         comparison = strcmp(Node_getName(fromChild),
+                             Node_getName(toChild));
+      }
+
+      childLength = psWalk->sPath.ulLength;
+      status = FT_pathEnter(&psWalk->sPath, comparison <= 0 ?
+                            Node_getName(fromChild) :
+                            Node_getName(toChild));
+      if (status != SUCCESS) {
+         break;
+      }
+      if (comparison < 0) {
+         status = FT_diffReport(psWalk, FT_DIFF_REMOVE, fromChild);
+         i++;
+      }
+      else if (comparison > 0) {
+         status = FT_diffAdd(psWalk, toChild);
+         j++;
+      }
+      else {
+         status = FT_diffPair(psWalk, fromChild, toChild,
+                              &isDiffering);
+         if (status == SUCCESS && isDiffering) {
+            /* merge the children of the pair next, under its path */
+            if (!DynArray_add(psWalk->oDAbove, from) ||
+                !DynArray_add(psWalk->oDAbove, to)) {
+               status = MEMORY_ERROR;
+               break;
+            }
+            from = fromChild;
+            to = toChild;
+            i = 0;
+            j = 0;
+            continue;
+         }
+         i++;
+         j++;
+      }
+      FT_pathLeave(&psWalk->sPath, childLength);
+   }
+   FT_pathLeave(&psWalk->sPath, length);
+   return status;
+}
+
+/*
+  Reports the differences between two trees, each either a snapshot
+  or the FT itself (when oSFrom or oSTo is NULL), as the records that
+  would turn the tree oSFrom into the tree oSTo, passing each in turn
+  to pfReport along with pvExtra. An added directory is reported
+  before everything below it, each of which is reported as added too;
+  a removed directory is reported once, for its whole subtree; and a
+  directory or file that changes type is reported removed and then
+  added. The trees are walked in lockstep over their sorted children,
+  and subtrees whose hashes are equal (see FT_subtreeHash) are skipped
+  without being entered, so the time taken grows with the size of the
+  differences rather than the size of the trees. A record's path and
+  contents are only valid during the call. Returns SUCCESS if every
+  difference was reported. Otherwise, stops and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * MEMORY_ERROR if memory could not be allocated to complete request,
+                 or either snapshot was lost (see FT_snapshot)
+  * IO_ERROR if spilled contents could not be read
+  * the first status other than SUCCESS that pfReport returned
+*/
+int FT_diff(FT_Snapshot_T oSFrom, FT_Snapshot_T oSTo,
+            int (*pfReport)(const struct ftDiffRecord *psRecord,
+                            void *pvExtra),
+            void *pvExtra) {
+   struct ftDiffWalk walk;
+   Node_T from = root;
+   Node_T to = root;
+   int status = SUCCESS;
+
+   assert(pfReport != NULL);
+
+   if (!isInitialized) {
+      return INITIALIZATION_ERROR;
+   }
+
+   if (oSFrom != NULL) {
+      status = FT_snapshotRoot(oSFrom, &from);
+   }
+   if (status == SUCCESS && oSTo != NULL) {
+      status = FT_snapshotRoot(oSTo, &to);
+   }
+   if (status != SUCCESS) {
+      return status;
+   }
+   walk.oDAbove = DynArray_new(0);
+   if (walk.oDAbove == NULL) {
+      return MEMORY_ERROR;
+   }
+   walk.sPath.pcPath = NULL;
+   walk.sPath.ulLength = 0;
+   walk.sPath.ulCapacity = 0;
+   walk.pfReport = pfReport;
+   walk.pvExtra = pvExtra;
+
+   if (from != NULL && (to == NULL ||
+       strcmp(Node_getName(from), Node_getName(to)) != 0)) {
+      status = FT_pathEnter(&walk.sPath, Node_getName(from));
+      if (status == SUCCESS) {
+         status = FT_diffReport(&walk, FT_DIFF_REMOVE, from);
+         FT_pathLeave(&walk.sPath, 0);
+      }
+      from = NULL;
+   }
+   if (status == SUCCESS && to != NULL) {
+      status = FT_pathEnter(&walk.sPath, Node_getName(to));
+      if (status == SUCCESS && from == NULL) {
+         status = FT_diffAdd(&walk, to);
+      }
+      else if (status == SUCCESS) {
+         status = FT_diffNodes(&walk, from, to);
+      }
+   }
+
+   free(walk.sPath.pcPath);
+   DynArray_free(walk.oDAbove);
+   return status;
+}
+
+/*
+  Applies the record psRecord to the FT, as described for
+  FT_applyPatch, within the transaction that FT_applyPatch keeps open,
+  and records it in the journal if changes are being journaled.
+  Returns the statuses given there.
+*/
+static int FT_applyDiff(const struct ftDiffRecord *psRecord) {
+   Node_T found = NULL;
+   boolean isInserted = FALSE;
+   int status;
+
+   assert(psRecord != NULL);
+   assert(psRecord->pcPath != NULL);
+
+   if (psRecord->eKind == FT_DIFF_REMOVE) {
+      return psRecord->isFile ? FT_rmFile(psRecord->pcPath) :
+                                FT_rmDir(psRecord->pcPath);
+   }
+   if (!psRecord->isFile) {
+      return psRecord->eKind == FT_DIFF_ADD ?
+             FT_insertDir(psRecord->pcPath) : NOT_A_FILE;
+   }
+
+   status = FT_log(psRecord->eKind == FT_DIFF_ADD ?
+                   JOURNAL_INSERT_FILE : JOURNAL_REPLACE,
+                   psRecord->pcPath, 0, psRecord->pvContents,
+                   psRecord->ulLength);
+   if (status != SUCCESS) {
+      return status;
+   }
+
+   /* the new contents are held to the quotas above the file, and an
+      added file is taken back out if they do not fit */
+   if (psRecord->eKind == FT_DIFF_ADD) {
+      status = FT_insert(psRecord->pcPath, TRUE, NULL, 0);
+      isInserted = (boolean) (status == SUCCESS);
+   }
+   if (status == SUCCESS) {
+      status = FT_findFile(root, psRecord->pcPath, &found);
+   }
+   if (status == SUCCESS) {
+      status = FT_checkGrowth(found, psRecord->ulLength);
+   }
+   if (status == SUCCESS && !isInserted) {
+      status = FT_keepContents(found);
+   }
+   if (status == SUCCESS) {
+      status = FT_restoreContents(psRecord->pcPath,
+                                  psRecord->pvContents,
+                                  psRecord->ulLength);
+   }
+   if (status != SUCCESS && isInserted) {
+      FT_dropInsert();
+   }
+   status = FT_settleLog(status);
+   if (status == SUCCESS) {
+      Watch_notify(psRecord->eKind == FT_DIFF_ADD ?
+                   FT_EVENT_CREATE : FT_EVENT_MODIFY, psRecord->pcPath);
+   }
+   return status;
+}
+
+/*
+  Applies the ulCount records at psRecords, such as those reported by
+  FT_diff, to the FT in order, as one transaction (see FT_begin):
+  either every record is applied, or none is and the FT is left as it
+  was. Added and modified files get FT-owned copies of the records'
+  contents (see FT_replaceFileContents), held to the quotas of the
+  directories above them. If a transaction is already open, the
+  records are applied as part of it instead, and if one fails the
+  records before it are left for FT_abort to take back.
+  Returns SUCCESS if every record was applied. Otherwise, returns the
+  status of the first record that could not be, as for FT_insertDir,
+  FT_insertFile, FT_rmDir, FT_rmFile, and FT_writeFileRange, or:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+*/
+int FT_applyPatch(const struct ftDiffRecord *psRecords,
+                  size_t ulCount) {
+   boolean isOwnTransaction;
+   size_t i;
+   int status = SUCCESS;
+
+   assert(psRecords != NULL || ulCount == 0);
+
+   if (!isInitialized) {
+      return INITIALIZATION_ERROR;
+   }
+
+   isOwnTransaction = (boolean) (oDChanges == NULL);
+   if (isOwnTransaction) {
+      status = FT_begin();
+   }
+   for (i = 0; status == SUCCESS && i < ulCount; i++) {
+      status = FT_applyDiff(&psRecords[i]);
+   }
+
+   if (isOwnTransaction && status == SUCCESS) {
+      status = FT_commit();
+   }
+   else if (isOwnTransaction && oDChanges != NULL) {
+      (void) FT_abort();
+   }
+   return status;
+}
+
+/*-------------------------------------------------------------------*/
+
+/*
+  Starts watching the subtree at absolute path pcPath, which need not
+  exist yet, for the kinds of change in uiKinds (FT_EVENT_CREATE,
+  FT_EVENT_REMOVE, and FT_EVENT_MODIFY, OR-ed together), and sets
+  *pulWatch to the watch's identifier. From then on, every change
+  made to the subtree through the FT's functions, including the
+  creation or removal of pcPath along with an ancestor and the changes
+  FT_abort takes back, queues an event in a bounded ring for
+  FT_drainEvents. A move is reported as a removal at its source and a
+  creation at its destination. An event repeating the path and watch
+  of the newest queued event is folded into it. When the ring is full,
+  events are dropped and the overflow is flagged. Changes rebuilt by
+  FT_load, FT_loadMapped, or FT_openJournal are not reported. When
+  nothing is watched, changes cost only a test. Returns SUCCESS, or:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_watch(const char *pcPath, unsigned int uiKinds,
+             size_t *pulWatch) {
+   Path_T path = NULL;
+   int status;
+
+   assert(pcPath != NULL);
+   assert(pulWatch != NULL);
+
+   if (!isInitialized) {
+      return INITIALIZATION_ERROR;
+   }
+
+   status = Path_new(pcPath, &path);
+   if (status != SUCCESS) {
+      return status;
+   }
+   Path_free(path);
+
+   return Watch_add(pcPath, uiKinds, pulWatch);
+}
+
+/*
+  Stops the watch with identifier ulWatch, leaving its queued events
+  to be drained. Returns SUCCESS, or:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * NO_SUCH_PATH if there is no such watch
+*/
+int FT_unwatch(size_t ulWatch) {
+   if (!isInitialized) {
+      return INITIALIZATION_ERROR;
+   }
+
+   return Watch_remove(ulWatch);
+}
+
+/*
+  Moves up to ulMax of the oldest queued events into psEvents, oldest
+  first, and sets *pulCount to the number moved; their paths must be
+  freed by the client. Sets *pbOverflowed to TRUE if events were
+  dropped since the last drain, in which case the client should look
+  at its watched subtrees afresh, and to FALSE otherwise. Returns
+  SUCCESS, or INITIALIZATION_ERROR if the FT is not in an initialized
+  state. FT_destroy stops every watch and frees every queued event.
+*/
+int FT_drainEvents(struct ftEvent *psEvents, size_t ulMax,
+                   size_t *pulCount, boolean *pbOverflowed) {
+   struct watchEvent event;
+   size_t drained;
+   boolean isOverflowed;
+
+   assert(psEvents != NULL || ulMax == 0);
+   assert(pulCount != NULL);
+   assert(pbOverflowed != NULL);
+
+   if (!isInitialized) {
+      return INITIALIZATION_ERROR;
+   }
+
+   /* events are moved one at a time, since the two event types are
+      kept apart */
+   Watch_drain(NULL, 0, &drained, pbOverflowed);
+   for (*pulCount = 0; *pulCount < ulMax; (*pulCount)++) {
+      Watch_drain(&event, 1, &drained, &isOverflowed);
+      if (drained == 0) {
+         break;
+      }
+      psEvents[*pulCount].ulWatch = event.ulWatch;
+      psEvents[*pulCount].uiKinds = event.uiKinds;
+      psEvents[*pulCount].pcPath = event.pcPath;
+   }
+   return SUCCESS;
+}
+
+/*-------------------------------------------------------------------*/
+
+/* The state of a walk of the FT by FT_glob */
+struct ftGlobWalk {
+   /* the absolute path of the node the walk is at */
+   struct ftPathBuf sPath;
+   /* the pattern being matched */
+   Glob_T oGGlob;
+   /* the state sets of the nodes on the path, from the root's parent
+      down, one after another, and the number of sets allocated */
+   unsigned char *pucSets;
+   size_t ulSetCapacity;
+   /* the function to report matches to, and its extra argument */
+   int (*pfMatch)(const char *, boolean, void *);
+   void *pvExtra;
+};
+
+/*
+  Makes room in walk psWalk for the state sets of ulSets nodes, the
+  deepest on the path being at depth ulSets - 1. Returns SUCCESS, or
+  MEMORY_ERROR if memory could not be allocated.
+*/
+static int FT_globReserve(struct ftGlobWalk *psWalk, size_t ulSets) {
+   enum {GROWTH_FACTOR = 2};
+   size_t capacity;
+   unsigned char *grown;
+
+   assert(psWalk != NULL);
+
+   if (ulSets <= psWalk->ulSetCapacity) {
+      return SUCCESS;
+   }
+   capacity = psWalk->ulSetCapacity;
+   while (capacity < ulSets) {
+      capacity *= GROWTH_FACTOR;
+   }
+   grown = realloc(psWalk->pucSets,
+                   capacity * Glob_getSetSize(psWalk->oGGlob));
+   if (grown == NULL) {
+      return MEMORY_ERROR;
+   }
+   psWalk->pucSets = grown;
+   psWalk->ulSetCapacity = capacity;
+   return SUCCESS;
+}
+
+/*
+  Finds the first child of node oNNode at depth ulDepth of walk
+  psWalk, from index *pulIndex on, that can match or lead to a match,
+  storing its state set in the slot below oNNode's and setting
+  *pulIndex to its index, or to oNNode's number of children if there
+  is none. When only a child of one name can, just that child is
+  looked at, found by binary search.
+*/
+static void FT_globNext(struct ftGlobWalk *psWalk, Node_T oNNode,
+                        size_t ulDepth, size_t *pulIndex) {
+   size_t setSize;
+   unsigned char *set;
+   const char *only;
+   size_t childID;
+   size_t last;
+   Node_T child = NULL;
+
+   assert(psWalk != NULL);
+   assert(oNNode != NULL);
+   assert(pulIndex != NULL);
+
+   setSize = Glob_getSetSize(psWalk->oGGlob);
+   set = psWalk->pucSets + ulDepth * setSize;
+   last = Node_getNumChildren(oNNode);
+   if (Node_isFile(oNNode) ||
+       !Glob_canDescend(psWalk->oGGlob, set, &only)) {
+      *pulIndex = last;
+      return;
+   }
+   if (only != NULL) {
+      if (!Node_hasChild(oNNode, only, &childID) ||
+          childID < *pulIndex) {
+         *pulIndex = last;
+         return;
+      }
+      *pulIndex = childID;
+      last = childID + 1;
+   }
+
+   for (; *pulIndex < last; (*pulIndex)++) {
+      (void) Node_getChild(oNNode, *pulIndex, &child);
+      if (Glob_step(psWalk->oGGlob, set, Node_getName(child),
+                    set + setSize)) {
+         return;
+      }
+   }
+   *pulIndex = Node_getNumChildren(oNNode);
+}
+
+/*
+  Walks the subtree rooted at oNTop, whose state set is in the slot at
+  depth 1 of walk psWalk, reporting each node that matches, parents
+  first. Each node's state set is kept in the slot at its depth, so
+  the sets on the path form an explicit stack, and the walk goes down
+  into a child that can lead to a match and back up by parent links
+  instead of recursing. Returns the statuses of FT_glob.
+*/
+static int FT_globTree(struct ftGlobWalk *psWalk, Node_T oNTop) {
+   size_t setSize;
+   size_t depth = 1;
+   size_t index;
+   Node_T node = oNTop;
+   Node_T child = NULL;
+   int status;
+
+   assert(psWalk != NULL);
+   assert(oNTop != NULL);
+
+   setSize = Glob_getSetSize(psWalk->oGGlob);
+   status = FT_pathEnter(&psWalk->sPath, Node_getName(node));
+   while (status == SUCCESS) {
+      /* node has just been reached: report it, and make room for its
+         children's state sets */
+      if (Glob_isMatch(psWalk->oGGlob,
+                       psWalk->pucSets + depth * setSize)) {
+         status = psWalk->pfMatch(psWalk->sPath.pcPath,
+                                  Node_isFile(node), psWalk->pvExtra);
+      }
+      if (status == SUCCESS) {
+         status = FT_globReserve(psWalk, depth + 2);
+      }
+      if (status != SUCCESS) {
+         break;
+      }
+
+      /* go down to node's first child that can lead to a match, or
+         else back up to the next one of the nearest node on the way
+         up that has one */
+      index = 0;
+      FT_globNext(psWalk, node, depth, &index);
+      while (index == Node_getNumChildren(node)) {
+         if (node == oNTop) {
+            return SUCCESS;
+         }
+         FT_pathLeave(&psWalk->sPath, psWalk->sPath.ulLength -
+                      strlen(Node_getName(node)) - 1);
+         (void) Node_hasChild(Node_getParent(node), Node_getName(node),
+                              &index);
+         index++;
+         node = Node_getParent(node);
+         depth--;
+         FT_globNext(psWalk, node, depth, &index);
+      }
+
+      (void) Node_getChild(node, index, &child);
+      status = FT_pathEnter(&psWalk->sPath, Node_getName(child));
+      node = child;
+      depth++;
+   }
+   return status;
+}
+
+/*
+  Walks the FT for the directories and files whose absolute paths
+  match the glob pcPattern, passing the path of each, directories
+  before what is below them and siblings in sorted order, to pfMatch
+  along with whether it is a file and pvExtra. A pattern has
+  components separated by '/' like a path, each of which is either
+  "**", matching any number (including none) of whole components, or
+  a name in which '*' matches any run of characters, '?' any one
+  character, and "[...]" any one character in the bracketed set or
+  range (or not in it, if the set starts with '!' or '^'). The
+  pattern is compiled once, and each node's progress through it
+  follows from its parent's and its own name, so subtrees that cannot
+  hold a match are skipped without being entered, and a component
+  with no wildcards is looked up by binary search among the sorted
+  children rather than compared with each of them: the time taken
+  grows with the part of the tree the pattern can reach rather than
+  the whole tree. A path is only valid during the call, which must
+  not change the FT. Returns SUCCESS if every match was reported.
+  Otherwise, stops and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcPattern is empty, begins or ends with a '/',
+             contains consecutive '/' delimiters, or has a '[' with
+             no matching ']'
+  * MEMORY_ERROR if memory could not be allocated to complete request
+  * the first status other than SUCCESS that pfMatch returned
+*/
+int FT_glob(const char *pcPattern,
+            int (*pfMatch)(const char *pcPath, boolean isFile,
+                           void *pvExtra),
+            void *pvExtra) {
+   enum {MIN_SETS = 16};
+   struct ftGlobWalk walk;
+   int status;
+
+   assert(pcPattern != NULL);
+   assert(pfMatch != NULL);
+
+   if (!isInitialized) {
+      return INITIALIZATION_ERROR;
+   }
+
+   status = Glob_new(pcPattern, &walk.oGGlob);
+   if (status != SUCCESS) {
+      return status;
+   }
+   walk.pucSets = malloc(MIN_SETS * Glob_getSetSize(walk.oGGlob));
+   if (walk.pucSets == NULL) {
+      Glob_free(walk.oGGlob);
+      return MEMORY_ERROR;
+   }
+   walk.ulSetCapacity = MIN_SETS;
+   walk.sPath.pcPath = NULL;
+   walk.sPath.ulLength = 0;
+   walk.sPath.ulCapacity = 0;
+   walk.pfMatch = pfMatch;
+   walk.pvExtra = pvExtra;
+
+   Glob_start(walk.oGGlob, walk.pucSets);
+   if (root != NULL && Glob_step(walk.oGGlob, walk.pucSets,
+                                 Node_getName(root),
+                                 walk.pucSets +
+                                 Glob_getSetSize(walk.oGGlob))) {
+      status = FT_globTree(&walk, root);
+   }
+
+   free(walk.sPath.pcPath);
+   free(walk.pucSets);
+   Glob_free(walk.oGGlob);
+   return status;
+}
+
+/*-------------------------------------------------------------------*/
+
+/* A directory on the path of a scan by FT_scanRange */
+struct ftScanFrame {
+   /* the directory */
+   Node_T oNDir;
+   /* the identifier of the next of its children to visit */
+   size_t ulNext;
+   /* the length of the directory's path */
+   size_t ulLength;
+};
+
+/* The state of a scan by FT_scanRange */
+struct ftScan {
+   /* the absolute path of the node the scan is at */
+   struct ftPathBuf sPath;
+   /* the directories on that path, from the root down, whose children
+      are still being visited, their number, and the number of frames
+      allocated */
+   struct ftScanFrame *psFrames;
+   size_t ulDepth;
+   size_t ulCapacity;
+};
+
+/*
+  Returns the rank of character c in path order: the end of a path
+  comes first, then the '/' that ends a component, and then every
+  other character in the order strcmp gives it.
+*/
+static int FT_pathRank(char c) {
+   if (c == '\0') {
+      return 0;
+   }
+   if (c == '/') {
+      return 1;
+   }
+   return (unsigned char) c + 2;
+}
+
+/*
+  Compares absolute paths pcFirst and pcSecond in path order, the
+  order of their components from the root down, in which a path comes
+  right before the paths below it. Returns <0, 0, or >0 if pcFirst is
+  "less than", "equal to", or "greater than" pcSecond, respectively.
+*/
+static int FT_comparePaths(const char *pcFirst, const char *pcSecond) {
+   size_t i = 0;
+
+   assert(pcFirst != NULL);
+   assert(pcSecond != NULL);
+
+   while (pcFirst[i] != '\0' && pcFirst[i] == pcSecond[i]) {
+      i++;
+   }
+   return FT_pathRank(pcFirst[i]) - FT_pathRank(pcSecond[i]);
+}
+
+/*
+  Pushes directory oNDir, whose path is scan psScan's, onto the
+  scan's stack, to visit its children from identifier ulNext on.
+  Returns SUCCESS, or MEMORY_ERROR if the stack could not be grown.
+*/
+static int FT_scanPush(struct ftScan *psScan, Node_T oNDir,
+                       size_t ulNext) {
+   enum {MIN_FRAMES = 16, GROWTH_FACTOR = 2};
+   struct ftScanFrame *grown;
+   size_t newCapacity;
+
+   assert(psScan != NULL);
+   assert(oNDir != NULL);
+
+   if (psScan->ulDepth == psScan->ulCapacity) {
+      newCapacity = psScan->ulCapacity == 0 ?
+                    MIN_FRAMES : psScan->ulCapacity * GROWTH_FACTOR;
+      grown = realloc(psScan->psFrames,
+                      newCapacity * sizeof(struct ftScanFrame));
+      if (grown == NULL) {
+         return MEMORY_ERROR;
+      }
+      psScan->psFrames = grown;
+      psScan->ulCapacity = newCapacity;
+   }
+
+   psScan->psFrames[psScan->ulDepth].oNDir = oNDir;
+   psScan->psFrames[psScan->ulDepth].ulNext = ulNext;
+   psScan->psFrames[psScan->ulDepth].ulLength = psScan->sPath.ulLength;
+   psScan->ulDepth++;
+   return SUCCESS;
+}
+
+/*
+  Moves scan psScan on to the next node in path order that is not
+  below the node it is at, popping the directories whose children
+  have all been visited, and sets *poNNext to that node, or to NULL if
+  there is none. Returns SUCCESS, or MEMORY_ERROR if the node's path
+  could not be built.
+*/
+static int FT_scanNext(struct ftScan *psScan, Node_T *poNNext) {
+   struct ftScanFrame *frame;
+
+   assert(psScan != NULL);
+   assert(poNNext != NULL);
+
+   while (psScan->ulDepth != 0) {
+      frame = &psScan->psFrames[psScan->ulDepth - 1];
+      if (frame->ulNext < Node_getNumChildren(frame->oNDir)) {
+         (void) Node_getChild(frame->oNDir, frame->ulNext, poNNext);
+         frame->ulNext++;
+         FT_pathLeave(&psScan->sPath, frame->ulLength);
+         return FT_pathEnter(&psScan->sPath, Node_getName(*poNNext));
+      }
+      psScan->ulDepth--;
+   }
+
+   *poNNext = NULL;
+   return SUCCESS;
+}
+
+/*
+  Starts scan psScan at the first node of the FT whose path is not
+  before oPLow in path order, or at the root if oPLow is NULL, by
+  descending from the root with a binary search among each
+  directory's children, pushing the directories it passes through.
+  Sets *poNFirst to that node, or to NULL if there is none. Returns
+  SUCCESS, or MEMORY_ERROR if the stack or path could not be grown.
+*/
+static int FT_scanSeek(struct ftScan *psScan, Path_T oPLow,
+                       Node_T *poNFirst) {
+   Node_T node;
+   size_t level;
+   size_t childID;
+   boolean found;
+   int comparison;
+   int status;
+
+   assert(psScan != NULL);
+   assert(poNFirst != NULL);
+
+   *poNFirst = NULL;
+   if (root == NULL) {
+      return SUCCESS;
+   }
+   status = FT_pathEnter(&psScan->sPath, Node_getName(root));
+   if (status != SUCCESS) {
+      return status;
+   }
+   if (oPLow == NULL) {
+      *poNFirst = root;
+      return SUCCESS;
+   }
+
+   node = root;
+   for (level = 0; ; level++) {
+      comparison = strcmp(Node_getName(node),
+                          Path_getComponent(oPLow, level));
+      if (comparison > 0 || (comparison == 0 &&
+                             level + 1 == Path_getDepth(oPLow))) {
+         *poNFirst = node;
+         return SUCCESS;
+      }
+      if (comparison < 0 || Node_isFile(node)) {
+         return FT_scanNext(psScan, poNFirst);
+      }
+
+      /* node's path is a proper prefix of oPLow, so resume at its
+         first child that is not before oPLow's next component */
+      found = Node_hasChild(node, Path_getComponent(oPLow, level + 1),
+                            &childID);
+      status = FT_scanPush(psScan, node, childID);
+      if (status != SUCCESS) {
+         return status;
+      }
+      if (!found) {
+         return FT_scanNext(psScan, poNFirst);
+      }
+      psScan->psFrames[psScan->ulDepth - 1].ulNext++;
+      (void) Node_getChild(node, childID, &node);
+      status = FT_pathEnter(&psScan->sPath, Node_getName(node));
+      if (status != SUCCESS) {
+         return status;
+      }
+   }
+}
+
+/*
+  Passes the absolute path of each directory and file in the FT from
+  pcLow (inclusive) up to pcHigh (exclusive), in path order, to
+  pfVisit along with whether it is a file and pvExtra, stopping after
+  ulLimit of them unless ulLimit is 0. Path order compares paths
+  component by component, so a directory comes right before what is
+  below it and siblings come in sorted order, as Node_compare keeps
+  them. Either bound may be NULL to leave that end of the range open,
+  and neither need exist in the FT. The scan seeks to pcLow by binary
+  search down the sorted children, and then walks on from there with
+  an explicit stack of the directories above it, so nothing is
+  visited before pcLow or after the scan stops, and nothing is copied
+  but the current path. A path is only valid during the call, which
+  must not change the FT. Returns SUCCESS if the scan reached its
+  end. Otherwise, stops and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcLow or pcHigh does not represent a well-formatted
+             path
+  * MEMORY_ERROR if memory could not be allocated to complete request
+  * the first status other than SUCCESS that pfVisit returned
+*/
+int FT_scanRange(const char *pcLow, const char *pcHigh, size_t ulLimit,
+                 int (*pfVisit)(const char *pcPath, boolean isFile,
+                                void *pvExtra),
+                 void *pvExtra) {
+   struct ftScan scan;
+   Path_T low = NULL;
+   Path_T high = NULL;
+   Node_T node = NULL;
+   size_t visited = 0;
+   int status;
+
+   assert(pfVisit != NULL);
+
+   if (!isInitialized) {
+      return INITIALIZATION_ERROR;
+   }
+
+   if (pcLow != NULL) {
+      status = Path_new(pcLow, &low);
+      if (status != SUCCESS) {
+         return status;
+      }
+   }
+   if (pcHigh != NULL) {
+      status = Path_new(pcHigh, &high);
+      if (status != SUCCESS) {
+         if (low != NULL) {
+            Path_free(low);
+         }
+         return status;
+      }
+   }
+
+   scan.sPath.pcPath = NULL;
+   scan.sPath.ulLength = 0;
+   scan.sPath.ulCapacity = 0;
+   scan.psFrames = NULL;
+   scan.ulDepth = 0;
+   scan.ulCapacity = 0;
+
+   status = FT_scanSeek(&scan, low, &node);
+   while (status == SUCCESS && node != NULL) {
+      if ((ulLimit != 0 && visited == ulLimit) ||
+          (high != NULL && FT_comparePaths(scan.sPath.pcPath,
+                                           pcHigh) >= 0)) {
+         break;
+      }
+      status = pfVisit(scan.sPath.pcPath, Node_isFile(node), pvExtra);
+      visited++;
+      if (status == SUCCESS && !Node_isFile(node)) {
+         status = FT_scanPush(&scan, node, 0);
+      }
+      if (status == SUCCESS) {
+         status = FT_scanNext(&scan, &node);
+      }
+   }
+
+   free(scan.sPath.pcPath);
+   free(scan.psFrames);
+   if (low != NULL) {
+      Path_free(low);
+   }
+   if (high != NULL) {
+      Path_free(high);
+   }
+   return status;
+}
+
+/*-------------------------------------------------------------------*/
+
+/* A search of the FT by FT_findByName */
+struct ftNameSearch {
+   /* the name searched for */
+   const char *pcName;
+   /* the function to report matches to, and its extra argument */
+   int (*pfMatch)(const char *, boolean, void *);
+   void *pvExtra;
+};
+
+/*
+  Reports node oNNode, found by search pvSearch, to the search's
+  pfMatch. Returns the status pfMatch returned, or MEMORY_ERROR if
+  the node's path could not be built.
+*/
+static int FT_reportFound(Node_T oNNode, void *pvSearch) {
+   struct ftNameSearch *search = pvSearch;
+   char *path;
+   int status;
+
+   assert(oNNode != NULL);
+   assert(search != NULL);
+
+   path = Node_toString(oNNode);
+   if (path == NULL) {
+      return MEMORY_ERROR;
+   }
+   status = search->pfMatch(path, Node_isFile(oNNode),
+                            search->pvExtra);
+   free(path);
+   return status;
+}
+
+/*
+  Reports node pvNode if it is named as search pvSearch asks, for a
+  Traverse_walk by FT_findByName without the name index. Returns
+  SUCCESS or the status of FT_reportFound.
+*/
+static int FT_findIfNamed(void *pvNode, void *pvSearch) {
+   struct ftNameSearch *search = pvSearch;
+
+   assert(pvNode != NULL);
+   assert(search != NULL);
+
+   if (strcmp(Node_getName(pvNode), search->pcName)) {
+      return SUCCESS;
+   }
+   return FT_reportFound(pvNode, search);
+}
+
+/*
+  Starts keeping a secondary index of the FT's directories and files
+  by name, for FT_findByName. The index is built from the whole tree
+  once, and then kept up to date as each directory or file is
+  inserted, removed, moved, or copied, at a small constant cost per
+  node linked in or out. Does nothing if the index is already kept.
+  Returns SUCCESS, or:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_enableNameIndex(void) {
+   int status;
+
+   if (!isInitialized) {
+      return INITIALIZATION_ERROR;
+   }
+
+   status = Node_startIndex();
+   if (status == SUCCESS && root != NULL) {
+      Node_indexRoot(root);
+   }
+   return status;
+}
+
+/*
+  Stops keeping the name index and frees it, as FT_destroy also does,
+  along with the trigram index if it is kept. Returns SUCCESS, or
+  INITIALIZATION_ERROR if the FT is not in an initialized state.
+*/
+int FT_disableNameIndex(void) {
+   if (!isInitialized) {
+      return INITIALIZATION_ERROR;
+   }
+
+   Node_stopIndex();
+   return SUCCESS;
+}
+
+/*
+  Passes the absolute path of each directory and file in the FT whose
+  name (the last component of its path) is pcName, in no particular
+  order, to pfMatch along with whether it is a file and pvExtra. With
+  the name index kept (see FT_enableNameIndex), the matches are found
+  with one hash lookup, in time proportional to their number;
+  otherwise the whole tree is walked. A path is only valid during the
+  call, which must not change the FT. Returns SUCCESS if every match
+  was reported. Otherwise, stops and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcName is empty or contains a '/'
+  * MEMORY_ERROR if memory could not be allocated to complete request
+  * the first status other than SUCCESS that pfMatch returned
+*/
+int FT_findByName(const char *pcName,
+                  int (*pfMatch)(const char *pcPath, boolean isFile,
+                                 void *pvExtra),
+                  void *pvExtra) {
+   struct ftNameSearch search;
+
+   assert(pcName != NULL);
+   assert(pfMatch != NULL);
+
+   if (!isInitialized) {
+      return INITIALIZATION_ERROR;
+   }
+   if (*pcName == '\0' || strchr(pcName, '/') != NULL) {
+      return BAD_PATH;
+   }
+
+   search.pcName = pcName;
+   search.pfMatch = pfMatch;
+   search.pvExtra = pvExtra;
+   if (Node_hasIndex()) {
+      return Node_findByName(pcName, FT_reportFound, &search);
+   }
+   return Traverse_walk(root, TRAVERSE_PRE_ORDER, FT_getNumChildren,
+                        FT_getChild, FT_findIfNamed, &search);
+}
+
+/*-------------------------------------------------------------------*/
+
+/* A search of the FT's file contents by FT_grep */
+struct ftGrep {
+   /* the bytes searched for, and their number */
+   const char *pcPattern;
+   size_t ulLength;
+   /* the function to report matches to, and its extra argument */
+   int (*pfMatch)(const char *, size_t, void *);
+   void *pvExtra;
+};
+
+/*
+  Returns TRUE and sets *pulOffset to the offset of the first
+  occurrence of the ulPattern bytes at pcPattern in the ulLength bytes
+  at pcText, or returns FALSE if there is none. Candidate starts are
+  found with memchr, which the C library scans a word or vector at a
+  time, and only those are compared in full.
+*/
+static boolean FT_findBytes(const char *pcText, size_t ulLength,
+                            const char *pcPattern, size_t ulPattern,
+                            size_t *pulOffset) {
+   const char *at = pcText;
+   const char *end;
+
+   assert(pcText != NULL || ulLength == 0);
+   assert(pcPattern != NULL);
+   assert(pulOffset != NULL);
+
+   if (ulPattern == 0) {
+      *pulOffset = 0;
+      return TRUE;
+   }
+   if (ulPattern > ulLength) {
+      return FALSE;
+   }
+
+   end = pcText + (ulLength - ulPattern) + 1;
+   while (at < end) {
+      at = memchr(at, pcPattern[0], (size_t) (end - at));
+      if (at == NULL) {
+         return FALSE;
+      }
+      if (!memcmp(at + 1, pcPattern + 1, ulPattern - 1)) {
+         *pulOffset = (size_t) (at - pcText);
+         return TRUE;
+      }
+      at++;
+   }
+   return FALSE;
+}
+
+/*
+  Checks file oNFile for the pattern of search pvGrep, and reports it
+  to the search's pfMatch if it holds it. Returns the status pfMatch
+  returned or SUCCESS if it was not called, or IO_ERROR if spilled
+  contents could not be brought back, or MEMORY_ERROR if the file's
+  path could not be built.
+*/
+static int FT_grepFile(Node_T oNFile, void *pvGrep) {
+   struct ftGrep *grep = pvGrep;
+   const char *contents;
+   size_t offset;
+   char *path;
+   int status;
+
+   assert(oNFile != NULL);
+   assert(grep != NULL);
+
+   contents = Node_getContents(oNFile);
+   if (contents == NULL && Node_getLength(oNFile) != 0) {
+      return IO_ERROR;
+   }
+   if (!FT_findBytes(contents, Node_getLength(oNFile), grep->pcPattern,
+                     grep->ulLength, &offset)) {
+      return SUCCESS;
+   }
+
+   path = Node_toString(oNFile);
+   if (path == NULL) {
+      return MEMORY_ERROR;
+   }
+   status = grep->pfMatch(path, offset, grep->pvExtra);
+   free(path);
+   return status;
+}
+
+/*
+  Checks node pvNode as search pvGrep asks if it is a file, for a
+  Traverse_walk by FT_grep without the trigram index. Returns SUCCESS
+  or the statuses of FT_grepFile.
+*/
+static int FT_grepNode(void *pvNode, void *pvGrep) {
+   assert(pvNode != NULL);
+
+   if (!Node_isFile(pvNode)) {
+      return SUCCESS;
+   }
+   return FT_grepFile(pvNode, pvGrep);
+}
+
+/*
+  Starts keeping a trigram index of the contents of the FT's files,
+  for FT_grep, along with the name index it rides on (see
+  FT_enableNameIndex). Each file's contents are indexed afresh by the
+  first FT_grep after it is inserted or changed, so a file changed
+  many times between searches is indexed once. Does nothing if the
+  index is already kept. Returns SUCCESS, or:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_enableTextIndex(void) {
+   int status;
+
+   status = FT_enableNameIndex();
+   if (status != SUCCESS) {
+      return status;
+   }
+   return Node_startTextIndex();
+}
+
+/*
+  Stops keeping the trigram index and frees it, as FT_disableNameIndex
+  and FT_destroy also do. Returns SUCCESS, or INITIALIZATION_ERROR if
+  the FT is not in an initialized state.
+*/
+int FT_disableTextIndex(void) {
+   if (!isInitialized) {
+      return INITIALIZATION_ERROR;
+   }
+
+   Node_stopTextIndex();
+   return SUCCESS;
+}
+
+/*
+  Passes the absolute path of each file in the FT whose contents hold
+  the string pcPattern (without its terminating '\0'), in no
+  particular order, to pfMatch along with the offset of the first
+  occurrence and pvExtra. With the trigram index kept (see
+  FT_enableTextIndex), only files holding every trigram of pcPattern
+  are checked; otherwise every file is. A path is only valid during
+  the call, which must not change the FT. Returns SUCCESS if every
+  match was reported. Otherwise, stops and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * MEMORY_ERROR if memory could not be allocated to complete request
+  * IO_ERROR if spilled contents could not be brought back
+  * the first status other than SUCCESS that pfMatch returned
+*/
+int FT_grep(const char *pcPattern,
+            int (*pfMatch)(const char *pcPath, size_t ulOffset,
+                           void *pvExtra),
+            void *pvExtra) {
+   struct ftGrep grep;
+
+   assert(pcPattern != NULL);
+   assert(pfMatch != NULL);
+
+   if (!isInitialized) {
+      return INITIALIZATION_ERROR;
+   }
+
+   grep.pcPattern = pcPattern;
+   grep.ulLength = strlen(pcPattern);
+   grep.pfMatch = pfMatch;
+   grep.pvExtra = pvExtra;
+   if (Node_hasTextIndex()) {
+      return Node_searchText(pcPattern, grep.ulLength, FT_grepFile,
+                             &grep);
+   }
+   return Traverse_walk(root, TRAVERSE_PRE_ORDER, FT_getNumChildren,
+                        FT_getChild, FT_grepNode, &grep);
+}
+
+/*-------------------------------------------------------------------*/
+
+/*
+  Starts keeping a cache of up to ulEntries (at least 1) absolute
+  paths looked up in the FT, mapping each path string exactly as
+  passed to the directory or file it names, so that looking it up
+  again skips parsing the path and walking down the tree. Removing or
+  moving a directory or file (including by FT_abort) invalidates just
+  the paths through it: each hit is checked by following parent links
+  up from the node it names, with no string comparisons, that nothing
+  on its path has been removed or moved since it was cached. Room for
+  new entries is made with CLOCK eviction. Restarts the cache, empty,
+  if it is already kept. Returns SUCCESS, or:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_enableLookupCache(size_t ulEntries) {
+   assert(ulEntries != 0);
+
+   if (!isInitialized) {
+      return INITIALIZATION_ERROR;
+   }
+
+   return Dcache_start(ulEntries, FT_isCacheCurrent, FT_forgetCached);
+}
+
+/*
+  Stops keeping the lookup cache and frees it, as FT_destroy also
+  does. Returns SUCCESS, or INITIALIZATION_ERROR if the FT is not in
+  an initialized state.
+*/
+int FT_disableLookupCache(void) {
+   if (!isInitialized) {
+      return INITIALIZATION_ERROR;
+   }
+
+   Dcache_stop();
+   return SUCCESS;
+}
+
+/*
+  Sets *pulEntries to the number of paths in the lookup cache,
+  *pulHits and *pulMisses to the numbers of lookups it answered and
+  did not, *pulEvictions to the number of paths evicted to make room,
+  and *pulProbes to the number of cached paths compared over all
+  lookups (whose ratio to the lookups measures their cost), each
+  since the cache was started. Returns SUCCESS, or:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state or
+                         the lookup cache is not kept
+*/
+int FT_getLookupStats(size_t *pulEntries, size_t *pulHits,
+                      size_t *pulMisses, size_t *pulEvictions,
+                      size_t *pulProbes) {
+   assert(pulEntries != NULL);
+   assert(pulHits != NULL);
+   assert(pulMisses != NULL);
+   assert(pulEvictions != NULL);
+   assert(pulProbes != NULL);
+
+   if (!isInitialized || !Dcache_isStarted()) {
+      return INITIALIZATION_ERROR;
+   }
+
+   Dcache_getStats(pulEntries, pulHits, pulMisses, pulEvictions,
+                   pulProbes);
+   return SUCCESS;
+}
+
+/*
+  Starts keeping a counting Bloom filter over the absolute paths of
+  the FT's directories and files, along with the name index it rides
+  on (see FT_enableNameIndex), so that FT_containsDir and
+  FT_containsFile answer most paths that are not in the FT after one
+  hash of the path, without parsing it or walking down the tree. The
+  filter is sized for ulPaths (at least 1) paths and doubled whenever
+  it holds more; it is kept up to date as nodes are inserted and
+  removed, and a move or rename costs time proportional to the size
+  of the subtree moved while it is kept. Restarts the filter if it is
+  already kept. Returns SUCCESS, or:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_enablePathFilter(size_t ulPaths) {
+   int status;
+
+   assert(ulPaths != 0);
+
+   status = FT_enableNameIndex();
+   if (status != SUCCESS) {
+      return status;
+   }
+   return Node_startPathFilter(ulPaths);
+}
+
+/*
+  Stops keeping the path filter and frees it, as FT_disableNameIndex
+  and FT_destroy also do. Returns SUCCESS, or INITIALIZATION_ERROR if
+  the FT is not in an initialized state.
+*/
+int FT_disablePathFilter(void) {
+   if (!isInitialized) {
+      return INITIALIZATION_ERROR;
+   }
+
+   Node_stopPathFilter();
+   return SUCCESS;
+}
+
+/*
+  Sets *pulPaths to the number of paths in the path filter,
+  *pulCounters to its number of counters, and *pulQueries and
+  *pulRejections to the numbers of paths FT_containsDir and
+  FT_containsFile asked it about and of those it found absent, each
+  since the filter was started. Returns SUCCESS, or:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state or
+                         the path filter is not kept
+*/
+int FT_getPathFilterStats(size_t *pulPaths, size_t *pulCounters,
+                          size_t *pulQueries, size_t *pulRejections) {
+   assert(pulPaths != NULL);
+   assert(pulCounters != NULL);
+   assert(pulQueries != NULL);
+   assert(pulRejections != NULL);
+
+   if (!isInitialized || !Node_hasPathFilter()) {
+      return INITIALIZATION_ERROR;
+   }
+
+   Node_getPathFilterStats(pulPaths, pulCounters, pulQueries,
+                           pulRejections);
+   return SUCCESS;
+}
+
+/*
+  Checks that pcName could name a child of the directory of handle
+  oHDir and that the directory is still in the FT. Nothing has been
+  unlinked or moved since it was last found there if the generation
+  is unchanged, and otherwise it is found there again by walking up
+  from it to the root. Returns SUCCESS and sets *poNResult to the
+  directory if so. Otherwise, sets *poNResult to NULL and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcName is empty or contains a '/'
+  * NO_SUCH_PATH if the directory has been removed from the FT
+*/
+static int FT_resolveHandle(FT_DirHandle_T oHDir, const char *pcName,
+                            Node_T *poNResult) {
+   Node_T top;
+
+   assert(oHDir != NULL);
+   assert(pcName != NULL);
+   assert(poNResult != NULL);
+
+   *poNResult = NULL;
+   if (!isInitialized) {
+      return INITIALIZATION_ERROR;
+   }
+   if (*pcName == '\0' || strchr(pcName, '/') != NULL) {
+      return BAD_PATH;
+   }
+
+   if (oHDir->ulGeneration != Node_getGeneration()) {
+      top = oHDir->oNDir;
+      while (Node_getParent(top) != NULL) {
+         top = Node_getParent(top);
+      }
+      if (top != root) {
+         return NO_SUCH_PATH;
+      }
+      oHDir->ulGeneration = Node_getGeneration();
+   }
+
+   *poNResult = oHDir->oNDir;
+   return SUCCESS;
+}
+
+/*
+  Returns a newly allocated string holding the absolute path of a
+  child named pcName of directory oNParent, which is then owned by the
+  caller, or NULL if there is an allocation error.
+*/
+static char *FT_childPath(Node_T oNParent, const char *pcName) {
+   char *parentPath;
+   char *path;
+
+   assert(oNParent != NULL);
+   assert(pcName != NULL);
+
+   parentPath = Node_toString(oNParent);
+   if (parentPath == NULL) {
+      return NULL;
+   }
+   path = malloc(strlen(parentPath) + 1 + strlen(pcName) + 1);
+   if (path != NULL) {
+      strcpy(path, parentPath);
+      strcat(path, "/");
+      strcat(path, pcName);
+   }
+   free(parentPath);
+   return path;
+}
+
+/*
+  Inserts a new node named pcName into the directory of handle oHDir,
+  a file with contents pvContents of size ulLength bytes if isFile is
+  TRUE and a directory otherwise. Returns SUCCESS or an error status
+  as described for FT_insertDirAt and FT_insertFileAt.
+*/
+static int FT_insertAt(FT_DirHandle_T oHDir, const char *pcName,
+                       boolean isFile, void *pvContents,
+                       size_t ulLength) {
+   Node_T dir = NULL;
+   Node_T newNode = NULL;
+   char *path;
+   size_t index;
+   int status;
+
+   assert(oHDir != NULL);
+   assert(pcName != NULL);
+
+   status = FT_resolveHandle(oHDir, pcName, &dir);
+   if (status != SUCCESS) {
+      return status;
+   }
+   if (Node_hasChild(dir, pcName, &index)) {
+      return ALREADY_IN_TREE;
+   }
+   status = Node_checkQuota(dir, 1, isFile ? ulLength : 0);
+   if (status != SUCCESS) {
+      return status;
+   }
+
+   /* the record goes ahead of the change, so the new node's path is
+      built from its parent's, and only if the journal needs it */
+   if (Journal_isOpen()) {
+      path = FT_childPath(dir, pcName);
+      if (path == NULL) {
+         return MEMORY_ERROR;
+      }
+      status = FT_log(isFile ? JOURNAL_INSERT_FILE : JOURNAL_INSERT_DIR,
+                      path, 0, isFile ? pvContents : NULL,
+                      isFile ? ulLength : 0);
+      free(path);
+      if (status != SUCCESS) {
+         return status;
+      }
+   }
+
+   /* fill in the new node before linking it, so its length goes up
+      dir's ancestors once */
+   status = Node_newChild(NULL, pcName, isFile, &newNode);
+   if (status == SUCCESS) {
+      if (isFile) {
+         (void) Node_replaceContents(newNode, pvContents, ulLength);
+      }
+      status = Node_attach(newNode, dir);
+      if (status == SUCCESS) {
+         status = FT_noteChange(CHANGE_INSERT, newNode, NULL, NULL);
+      }
+      if (status != SUCCESS) {
+         (void) Node_free(newNode);
+      }
+   }
+   status = FT_settleLog(status);
+   if (status != SUCCESS) {
+      return status;
+   }
+   count++;
+
+   FT_notifyNode(FT_EVENT_CREATE, newNode);
+   return SUCCESS;
+}
+
+/*
+  Opens a handle on the directory with absolute path pcPath, through
+  which its children are reached by name alone, in time logarithmic
+  in their number, without parsing or walking a path. The handle
+  follows the directory wherever it is moved or renamed, and pins it,
+  so that once it is removed (including by FT_destroy) operations
+  through the handle safely fail with NO_SUCH_PATH; it becomes usable
+  again if FT_abort puts the directory back. Checking that the
+  directory is still in the FT costs a comparison while nothing has
+  been unlinked or moved, and otherwise a walk up to the root. Sets
+  *poHResult to the handle, which must be closed with
+  FT_closeDirHandle, and returns SUCCESS. Otherwise, sets *poHResult
+  to NULL and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * CONFLICTING_PATH if the root exists but is not a prefix of pcPath
+  * NO_SUCH_PATH if absolute path pcPath does not exist in the FT
+  * NOT_A_DIRECTORY if pcPath is in the FT as a file not a directory
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_openDirHandle(const char *pcPath, FT_DirHandle_T *poHResult) {
+   struct ftDirHandle *handle;
+   Node_T found = NULL;
+   int status;
+
+   assert(pcPath != NULL);
+   assert(poHResult != NULL);
+
+   *poHResult = NULL;
+   status = FT_findNode(root, pcPath, &found);
+   if (status != SUCCESS) {
+      return status;
+   }
+   if (Node_isFile(found)) {
+      return NOT_A_DIRECTORY;
+   }
+
+   handle = malloc(sizeof(struct ftDirHandle));
+   if (handle == NULL) {
+      return MEMORY_ERROR;
+   }
+   Node_pin(found);
+   handle->oNDir = found;
+   handle->ulGeneration = Node_getGeneration();
+   *poHResult = handle;
+   return SUCCESS;
+}
+
+/*
+  Closes handle oHDir, freeing it, and the directory it refers to if
+  that was removed and no other handle refers to it.
+*/
+void FT_closeDirHandle(FT_DirHandle_T oHDir) {
+   assert(oHDir != NULL);
+
+   Node_unpin(oHDir->oNDir);
+   free(oHDir);
+}
+
+/*
+  Inserts a new directory named pcName into the directory of handle
+  oHDir. Returns SUCCESS if the new directory is inserted successfully.
+  Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcName is empty or contains a '/'
+  * NO_SUCH_PATH if the handle's directory has been removed
+  * ALREADY_IN_TREE if the directory already has a child named pcName
+  * MEMORY_ERROR if memory could not be allocated to complete request
+  * QUOTA_EXCEEDED if the new directory would take the directory or
+                   one above it past its quota (see FT_setQuota)
+*/
+int FT_insertDirAt(FT_DirHandle_T oHDir, const char *pcName) {
+   assert(oHDir != NULL);
+   assert(pcName != NULL);
+
+   return FT_insertAt(oHDir, pcName, FALSE, NULL, 0);
+}
+
+/*
+  Inserts a new file named pcName, with file contents pvContents of
+  size ulLength bytes, into the directory of handle oHDir. Returns
+  SUCCESS or an error status as described for FT_insertDirAt.
+*/
+int FT_insertFileAt(FT_DirHandle_T oHDir, const char *pcName,
+                    void *pvContents, size_t ulLength) {
+   assert(oHDir != NULL);
+   assert(pcName != NULL);
+
+   return FT_insertAt(oHDir, pcName, TRUE, pvContents, ulLength);
+}
+
+/*
+  Returns TRUE if the directory of handle oHDir has a child, directory
+  or file, named pcName, and FALSE if not or if there is an error
+  while checking.
+*/
+boolean FT_containsAt(FT_DirHandle_T oHDir, const char *pcName) {
+   Node_T dir = NULL;
+   size_t index;
+
+   assert(oHDir != NULL);
+   assert(pcName != NULL);
+
+   if (FT_resolveHandle(oHDir, pcName, &dir) != SUCCESS) {
+      return FALSE;
+   }
+   return Node_hasChild(dir, pcName, &index);
+}
+
+/*
+  Looks up the child named pcName of the directory of handle oHDir,
+  setting *pbIsFile and *pulSize as described for FT_stat. Returns
+  SUCCESS, or:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcName is empty or contains a '/'
+  * NO_SUCH_PATH if the handle's directory has been removed or has no
+                 child named pcName
+*/
+int FT_statAt(FT_DirHandle_T oHDir, const char *pcName,
+              boolean *pbIsFile, size_t *pulSize) {
+   Node_T dir = NULL;
+   Node_T child = NULL;
+   size_t index;
+   int status;
+
+   assert(oHDir != NULL);
+   assert(pcName != NULL);
+   assert(pbIsFile != NULL);
+   assert(pulSize != NULL);
+
+   status = FT_resolveHandle(oHDir, pcName, &dir);
+   if (status != SUCCESS) {
+      return status;
+   }
+   if (!Node_hasChild(dir, pcName, &index)) {
+      return NO_SUCH_PATH;
+   }
+   (void) Node_getChild(dir, index, &child);
+
+   if (Node_isFile(child)) {
+      *pbIsFile = TRUE;
+      *pulSize = Node_getLength(child);
+   }
+   else {
+      *pbIsFile = FALSE;
+   }
+   return SUCCESS;
+}
+
+/*
+  Removes the file named pcName from the directory of handle oHDir.
+  Returns SUCCESS if found and removed. Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcName is empty or contains a '/'
+  * NO_SUCH_PATH if the handle's directory has been removed or has no
+                 child named pcName
+  * NOT_A_FILE if the child named pcName is a directory not a file
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_rmFileAt(FT_DirHandle_T oHDir, const char *pcName) {
+   Node_T dir = NULL;
+   Node_T file = NULL;
+   char *path = NULL;
+   size_t index;
+   int status;
+
+   assert(oHDir != NULL);
+   assert(pcName != NULL);
+
+   status = FT_resolveHandle(oHDir, pcName, &dir);
+   if (status != SUCCESS) {
+      return status;
+   }
+   if (!Node_hasChild(dir, pcName, &index)) {
+      return NO_SUCH_PATH;
+   }
+   (void) Node_getChild(dir, index, &file);
+   if (!Node_isFile(file)) {
+      return NOT_A_FILE;
+   }
+
+   /* the file's path is only built if a watch or the journal needs
+      it */
+   if (Watch_isActive() || Journal_isOpen()) {
+      path = Node_toString(file);
+      if (path == NULL) {
+         return MEMORY_ERROR;
+      }
+   }
+   if (path != NULL) {
+      status = FT_log(JOURNAL_RM_FILE, path, 0, NULL, 0);
+   }
+   if (status == SUCCESS) {
+      status = FT_settleLog(FT_rmNode(file));
+   }
+   if (status == SUCCESS && path != NULL) {
+      Watch_notify(FT_EVENT_REMOVE, path);
+   }
+   free(path);
+   return status;
+}
@@ -15,6 +15,54 @@
 #include <stddef.h>
 #include "a4def.h"
 
+/* A FT_Snapshot_T is a read-only view of the FT at a point in time */
+typedef struct ftSnapshot *FT_Snapshot_T;
+
+/* A FT_DirHandle_T refers to a directory of the FT, wherever it is
+   moved, for operations on its children by name */
+typedef struct ftDirHandle *FT_DirHandle_T;
+
+/* The kinds of difference between two trees */
+enum ftDiffKind {
+   /* a directory or file is only in the newer tree */
+   FT_DIFF_ADD,
+   /* a directory or file, with everything below it, is only in the
+      older tree */
+   FT_DIFF_REMOVE,
+   /* a file is in both trees, with different contents */
+   FT_DIFF_MODIFY
+};
+
+/* A difference between two trees, reported by FT_diff and applied by
+   FT_applyPatch */
+struct ftDiffRecord {
+   /* the kind of difference */
+   enum ftDiffKind eKind;
+   /* the absolute path of the directory or file that differs */
+   const char *pcPath;
+   /* TRUE if that is a file, and FALSE if it is a directory */
+   boolean isFile;
+   /* the contents of an added or modified file in the newer tree, of
+      length ulLength; NULL and 0 otherwise */
+   const void *pvContents;
+   size_t ulLength;
+};
+
+/* The kinds of change reported to watches, as bit flags */
+enum {FT_EVENT_CREATE = 1, FT_EVENT_REMOVE = 2, FT_EVENT_MODIFY = 4};
+
+/* A change to a watched subtree, reported by FT_drainEvents */
+struct ftEvent {
+   /* the watch it is reported to */
+   size_t ulWatch;
+   /* the kinds of change, OR-ed together when repeated changes to
+      the same path were folded into one event */
+   unsigned int uiKinds;
+   /* the absolute path of the created, removed, or modified directory
+      or file, allocated with malloc and owned by the client */
+   char *pcPath;
+};
+
 /*
    Inserts a new directory into the FT with absolute path pcPath.
    Returns SUCCESS if the new directory is inserted successfully.
@@ -25,6 +73,8 @@
    * NOT_A_DIRECTORY if a proper prefix of pcPath exists as a file
    * ALREADY_IN_TREE if pcPath is already in the FT (as dir or file)
    * MEMORY_ERROR if memory could not be allocated to complete request
+   * QUOTA_EXCEEDED if the directories to build would take one above
+                    them past its quota (see FT_setQuota)
 */
 int FT_insertDir(const char *pcPath);
 
@@ -60,6 +110,8 @@ int FT_rmDir(const char *pcPath);
    * NOT_A_DIRECTORY if a proper prefix of pcPath exists as a file
    * ALREADY_IN_TREE if pcPath is already in the FT (as dir or file)
    * MEMORY_ERROR if memory could not be allocated to complete request
+   * QUOTA_EXCEEDED if the file, with any directories to build for it,
+                    would take a directory above it past its quota
 */
 int FT_insertFile(const char *pcPath, void *pvContents,
                   size_t ulLength);
@@ -96,11 +148,69 @@ void *FT_getFileContents(const char *pcPath);
   Replaces current contents of the file with absolute path pcPath with
   the parameter pvNewContents of size ulNewLength bytes.
   Returns the old contents if successful. (Note: contents may be NULL.)
-  Returns NULL if unable to complete the request for any reason.
+  Returns NULL if unable to complete the request for any reason,
+  including longer contents that would take a directory above the
+  file past its quota (see FT_setQuota).
+
+  If the old contents were last modified by FT_writeFileRange or
+  FT_appendFile, or were rebuilt by FT_load, FT_loadMapped, or
+  FT_openJournal, they were allocated by the FT and are then owned by
+  the client!
 */
 void *FT_replaceFileContents(const char *pcPath, void *pvNewContents,
                              size_t ulNewLength);
 
+/*
+  Copies up to ulLength bytes of the contents of the file with absolute
+  path pcPath, starting at byte ulOffset, into pvBuf, and sets
+  *pulRead to the number of bytes copied (fewer than ulLength if the
+  contents end first). Returns SUCCESS if successful.
+  Otherwise, leaves *pulRead unchanged and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * CONFLICTING_PATH if the root's path is not a prefix of pcPath
+  * NO_SUCH_PATH if absolute path pcPath does not exist in the FT
+  * NOT_A_FILE if pcPath is in the FT as a directory not a file
+  * MEMORY_ERROR if memory could not be allocated to complete request
+  * IO_ERROR if spilled contents could not be read back
+*/
+int FT_readFileRange(const char *pcPath, size_t ulOffset, void *pvBuf,
+                     size_t ulLength, size_t *pulRead);
+
+/*
+  Overwrites ulLength bytes of the contents of the file with absolute
+  path pcPath, starting at byte ulOffset, with the bytes at pvData,
+  extending the file if needed (and zero-filling any gap past its old
+  end). Returns SUCCESS if successful.
+  Otherwise, leaves the contents unchanged and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * CONFLICTING_PATH if the root's path is not a prefix of pcPath
+  * NO_SUCH_PATH if absolute path pcPath does not exist in the FT
+  * NOT_A_FILE if pcPath is in the FT as a directory not a file
+  * MEMORY_ERROR if memory could not be allocated to complete request
+  * IO_ERROR if spilled contents could not be written
+  * QUOTA_EXCEEDED if extending the file would take a directory above
+                   it past its quota (see FT_setQuota)
+
+  The first ranged write to a file copies its contents into a buffer
+  owned by the FT, so the client's original contents are never
+  modified. After that, each write or append costs time proportional
+  to ulLength (amortized), not to the size of the file. A pointer
+  previously returned by FT_getFileContents for this file may be
+  invalidated by the write.
+*/
+int FT_writeFileRange(const char *pcPath, size_t ulOffset,
+                      const void *pvData, size_t ulLength);
+
+/*
+  Appends the ulLength bytes at pvData to the end of the contents of
+  the file with absolute path pcPath. Returns SUCCESS if successful,
+  or otherwise one of the statuses listed for FT_writeFileRange.
+*/
+int FT_appendFile(const char *pcPath, const void *pvData,
+                  size_t ulLength);
+
 /*
   Returns SUCCESS if pcPath exists in the hierarchy,
   Otherwise, returns:
@@ -119,6 +229,350 @@ void *FT_replaceFileContents(const char *pcPath, void *pvNewContents,
 */
 int FT_stat(const char *pcPath, boolean *pbIsFile, size_t *pulSize);
 
+/*
+  Sets *pulHash to the hash of the subtree at absolute path pcPath: for
+  a file, of its contents, and for a directory, of its children's
+  names, types, and hashes in name order, recursively. Two subtrees,
+  in this FT or another, with equal hashes hold the same directories
+  and files below their roots (barring a 64-bit collision), so a
+  comparison of replicas can skip them without looking inside. Every
+  node keeps its hash, and a change only marks the hashes along its
+  chain of ancestors out of date, so this call rehashes just what
+  changed since it was last made. Returns SUCCESS if successful.
+  Otherwise, leaves *pulHash unchanged and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * CONFLICTING_PATH if the root's path is not a prefix of pcPath
+  * NO_SUCH_PATH if absolute path pcPath does not exist in the FT
+  * MEMORY_ERROR if memory could not be allocated to complete request
+  * IO_ERROR if spilled contents could not be read
+*/
+int FT_subtreeHash(const char *pcPath, unsigned long *pulHash);
+
+/*
+  Sets *pulFiles and *pulDirs to the numbers of files and directories
+  in the subtree at absolute path pcPath, itself included, and
+  *pulBytes to the total length of the files' contents. Every
+  directory keeps these totals for its subtree, and each change
+  updates them along its chain of ancestors, so the call takes time
+  proportional to the depth of pcPath rather than to the size of the
+  subtree. Returns SUCCESS if successful. Otherwise, leaves the
+  totals unchanged and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * CONFLICTING_PATH if the root's path is not a prefix of pcPath
+  * NO_SUCH_PATH if absolute path pcPath does not exist in the FT
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_statTree(const char *pcPath, size_t *pulFiles, size_t *pulDirs,
+                size_t *pulBytes);
+
+/*
+  Gives the directory with absolute path pcPath a quota of at most
+  ulMaxNodes directories and files and ulMaxBytes bytes of file
+  contents in its subtree, itself included, with 0 meaning no limit
+  (so both 0 removes the quota). Inserts, copies, moves, and writes
+  that would take the subtree past either limit then fail with
+  QUOTA_EXCEEDED, checked against totals kept along the chain of
+  ancestors (see FT_statTree) in time proportional to the depth of
+  the change, or in constant time while no quota is set. A quota may
+  be set below what the subtree already holds, which only stops it
+  from growing. Quotas take effect at once, even inside a
+  transaction, and are not saved in snapshots or copied with their
+  directories. Returns SUCCESS if successful. Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * CONFLICTING_PATH if the root's path is not a prefix of pcPath
+  * NO_SUCH_PATH if absolute path pcPath does not exist in the FT
+  * NOT_A_DIRECTORY if pcPath is in the FT as a file not a directory
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_setQuota(const char *pcPath, size_t ulMaxNodes,
+                size_t ulMaxBytes);
+
+/*
+  Sets *pulMaxNodes and *pulMaxBytes to the quota of the directory or
+  file with absolute path pcPath (see FT_setQuota), each 0 if there is
+  no limit. Returns SUCCESS if successful. Otherwise, leaves them
+  unchanged and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * CONFLICTING_PATH if the root's path is not a prefix of pcPath
+  * NO_SUCH_PATH if absolute path pcPath does not exist in the FT
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_getQuota(const char *pcPath, size_t *pulMaxNodes,
+                size_t *pulMaxBytes);
+
+/*
+  Moves the file or directory with absolute path pcSrc, with everything
+  below it, to absolute path pcDest, whose parent must already be a
+  directory in the FT. Only the moved node is relinked and renamed, so
+  the time a move takes does not depend on the size of its subtree.
+  Returns SUCCESS if moved. Otherwise, leaves the FT unchanged and
+  returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcSrc or pcDest does not represent a well-formatted
+             path
+  * CONFLICTING_PATH if the root exists but is not a prefix of pcSrc
+                     or pcDest, if pcSrc is the root, or if pcDest
+                     lies below pcSrc
+  * NO_SUCH_PATH if pcSrc or the parent of pcDest does not exist in
+                 the FT
+  * NOT_A_DIRECTORY if a proper prefix of pcDest exists as a file
+  * ALREADY_IN_TREE if pcDest is already in the FT (as dir or file)
+  * MEMORY_ERROR if memory could not be allocated to complete request
+  * QUOTA_EXCEEDED if the subtree would take a directory above pcDest,
+                   but not above pcSrc, past its quota
+*/
+int FT_move(const char *pcSrc, const char *pcDest);
+
+/*
+  Builds a copy of the file or directory with absolute path pcSrc,
+  with everything below it, at absolute path pcDest, whose parent must
+  already be a directory in the FT. The copy shares file contents
+  with the original rather than copying them: contents owned by the
+  client stay owned by the client, and contents owned by the FT are
+  copied only when first changed through either path (with
+  FT_writeFileRange or FT_appendFile), so copying takes time
+  proportional to the number of directories and files copied, not to
+  the size of their contents. The directories and files themselves
+  are not shared, since each copy is a live part of the FT that can be
+  changed, moved, and looked up on its own; to keep a read-only image
+  of a subtree in constant time, take an FT_snapshot instead. Returns
+  SUCCESS if copied. Otherwise, leaves the FT unchanged and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcSrc or pcDest does not represent a well-formatted
+             path
+  * CONFLICTING_PATH if the root exists but is not a prefix of pcSrc
+                     or pcDest, or if pcDest lies below pcSrc
+  * NO_SUCH_PATH if pcSrc or the parent of pcDest does not exist in
+                 the FT
+  * NOT_A_DIRECTORY if a proper prefix of pcDest exists as a file
+  * ALREADY_IN_TREE if pcDest is already in the FT (as dir or file)
+  * MEMORY_ERROR if memory could not be allocated to complete request
+  * QUOTA_EXCEEDED if the copy would take a directory above pcDest
+                   past its quota
+*/
+int FT_copy(const char *pcSrc, const char *pcDest);
+
+/*
+  Opens a transaction: the changes made from now on until FT_commit or
+  FT_abort take effect in the FT at once, as usual, but each is noted
+  so that FT_abort can take all of them back together. Removed
+  subtrees are only unlinked, and the old contents of changed files
+  are kept in copies that share them (see FT_copy), until the
+  transaction ends. While changes are being journaled, their records
+  are held back and written at commit as a single record with one
+  checksum, so that after a crash the journal replays either all of a
+  transaction's changes or none of them. Returns SUCCESS, or:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state or
+                         a transaction is already open
+  * MEMORY_ERROR if memory could not be allocated to complete request
+
+  Contents returned by FT_replaceFileContents inside a transaction are
+  put back by FT_abort, so the client must keep them until the
+  transaction ends. FT_load, FT_loadMapped, FT_openJournal, and
+  FT_checkpoint refuse to run while a transaction is open, and
+  FT_destroy ends it, keeping its changes but not its records.
+*/
+int FT_begin(void);
+
+/*
+  Ends the open transaction, keeping all of its changes and writing
+  their records to the journal, if changes are being journaled, as one
+  record (completing a group commit if this fills the commit window).
+  Returns SUCCESS, or:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state or
+                         no transaction is open
+  * MEMORY_ERROR if memory could not be allocated to complete request,
+                 in which case the transaction is aborted instead
+  * IO_ERROR if the group commit failed, in which case the changes are
+             kept and their record stays buffered for the next flush
+*/
+int FT_commit(void);
+
+/*
+  Ends the open transaction, taking back all of its changes, newest
+  first, and discarding their journal records, so that the FT is as it
+  was when FT_begin was called. Returns SUCCESS, or
+  INITIALIZATION_ERROR if the FT is not in an initialized state or no
+  transaction is open.
+*/
+int FT_abort(void);
+
+/*
+  Keeps FT-owned file contents longer than ulThreshold bytes out of
+  the heap, in the append-only backing file pcBackingFile, from now
+  until FT_destroy. Returns SUCCESS if the spill store was opened.
+  Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+                         or spilling is already enabled
+  * IO_ERROR if the backing file could not be created
+
+  Only contents owned by the FT (those built by FT_writeFileRange or
+  FT_appendFile) are spilled; contents passed in by the client stay
+  where the client put them. Spilled contents are mapped back into
+  memory by FT_getFileContents, and the returned pointer stays valid
+  until the file is next modified or removed. The backing file is
+  unlinked as soon as it is created and never grows smaller; space
+  abandoned by removed or relocated contents is not reused.
+*/
+int FT_enableSpill(const char *pcBackingFile, size_t ulThreshold);
+
+/*
+  Caps the heap memory used by FT-owned file contents at ulBytes,
+  evicting the least recently used contents to the spill store when
+  the cap is exceeded, or removes the cap if ulBytes is 0. Resets the
+  counters reported by FT_getCacheStats. Returns SUCCESS, or
+  INITIALIZATION_ERROR if the FT is not in an initialized state or
+  spilling has not been enabled with FT_enableSpill.
+
+  Evicted contents are faulted back onto the heap the next time they
+  are read or written. While a cap is set, a pointer returned by
+  FT_getFileContents is only valid until the next call that reads or
+  writes any file's contents.
+*/
+int FT_setMemoryBudget(size_t ulBytes);
+
+/*
+  Sets *pulResident to the number of heap bytes currently used by
+  FT-owned file contents, and *pulHits, *pulMisses, and *pulEvictions
+  to the number of content accesses that found the contents resident,
+  that had to fault evicted contents back in, and the number of
+  evictions, since the budget was last set. Returns SUCCESS, or
+  INITIALIZATION_ERROR if the FT is not in an initialized state.
+*/
+int FT_getCacheStats(size_t *pulResident, size_t *pulHits,
+                     size_t *pulMisses, size_t *pulEvictions);
+
+/*
+  Writes a compact binary snapshot of the FT to the file pcFile,
+  replacing it, so that it can later be rebuilt with FT_load. Returns
+  SUCCESS if the snapshot was written. Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * IO_ERROR if the file could not be written
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_save(const char *pcFile);
+
+/*
+  Rebuilds the FT from the snapshot in the file pcFile, written by
+  FT_save. The FT must be empty. The nodes are built directly under
+  their parents, and file contents are read into memory owned by the
+  FT (see FT_replaceFileContents). Returns SUCCESS if the FT was
+  rebuilt. Otherwise, leaves the FT empty and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * CONFLICTING_PATH if the FT is not empty or is being journaled
+  * IO_ERROR if the file could not be read or is not a valid snapshot
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_load(const char *pcFile);
+
+/*
+  Rebuilds the FT from the snapshot in the file pcFile like FT_load,
+  but without reading file contents up front: the file is mapped
+  privately into memory until FT_destroy, and each file's contents are
+  read in place from the mapping, paged in when first touched and
+  shared with other processes mapping the same snapshot. Contents are
+  copied into FT-owned memory only when first changed with
+  FT_writeFileRange or FT_appendFile. Returns the same statuses as
+  FT_load, and also CONFLICTING_PATH if a snapshot is already mapped.
+
+  The directories and files themselves are still built in memory, in
+  one pass over the snapshot, so loading takes time proportional to
+  their number: each keeps state that changes with the tree around it
+  (its parent, subtree totals and hash, and its links into the indexes
+  and caches), which a read-only mapping cannot hold.
+*/
+int FT_loadMapped(const char *pcFile);
+
+/*
+  Starts journaling changes to the FT, which must be empty. First
+  rebuilds the FT from the checkpoint snapshot in the file pcSnapshot
+  (if there is one) and then replays the changes recorded after it in
+  the journal in the file pcJournal (if there is one). From then on,
+  every successful FT_insertDir, FT_insertFile, FT_rmDir, FT_rmFile,
+  FT_move, FT_copy, FT_replaceFileContents, FT_writeFileRange, and
+  FT_appendFile is recorded in the journal, and the records are
+  flushed to disk as a group once every ulCommitWindow changes (or
+  after every change if ulCommitWindow is 0), by FT_sync, and by
+  FT_destroy. A crash loses at most the changes made since the last
+  flush. File contents rebuilt from the snapshot or journal are owned
+  by the FT (see FT_replaceFileContents). Returns SUCCESS if
+  journaling started. Otherwise, leaves the FT empty and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+                         or changes are already being journaled
+  * CONFLICTING_PATH if the FT is not empty
+  * IO_ERROR if the snapshot or journal could not be read or written
+  * MEMORY_ERROR if memory could not be allocated to complete request
+
+  While journaling, each change's record is appended before the change
+  is made, and watches hear of it only after both: a change that
+  cannot be recorded is not made, and its function returns
+  MEMORY_ERROR (FT_replaceFileContents returns NULL). A group commit
+  that fails does not fail the change that filled the window, which
+  is made and recorded; the records stay buffered for the next group
+  commit to retry, and FT_sync reports the failure.
+*/
+int FT_openJournal(const char *pcSnapshot, const char *pcJournal,
+                   size_t ulCommitWindow);
+
+/*
+  Flushes the journal's buffered records to disk, completing a group
+  commit early. Returns SUCCESS, INITIALIZATION_ERROR if the FT is not
+  in an initialized state or changes are not being journaled, or
+  IO_ERROR if the records could not be flushed.
+*/
+int FT_sync(void);
+
+/*
+  Writes the whole FT as a new checkpoint snapshot to the snapshot
+  file given to FT_openJournal, replacing the old one, and then starts
+  a new, empty journal, so that the journal never needs to replay
+  changes older than the last checkpoint. A crash part way through
+  leaves either the old snapshot and journal or the new ones. Returns
+  SUCCESS, or:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+                         or changes are not being journaled
+  * IO_ERROR if the snapshot or new journal could not be written
+  * MEMORY_ERROR if memory could not be allocated to complete request
+  If the snapshot was written but the new journal was not, journaling
+  stops, since the old journal no longer follows the snapshot.
+*/
+int FT_checkpoint(void);
+
+/*
+  Imports the local directory pcDir, with everything in it, as a new
+  directory of the FT with absolute path pcPath (inserted as with
+  FT_insertDir). Subdirectories and regular files become directories
+  and files of the FT, with file contents read into memory owned by
+  the FT (see FT_replaceFileContents); other entries, such as symbolic
+  links, are skipped. Returns SUCCESS if the directory was imported.
+  Otherwise, returns one of the statuses of FT_insertDir, or:
+  * IO_ERROR if pcDir or anything in it could not be read
+  * MEMORY_ERROR if memory could not be allocated to complete request
+  * QUOTA_EXCEEDED if what pcDir holds would take a directory above
+                   pcPath past its quota
+  in which case pcPath is removed again.
+*/
+int FT_importFromDisk(const char *pcDir, const char *pcPath);
+
+/*
+  Exports the whole FT into the local directory pcDir (created if it
+  does not exist): the root becomes a directory of pcDir, and every
+  directory and file below it a directory or file below that. Existing
+  directories are reused and existing files overwritten. Sets
+  *pulFiles and *pulBytes to the number of files and bytes written,
+  and *pdSeconds to the time the export took, from which throughput
+  in files/s and bytes/s follows. Returns SUCCESS if the FT was
+  exported. Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * IO_ERROR if something could not be created or written
+*/
+int FT_exportToDisk(const char *pcDir, size_t *pulFiles,
+                    size_t *pulBytes, double *pdSeconds);
+
 /*
   Sets the FT data structure to an initialized state.
   The data structure is initially empty.
@@ -149,4 +603,433 @@ int FT_destroy(void);
 */
 char *FT_toString(void);
 
+/*
+  Takes a snapshot of the FT: a read-only view of the FT as it is now,
+  which later changes to the FT do not affect. Taking it costs
+  constant time, since the snapshot shares the FT's tree: a change to
+  a node that a snapshot still sees first copies the node into it,
+  with each of its ancestors not yet copied, sharing their contents
+  and other children as described for FT_copy, and so costs time
+  proportional to the depth of the change for each snapshot held.
+  Sets *poSResult to the snapshot, which must be released with
+  FT_releaseSnapshot, and returns SUCCESS. Otherwise, sets *poSResult
+  to NULL and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * MEMORY_ERROR if memory could not be allocated to complete request
+
+  Changes to the FT never fail for want of memory to copy nodes into a
+  snapshot; the snapshot is lost instead, and reading it then fails
+  with MEMORY_ERROR. Contents owned by the client are shared by
+  pointer, so the client must leave them unchanged while a snapshot
+  may refer to them. A snapshot still held when the FT is destroyed
+  becomes empty.
+*/
+int FT_snapshot(FT_Snapshot_T *poSResult);
+
+/*
+  Looks up absolute path pcPath in snapshot oSSnapshot, returning the
+  statuses and setting *pbIsFile and *pulSize as described for
+  FT_stat, or returning MEMORY_ERROR if the snapshot was lost.
+*/
+int FT_snapshotStat(FT_Snapshot_T oSSnapshot, const char *pcPath,
+                    boolean *pbIsFile, size_t *pulSize);
+
+/*
+  Copies up to ulLength bytes of the contents of the file with
+  absolute path pcPath in snapshot oSSnapshot, starting at byte
+  ulOffset, into pvBuf, returning the statuses and setting *pulRead as
+  described for FT_readFileRange, or returning MEMORY_ERROR if the
+  snapshot was lost.
+*/
+int FT_snapshotRead(FT_Snapshot_T oSSnapshot, const char *pcPath,
+                    size_t ulOffset, void *pvBuf, size_t ulLength,
+                    size_t *pulRead);
+
+/*
+  Returns a string representation of snapshot oSSnapshot, as described
+  for FT_toString, or NULL if there is an allocation error or the
+  snapshot was lost.
+
+  Allocates memory for the returned string,
+  which is then owned by client!
+*/
+char *FT_snapshotToString(FT_Snapshot_T oSSnapshot);
+
+/*
+  Releases snapshot oSSnapshot, freeing its copies of the FT's nodes
+  and the nodes removed from the FT that it was the last to see.
+  Contents it shared with the FT are freed once nothing else shares
+  them.
+*/
+void FT_releaseSnapshot(FT_Snapshot_T oSSnapshot);
+
+/*
+  Reports the differences between two trees, each either a snapshot
+  or the FT itself (when oSFrom or oSTo is NULL), as the records that
+  would turn the tree oSFrom into the tree oSTo, passing each in turn
+  to pfReport along with pvExtra. An added directory is reported
+  before everything below it, each of which is reported as added too;
+  a removed directory is reported once, for its whole subtree; and a
+  directory or file that changes type is reported removed and then
+  added. The trees are walked in lockstep over their sorted children,
+  and subtrees whose hashes are equal (see FT_subtreeHash) are skipped
+  without being entered, so the time taken grows with the size of the
+  differences rather than the size of the trees. A record's path and
+  contents are only valid during the call. Returns SUCCESS if every
+  difference was reported. Otherwise, stops and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * MEMORY_ERROR if memory could not be allocated to complete request,
+                 or either snapshot was lost (see FT_snapshot)
+  * IO_ERROR if spilled contents could not be read
+  * the first status other than SUCCESS that pfReport returned
+*/
+int FT_diff(FT_Snapshot_T oSFrom, FT_Snapshot_T oSTo,
+            int (*pfReport)(const struct ftDiffRecord *psRecord,
+                            void *pvExtra),
+            void *pvExtra);
+
+/*
+  Applies the ulCount records at psRecords, such as those reported by
+  FT_diff, to the FT in order, as one transaction (see FT_begin):
+  either every record is applied, or none is and the FT is left as it
+  was. Added and modified files get FT-owned copies of the records'
+  contents (see FT_replaceFileContents), held to the quotas of the
+  directories above them. If a transaction is already open, the
+  records are applied as part of it instead, and if one fails the
+  records before it are left for FT_abort to take back.
+  Returns SUCCESS if every record was applied. Otherwise, returns the
+  status of the first record that could not be, as for FT_insertDir,
+  FT_insertFile, FT_rmDir, FT_rmFile, and FT_writeFileRange, or:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+*/
+int FT_applyPatch(const struct ftDiffRecord *psRecords,
+                  size_t ulCount);
+
+/*
+  Starts watching the subtree at absolute path pcPath, which need not
+  exist yet, for the kinds of change in uiKinds (FT_EVENT_CREATE,
+  FT_EVENT_REMOVE, and FT_EVENT_MODIFY, OR-ed together), and sets
+  *pulWatch to the watch's identifier. From then on, every change
+  made to the subtree through the FT's functions, including the
+  creation or removal of pcPath along with an ancestor and the changes
+  FT_abort takes back, queues an event in a bounded ring for
+  FT_drainEvents. A move is reported as a removal at its source and a
+  creation at its destination. An event repeating the path and watch
+  of the newest queued event is folded into it. When the ring is full,
+  events are dropped and the overflow is flagged. Changes rebuilt by
+  FT_load, FT_loadMapped, or FT_openJournal are not reported. When
+  nothing is watched, changes cost only a test. Returns SUCCESS, or:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_watch(const char *pcPath, unsigned int uiKinds,
+             size_t *pulWatch);
+
+/*
+  Stops the watch with identifier ulWatch, leaving its queued events
+  to be drained. Returns SUCCESS, or:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * NO_SUCH_PATH if there is no such watch
+*/
+int FT_unwatch(size_t ulWatch);
+
+/*
+  Moves up to ulMax of the oldest queued events into psEvents, oldest
+  first, and sets *pulCount to the number moved; their paths must be
+  freed by the client. Sets *pbOverflowed to TRUE if events were
+  dropped since the last drain, in which case the client should look
+  at its watched subtrees afresh, and to FALSE otherwise. Returns
+  SUCCESS, or INITIALIZATION_ERROR if the FT is not in an initialized
+  state. FT_destroy stops every watch and frees every queued event.
+*/
+int FT_drainEvents(struct ftEvent *psEvents, size_t ulMax,
+                   size_t *pulCount, boolean *pbOverflowed);
+
+/*
+  Walks the FT for the directories and files whose absolute paths
+  match the glob pcPattern, passing the path of each, directories
+  before what is below them and siblings in sorted order, to pfMatch
+  along with whether it is a file and pvExtra. A pattern has
+  components separated by '/' like a path, each of which is either
+  "**", matching any number (including none) of whole components, or
+  a name in which '*' matches any run of characters, '?' any one
+  character, and "[...]" any one character in the bracketed set or
+  range (or not in it, if the set starts with '!' or '^'). The
+  pattern is compiled once, and each node's progress through it
+  follows from its parent's and its own name, so subtrees that cannot
+  hold a match are skipped without being entered, and a component
+  with no wildcards is looked up by binary search among the sorted
+  children rather than compared with each of them: the time taken
+  grows with the part of the tree the pattern can reach rather than
+  the whole tree. A path is only valid during the call, which must
+  not change the FT. Returns SUCCESS if every match was reported.
+  Otherwise, stops and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcPattern is empty, begins or ends with a '/',
+             contains consecutive '/' delimiters, or has a '[' with
+             no matching ']'
+  * MEMORY_ERROR if memory could not be allocated to complete request
+  * the first status other than SUCCESS that pfMatch returned
+*/
+int FT_glob(const char *pcPattern,
+            int (*pfMatch)(const char *pcPath, boolean isFile,
+                           void *pvExtra),
+            void *pvExtra);
+
+/*
+  Passes the absolute path of each directory and file in the FT from
+  pcLow (inclusive) up to pcHigh (exclusive), in path order, to
+  pfVisit along with whether it is a file and pvExtra, stopping after
+  ulLimit of them unless ulLimit is 0. Path order compares paths
+  component by component, so a directory comes right before what is
+  below it and siblings come in sorted order, as Node_compare keeps
+  them. Either bound may be NULL to leave that end of the range open,
+  and neither need exist in the FT. The scan seeks to pcLow by binary
+  search down the sorted children, and then walks on from there with
+  an explicit stack of the directories above it, so nothing is
+  visited before pcLow or after the scan stops, and nothing is copied
+  but the current path. A path is only valid during the call, which
+  must not change the FT. Returns SUCCESS if the scan reached its
+  end. Otherwise, stops and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcLow or pcHigh does not represent a well-formatted
+             path
+  * MEMORY_ERROR if memory could not be allocated to complete request
+  * the first status other than SUCCESS that pfVisit returned
+*/
+int FT_scanRange(const char *pcLow, const char *pcHigh, size_t ulLimit,
+                 int (*pfVisit)(const char *pcPath, boolean isFile,
+                                void *pvExtra),
+                 void *pvExtra);
+
+/*
+  Starts keeping a secondary index of the FT's directories and files
+  by name, for FT_findByName. The index is built from the whole tree
+  once, and then kept up to date as each directory or file is
+  inserted, removed, moved, or copied, at a small constant cost per
+  node linked in or out. Does nothing if the index is already kept.
+  Returns SUCCESS, or:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_enableNameIndex(void);
+
+/*
+  Stops keeping the name index and frees it, as FT_destroy also does,
+  along with the trigram index if it is kept. Returns SUCCESS, or
+  INITIALIZATION_ERROR if the FT is not in an initialized state.
+*/
+int FT_disableNameIndex(void);
+
+/*
+  Passes the absolute path of each directory and file in the FT whose
+  name (the last component of its path) is pcName, in no particular
+  order, to pfMatch along with whether it is a file and pvExtra. With
+  the name index kept (see FT_enableNameIndex), the matches are found
+  with one hash lookup, in time proportional to their number;
+  otherwise the whole tree is walked. A path is only valid during the
+  call, which must not change the FT. Returns SUCCESS if every match
+  was reported. Otherwise, stops and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcName is empty or contains a '/'
+  * MEMORY_ERROR if memory could not be allocated to complete request
+  * the first status other than SUCCESS that pfMatch returned
+*/
+int FT_findByName(const char *pcName,
+                  int (*pfMatch)(const char *pcPath, boolean isFile,
+                                 void *pvExtra),
+                  void *pvExtra);
+
+/*
+  Starts keeping a trigram index of the contents of the FT's files,
+  for FT_grep, along with the name index it rides on (see
+  FT_enableNameIndex). Each file's contents are indexed afresh by the
+  first FT_grep after it is inserted or changed, so a file changed
+  many times between searches is indexed once. Does nothing if the
+  index is already kept. Returns SUCCESS, or:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_enableTextIndex(void);
+
+/*
+  Stops keeping the trigram index and frees it, as FT_disableNameIndex
+  and FT_destroy also do. Returns SUCCESS, or INITIALIZATION_ERROR if
+  the FT is not in an initialized state.
+*/
+int FT_disableTextIndex(void);
+
+/*
+  Passes the absolute path of each file in the FT whose contents hold
+  the string pcPattern (without its terminating '\0'), in no
+  particular order, to pfMatch along with the offset of the first
+  occurrence and pvExtra. With the trigram index kept (see
+  FT_enableTextIndex), only files holding every trigram of pcPattern
+  are checked; otherwise every file is. A path is only valid during
+  the call, which must not change the FT. Returns SUCCESS if every
+  match was reported. Otherwise, stops and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * MEMORY_ERROR if memory could not be allocated to complete request
+  * IO_ERROR if spilled contents could not be brought back
+  * the first status other than SUCCESS that pfMatch returned
+*/
+int FT_grep(const char *pcPattern,
+            int (*pfMatch)(const char *pcPath, size_t ulOffset,
+                           void *pvExtra),
+            void *pvExtra);
+
+/*
+  Starts keeping a cache of up to ulEntries (at least 1) absolute
+  paths looked up in the FT, mapping each path string exactly as
+  passed to the directory or file it names, so that looking it up
+  again skips parsing the path and walking down the tree. Removing or
+  moving a directory or file (including by FT_abort) invalidates just
+  the paths through it: each hit is checked by following parent links
+  up from the node it names, with no string comparisons, that nothing
+  on its path has been removed or moved since it was cached. Room for
+  new entries is made with CLOCK eviction. Restarts the cache, empty,
+  if it is already kept. Returns SUCCESS, or:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_enableLookupCache(size_t ulEntries);
+
+/*
+  Stops keeping the lookup cache and frees it, as FT_destroy also
+  does. Returns SUCCESS, or INITIALIZATION_ERROR if the FT is not in
+  an initialized state.
+*/
+int FT_disableLookupCache(void);
+
+/*
+  Sets *pulEntries to the number of paths in the lookup cache,
+  *pulHits and *pulMisses to the numbers of lookups it answered and
+  did not, *pulEvictions to the number of paths evicted to make room,
+  and *pulProbes to the number of cached paths compared over all
+  lookups (whose ratio to the lookups measures their cost), each
+  since the cache was started. Returns SUCCESS, or:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state or
+                         the lookup cache is not kept
+*/
+int FT_getLookupStats(size_t *pulEntries, size_t *pulHits,
+                      size_t *pulMisses, size_t *pulEvictions,
+                      size_t *pulProbes);
+
+/*
+  Starts keeping a counting Bloom filter over the absolute paths of
+  the FT's directories and files, along with the name index it rides
+  on (see FT_enableNameIndex), so that FT_containsDir and
+  FT_containsFile answer most paths that are not in the FT after one
+  hash of the path, without parsing it or walking down the tree. The
+  filter is sized for ulPaths (at least 1) paths and doubled whenever
+  it holds more; it is kept up to date as nodes are inserted and
+  removed, and a move or rename costs time proportional to the size
+  of the subtree moved while it is kept. Restarts the filter if it is
+  already kept. Returns SUCCESS, or:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_enablePathFilter(size_t ulPaths);
+
+/*
+  Stops keeping the path filter and frees it, as FT_disableNameIndex
+  and FT_destroy also do. Returns SUCCESS, or INITIALIZATION_ERROR if
+  the FT is not in an initialized state.
+*/
+int FT_disablePathFilter(void);
+
+/*
+  Sets *pulPaths to the number of paths in the path filter,
+  *pulCounters to its number of counters, and *pulQueries and
+  *pulRejections to the numbers of paths FT_containsDir and
+  FT_containsFile asked it about and of those it found absent, each
+  since the filter was started. Returns SUCCESS, or:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state or
+                         the path filter is not kept
+*/
+int FT_getPathFilterStats(size_t *pulPaths, size_t *pulCounters,
+                          size_t *pulQueries, size_t *pulRejections);
+
+/*
+  Opens a handle on the directory with absolute path pcPath, through
+  which its children are reached by name alone, in time logarithmic
+  in their number, without parsing or walking a path. The handle
+  follows the directory wherever it is moved or renamed, and pins it,
+  so that once it is removed (including by FT_destroy) operations
+  through the handle safely fail with NO_SUCH_PATH; it becomes usable
+  again if FT_abort puts the directory back. Checking that the
+  directory is still in the FT costs a comparison while nothing has
+  been unlinked or moved, and otherwise a walk up to the root. Sets
+  *poHResult to the handle, which must be closed with
+  FT_closeDirHandle, and returns SUCCESS. Otherwise, sets *poHResult
+  to NULL and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * CONFLICTING_PATH if the root exists but is not a prefix of pcPath
+  * NO_SUCH_PATH if absolute path pcPath does not exist in the FT
+  * NOT_A_DIRECTORY if pcPath is in the FT as a file not a directory
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_openDirHandle(const char *pcPath, FT_DirHandle_T *poHResult);
+
+/*
+  Closes handle oHDir, freeing it, and the directory it refers to if
+  that was removed and no other handle refers to it.
+*/
+void FT_closeDirHandle(FT_DirHandle_T oHDir);
+
+/*
+  Inserts a new directory named pcName into the directory of handle
+  oHDir. Returns SUCCESS if the new directory is inserted successfully.
+  Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcName is empty or contains a '/'
+  * NO_SUCH_PATH if the handle's directory has been removed
+  * ALREADY_IN_TREE if the directory already has a child named pcName
+  * MEMORY_ERROR if memory could not be allocated to complete request
+  * QUOTA_EXCEEDED if the new directory would take the directory or
+                   one above it past its quota (see FT_setQuota)
+*/
+int FT_insertDirAt(FT_DirHandle_T oHDir, const char *pcName);
+
+/*
+  Inserts a new file named pcName, with file contents pvContents of
+  size ulLength bytes, into the directory of handle oHDir. Returns
+  SUCCESS or an error status as described for FT_insertDirAt.
+*/
+int FT_insertFileAt(FT_DirHandle_T oHDir, const char *pcName,
+                    void *pvContents, size_t ulLength);
+
+/*
+  Returns TRUE if the directory of handle oHDir has a child, directory
+  or file, named pcName, and FALSE if not or if there is an error
+  while checking.
+*/
+boolean FT_containsAt(FT_DirHandle_T oHDir, const char *pcName);
+
+/*
+  Looks up the child named pcName of the directory of handle oHDir,
+  setting *pbIsFile and *pulSize as described for FT_stat. Returns
+  SUCCESS, or:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcName is empty or contains a '/'
+  * NO_SUCH_PATH if the handle's directory has been removed or has no
+                 child named pcName
+*/
+int FT_statAt(FT_DirHandle_T oHDir, const char *pcName,
+              boolean *pbIsFile, size_t *pulSize);
+
+/*
+  Removes the file named pcName from the directory of handle oHDir.
+  Returns SUCCESS if found and removed. Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcName is empty or contains a '/'
+  * NO_SUCH_PATH if the handle's directory has been removed or has no
+                 child named pcName
+  * NOT_A_FILE if the child named pcName is a directory not a file
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_rmFileAt(FT_DirHandle_T oHDir, const char *pcName);
+
 #endif
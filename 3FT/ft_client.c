@@ -10,14 +10,63 @@
 #include <string.h>
 #include "ft.h"
 
+/* Appends a line for the difference psRecord, "+", "-", or "*" and
+   its path, to the string pvLines. Returns SUCCESS. */
+static int appendDiff(const struct ftDiffRecord *psRecord,
+                      void *pvLines) {
+  strcat(pvLines, psRecord->eKind == FT_DIFF_ADD ? "+ " :
+                  psRecord->eKind == FT_DIFF_REMOVE ? "- " : "* ");
+  strcat(pvLines, psRecord->pcPath);
+  strcat(pvLines, "\n");
+  return SUCCESS;
+}
+
+/* Adds 1 to the count at pvCount, for any difference psRecord.
+   Returns SUCCESS. */
+static int countDiff(const struct ftDiffRecord *psRecord,
+                     void *pvCount) {
+  (*(size_t *) pvCount)++;
+  return SUCCESS;
+}
+
+/* Appends the path pcPath and a newline to the string pvLines.
+   Returns SUCCESS. */
+static int appendMatch(const char *pcPath, boolean isFile,
+                       void *pvLines) {
+  strcat(pvLines, pcPath);
+  strcat(pvLines, "\n");
+  return SUCCESS;
+}
+
+/* Appends the path pcPath, a space, the offset ulOffset, and a
+   newline to the string pvLines. Returns SUCCESS. */
+static int appendGrep(const char *pcPath, size_t ulOffset,
+                      void *pvLines) {
+  sprintf((char *) pvLines + strlen(pvLines), "%s %lu\n", pcPath,
+          (unsigned long) ulOffset);
+  return SUCCESS;
+}
+
 /* Tests the FT implementation with an assortment of checks.
    Prints the status of the data structure along the way to stderr.
    Returns 0. */
 int main(void) {
   enum {ARRLEN = 1000};
   char* temp;
+  char* saved;
   boolean bIsFile;
   size_t l;
+  size_t hits, misses, evictions;
+  FILE *file;
+  size_t files, dirs, bytes;
+  unsigned long hash, otherHash;
+  double seconds;
+  FT_Snapshot_T snap, otherSnap;
+  FT_DirHandle_T handle, otherHandle;
+  struct ftDiffRecord patch[6];
+  struct ftEvent events[4];
+  size_t watch, otherWatch;
+  boolean bOverflowed;
   char arr[ARRLEN];
   arr[0] = '\0';
 
@@ -41,205 +90,1200 @@ int main(void) {
      and toString should return the empty string.
   */
   assert(FT_init() == SUCCESS);
-  /* assert(FT_containsDir("1root/2child/3gkid") == FALSE); */
-  /* assert(FT_containsFile("1root/2child/3gkid/4ggk") == FALSE); */
-  /* assert((temp = FT_toString()) != NULL); */
-  /* assert(!strcmp(temp,"")); */
-  /* free(temp); */
-
-  /* /\* A valid path must not: */
-  /*    * be the empty string */
-  /*    * start with a '/' */
-  /*    * end with a '/' */
-  /*    * have consecutive '/' delimiters. */
-  /* *\/ */
-  /* assert(FT_insertDir("") == BAD_PATH); */
-  /* assert(FT_insertDir("/1root/2child") == BAD_PATH); */
-  /* assert(FT_insertDir("1root/2child/") == BAD_PATH); */
-  /* assert(FT_insertDir("1root//2child") == BAD_PATH); */
-  /* assert(FT_insertFile("", NULL, 0) == BAD_PATH); */
-  /* assert(FT_insertFile("/1root/2child", NULL, 0) == BAD_PATH); */
-  /* assert(FT_insertFile("1root/2child/", NULL, 0) == BAD_PATH); */
-  /* assert(FT_insertFile("1root//2child", NULL, 0) == BAD_PATH); */
-
-  /* /\* putting a file at the root is illegal *\/ */
-  /* assert(FT_insertFile("A",NULL,0) == CONFLICTING_PATH); */
-
-  /* /\* After insertion, the data structure should contain every prefix */
-  /*    of the inserted path, toString should return a string with these */
-  /*    prefixes, trying to insert it again should return */
-  /*    ALREADY_IN_TREE, and trying to insert some other root should */
-  /*    return CONFLICTING_PATH. */
-  /* *\/ */
-  /* assert(FT_insertDir("1root/2child/3gkid") == SUCCESS); */
-  /* assert(FT_containsDir("1root") == TRUE); */
-  /* assert(FT_containsFile("1root") == FALSE); */
-  /* assert(FT_containsDir("1root/2child") == TRUE); */
-  /* assert(FT_containsFile("1root/2child") == FALSE); */
-  /* assert(FT_containsDir("1root/2child/3gkid") == TRUE); */
-  /* assert(FT_containsFile("1root/2child/3gkid") == FALSE); */
-  /* assert(FT_insertFile("1root/2second/3gfile", NULL, 0) == SUCCESS); */
-  /* assert(FT_containsDir("1root/2second") == TRUE); */
-  /* assert(FT_containsFile("1root/2second") == FALSE); */
-  /* assert(FT_containsDir("1root/2second/3gfile") == FALSE); */
-  /* assert(FT_containsFile("1root/2second/3gfile") == TRUE); */
-  /* assert(FT_getFileContents("1root/2second/3gfile") == NULL); */
-  /* assert(FT_insertDir("1root/2child/3gkid") == ALREADY_IN_TREE); */
-  /* assert(FT_insertFile("1root/2child/3gkid", NULL, 0) == */
-  /*        ALREADY_IN_TREE); */
-  /* assert(FT_insertDir("1otherroot") == CONFLICTING_PATH); */
-  /* assert(FT_insertDir("1otherroot/2d") == CONFLICTING_PATH); */
-  /* assert(FT_insertFile("1otherroot/2f", NULL, 0) == CONFLICTING_PATH); */
-
-  /* /\* Trying to insert a third child should succeed, unlike in BDT *\/ */
-  /* assert(FT_insertFile("1root/2third", NULL, 0) == SUCCESS); */
-  /* assert(FT_insertDir("1root/2ok/3yes/4indeed") == SUCCESS); */
-  /* assert(FT_containsDir("1root") == TRUE); */
-  /* assert(FT_containsDir("1root/2child") == TRUE); */
-  /* assert(FT_containsDir("1root/2second") == TRUE); */
-  /* assert(FT_containsDir("1root/2third") == FALSE); */
-  /* assert(FT_containsFile("1root/2third") == TRUE); */
-  /* assert(FT_containsDir("1root/2ok") == TRUE); */
-  /* assert(FT_containsDir("1root/2ok/3yes") == TRUE); */
-  /* assert(FT_containsDir("1root/2ok/3yes/4indeed") == TRUE); */
-  /* assert((temp = FT_toString()) != NULL); */
-  /* fprintf(stderr, "Checkpoint 1:\n%s\n", temp); */
-  /* free(temp); */
-
-  /* /\* Children must be unique, but individual directories or files */
-  /*    in different paths needn't be */
-  /* *\/ */
-  /* assert(FT_insertFile("1root/2child/3gkid", NULL, 0) == */
-  /*        ALREADY_IN_TREE); */
-  /* assert(FT_insertDir("1root/2child/3gkid") == ALREADY_IN_TREE); */
-  /* assert(FT_insertDir("1root/2child/3gk2/4ggk") == SUCCESS); */
-  /* assert(FT_containsDir("1root/2child/3gk2/4ggk") == TRUE); */
-  /* assert(FT_containsFile("1root/2child/3gk2/4ggk") == FALSE); */
-  /* assert(FT_insertDir("1root/2child/2child/2child") == SUCCESS); */
-  /* assert(FT_containsDir("1root/2child/2child/2child") == TRUE); */
-  /* assert(FT_containsFile("1root/2child/2child/2child") == FALSE); */
-  /* assert(FT_insertFile("1root/2child/2child/2child/2child", NULL, 0) == */
-  /*        SUCCESS); */
-  /* assert(FT_containsDir("1root/2child/2child/2child/2child") == FALSE); */
-  /* assert(FT_containsFile("1root/2child/2child/2child/2child") == TRUE); */
-  /* assert((temp = FT_toString()) != NULL); */
-  /* fprintf(stderr, "Checkpoint 2:\n%s\n", temp); */
-  /* free(temp); */
-
-  /* /\* Attempting to insert a child of a file is illegal *\/ */
-  /* assert(FT_insertDir("1root/2third/3nopeD") == NOT_A_DIRECTORY); */
-  /* assert(FT_containsDir("1root/2third/3nopeD") == FALSE); */
-  /* assert(FT_insertFile("1root/2third/3nopeF", NULL, 0) == */
-  /*        NOT_A_DIRECTORY); */
-  /* assert(FT_containsFile("1root/2third/3nopeF") == FALSE); */
-
-
-  /* /\* calling rm* on a path that doesn't exist should return */
-  /*    NO_SUCH_PATH, but on a path that does exist with the right */
-  /*    flavor should return SUCCESS and remove entire subtree rooted at */
-  /*    that path */
-  /* *\/ */
-  /* assert(FT_containsDir("1root/2child/3gkid") == TRUE); */
-  /* assert(FT_containsFile("1root/2second/3gfile") == TRUE); */
-  /* assert(FT_containsDir("1root/2second/3gfile") == FALSE); */
-  /* assert(FT_rmDir("1root/2child/3nope") == NO_SUCH_PATH); */
-  /* assert(FT_rmDir("1root/2second/3gfile") == NOT_A_DIRECTORY); */
-  /* assert(FT_rmFile("1root/2child/3nope") == NO_SUCH_PATH); */
-  /* assert(FT_rmFile("1root/2child/3gkid") == NOT_A_FILE); */
-  /* assert(FT_rmDir("1root/2child/3gkid") == SUCCESS); */
-  /* assert(FT_rmFile("1root/2second/3gfile") == SUCCESS); */
-  /* assert(FT_containsDir("1root/2child/3gkid") == FALSE); */
-  /* assert(FT_containsFile("1root/2second/3gfile") == FALSE); */
-  /* assert(FT_rmFile("1root/2child/2child/2child/2child") == SUCCESS); */
-  /* assert(FT_rmDir("1root/2child/2child") == SUCCESS); */
-  /* assert((temp = FT_toString()) != NULL); */
-  /* fprintf(stderr, "Checkpoint 3:\n%s\n", temp); */
-  /* free(temp); */
-
-  /* /\* removing the root doesn't uninitialize the structure *\/ */
-  /* assert(FT_rmDir("1anotherroot") == CONFLICTING_PATH); */
-  /* assert(FT_rmDir("1root") == SUCCESS); */
-  /* assert(FT_rmDir("1root") == NO_SUCH_PATH); */
-  /* assert(FT_containsDir("1root/2child") == FALSE); */
-  /* assert(FT_containsDir("1root") == FALSE); */
-  /* assert(FT_rmDir("1root") == NO_SUCH_PATH); */
-  /* assert(FT_rmDir("1anotherroot") == NO_SUCH_PATH); */
-  /* assert((temp = FT_toString()) != NULL); */
-  /* assert(!strcmp(temp,"")); */
-  /* free(temp); */
-
-  /* /\* checking that file contents work as expected *\/ */
-  /* assert(FT_insertDir("1root") == SUCCESS); */
-  /* assert(FT_insertFile("1root/H", "hello, world!", */
-  /*                      strlen("hello, world!")+1) == SUCCESS); */
-  /* assert(!strcmp(FT_getFileContents("1root/H"), "hello, world!")); */
-  /* bIsFile = FALSE; */
-  /* l = -1; */
-  /* assert(FT_stat("1root/H", &bIsFile, &l) == SUCCESS); */
-  /* assert(bIsFile == TRUE); */
-  /* assert(l == (strlen("hello, world!")+1)); */
-  /* assert(!strcmp(FT_replaceFileContents("1root/H","Kernighan", */
-  /*                                       strlen("Kernighan")+1), */
-  /*                "hello, world!")); */
-  /* assert(!strcmp((char*)FT_getFileContents("1root/H"),"Kernighan")); */
-  /* assert(FT_stat("1root/H", &bIsFile, &l) == SUCCESS); */
-  /* assert(bIsFile == TRUE); */
-  /* assert(l == (strlen("Kernighan")+1)); */
-  /* assert(!strcmp(FT_replaceFileContents("1root/H",arr,ARRLEN), */
-  /*                "Kernighan")); */
-  /* assert(!strcmp((char*)FT_getFileContents("1root/H"),"")); */
-  /* assert(FT_stat("1root/H", &bIsFile, &l) == SUCCESS); */
-  /* assert(bIsFile == TRUE); */
-  /* assert(l == ARRLEN); */
-  /* assert(FT_rmFile("1root/H") == SUCCESS); */
-  /* assert(FT_insertDir("1root/2d") == SUCCESS); */
-  /* assert(FT_stat("1root/2d", &bIsFile, &l) == SUCCESS); */
-  /* assert(bIsFile == FALSE); */
-  /* assert(l == ARRLEN); */
-  /* assert(FT_stat("1root/H", &bIsFile, &l) == NO_SUCH_PATH); */
-  /* assert(bIsFile == FALSE); */
-  /* assert(l == ARRLEN); */
-  /* assert(FT_rmDir("1root") == SUCCESS); */
-  /* assert((temp = FT_toString()) != NULL); */
-  /* assert(!strcmp(temp,"")); */
-  /* free(temp); */
-
-  /* /\* children should be printed in lexicographic order, */
-  /*    depth first, file children before directory children *\/ */
-  /* assert(FT_insertDir("1root/y") == SUCCESS); */
-  /* assert((temp = FT_toString()) != NULL); */
-  /* fprintf(stderr, "Checkpoint 4.1:\n%s\n", temp); */
-  /* free(temp); */
-  /* assert(FT_insertDir("1root/x") == SUCCESS); */
-  /* assert((temp = FT_toString()) != NULL); */
-  /* fprintf(stderr, "Checkpoint 4.2:\n%s\n", temp); */
-  /* free(temp); */
-  /* assert(FT_insertFile("1root/x/C", "Ritchie", */
-  /*                      strlen("Ritchie")+1) == SUCCESS); */
-  /* assert(FT_insertDir("1root/x/c++") == SUCCESS); */
-  /* assert((temp = FT_toString()) != NULL); */
-  /* fprintf(stderr, "Checkpoint 4.3:\n%s\n", temp); */
-  /* free(temp); */
-  /* assert(FT_insertFile("1root/x/B", "Thompson", */
-  /*                      strlen("Thompson")+1) == SUCCESS); */
-  /* assert((temp = FT_toString()) != NULL); */
-  /* fprintf(stderr, "Checkpoint 4.4:\n%s\n", temp); */
-  /* free(temp); */
-  /* assert(FT_insertDir("1root/y/CHILD1DIR") == SUCCESS); */
-  /* assert(FT_insertDir("1root/y/CHILD2DIR") == SUCCESS); */
-  /* assert(FT_insertFile("1root/y/CHILD2FILE", NULL, 0) == SUCCESS); */
-  /* assert(FT_insertDir("1root/y/CHILD3DIR") == SUCCESS); */
-  /* assert(FT_insertFile("1root/y/CHILD1FILE", NULL, 0) == SUCCESS); */
-  /* assert(FT_insertDir("1root/y/CHILD2DIR/CHILD4DIR") == SUCCESS); */
-  /* assert((temp = FT_toString()) != NULL); */
-  /* fprintf(stderr, "Checkpoint 4.5:\n%s\n", temp); */
-  /* free(temp); */
-
-  /* assert(FT_destroy() == SUCCESS); */
-  /* assert(FT_destroy() == INITIALIZATION_ERROR); */
-  /* assert(FT_containsDir("1root") == FALSE); */
-  /* assert(FT_containsFile("1root") == FALSE); */
-  /* assert((temp = FT_toString()) == NULL); */
+  assert(FT_containsDir("1root/2child/3gkid") == FALSE);
+  assert(FT_containsFile("1root/2child/3gkid/4ggk") == FALSE);
+  assert((temp = FT_toString()) != NULL);
+  assert(!strcmp(temp,""));
+  free(temp);
+
+  /* A valid path must not:
+     * be the empty string
+     * start with a '/'
+     * end with a '/'
+     * have consecutive '/' delimiters.
+  */
+  assert(FT_insertDir("") == BAD_PATH);
+  assert(FT_insertDir("/1root/2child") == BAD_PATH);
+  assert(FT_insertDir("1root/2child/") == BAD_PATH);
+  assert(FT_insertDir("1root//2child") == BAD_PATH);
+  assert(FT_insertFile("", NULL, 0) == BAD_PATH);
+  assert(FT_insertFile("/1root/2child", NULL, 0) == BAD_PATH);
+  assert(FT_insertFile("1root/2child/", NULL, 0) == BAD_PATH);
+  assert(FT_insertFile("1root//2child", NULL, 0) == BAD_PATH);
+
+  /* putting a file at the root is illegal */
+  assert(FT_insertFile("A",NULL,0) == CONFLICTING_PATH);
+
+  /* After insertion, the data structure should contain every prefix
+     of the inserted path, toString should return a string with these
+     prefixes, trying to insert it again should return
+     ALREADY_IN_TREE, and trying to insert some other root should
+     return CONFLICTING_PATH.
+  */
+  assert(FT_insertDir("1root/2child/3gkid") == SUCCESS);
+  assert(FT_containsDir("1root") == TRUE);
+  assert(FT_containsFile("1root") == FALSE);
+  assert(FT_containsDir("1root/2child") == TRUE);
+  assert(FT_containsFile("1root/2child") == FALSE);
+  assert(FT_containsDir("1root/2child/3gkid") == TRUE);
+  assert(FT_containsFile("1root/2child/3gkid") == FALSE);
+  assert(FT_insertFile("1root/2second/3gfile", NULL, 0) == SUCCESS);
+  assert(FT_containsDir("1root/2second") == TRUE);
+  assert(FT_containsFile("1root/2second") == FALSE);
+  assert(FT_containsDir("1root/2second/3gfile") == FALSE);
+  assert(FT_containsFile("1root/2second/3gfile") == TRUE);
+  assert(FT_getFileContents("1root/2second/3gfile") == NULL);
+  assert(FT_insertDir("1root/2child/3gkid") == ALREADY_IN_TREE);
+  assert(FT_insertFile("1root/2child/3gkid", NULL, 0) ==
+         ALREADY_IN_TREE);
+  assert(FT_insertDir("1otherroot") == CONFLICTING_PATH);
+  assert(FT_insertDir("1otherroot/2d") == CONFLICTING_PATH);
+  assert(FT_insertFile("1otherroot/2f", NULL, 0) == CONFLICTING_PATH);
+
+  /* Trying to insert a third child should succeed, unlike in BDT */
+  assert(FT_insertFile("1root/2third", NULL, 0) == SUCCESS);
+  assert(FT_insertDir("1root/2ok/3yes/4indeed") == SUCCESS);
+  assert(FT_containsDir("1root") == TRUE);
+  assert(FT_containsDir("1root/2child") == TRUE);
+  assert(FT_containsDir("1root/2second") == TRUE);
+  assert(FT_containsDir("1root/2third") == FALSE);
+  assert(FT_containsFile("1root/2third") == TRUE);
+  assert(FT_containsDir("1root/2ok") == TRUE);
+  assert(FT_containsDir("1root/2ok/3yes") == TRUE);
+  assert(FT_containsDir("1root/2ok/3yes/4indeed") == TRUE);
+  assert((temp = FT_toString()) != NULL);
+  fprintf(stderr, "Checkpoint 1:\n%s\n", temp);
+  free(temp);
+
+  /* Children must be unique, but individual directories or files
+     in different paths needn't be
+  */
+  assert(FT_insertFile("1root/2child/3gkid", NULL, 0) ==
+         ALREADY_IN_TREE);
+  assert(FT_insertDir("1root/2child/3gkid") == ALREADY_IN_TREE);
+  assert(FT_insertDir("1root/2child/3gk2/4ggk") == SUCCESS);
+  assert(FT_containsDir("1root/2child/3gk2/4ggk") == TRUE);
+  assert(FT_containsFile("1root/2child/3gk2/4ggk") == FALSE);
+  assert(FT_insertDir("1root/2child/2child/2child") == SUCCESS);
+  assert(FT_containsDir("1root/2child/2child/2child") == TRUE);
+  assert(FT_containsFile("1root/2child/2child/2child") == FALSE);
+  assert(FT_insertFile("1root/2child/2child/2child/2child", NULL, 0) ==
+         SUCCESS);
+  assert(FT_containsDir("1root/2child/2child/2child/2child") == FALSE);
+  assert(FT_containsFile("1root/2child/2child/2child/2child") == TRUE);
+  assert((temp = FT_toString()) != NULL);
+  fprintf(stderr, "Checkpoint 2:\n%s\n", temp);
+  free(temp);
+
+  /* Attempting to insert a child of a file is illegal */
+  assert(FT_insertDir("1root/2third/3nopeD") == NOT_A_DIRECTORY);
+  assert(FT_containsDir("1root/2third/3nopeD") == FALSE);
+  assert(FT_insertFile("1root/2third/3nopeF", NULL, 0) ==
+         NOT_A_DIRECTORY);
+  assert(FT_containsFile("1root/2third/3nopeF") == FALSE);
+
+
+  /* calling rm* on a path that doesn't exist should return
+     NO_SUCH_PATH, but on a path that does exist with the right
+     flavor should return SUCCESS and remove entire subtree rooted at
+     that path
+  */
+  assert(FT_containsDir("1root/2child/3gkid") == TRUE);
+  assert(FT_containsFile("1root/2second/3gfile") == TRUE);
+  assert(FT_containsDir("1root/2second/3gfile") == FALSE);
+  assert(FT_rmDir("1root/2child/3nope") == NO_SUCH_PATH);
+  assert(FT_rmDir("1root/2second/3gfile") == NOT_A_DIRECTORY);
+  assert(FT_rmFile("1root/2child/3nope") == NO_SUCH_PATH);
+  assert(FT_rmFile("1root/2child/3gkid") == NOT_A_FILE);
+  assert(FT_rmDir("1root/2child/3gkid") == SUCCESS);
+  assert(FT_rmFile("1root/2second/3gfile") == SUCCESS);
+  assert(FT_containsDir("1root/2child/3gkid") == FALSE);
+  assert(FT_containsFile("1root/2second/3gfile") == FALSE);
+  assert(FT_rmFile("1root/2child/2child/2child/2child") == SUCCESS);
+  assert(FT_rmDir("1root/2child/2child") == SUCCESS);
+  assert((temp = FT_toString()) != NULL);
+  fprintf(stderr, "Checkpoint 3:\n%s\n", temp);
+  free(temp);
+
+  /* removing the root doesn't uninitialize the structure */
+  assert(FT_rmDir("1anotherroot") == CONFLICTING_PATH);
+  assert(FT_rmDir("1root") == SUCCESS);
+  assert(FT_rmDir("1root") == NO_SUCH_PATH);
+  assert(FT_containsDir("1root/2child") == FALSE);
+  assert(FT_containsDir("1root") == FALSE);
+  assert(FT_rmDir("1root") == NO_SUCH_PATH);
+  assert(FT_rmDir("1anotherroot") == NO_SUCH_PATH);
+  assert((temp = FT_toString()) != NULL);
+  assert(!strcmp(temp,""));
+  free(temp);
+
+  /* checking that file contents work as expected */
+  assert(FT_insertDir("1root") == SUCCESS);
+  assert(FT_insertFile("1root/H", "hello, world!",
+                       strlen("hello, world!")+1) == SUCCESS);
+  assert(!strcmp(FT_getFileContents("1root/H"), "hello, world!"));
+  bIsFile = FALSE;
+  l = -1;
+  assert(FT_stat("1root/H", &bIsFile, &l) == SUCCESS);
+  assert(bIsFile == TRUE);
+  assert(l == (strlen("hello, world!")+1));
+  assert(!strcmp(FT_replaceFileContents("1root/H","Kernighan",
+                                        strlen("Kernighan")+1),
+                 "hello, world!"));
+  assert(!strcmp((char*)FT_getFileContents("1root/H"),"Kernighan"));
+  assert(FT_stat("1root/H", &bIsFile, &l) == SUCCESS);
+  assert(bIsFile == TRUE);
+  assert(l == (strlen("Kernighan")+1));
+  assert(!strcmp(FT_replaceFileContents("1root/H",arr,ARRLEN),
+                 "Kernighan"));
+  assert(!strcmp((char*)FT_getFileContents("1root/H"),""));
+  assert(FT_stat("1root/H", &bIsFile, &l) == SUCCESS);
+  assert(bIsFile == TRUE);
+  assert(l == ARRLEN);
+  assert(FT_rmFile("1root/H") == SUCCESS);
+  assert(FT_insertDir("1root/2d") == SUCCESS);
+  assert(FT_stat("1root/2d", &bIsFile, &l) == SUCCESS);
+  assert(bIsFile == FALSE);
+  assert(l == ARRLEN);
+  assert(FT_stat("1root/H", &bIsFile, &l) == NO_SUCH_PATH);
+  assert(bIsFile == FALSE);
+  assert(l == ARRLEN);
+  assert(FT_rmDir("1root") == SUCCESS);
+  assert((temp = FT_toString()) != NULL);
+  assert(!strcmp(temp,""));
+  free(temp);
+
+  /* ranged reads see the contents in place, while ranged writes and
+     appends work on the FT's own copy, never the client's buffer */
+  assert(FT_insertFile("1root/R", "hello, world!",
+                       strlen("hello, world!")+1) == SUCCESS);
+  assert(FT_readFileRange("1root/R", 7, arr, ARRLEN, &l) == SUCCESS);
+  assert(l == strlen("world!")+1);
+  assert(!strcmp(arr, "world!"));
+  assert(FT_readFileRange("1root/R", 100, arr, ARRLEN, &l) == SUCCESS);
+  assert(l == 0);
+  assert(FT_writeFileRange("1root/R", 7, "there", 5) == SUCCESS);
+  assert(!strcmp((char*)FT_getFileContents("1root/R"),
+                 "hello, there!"));
+  assert(FT_writeFileRange("1root/R", 13, "!!", 3) == SUCCESS);
+  assert(FT_appendFile("1root/R", "tail", 5) == SUCCESS);
+  assert(FT_stat("1root/R", &bIsFile, &l) == SUCCESS);
+  assert(l == strlen("hello, there!!!")+1+5);
+  assert(!strcmp((char*)FT_getFileContents("1root/R"),
+                 "hello, there!!!"));
+  assert(!strcmp((char*)FT_getFileContents("1root/R") + 16, "tail"));
+  assert(FT_appendFile("1root", "x", 1) == NOT_A_FILE);
+  assert(FT_writeFileRange("1root/nope", 0, "x", 1) == NO_SUCH_PATH);
+  free(FT_replaceFileContents("1root/R", NULL, 0));
+  assert(FT_appendFile("1root/R", "abc", 4) == SUCCESS);
+  assert(!strcmp((char*)FT_getFileContents("1root/R"), "abc"));
+  assert(FT_rmDir("1root") == SUCCESS);
+
+  /* once spilling is enabled, FT-owned contents past the threshold
+     move to the backing file but read back the same */
+  assert(FT_insertFile("1root/S", "spill", strlen("spill")+1) ==
+         SUCCESS);
+  assert(FT_enableSpill("ft_client.spill", 16) == SUCCESS);
+  assert(FT_enableSpill("ft_client.spill", 16) == INITIALIZATION_ERROR);
+  for (l = 0; l < 64; l++)
+    assert(FT_writeFileRange("1root/S", 6 + 2*l, "ab", 2) == SUCCESS);
+  assert(FT_appendFile("1root/S", "", 1) == SUCCESS);
+  assert(FT_readFileRange("1root/S", 0, arr, 6, &l) == SUCCESS);
+  assert(l == 6 && !strcmp(arr, "spill"));
+  assert(FT_readFileRange("1root/S", 130, arr, ARRLEN, &l) == SUCCESS);
+  assert(l == 5 && !strcmp(arr, "abab"));
+  assert(!strcmp((char*)FT_getFileContents("1root/S") + 132, "ab"));
+  assert(FT_writeFileRange("1root/S", 0, "S", 1) == SUCCESS);
+  assert(!strcmp((char*)FT_getFileContents("1root/S"), "Spill"));
+  assert(FT_copy("1root/S", "1root/T") == SUCCESS);
+  assert(FT_writeFileRange("1root/T", 0, "T", 1) == SUCCESS);
+  assert(!strcmp((char*)FT_getFileContents("1root/T"), "Tpill"));
+  assert(!strcmp((char*)FT_getFileContents("1root/S"), "Spill"));
+  temp = FT_replaceFileContents("1root/S", NULL, 0);
+  assert(!strcmp(temp, "Spill") && !strcmp(temp + 130, "abab"));
+  free(temp);
+  assert(FT_rmDir("1root") == SUCCESS);
+
+  /* under a memory budget, the least recently used FT-owned contents
+     are evicted to the spill file and faulted back in on access */
+  assert(FT_insertFile("1root/a", NULL, 0) == SUCCESS);
+  assert(FT_insertFile("1root/b", NULL, 0) == SUCCESS);
+  assert(FT_insertFile("1root/c", NULL, 0) == SUCCESS);
+  assert(FT_appendFile("1root/a", "aaaaaaaaa", 10) == SUCCESS);
+  assert(FT_appendFile("1root/b", "bbbbbbbbb", 10) == SUCCESS);
+  assert(FT_appendFile("1root/c", "ccccccccc", 10) == SUCCESS);
+  assert(FT_setMemoryBudget(40) == SUCCESS);
+  assert(FT_getCacheStats(&l, &hits, &misses, &evictions) == SUCCESS);
+  assert(l == 32 && hits == 0 && misses == 0 && evictions == 1);
+  assert(!strcmp((char*)FT_getFileContents("1root/a"), "aaaaaaaaa"));
+  assert(!strcmp((char*)FT_getFileContents("1root/c"), "ccccccccc"));
+  assert(FT_getCacheStats(&l, &hits, &misses, &evictions) == SUCCESS);
+  assert(l == 32 && hits == 1 && misses == 1 && evictions == 2);
+  assert(FT_readFileRange("1root/b", 0, arr, ARRLEN, &l) == SUCCESS);
+  assert(!strcmp(arr, "bbbbbbbbb"));
+  assert(FT_getCacheStats(&l, &hits, &misses, &evictions) == SUCCESS);
+  assert(misses == 2 && evictions == 3);
+  assert(FT_setMemoryBudget(0) == SUCCESS);
+  assert(FT_rmDir("1root") == SUCCESS);
+
+  /* a local directory can be imported whole, and its files read back
+     the same as on disk */
+  assert(FT_importFromDisk("ft_client.nodir", "1root/imp") == IO_ERROR);
+  assert(FT_containsDir("1root/imp") == FALSE);
+  assert(FT_importFromDisk(".", "1root/imp") == SUCCESS);
+  assert(FT_importFromDisk(".", "1root/imp") == ALREADY_IN_TREE);
+  assert(FT_stat("1root/imp/ft_client.c", &bIsFile, &l) == SUCCESS);
+  assert(bIsFile);
+  assert((file = fopen("ft_client.c", "rb")) != NULL);
+  assert(fseek(file, 0, SEEK_END) == 0 && ftell(file) == (long) l);
+  rewind(file);
+  assert(fread(arr, 1, 64, file) == 64);
+  fclose(file);
+  assert(FT_readFileRange("1root/imp/ft_client.c", 0, arr + 64, 64, &l)
+         == SUCCESS);
+  assert(l == 64 && !memcmp(arr, arr + 64, 64));
+  assert(FT_rmDir("1root") == SUCCESS);
+
+  /* an exported FT reads back the same when imported again */
+  assert(FT_insertFile("1root/d/f", "data", 5) == SUCCESS);
+  assert(FT_insertDir("1root/e") == SUCCESS);
+  assert(FT_insertFile("1root/g", NULL, 0) == SUCCESS);
+  assert(FT_exportToDisk("ft_client.out", &files, &bytes, &seconds) ==
+         SUCCESS);
+  assert(files == 2 && bytes == 5 && seconds >= 0);
+  assert(FT_importFromDisk("ft_client.out/1root", "1root/back") ==
+         SUCCESS);
+  assert(!strcmp((char*)FT_getFileContents("1root/back/d/f"), "data"));
+  assert(FT_containsDir("1root/back/e"));
+  assert(FT_stat("1root/back/g", &bIsFile, &l) == SUCCESS);
+  assert(bIsFile && l == 0);
+  assert(FT_rmDir("1root") == SUCCESS);
+  assert(remove("ft_client.out/1root/d/f") == 0);
+  assert(remove("ft_client.out/1root/d") == 0);
+  assert(remove("ft_client.out/1root/e") == 0);
+  assert(remove("ft_client.out/1root/g") == 0);
+  assert(remove("ft_client.out/1root") == 0);
+
+  /* ...however deep it is, with directories closed on the way down
+     reopened on the way back up */
+  saved = malloc(strlen("ft_client.out/1root") + 2 * 100 +
+                 strlen("/f") + 1);
+  assert(saved != NULL);
+  strcpy(saved, "ft_client.out/1root");
+  for (l = 0; l < 100; l++)
+    strcat(saved, "/d");
+  strcat(saved, "/f");
+  temp = saved + strlen("ft_client.out/");
+  assert(FT_insertFile(temp, "deep", 5) == SUCCESS);
+  assert(FT_insertFile("1root/d/y/g", "y", 2) == SUCCESS);
+  assert(FT_insertFile("1root/d/z", "z", 2) == SUCCESS);
+  assert(FT_exportToDisk("ft_client.out", &files, &bytes, &seconds) ==
+         SUCCESS);
+  assert(files == 3 && bytes == 9);
+  assert(FT_importFromDisk("ft_client.out/1root/d", "1root/back") ==
+         SUCCESS);
+  assert(!strcmp((char*)FT_getFileContents("1root/back/y/g"), "y"));
+  assert(!strcmp((char*)FT_getFileContents("1root/back/z"), "z"));
+  assert(FT_statTree("1root/back", &files, &dirs, &bytes) == SUCCESS);
+  assert(files == 3 && dirs == 101 && bytes == 9);
+  assert(FT_rmDir("1root") == SUCCESS);
+  assert(remove("ft_client.out/1root/d/y/g") == 0);
+  assert(remove("ft_client.out/1root/d/y") == 0);
+  assert(remove("ft_client.out/1root/d/z") == 0);
+  while (strcmp(saved, "ft_client.out") != 0) {
+    assert(remove(saved) == 0);
+    *strrchr(saved, '/') = '\0';
+  }
+  free(saved);
+  assert(remove("ft_client.out") == 0);
+
+  /* a subtree moves whole under its new parent and name */
+  assert(FT_insertFile("1root/a/b/f", "moved", 6) == SUCCESS);
+  assert(FT_insertDir("1root/c") == SUCCESS);
+  assert(FT_move("1root/a/b", "1root/c/d") == SUCCESS);
+  assert(FT_containsDir("1root/a/b") == FALSE);
+  assert(!strcmp((char*)FT_getFileContents("1root/c/d/f"), "moved"));
+  assert(FT_move("1root/c/d/f", "1root/a/g") == SUCCESS);
+  assert(FT_containsFile("1root/a/g"));
+  assert(FT_move("1root/a/g", "1root/c") == ALREADY_IN_TREE);
+  assert(FT_move("1root/c", "1root/c/d/e") == CONFLICTING_PATH);
+  assert(FT_move("1root", "1root/e") == CONFLICTING_PATH);
+  assert(FT_move("1root/c", "2root/c") == CONFLICTING_PATH);
+  assert(FT_move("1root/nope", "1root/e") == NO_SUCH_PATH);
+  assert(FT_move("1root/c", "1root/e/f") == NO_SUCH_PATH);
+  assert(FT_move("1root/c", "1root/a/g/h") == NOT_A_DIRECTORY);
+  assert(FT_move("1root/c", "1root//e") == BAD_PATH);
+  assert((temp = FT_toString()) != NULL);
+  assert(!strcmp(temp, "1root\n1root/a\n1root/a/g\n1root/c\n"
+                       "1root/c/d\n"));
+  free(temp);
+  assert(FT_rmDir("1root") == SUCCESS);
+
+  /* a copy has directories and files of its own, but shares their
+     contents with its original until either changes */
+  assert(FT_insertFile("1root/t/f", "client", 7) == SUCCESS);
+  assert(FT_insertFile("1root/t/g", NULL, 0) == SUCCESS);
+  assert(FT_appendFile("1root/t/g", "owned", 6) == SUCCESS);
+  assert(FT_copy("1root/t", "1root/u") == SUCCESS);
+  assert(FT_copy("1root/t", "1root/u") == ALREADY_IN_TREE);
+  assert(FT_copy("1root/t", "1root/t/v") == CONFLICTING_PATH);
+  assert(FT_copy("1root/t/f", "1root/t/f/v") == NOT_A_DIRECTORY);
+  assert(FT_getFileContents("1root/u/f") ==
+         FT_getFileContents("1root/t/f"));
+  assert(FT_getFileContents("1root/u/g") ==
+         FT_getFileContents("1root/t/g"));
+  assert(FT_writeFileRange("1root/u/g", 0, "O", 1) == SUCCESS);
+  assert(!strcmp((char*)FT_getFileContents("1root/u/g"), "Owned"));
+  assert(!strcmp((char*)FT_getFileContents("1root/t/g"), "owned"));
+  assert(FT_copy("1root/t/g", "1root/w") == SUCCESS);
+  assert(FT_rmDir("1root/t") == SUCCESS);
+  assert(FT_appendFile("1root/w", "!", 2) == SUCCESS);
+  assert(!strcmp((char*)FT_getFileContents("1root/w") + 6, "!"));
+  assert((temp = FT_toString()) != NULL);
+  assert(!strcmp(temp, "1root\n1root/w\n1root/u\n1root/u/f\n"
+                       "1root/u/g\n"));
+  free(temp);
+  assert(FT_rmDir("1root") == SUCCESS);
+
+  /* a snapshot keeps its view of the FT while the FT changes */
+  assert(FT_insertFile("1root/s/f", NULL, 0) == SUCCESS);
+  assert(FT_appendFile("1root/s/f", "before", 7) == SUCCESS);
+  assert(FT_insertDir("1root/s/d") == SUCCESS);
+  assert(FT_snapshot(&snap) == SUCCESS);
+  assert((saved = FT_toString()) != NULL);
+  assert(FT_writeFileRange("1root/s/f", 0, "B", 1) == SUCCESS);
+  assert(FT_move("1root/s/d", "1root/d") == SUCCESS);
+  assert(FT_rmFile("1root/s/f") == SUCCESS);
+  assert((temp = FT_snapshotToString(snap)) != NULL);
+  assert(!strcmp(temp, saved));
+  free(temp);
+  free(saved);
+  assert(FT_snapshotStat(snap, "1root/s/f", &bIsFile, &l) == SUCCESS);
+  assert(bIsFile && l == 7);
+  assert(FT_snapshotStat(snap, "1root/d", &bIsFile, &l) ==
+         NO_SUCH_PATH);
+  assert(FT_snapshotRead(snap, "1root/s/f", 0, arr, ARRLEN, &l) ==
+         SUCCESS);
+  assert(l == 7 && !strcmp(arr, "before"));
+  assert(FT_snapshotRead(snap, "1root/s/d", 0, arr, 1, &l) ==
+         NOT_A_FILE);
+  FT_releaseSnapshot(snap);
+
+  /* ...including removal of the whole tree, snapshots taken between
+     changes each keep their own view, and snapshots may be released
+     in any order */
+  assert(FT_insertFile("1root/s/g", "kept", 5) == SUCCESS);
+  assert(FT_snapshot(&snap) == SUCCESS);
+  assert((saved = FT_toString()) != NULL);
+  assert(FT_insertDir("1root/s/e") == SUCCESS);
+  assert(FT_snapshot(&otherSnap) == SUCCESS);
+  assert(FT_rmDir("1root") == SUCCESS);
+  assert(FT_insertDir("1root/n") == SUCCESS);
+  assert((temp = FT_snapshotToString(snap)) != NULL);
+  assert(!strcmp(temp, saved));
+  free(temp);
+  free(saved);
+  assert((temp = FT_snapshotToString(otherSnap)) != NULL);
+  assert(!strcmp(temp, "1root\n1root/d\n1root/s\n1root/s/g\n"
+                       "1root/s/e\n"));
+  free(temp);
+  arr[0] = '\0';
+  assert(FT_diff(snap, otherSnap, appendDiff, arr) == SUCCESS);
+  assert(!strcmp(arr, "+ 1root/s/e\n"));
+  FT_releaseSnapshot(snap);
+  assert(FT_snapshotRead(otherSnap, "1root/s/g", 0, arr, ARRLEN, &l)
+         == SUCCESS);
+  assert(l == 5 && !strcmp(arr, "kept"));
+  FT_releaseSnapshot(otherSnap);
+
+  /* ...and sees neither the changes of an aborted transaction nor
+     their undoing */
+  assert(FT_insertFile("1root/n/f", "old", 4) == SUCCESS);
+  assert(FT_begin() == SUCCESS);
+  assert(FT_writeFileRange("1root/n/f", 0, "n", 1) == SUCCESS);
+  assert(FT_snapshot(&snap) == SUCCESS);
+  assert(FT_insertDir("1root/n/t") == SUCCESS);
+  assert(FT_abort() == SUCCESS);
+  assert(FT_snapshotRead(snap, "1root/n/f", 0, arr, ARRLEN, &l) ==
+         SUCCESS);
+  assert(l == 4 && !strcmp(arr, "nld"));
+  assert(FT_snapshotStat(snap, "1root/n/t", &bIsFile, &l) ==
+         NO_SUCH_PATH);
+  arr[0] = '\0';
+  assert(FT_diff(snap, NULL, appendDiff, arr) == SUCCESS);
+  assert(!strcmp(arr, "* 1root/n/f\n"));
+  FT_releaseSnapshot(snap);
+  assert(FT_rmDir("1root") == SUCCESS);
+
+  /* equal subtrees hash equal wherever they are, and a change shows
+     in the hashes of all of its ancestors */
+  assert(FT_insertFile("1root/a/f", "same", 5) == SUCCESS);
+  assert(FT_insertDir("1root/a/d") == SUCCESS);
+  assert(FT_copy("1root/a", "1root/b") == SUCCESS);
+  assert(FT_subtreeHash("1root/a", &hash) == SUCCESS);
+  assert(FT_subtreeHash("1root/b", &otherHash) == SUCCESS);
+  assert(hash == otherHash);
+  assert(FT_subtreeHash("1root", &hash) == SUCCESS);
+  assert(FT_writeFileRange("1root/b/f", 0, "S", 1) == SUCCESS);
+  assert(FT_subtreeHash("1root", &otherHash) == SUCCESS);
+  assert(hash != otherHash);
+  assert(FT_subtreeHash("1root/b", &otherHash) == SUCCESS);
+  assert(FT_writeFileRange("1root/b/f", 0, "s", 1) == SUCCESS);
+  assert(FT_subtreeHash("1root/b", &hash) == SUCCESS);
+  assert(hash != otherHash);
+  assert(FT_subtreeHash("1root/a", &otherHash) == SUCCESS);
+  assert(hash == otherHash);
+  assert(FT_move("1root/b/d", "1root/b/e") == SUCCESS);
+  assert(FT_subtreeHash("1root/b", &hash) == SUCCESS);
+  assert(hash != otherHash);
+  assert(FT_subtreeHash("1root/b/f", &hash) == SUCCESS);
+  assert(FT_subtreeHash("1root/a/f", &otherHash) == SUCCESS);
+  assert(hash == otherHash);
+  assert(FT_subtreeHash("1root/c", &hash) == NO_SUCH_PATH);
+  assert(FT_rmDir("1root") == SUCCESS);
+
+  /* the totals of a subtree count its files, directories, and bytes,
+     and follow copies, writes, moves, removals, and aborts */
+  assert(FT_insertFile("1root/a/f", "12345", 5) == SUCCESS);
+  assert(FT_insertDir("1root/a/d") == SUCCESS);
+  assert(FT_copy("1root/a", "1root/b") == SUCCESS);
+  assert(FT_appendFile("1root/b/f", "678", 3) == SUCCESS);
+  assert(FT_statTree("1root", &files, &dirs, &bytes) == SUCCESS);
+  assert(files == 2 && dirs == 5 && bytes == 13);
+  assert(FT_begin() == SUCCESS);
+  assert(FT_move("1root/b/f", "1root/a/d/g") == SUCCESS);
+  assert(FT_rmDir("1root/b") == SUCCESS);
+  assert(FT_statTree("1root/a", &files, &dirs, &bytes) == SUCCESS);
+  assert(files == 2 && dirs == 2 && bytes == 13);
+  assert(FT_statTree("1root", &files, &dirs, &bytes) == SUCCESS);
+  assert(files == 2 && dirs == 3 && bytes == 13);
+  assert(FT_abort() == SUCCESS);
+  assert(FT_statTree("1root/b", &files, &dirs, &bytes) == SUCCESS);
+  assert(files == 1 && dirs == 2 && bytes == 8);
+  assert(FT_statTree("1root/a/f", &files, &dirs, &bytes) == SUCCESS);
+  assert(files == 1 && dirs == 0 && bytes == 5);
+  assert(!strcmp(FT_replaceFileContents("1root/a/f", NULL, 0),
+                 "12345"));
+  assert(FT_statTree("1root", &files, &dirs, &bytes) == SUCCESS);
+  assert(files == 2 && dirs == 5 && bytes == 8);
+  assert(FT_statTree("1root/c", &files, &dirs, &bytes) ==
+         NO_SUCH_PATH);
+  assert(FT_rmDir("1root") == SUCCESS);
+
+  /* a quota on a directory stops inserts, copies, moves, and writes
+     that would take its subtree past it, but not moves within it */
+  assert(FT_insertFile("1root/t/f", "1234", 4) == SUCCESS);
+  assert(FT_insertDir("1root/u") == SUCCESS);
+  assert(FT_setQuota("1root/t", 6, 10) == SUCCESS);
+  assert(FT_setQuota("1root/t/f", 6, 10) == NOT_A_DIRECTORY);
+  assert(FT_getQuota("1root/t", &files, &bytes) == SUCCESS);
+  assert(files == 6 && bytes == 10);
+  assert(FT_insertDir("1root/t/a/b/c/d/e") == QUOTA_EXCEEDED);
+  assert(!FT_containsDir("1root/t/a"));
+  assert(FT_insertDir("1root/t/a/b") == SUCCESS);
+  assert(FT_insertFile("1root/u/g", "123456789", 10) == SUCCESS);
+  assert(FT_copy("1root/u/g", "1root/t/a/g") == QUOTA_EXCEEDED);
+  assert(FT_move("1root/u/g", "1root/t/g") == QUOTA_EXCEEDED);
+  assert(FT_appendFile("1root/t/f", "123456", 6) == SUCCESS);
+  assert(FT_appendFile("1root/t/f", "x", 1) == QUOTA_EXCEEDED);
+  assert(FT_writeFileRange("1root/t/f", 0, "ab", 2) == SUCCESS);
+  assert(FT_replaceFileContents("1root/t/f", "12345678901", 11) ==
+         NULL);
+  assert(FT_move("1root/t/f", "1root/t/a/f") == SUCCESS);
+  assert(FT_statTree("1root/t", &files, &dirs, &bytes) == SUCCESS);
+  assert(files == 1 && dirs == 3 && bytes == 10);
+
+  /* ...and holds patches and imports to it too, taking back what
+     they inserted */
+  patch[0].eKind = FT_DIFF_ADD;
+  patch[0].pcPath = "1root/t/z/h";
+  patch[0].isFile = TRUE;
+  patch[0].pvContents = "x";
+  patch[0].ulLength = 2;
+  assert(FT_begin() == SUCCESS);
+  assert(FT_applyPatch(patch, 1) == QUOTA_EXCEEDED);
+  assert(FT_commit() == SUCCESS);
+  assert(!FT_containsDir("1root/t/z"));
+  patch[0].eKind = FT_DIFF_MODIFY;
+  patch[0].pcPath = "1root/t/a/f";
+  patch[0].pvContents = "12345678901";
+  patch[0].ulLength = 11;
+  assert(FT_applyPatch(patch, 1) == QUOTA_EXCEEDED);
+  assert(FT_stat("1root/t/a/f", &bIsFile, &l) == SUCCESS);
+  assert(l == 10);
+  assert(FT_importFromDisk(".", "1root/t/imp") == QUOTA_EXCEEDED);
+  assert(!FT_containsDir("1root/t/imp"));
+  assert(FT_statTree("1root/t", &files, &dirs, &bytes) == SUCCESS);
+  assert(files == 1 && dirs == 3 && bytes == 10);
+  assert(FT_setQuota("1root/t", 0, 0) == SUCCESS);
+  assert(FT_move("1root/u/g", "1root/t/g") == SUCCESS);
+  assert(FT_rmDir("1root") == SUCCESS);
+
+  /* a diff reports only what differs, without entering equal
+     subtrees, and a patch applies such records all or not at all */
+  assert(FT_insertFile("1root/same/f", "s", 2) == SUCCESS);
+  assert(FT_insertFile("1root/gone/f", "g", 2) == SUCCESS);
+  assert(FT_insertFile("1root/mod", "old", 4) == SUCCESS);
+  assert(FT_insertDir("1root/kind") == SUCCESS);
+  assert(FT_snapshot(&snap) == SUCCESS);
+  assert(FT_rmDir("1root/gone") == SUCCESS);
+  assert(!strcmp(FT_replaceFileContents("1root/mod", "new", 4),
+                 "old"));
+  assert(FT_insertFile("1root/new/f", "n", 2) == SUCCESS);
+  assert(FT_rmDir("1root/kind") == SUCCESS);
+  assert(FT_insertFile("1root/kind", "k", 2) == SUCCESS);
+  arr[0] = '\0';
+  assert(FT_diff(snap, NULL, appendDiff, arr) == SUCCESS);
+  assert(!strcmp(arr, "- 1root/gone\n- 1root/kind\n+ 1root/kind\n"
+                      "* 1root/mod\n+ 1root/new\n+ 1root/new/f\n"));
+
+  patch[0].eKind = FT_DIFF_ADD;
+  patch[0].pcPath = "1root/back";
+  patch[0].isFile = FALSE;
+  patch[1] = patch[0];
+  assert(FT_applyPatch(patch, 2) == ALREADY_IN_TREE);
+  assert(FT_containsDir("1root/back") == FALSE);
+
+  patch[0].eKind = FT_DIFF_REMOVE;
+  patch[0].pcPath = "1root/new";
+  patch[1].eKind = FT_DIFF_REMOVE;
+  patch[1].pcPath = "1root/kind";
+  patch[1].isFile = TRUE;
+  patch[2].eKind = FT_DIFF_ADD;
+  patch[2].pcPath = "1root/kind";
+  patch[2].isFile = FALSE;
+  patch[3].eKind = FT_DIFF_MODIFY;
+  patch[3].pcPath = "1root/mod";
+  patch[3].isFile = TRUE;
+  patch[3].pvContents = "old";
+  patch[3].ulLength = 4;
+  patch[4] = patch[2];
+  patch[4].pcPath = "1root/gone";
+  patch[5] = patch[3];
+  patch[5].eKind = FT_DIFF_ADD;
+  patch[5].pcPath = "1root/gone/f";
+  patch[5].pvContents = "g";
+  patch[5].ulLength = 2;
+  assert(FT_applyPatch(patch, 6) == SUCCESS);
+  arr[0] = '\0';
+  assert(FT_diff(snap, NULL, appendDiff, arr) == SUCCESS);
+  assert(!strcmp(arr, ""));
+  assert(!strcmp((char*)FT_getFileContents("1root/mod"), "old"));
+  FT_releaseSnapshot(snap);
+  assert(FT_rmDir("1root") == SUCCESS);
+
+  /* a glob reports its matches parents first and in sorted order,
+     with "**" spanning any number of components */
+  assert(FT_insertFile("1root/a/logs/x.gz", NULL, 0) == SUCCESS);
+  assert(FT_insertFile("1root/a/logs/old/y.gz", NULL, 0) == SUCCESS);
+  assert(FT_insertFile("1root/a/logs/y.txt", NULL, 0) == SUCCESS);
+  assert(FT_insertFile("1root/b/logs/z.gz", NULL, 0) == SUCCESS);
+  assert(FT_insertFile("1root/b/other/w.gz", NULL, 0) == SUCCESS);
+  arr[0] = '\0';
+  assert(FT_glob("1root/*/logs/**/*.gz", appendMatch, arr) ==
+         SUCCESS);
+  assert(!strcmp(arr, "1root/a/logs/old/y.gz\n1root/a/logs/x.gz\n"
+                      "1root/b/logs/z.gz\n"));
+  arr[0] = '\0';
+  assert(FT_glob("1root/a/logs/**", appendMatch, arr) == SUCCESS);
+  assert(!strcmp(arr, "1root/a/logs\n1root/a/logs/old\n"
+                      "1root/a/logs/old/y.gz\n1root/a/logs/x.gz\n"
+                      "1root/a/logs/y.txt\n"));
+  arr[0] = '\0';
+  assert(FT_glob("1root/[!a]/?ther", appendMatch, arr) == SUCCESS);
+  assert(!strcmp(arr, "1root/b/other\n"));
+  arr[0] = '\0';
+  assert(FT_glob("2root/**", appendMatch, arr) == SUCCESS);
+  assert(arr[0] == '\0');
+  assert(FT_glob("1root/[ab", appendMatch, arr) == BAD_PATH);
+  assert(FT_glob("1root//a", appendMatch, arr) == BAD_PATH);
+  assert(FT_rmDir("1root") == SUCCESS);
+
+  /* a range scan visits the paths from its low bound up to its high
+     one in path order, in which a directory comes right before what
+     is below it, even when a sibling's name sorts between them */
+  assert(FT_insertFile("1root/a/x", NULL, 0) == SUCCESS);
+  assert(FT_insertDir("1root/a-b") == SUCCESS);
+  assert(FT_insertDir("1root/b/c") == SUCCESS);
+  assert(FT_insertFile("1root/d", NULL, 0) == SUCCESS);
+  arr[0] = '\0';
+  assert(FT_scanRange(NULL, NULL, 0, appendMatch, arr) == SUCCESS);
+  assert(!strcmp(arr, "1root\n1root/a\n1root/a/x\n1root/a-b\n"
+                      "1root/b\n1root/b/c\n1root/d\n"));
+  arr[0] = '\0';
+  assert(FT_scanRange("1root/a/m", "1root/b/c", 0, appendMatch, arr)
+         == SUCCESS);
+  assert(!strcmp(arr, "1root/a/x\n1root/a-b\n1root/b\n"));
+  arr[0] = '\0';
+  assert(FT_scanRange("1root/a", NULL, 2, appendMatch, arr) ==
+         SUCCESS);
+  assert(!strcmp(arr, "1root/a\n1root/a/x\n"));
+  arr[0] = '\0';
+  assert(FT_scanRange("0root", "1root/a", 0, appendMatch, arr) ==
+         SUCCESS);
+  assert(!strcmp(arr, "1root\n"));
+  assert(FT_scanRange("1root/e", NULL, 0, appendMatch, arr) ==
+         SUCCESS);
+  assert(FT_scanRange(NULL, "1root", 0, appendMatch, arr) ==
+         SUCCESS);
+  assert(!strcmp(arr, "1root\n"));
+  assert(FT_scanRange("1root//a", NULL, 0, appendMatch, arr) ==
+         BAD_PATH);
+  assert(FT_rmDir("1root") == SUCCESS);
+
+  /* a search by name finds every directory and file with the name,
+     by walking the tree or with the name index, which keeps up with
+     moves, copies, removals, and aborts */
+  assert(FT_insertFile("1root/a/config", NULL, 0) == SUCCESS);
+  assert(FT_insertDir("1root/b/config") == SUCCESS);
+  arr[0] = '\0';
+  assert(FT_findByName("config", appendMatch, arr) == SUCCESS);
+  assert(!strcmp(arr, "1root/a/config\n1root/b/config\n"));
+  assert(FT_enableNameIndex() == SUCCESS);
+  assert(FT_enableNameIndex() == SUCCESS);
+  assert(FT_move("1root/b/config", "1root/b/settings") == SUCCESS);
+  assert(FT_copy("1root/a", "1root/c") == SUCCESS);
+  assert(FT_begin() == SUCCESS);
+  assert(FT_rmDir("1root/a") == SUCCESS);
+  assert(FT_insertFile("1root/d/config", NULL, 0) == SUCCESS);
+  arr[0] = '\0';
+  assert(FT_findByName("config", appendMatch, arr) == SUCCESS);
+  assert(strlen(arr) == 30 && strstr(arr, "1root/c/config\n") &&
+         strstr(arr, "1root/d/config\n"));
+  assert(FT_abort() == SUCCESS);
+  arr[0] = '\0';
+  assert(FT_findByName("config", appendMatch, arr) == SUCCESS);
+  assert(strlen(arr) == 30 && strstr(arr, "1root/a/config\n") &&
+         strstr(arr, "1root/c/config\n"));
+  arr[0] = '\0';
+  assert(FT_findByName("settings", appendMatch, arr) == SUCCESS);
+  assert(!strcmp(arr, "1root/b/settings\n"));
+  assert(FT_findByName("a/config", appendMatch, arr) == BAD_PATH);
+  assert(FT_findByName("", appendMatch, arr) == BAD_PATH);
+  assert(FT_rmDir("1root") == SUCCESS);
+  arr[0] = '\0';
+  assert(FT_findByName("config", appendMatch, arr) == SUCCESS);
+  assert(arr[0] == '\0');
+  assert(FT_insertFile("1root/config", NULL, 0) == SUCCESS);
+  assert(FT_findByName("1root", appendMatch, arr) == SUCCESS);
+  assert(!strcmp(arr, "1root\n"));
+  assert(FT_disableNameIndex() == SUCCESS);
+  assert(FT_rmDir("1root") == SUCCESS);
+
+  /* a grep finds each file holding a string, by checking every file
+     or only the candidates the trigram index leaves, which keeps up
+     with replacements, writes, appends, removals, and aborts */
+  assert(FT_insertFile("1root/a", "the quick brown fox", 20) ==
+         SUCCESS);
+  assert(FT_insertFile("1root/b/c", "a lazy dog", 11) == SUCCESS);
+  arr[0] = '\0';
+  assert(FT_grep("brown", appendGrep, arr) == SUCCESS);
+  assert(!strcmp(arr, "1root/a 10\n"));
+  assert(FT_enableTextIndex() == SUCCESS);
+  assert(FT_enableTextIndex() == SUCCESS);
+  arr[0] = '\0';
+  assert(FT_grep("brown", appendGrep, arr) == SUCCESS);
+  assert(!strcmp(arr, "1root/a 10\n"));
+  saved = FT_replaceFileContents("1root/a", "a brown dog", 12);
+  assert(!strcmp(saved, "the quick brown fox"));
+  arr[0] = '\0';
+  assert(FT_grep("dog", appendGrep, arr) == SUCCESS);
+  assert(strlen(arr) == 22 && strstr(arr, "1root/a 8\n") &&
+         strstr(arr, "1root/b/c 7\n"));
+  assert(FT_appendFile("1root/b/c", "and a fox", 10) == SUCCESS);
+  assert(FT_begin() == SUCCESS);
+  assert(FT_rmFile("1root/b/c") == SUCCESS);
+  assert(FT_insertFile("1root/d", "fox", 4) == SUCCESS);
+  arr[0] = '\0';
+  assert(FT_grep("fox", appendGrep, arr) == SUCCESS);
+  assert(!strcmp(arr, "1root/d 0\n"));
+  assert(FT_abort() == SUCCESS);
+  arr[0] = '\0';
+  assert(FT_grep("fox", appendGrep, arr) == SUCCESS);
+  assert(!strcmp(arr, "1root/b/c 17\n"));
+  assert(FT_writeFileRange("1root/b/c", 0, "A", 1) == SUCCESS);
+  arr[0] = '\0';
+  assert(FT_grep("A lazy", appendGrep, arr) == SUCCESS);
+  assert(!strcmp(arr, "1root/b/c 0\n"));
+  arr[0] = '\0';
+  assert(FT_grep("zebra", appendGrep, arr) == SUCCESS);
+  assert(arr[0] == '\0');
+  assert(FT_grep("ow", appendGrep, arr) == SUCCESS);
+  assert(!strcmp(arr, "1root/a 4\n"));
+  arr[0] = '\0';
+  assert(FT_grep("", appendGrep, arr) == SUCCESS);
+  assert(strlen(arr) == 22);
+  assert(FT_disableTextIndex() == SUCCESS);
+  arr[0] = '\0';
+  assert(FT_grep("A lazy", appendGrep, arr) == SUCCESS);
+  assert(!strcmp(arr, "1root/b/c 0\n"));
+  assert(FT_disableNameIndex() == SUCCESS);
+  assert(FT_rmDir("1root") == SUCCESS);
+
+  /* a lookup cache answers repeated paths without walking the tree,
+     evicts with CLOCK, and forgets just the paths through a node once
+     it is removed or moved */
+  assert(FT_getLookupStats(&l, &hits, &misses, &evictions, &files) ==
+         INITIALIZATION_ERROR);
+  assert(FT_insertFile("1root/a/f", "x", 2) == SUCCESS);
+  assert(FT_enableLookupCache(2) == SUCCESS);
+  assert(FT_containsFile("1root/a/f"));
+  assert(FT_containsFile("1root/a/f"));
+  assert(FT_containsDir("1root/a"));
+  assert(FT_getLookupStats(&l, &hits, &misses, &evictions, &files) ==
+         SUCCESS);
+  assert(l == 2 && hits == 1 && misses == 2 && evictions == 0);
+  assert(FT_containsDir("1root"));
+  assert(FT_containsFile("1root/a/f"));
+  assert(FT_getLookupStats(&l, &hits, &misses, &evictions, &files) ==
+         SUCCESS);
+  assert(l == 2 && hits == 2 && misses == 3 && evictions == 1);
+  assert(FT_move("1root/a", "1root/b") == SUCCESS);
+  assert(!FT_containsFile("1root/a/f"));
+  assert(FT_containsFile("1root/b/f"));
+  assert(FT_begin() == SUCCESS);
+  assert(FT_rmFile("1root/b/f") == SUCCESS);
+  assert(!FT_containsFile("1root/b/f"));
+  assert(FT_abort() == SUCCESS);
+  assert(FT_containsFile("1root/b/f"));
+  assert(!FT_containsFile("1root//b"));
+  assert(FT_insertDir("1root/c") == SUCCESS);
+  assert(FT_containsFile("1root/b/f"));
+  assert(FT_getLookupStats(&l, &hits, &misses, &evictions, &files) ==
+         SUCCESS);
+  bytes = hits;
+  assert(FT_rmDir("1root/c") == SUCCESS);
+  assert(FT_containsFile("1root/b/f"));
+  assert(FT_getLookupStats(&l, &hits, &misses, &evictions, &files) ==
+         SUCCESS);
+  assert(hits == bytes + 1);
+  assert(FT_disableLookupCache() == SUCCESS);
+  assert(FT_containsFile("1root/b/f"));
+  assert(FT_rmDir("1root") == SUCCESS);
+
+  /* a path filter holds the path of every node, grows as they are
+     inserted, follows moves, removals, and aborts, and turns away
+     paths that are not in the tree without walking it */
+  assert(FT_getPathFilterStats(&l, &files, &hits, &misses) ==
+         INITIALIZATION_ERROR);
+  assert(FT_insertFile("1root/a/f", "x", 2) == SUCCESS);
+  assert(FT_enablePathFilter(1) == SUCCESS);
+  assert(FT_getPathFilterStats(&l, &files, &hits, &misses) ==
+         SUCCESS);
+  assert(l == 3 && files >= 64 && hits == 0 && misses == 0);
+  assert(FT_insertDir("1root/b/c") == SUCCESS);
+  assert(FT_containsFile("1root/a/f"));
+  assert(FT_containsDir("1root/b/c"));
+  assert(!FT_containsFile("1root/a/g"));
+  assert(!FT_containsDir("1root/b/d"));
+  assert(!FT_containsDir("1root//b"));
+  assert(FT_getPathFilterStats(&l, &files, &hits, &misses) ==
+         SUCCESS);
+  assert(l == 5 && hits == 5 && misses >= 1);
+  assert(FT_move("1root/a", "1root/b/c/d") == SUCCESS);
+  assert(!FT_containsFile("1root/a/f"));
+  assert(FT_containsFile("1root/b/c/d/f"));
+  assert(FT_begin() == SUCCESS);
+  assert(FT_rmDir("1root/b") == SUCCESS);
+  assert(FT_getPathFilterStats(&l, &files, &hits, &misses) ==
+         SUCCESS);
+  assert(l == 1);
+  assert(!FT_containsDir("1root/b"));
+  assert(FT_abort() == SUCCESS);
+  assert(FT_containsFile("1root/b/c/d/f"));
+  assert(FT_getPathFilterStats(&l, &files, &hits, &misses) ==
+         SUCCESS);
+  assert(l == 5);
+  assert(FT_disablePathFilter() == SUCCESS);
+  assert(FT_getPathFilterStats(&l, &files, &hits, &misses) ==
+         INITIALIZATION_ERROR);
+  assert(FT_containsFile("1root/b/c/d/f"));
+  assert(FT_disableNameIndex() == SUCCESS);
+  assert(FT_rmDir("1root") == SUCCESS);
+
+  /* a directory handle reaches children by name, follows its
+     directory through moves, and fails safely once it is removed,
+     until an abort puts it back */
+  assert(FT_insertFile("1root/a/f", "x", 2) == SUCCESS);
+  assert(FT_openDirHandle("1root/b", &handle) == NO_SUCH_PATH);
+  assert(handle == NULL);
+  assert(FT_openDirHandle("1root/a/f", &handle) == NOT_A_DIRECTORY);
+  assert(FT_openDirHandle("1root/a", &handle) == SUCCESS);
+  assert(FT_openDirHandle("1root/a", &otherHandle) == SUCCESS);
+  assert(FT_containsAt(handle, "f"));
+  assert(!FT_containsAt(handle, "g"));
+  assert(FT_insertFileAt(handle, "g", "yz", 3) == SUCCESS);
+  assert(FT_insertFileAt(handle, "g", NULL, 0) == ALREADY_IN_TREE);
+  assert(FT_insertDirAt(handle, "d/e") == BAD_PATH);
+  assert(FT_insertDirAt(handle, "") == BAD_PATH);
+  assert(FT_insertDirAt(handle, "d") == SUCCESS);
+  assert(FT_containsFile("1root/a/g"));
+  assert(FT_containsDir("1root/a/d"));
+  assert(FT_statAt(handle, "g", &bIsFile, &l) == SUCCESS);
+  assert(bIsFile && l == 3);
+  assert(FT_statAt(handle, "d", &bIsFile, &l) == SUCCESS);
+  assert(!bIsFile);
+  assert(FT_statAt(handle, "h", &bIsFile, &l) == NO_SUCH_PATH);
+  assert(FT_move("1root/a", "1root/b") == SUCCESS);
+  assert(FT_containsAt(handle, "g"));
+  assert(FT_rmFileAt(handle, "g") == SUCCESS);
+  assert(FT_rmFileAt(handle, "g") == NO_SUCH_PATH);
+  assert(FT_rmFileAt(handle, "d") == NOT_A_FILE);
+  assert(!FT_containsFile("1root/b/g"));
+  assert(FT_begin() == SUCCESS);
+  assert(FT_rmDir("1root/b") == SUCCESS);
+  assert(!FT_containsAt(handle, "f"));
+  assert(FT_insertDirAt(handle, "e") == NO_SUCH_PATH);
+  assert(FT_abort() == SUCCESS);
+  assert(FT_containsAt(handle, "f"));
+  FT_closeDirHandle(handle);
+  assert(FT_rmDir("1root") == SUCCESS);
+  assert(FT_statAt(otherHandle, "f", &bIsFile, &l) == NO_SUCH_PATH);
+  assert(FT_insertDir("1root/b") == SUCCESS);
+  assert(!FT_containsAt(otherHandle, "f"));
+  FT_closeDirHandle(otherHandle);
+  assert(FT_rmDir("1root") == SUCCESS);
+
+  /* a deep tree is listed and removed without recursion */
+  saved = malloc(strlen("1root") + 2 * 100000 + strlen("/f") + 1);
+  assert(saved != NULL);
+  strcpy(saved, "1root");
+  for (l = 0; l < 100000; l++)
+    memcpy(saved + strlen("1root") + 2 * l, "/d", 2);
+  saved[strlen("1root") + 2 * 5000] = '\0';
+  assert(FT_insertDir(saved) == SUCCESS);
+  strcat(saved, "/f");
+  assert(FT_insertFile(saved, NULL, 0) == SUCCESS);
+  assert((temp = FT_toString()) != NULL);
+  assert(strstr(temp, saved) != NULL);
+  assert(strlen(strstr(temp, saved)) == strlen(saved) + 1);
+  free(temp);
+  assert(FT_rmFile(saved) == SUCCESS);
+
+  /* ...and, far deeper, copied, hashed, filtered, and diffed without
+     recursion */
+  memcpy(saved + strlen("1root") + 2 * 5000, "/d/d", 4);
+  strcpy(saved + strlen("1root") + 2 * 100000, "/f");
+  assert(FT_insertFile(saved, NULL, 0) == SUCCESS);
+  assert(FT_enablePathFilter(4 * 100000) == SUCCESS);
+  assert(FT_snapshot(&snap) == SUCCESS);
+  assert(FT_copy("1root/d", "1root/e") == SUCCESS);
+  assert(FT_subtreeHash("1root/d", &hash) == SUCCESS);
+  assert(FT_subtreeHash("1root/e", &otherHash) == SUCCESS);
+  assert(hash == otherHash);
+  saved[strlen("1root/")] = 'e';
+  assert(FT_containsFile(saved));
+  saved[strlen("1root/")] = 'd';
+  assert(FT_containsFile(saved));
+  assert(FT_appendFile(saved, "x", 1) == SUCCESS);
+  l = 0;
+  assert(FT_diff(snap, NULL, countDiff, &l) == SUCCESS);
+  assert(l == 100000 + 1 + 1);
+  assert(FT_rmDir("1root/e") == SUCCESS);
+  assert((temp = calloc(strlen(saved) + 32, 1)) != NULL);
+  assert(FT_diff(snap, NULL, appendDiff, temp) == SUCCESS);
+  assert(!strncmp(temp, "* ", 2));
+  assert(!strncmp(temp + 2, saved, strlen(saved)));
+  assert(!strcmp(temp + 2 + strlen(saved), "\n"));
+  FT_releaseSnapshot(snap);
+  assert(FT_disableNameIndex() == SUCCESS);
+
+  /* ...globbed, searched, and grepped without the index... */
+  assert(FT_appendFile(saved, "0123456789abcdefgh", 18) == SUCCESS);
+  temp[0] = '\0';
+  assert(FT_glob("1root/**/f", appendMatch, temp) == SUCCESS);
+  assert(!strncmp(temp, saved, strlen(saved)));
+  assert(!strcmp(temp + strlen(saved), "\n"));
+  temp[0] = '\0';
+  assert(FT_findByName("f", appendMatch, temp) == SUCCESS);
+  assert(!strncmp(temp, saved, strlen(saved)));
+  assert(!strcmp(temp + strlen(saved), "\n"));
+  temp[0] = '\0';
+  assert(FT_grep("abc", appendGrep, temp) == SUCCESS);
+  assert(!strncmp(temp, saved, strlen(saved)));
+  assert(!strcmp(temp + strlen(saved), " 11\n"));
+  free(temp);
+
+  /* ...and saved, loaded, spilled, and filtered again */
+  assert(FT_save("ft_client.snap") == SUCCESS);
+  assert(FT_destroy() == SUCCESS);
+  assert(FT_init() == SUCCESS);
+  assert(FT_load("ft_client.snap") == SUCCESS);
+  remove("ft_client.snap");
+  assert(FT_enableSpill("ft_client.spill", 16) == SUCCESS);
+  assert(FT_enablePathFilter(4 * 100000) == SUCCESS);
+  assert(FT_containsFile(saved));
+  assert(FT_readFileRange(saved, 0, arr, ARRLEN, &l) == SUCCESS);
+  assert(l == 19 && !strncmp(arr, "x0123456789abcdefgh", 19));
+  assert(FT_disableNameIndex() == SUCCESS);
+  free(saved);
+  assert(FT_rmDir("1root") == SUCCESS);
+
+  /* a watch gets an event for each change to its subtree, with
+     repeats folded together and an overflow flagged when the ring
+     fills up */
+  assert(FT_watch("1root/w", FT_EVENT_CREATE | FT_EVENT_REMOVE |
+                  FT_EVENT_MODIFY, &watch) == SUCCESS);
+  assert(FT_watch("1root/w/x", FT_EVENT_REMOVE, &otherWatch) ==
+         SUCCESS);
+  assert(FT_watch("1root//w", FT_EVENT_CREATE, &l) == BAD_PATH);
+  assert(FT_insertFile("1root/w/x/f", NULL, 0) == SUCCESS);
+  assert(FT_appendFile("1root/w/x/f", "a", 1) == SUCCESS);
+  assert(FT_appendFile("1root/w/x/f", "b", 1) == SUCCESS);
+  assert(FT_insertDir("1root/v") == SUCCESS);
+  assert(FT_rmDir("1root/w") == SUCCESS);
+  assert(FT_drainEvents(events, 4, &l, &bOverflowed) == SUCCESS);
+  assert(l == 3 && !bOverflowed);
+  assert(events[0].ulWatch == watch &&
+         events[0].uiKinds == (FT_EVENT_CREATE | FT_EVENT_MODIFY) &&
+         !strcmp(events[0].pcPath, "1root/w/x/f"));
+  assert(events[1].ulWatch == watch &&
+         events[1].uiKinds == FT_EVENT_REMOVE &&
+         !strcmp(events[1].pcPath, "1root/w"));
+  assert(events[2].ulWatch == otherWatch &&
+         !strcmp(events[2].pcPath, "1root/w"));
+  for (l = 0; l < 3; l++)
+    free(events[l].pcPath);
+  assert(FT_unwatch(otherWatch) == SUCCESS);
+  assert(FT_unwatch(otherWatch) == NO_SUCH_PATH);
+  assert(FT_begin() == SUCCESS);
+  assert(FT_insertDir("1root/w") == SUCCESS);
+  assert(FT_abort() == SUCCESS);
+  assert(FT_drainEvents(events, 4, &l, &bOverflowed) == SUCCESS);
+  assert(l == 1 && events[0].uiKinds ==
+         (FT_EVENT_CREATE | FT_EVENT_REMOVE));
+  free(events[0].pcPath);
+  assert(FT_insertFile("1root/w/f", NULL, 0) == SUCCESS);
+  assert(FT_insertFile("1root/w/g", NULL, 0) == SUCCESS);
+  for (l = 0; l < 2000; l++)
+    assert(FT_appendFile(l % 2 ? "1root/w/f" : "1root/w/g", "x", 1)
+           == SUCCESS);
+  assert(FT_drainEvents(events, 4, &l, &bOverflowed) == SUCCESS);
+  assert(l == 4 && bOverflowed);
+  do {
+    while (l > 0)
+      free(events[--l].pcPath);
+    assert(FT_drainEvents(events, 4, &l, &bOverflowed) == SUCCESS);
+    assert(!bOverflowed);
+  } while (l > 0);
+  assert(FT_unwatch(watch) == SUCCESS);
+  assert(FT_rmDir("1root") == SUCCESS);
+
+  /* a transaction's changes are all taken back by an abort, even
+     after one of them failed, and all kept by a commit */
+  assert(FT_commit() == INITIALIZATION_ERROR);
+  assert(FT_abort() == INITIALIZATION_ERROR);
+  assert(FT_insertFile("1root/k/f", "kept", 5) == SUCCESS);
+  assert(FT_insertFile("1root/k/g", NULL, 0) == SUCCESS);
+  assert(FT_appendFile("1root/k/g", "owned", 6) == SUCCESS);
+  assert((saved = FT_toString()) != NULL);
+  assert(FT_begin() == SUCCESS);
+  assert(FT_begin() == INITIALIZATION_ERROR);
+  assert(FT_insertDir("1root/n/m") == SUCCESS);
+  assert(FT_writeFileRange("1root/k/g", 0, "O", 1) == SUCCESS);
+  assert(FT_appendFile("1root/k/g", "!", 2) == SUCCESS);
+  assert(FT_move("1root/k/f", "1root/n/f") == SUCCESS);
+  assert(FT_copy("1root/k", "1root/n/m/k") == SUCCESS);
+  assert(FT_rmDir("1root/k") == SUCCESS);
+  assert(!strcmp(FT_replaceFileContents("1root/n/f", "new", 4),
+                 "kept"));
+  assert(FT_insertDir("1root/n") == ALREADY_IN_TREE);
+  assert(FT_load("ft_client.snap") == CONFLICTING_PATH);
+  assert(FT_abort() == SUCCESS);
+  assert((temp = FT_toString()) != NULL);
+  assert(!strcmp(temp, saved));
+  free(temp);
+  free(saved);
+  assert(!strcmp((char*)FT_getFileContents("1root/k/f"), "kept"));
+  assert(!strcmp((char*)FT_getFileContents("1root/k/g"), "owned"));
+  assert(FT_begin() == SUCCESS);
+  assert(FT_rmDir("1root") == SUCCESS);
+  assert(FT_insertFile("2root/f", "x", 2) == SUCCESS);
+  assert(FT_commit() == SUCCESS);
+  assert(FT_begin() == SUCCESS);
+  assert(FT_rmDir("2root") == SUCCESS);
+  assert(FT_insertDir("1root") == SUCCESS);
+  assert(FT_abort() == SUCCESS);
+  assert((temp = FT_toString()) != NULL);
+  assert(!strcmp(temp, "2root\n2root/f\n"));
+  free(temp);
+  /* each transaction keeps a file's contents from before its own
+     first change, however many changes follow */
+  assert(FT_begin() == SUCCESS);
+  for (l = 0; l < 100; l++)
+    assert(FT_appendFile("2root/f", "y", 1) == SUCCESS);
+  assert(FT_commit() == SUCCESS);
+  assert(FT_begin() == SUCCESS);
+  assert(FT_writeFileRange("2root/f", 0, "z", 1) == SUCCESS);
+  assert(FT_appendFile("2root/f", "z", 1) == SUCCESS);
+  assert(FT_abort() == SUCCESS);
+  assert(FT_stat("2root/f", &bIsFile, &l) == SUCCESS);
+  assert(l == 102);
+  assert(((char*)FT_getFileContents("2root/f"))[0] == 'x');
+  assert(FT_rmDir("2root") == SUCCESS);
+
+  /* children should be printed in lexicographic order,
+     depth first, file children before directory children */
+  assert(FT_insertDir("1root/y") == SUCCESS);
+  assert((temp = FT_toString()) != NULL);
+  fprintf(stderr, "Checkpoint 4.1:\n%s\n", temp);
+  free(temp);
+  assert(FT_insertDir("1root/x") == SUCCESS);
+  assert((temp = FT_toString()) != NULL);
+  fprintf(stderr, "Checkpoint 4.2:\n%s\n", temp);
+  free(temp);
+  assert(FT_insertFile("1root/x/C", "Ritchie",
+                       strlen("Ritchie")+1) == SUCCESS);
+  assert(FT_insertDir("1root/x/c++") == SUCCESS);
+  assert((temp = FT_toString()) != NULL);
+  fprintf(stderr, "Checkpoint 4.3:\n%s\n", temp);
+  free(temp);
+  assert(FT_insertFile("1root/x/B", "Thompson",
+                       strlen("Thompson")+1) == SUCCESS);
+  assert((temp = FT_toString()) != NULL);
+  fprintf(stderr, "Checkpoint 4.4:\n%s\n", temp);
+  free(temp);
+  assert(FT_insertDir("1root/y/CHILD1DIR") == SUCCESS);
+  assert(FT_insertDir("1root/y/CHILD2DIR") == SUCCESS);
+  assert(FT_insertFile("1root/y/CHILD2FILE", NULL, 0) == SUCCESS);
+  assert(FT_insertDir("1root/y/CHILD3DIR") == SUCCESS);
+  assert(FT_insertFile("1root/y/CHILD1FILE", NULL, 0) == SUCCESS);
+  assert(FT_insertDir("1root/y/CHILD2DIR/CHILD4DIR") == SUCCESS);
+  assert((temp = FT_toString()) != NULL);
+  fprintf(stderr, "Checkpoint 4.5:\n%s\n", temp);
+  free(temp);
+
+  /* a snapshot rebuilds the same tree, with FT-owned contents */
+  assert(FT_save("ft_client.snap") == SUCCESS);
+  assert(FT_load("ft_client.snap") == CONFLICTING_PATH);
+  assert((saved = FT_toString()) != NULL);
+  assert(FT_destroy() == SUCCESS);
+  assert(FT_load("ft_client.snap") == INITIALIZATION_ERROR);
+  assert(FT_init() == SUCCESS);
+  assert(FT_load("ft_client.nosnap") == IO_ERROR);
+  assert(FT_load("ft_client.snap") == SUCCESS);
+  assert((temp = FT_toString()) != NULL);
+  assert(!strcmp(temp, saved));
+  free(temp);
+  free(saved);
+  assert(!strcmp((char*)FT_getFileContents("1root/x/B"), "Thompson"));
+  assert(FT_stat("1root/y/CHILD1FILE", &bIsFile, &l) == SUCCESS);
+  assert(bIsFile && l == 0);
+  assert(FT_appendFile("1root/x/C", "!", 2) == SUCCESS);
+  assert(!strcmp((char*)FT_getFileContents("1root/x/C") + 8, "!"));
+
+  /* a mapped snapshot reads contents in place until they change,
+     and saving over it leaves the mapping intact */
+  assert(FT_destroy() == SUCCESS);
+  assert(FT_init() == SUCCESS);
+  assert(FT_loadMapped("ft_client.snap") == SUCCESS);
+  assert(FT_loadMapped("ft_client.snap") == CONFLICTING_PATH);
+  assert(!strcmp((char*)FT_getFileContents("1root/x/C"), "Ritchie"));
+  assert(FT_appendFile("1root/x/C", "!", 2) == SUCCESS);
+  assert(!strcmp((char*)FT_getFileContents("1root/x/C") + 8, "!"));
+  assert(FT_save("ft_client.snap") == SUCCESS);
+  assert(!strcmp((char*)FT_getFileContents("1root/x/B"), "Thompson"));
+  temp = FT_replaceFileContents("1root/x/B", NULL, 0);
+  assert(!strcmp(temp, "Thompson"));
+  free(temp);
+
+  /* a snapshot crafted to be deep loads without overflowing the
+     stack, and one whose records run out or repeat a name is turned
+     down whole */
+  assert(FT_destroy() == SUCCESS);
+  assert((file = fopen("ft_client.snap", "wb")) != NULL);
+  fputs("FTSNAP2\n", file);
+  fputc(0, file);
+  for (l = 300000; l >= 0x80; l >>= 7)
+    fputc((int) (l & 0x7f) | 0x80, file);
+  fputc((int) l, file);
+  for (l = 0; l < 300000; l++) {
+    fputc(l + 1 < 300000 ? 2 : 0, file);
+    fputc(l == 0 ? 0 : 1, file);
+    fputc(l == 0 ? 1 : 0, file);
+    if (l == 0)
+      fputc('d', file);
+  }
+  assert(fclose(file) == 0);
+  assert(FT_init() == SUCCESS);
+  assert(FT_load("ft_client.snap") == SUCCESS);
+  assert(FT_stat("d/d/d", &bIsFile, &l) == SUCCESS);
+  assert(!bIsFile);
+  assert(FT_destroy() == SUCCESS);
+  assert((file = fopen("ft_client.snap", "r+b")) != NULL);
+  assert(fseek(file, -3, SEEK_END) == 0);
+  fputc(2, file);
+  assert(fclose(file) == 0);
+  assert(FT_init() == SUCCESS);
+  assert(FT_load("ft_client.snap") == IO_ERROR);
+  assert((file = fopen("ft_client.snap", "wb")) != NULL);
+  fwrite("FTSNAP2\n\0\3\4\0\1d\1\0\1a\0\1\1\0\0", 1, 23, file);
+  assert(fclose(file) == 0);
+  assert(FT_load("ft_client.snap") == IO_ERROR);
+  assert(FT_stat("d", &bIsFile, &l) == NO_SUCH_PATH);
+  remove("ft_client.snap");
+
+  /* journaled changes survive a restart, and a checkpoint folds them
+     into a new snapshot */
+  assert(FT_destroy() == SUCCESS);
+  assert(FT_sync() == INITIALIZATION_ERROR);
+  assert(FT_init() == SUCCESS);
+  assert(FT_checkpoint() == INITIALIZATION_ERROR);
+  assert(FT_openJournal("ft_client.snap", "ft_client.jrnl", 4) ==
+         SUCCESS);
+  assert(FT_load("ft_client.snap") == CONFLICTING_PATH);
+  assert(FT_insertFile("1root/x/C", "Ritchie", strlen("Ritchie")+1) ==
+         SUCCESS);
+  assert(FT_insertDir("1root/y/z") == SUCCESS);
+  /* records go ahead of their changes, and are taken back when the
+     changes fail, so replay never meets one of these */
+  assert(FT_insertDir("1root/y/z") == ALREADY_IN_TREE);
+  assert(FT_rmFile("1root/y/nope") == NO_SUCH_PATH);
+  assert(FT_move("1root/nope", "1root/q") == NO_SUCH_PATH);
+  assert(FT_appendFile("1root/y", "x", 1) == NOT_A_FILE);
+  assert(FT_insertFile("1root/y/z/f", NULL, 0) == SUCCESS);
+  assert(FT_appendFile("1root/y/z/f", "abc", 3) == SUCCESS);
+  assert(FT_writeFileRange("1root/y/z/f", 1, "BCD", 4) == SUCCESS);
+  assert(FT_checkpoint() == SUCCESS);
+  assert(FT_rmDir("1root/y") == SUCCESS);
+  assert(FT_move("1root/x", "1root/w") == SUCCESS);
+  assert(FT_copy("1root/w", "1root/v") == SUCCESS);
+  assert(!strcmp(FT_replaceFileContents("1root/w/C", "Kernighan",
+                                        strlen("Kernighan")+1),
+                 "Ritchie"));
+  assert(FT_begin() == SUCCESS);
+  assert(FT_insertDir("1root/b/c") == SUCCESS);
+  assert(FT_rmDir("1root/v") == SUCCESS);
+  assert(FT_commit() == SUCCESS);
+  assert(FT_sync() == SUCCESS);
+  assert((saved = FT_toString()) != NULL);
+  /* an open transaction's records never reach the journal */
+  assert(FT_begin() == SUCCESS);
+  assert(FT_insertDir("1root/lost") == SUCCESS);
+  assert(FT_checkpoint() == INITIALIZATION_ERROR);
+  assert(FT_sync() == SUCCESS);
+  assert(FT_destroy() == SUCCESS);
+  assert(FT_init() == SUCCESS);
+  assert(FT_openJournal("ft_client.snap", "ft_client.jrnl", 4) ==
+         SUCCESS);
+  assert((temp = FT_toString()) != NULL);
+  assert(!strcmp(temp, saved));
+  free(temp);
+  free(saved);
+  assert(!strcmp((char*)FT_getFileContents("1root/w/C"), "Kernighan"));
+  remove("ft_client.snap");
+  remove("ft_client.jrnl");
+
+  assert(FT_snapshot(&snap) == SUCCESS);
+  assert(FT_destroy() == SUCCESS);
+  assert(FT_snapshotStat(snap, "1root", &bIsFile, &l) ==
+         INITIALIZATION_ERROR);
+  FT_releaseSnapshot(snap);
+  assert(FT_destroy() == INITIALIZATION_ERROR);
+  assert(FT_snapshot(&snap) == INITIALIZATION_ERROR);
+  assert(FT_containsDir("1root") == FALSE);
+  assert(FT_containsFile("1root") == FALSE);
+  assert((temp = FT_toString()) == NULL);
 
   return 0;
 }
@@ -0,0 +1,341 @@
+/*-------------------------------------------------------------------*/
+/* glob.c                                                            */
+/* Author: Hugh Peterson                                             */
+/*-------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "a4def.h"
+#include "glob.h"
+
+/*-------------------------------------------------------------------*/
+
+/* The kinds of component in a glob */
+enum globKind {GLOB_LITERAL, GLOB_WILDCARD, GLOB_ANY_DEPTH};
+
+/* A component of a glob */
+struct globComponent {
+   /* the kind of component */
+   enum globKind eKind;
+   /* the component's text, which lies in its glob's copy of the
+      pattern */
+   const char *pcText;
+};
+
+/* A compiled pattern */
+struct glob {
+   /* the pattern, with each '/' replaced by a '\0' */
+   char *pcPattern;
+   /* the components, and their number */
+   struct globComponent *psComponents;
+   size_t ulCount;
+};
+
+/*-------------------------------------------------------------------*/
+
+/*
+  Returns the length of the set "[...]" at the start of pcClass, up to
+  and including its closing ']', or 0 if it has none. A ']' right
+  after the '[' (or the '!' or '^' that negates the set) is part of
+  the set.
+*/
+static size_t Glob_classLength(const char *pcClass) {
+   size_t i = 1;
+
+   assert(pcClass != NULL);
+   assert(pcClass[0] == '[');
+
+   if(pcClass[i] == '!' || pcClass[i] == '^')
+      i++;
+   if(pcClass[i] == ']')
+      i++;
+   while(pcClass[i] != ']') {
+      if(pcClass[i] == '\0' || pcClass[i] == '/')
+         return 0;
+      i++;
+   }
+   return i + 1;
+}
+
+/*
+  Returns TRUE if c is in the set "[...]" at the start of pcClass,
+  which has a closing ']', and FALSE otherwise.
+*/
+static boolean Glob_inClass(const char *pcClass, char c) {
+   boolean isNegated = FALSE;
+   boolean isIn = FALSE;
+   size_t i = 1;
+
+   assert(pcClass != NULL);
+
+   if(pcClass[i] == '!' || pcClass[i] == '^') {
+      isNegated = TRUE;
+      i++;
+   }
+   do {
+      if(pcClass[i + 1] == '-' && pcClass[i + 2] != ']') {
+         if((unsigned char) pcClass[i] <= (unsigned char) c &&
+            (unsigned char) c <= (unsigned char) pcClass[i + 2])
+            isIn = TRUE;
+         i += 3;
+      }
+      else {
+         if(pcClass[i] == c)
+            isIn = TRUE;
+         i++;
+      }
+   } while(pcClass[i] != ']');
+
+   return (boolean) (isIn != isNegated);
+}
+
+/*
+  Returns TRUE if the name pcName matches the wildcard component
+  pcPattern, and FALSE otherwise. Only the most recent '*' is ever
+  backtracked to, since a later '*' can absorb anything an earlier one
+  could, so the time taken grows with the product of the lengths at
+  worst rather than exponentially.
+*/
+static boolean Glob_matchWildcard(const char *pcPattern,
+                                  const char *pcName) {
+   const char *starPattern = NULL;
+   const char *starName = NULL;
+   const char *next;
+   boolean isMatched;
+
+   assert(pcPattern != NULL);
+   assert(pcName != NULL);
+
+   while(*pcName != '\0') {
+      if(*pcPattern == '*') {
+         starPattern = ++pcPattern;
+         starName = pcName;
+         continue;
+      }
+
+      if(*pcPattern == '[') {
+         isMatched = Glob_inClass(pcPattern, *pcName);
+         next = pcPattern + Glob_classLength(pcPattern);
+      }
+      else {
+         isMatched = (boolean) (*pcPattern == '?' ||
+                                *pcPattern == *pcName);
+         next = pcPattern + 1;
+      }
+
+      if(isMatched) {
+         pcPattern = next;
+         pcName++;
+      }
+      else if(starPattern == NULL)
+         return FALSE;
+      else {
+         pcPattern = starPattern;
+         pcName = ++starName;
+      }
+   }
+
+   while(*pcPattern == '*')
+      pcPattern++;
+   return (boolean) (*pcPattern == '\0');
+}
+
+/*
+  Adds to the state set pucSet every position reachable from one
+  already in it by letting a "**" component match no components.
+*/
+static void Glob_close(Glob_T oGGlob, unsigned char *pucSet) {
+   size_t i;
+
+   assert(oGGlob != NULL);
+   assert(pucSet != NULL);
+
+   for(i = 0; i < oGGlob->ulCount; i++)
+      if(pucSet[i] && oGGlob->psComponents[i].eKind == GLOB_ANY_DEPTH)
+         pucSet[i + 1] = 1;
+}
+
+/*-------------------------------------------------------------------*/
+
+/*
+  Compiles the pattern pcPattern. Returns SUCCESS and sets *poGResult
+  to the new glob, or sets *poGResult to NULL and returns:
+  * BAD_PATH if pcPattern is the empty string, begins or ends with a
+             '/', contains consecutive '/' delimiters, or contains a
+             '[' with no matching ']'
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int Glob_new(const char *pcPattern, Glob_T *poGResult) {
+   struct glob *glob;
+   struct globComponent *component;
+   char *text;
+   size_t i;
+
+   assert(pcPattern != NULL);
+   assert(poGResult != NULL);
+
+   *poGResult = NULL;
+
+   glob = malloc(sizeof(struct glob));
+   if(glob == NULL)
+      return MEMORY_ERROR;
+   glob->pcPattern = malloc(strlen(pcPattern) + 1);
+   if(glob->pcPattern == NULL) {
+      free(glob);
+      return MEMORY_ERROR;
+   }
+   strcpy(glob->pcPattern, pcPattern);
+
+   glob->ulCount = 1;
+   for(text = glob->pcPattern; *text != '\0'; text++)
+      if(*text == '/')
+         glob->ulCount++;
+   glob->psComponents = calloc(glob->ulCount,
+                               sizeof(struct globComponent));
+   if(glob->psComponents == NULL) {
+      Glob_free(glob);
+      return MEMORY_ERROR;
+   }
+
+   text = glob->pcPattern;
+   for(i = 0; i < glob->ulCount; i++) {
+      component = &glob->psComponents[i];
+      component->pcText = text;
+      component->eKind = GLOB_LITERAL;
+      if(*text == '\0' || *text == '/') {
+         Glob_free(glob);
+         return BAD_PATH;
+      }
+
+      for(; *text != '\0' && *text != '/'; text++) {
+         if(*text == '*' || *text == '?')
+            component->eKind = GLOB_WILDCARD;
+         else if(*text == '[') {
+            if(Glob_classLength(text) == 0) {
+               Glob_free(glob);
+               return BAD_PATH;
+            }
+            component->eKind = GLOB_WILDCARD;
+         }
+      }
+      if(*text == '/')
+         *text++ = '\0';
+
+      if(!strcmp(component->pcText, "**"))
+         component->eKind = GLOB_ANY_DEPTH;
+   }
+
+   *poGResult = glob;
+   return SUCCESS;
+}
+
+/* Frees all memory allocated for oGGlob. */
+void Glob_free(Glob_T oGGlob) {
+   assert(oGGlob != NULL);
+
+   free(oGGlob->psComponents);
+   free(oGGlob->pcPattern);
+   free(oGGlob);
+}
+
+/*
+  Returns the number of bytes in a state set of oGGlob, which is how
+  much space a client must provide for each one.
+*/
+size_t Glob_getSetSize(Glob_T oGGlob) {
+   assert(oGGlob != NULL);
+
+   return oGGlob->ulCount + 1;
+}
+
+/*
+  Stores in pucSet the state set of oGGlob before the first component
+  of a path, from which Glob_step gives the state set of the root.
+*/
+void Glob_start(Glob_T oGGlob, unsigned char *pucSet) {
+   assert(oGGlob != NULL);
+   assert(pucSet != NULL);
+
+   memset(pucSet, 0, oGGlob->ulCount + 1);
+   pucSet[0] = 1;
+   Glob_close(oGGlob, pucSet);
+}
+
+/*
+  Stores in pucTo the state set of oGGlob for the child named pcName
+  of a node whose state set is pucFrom. Returns TRUE if that set is
+  not empty, so that the child or something below it may match, and
+  FALSE otherwise.
+*/
+boolean Glob_step(Glob_T oGGlob, const unsigned char *pucFrom,
+                  const char *pcName, unsigned char *pucTo) {
+   struct globComponent *component;
+   boolean isLive = FALSE;
+   size_t i;
+
+   assert(oGGlob != NULL);
+   assert(pucFrom != NULL);
+   assert(pcName != NULL);
+   assert(pucTo != NULL);
+
+   memset(pucTo, 0, oGGlob->ulCount + 1);
+   for(i = 0; i < oGGlob->ulCount; i++) {
+      if(!pucFrom[i])
+         continue;
+      component = &oGGlob->psComponents[i];
+      if(component->eKind == GLOB_ANY_DEPTH)
+         pucTo[i] = 1;
+      else if(component->eKind == GLOB_LITERAL ?
+              !strcmp(component->pcText, pcName) :
+              Glob_matchWildcard(component->pcText, pcName))
+         pucTo[i + 1] = 1;
+      else
+         continue;
+      isLive = TRUE;
+   }
+   Glob_close(oGGlob, pucTo);
+
+   return isLive;
+}
+
+/*
+  Returns TRUE if a node with state set pucSet matches the whole of
+  oGGlob, and FALSE otherwise.
+*/
+boolean Glob_isMatch(Glob_T oGGlob, const unsigned char *pucSet) {
+   assert(oGGlob != NULL);
+   assert(pucSet != NULL);
+
+   return (boolean) (pucSet[oGGlob->ulCount] != 0);
+}
+
+/*
+  Returns TRUE if a child of a node with state set pucSet may match
+  oGGlob or have descendants that do, and FALSE otherwise. If it may,
+  and only a child with one particular name can, sets *ppcOnly to
+  that name; otherwise sets *ppcOnly to NULL.
+*/
+boolean Glob_canDescend(Glob_T oGGlob, const unsigned char *pucSet,
+                        const char **ppcOnly) {
+   struct globComponent *component = NULL;
+   size_t live = 0;
+   size_t i;
+
+   assert(oGGlob != NULL);
+   assert(pucSet != NULL);
+   assert(ppcOnly != NULL);
+
+   for(i = 0; i < oGGlob->ulCount; i++) {
+      if(pucSet[i]) {
+         component = &oGGlob->psComponents[i];
+         live++;
+      }
+   }
+
+   *ppcOnly = NULL;
+   if(live == 1 && component->eKind == GLOB_LITERAL)
+      *ppcOnly = component->pcText;
+   return (boolean) (live != 0);
+}
@@ -0,0 +1,81 @@
+/*-------------------------------------------------------------------*/
+/* glob.h                                                            */
+/* Author: Hugh Peterson                                             */
+/*-------------------------------------------------------------------*/
+
+#ifndef GLOB_INCLUDED
+#define GLOB_INCLUDED
+
+#include <stddef.h>
+#include "a4def.h"
+
+/*
+  A glob is a compiled pattern for absolute paths, made of components
+  separated by '/' like a path's, each of which is either:
+  * "**", matching any number (including none) of whole components
+  * a wildcard, in which '*' matches any run of characters, '?' any
+    one character, and "[...]" any one character in the bracketed set
+    or range (or not in it, if the set starts with '!' or '^')
+  * a literal, with none of those, matching only itself
+
+  A glob is matched against a tree one node at a time, from the root
+  down: the positions in the pattern that the path of a node has
+  reached form its state set, and the state set of a child follows
+  from its parent's and the child's name alone. Subtrees whose state
+  set is empty cannot hold a match and need not be walked, and those
+  whose only position is a literal need only the child of that name.
+*/
+typedef struct glob *Glob_T;
+
+/*-------------------------------------------------------------------*/
+
+/*
+  Compiles the pattern pcPattern. Returns SUCCESS and sets *poGResult
+  to the new glob, or sets *poGResult to NULL and returns:
+  * BAD_PATH if pcPattern is the empty string, begins or ends with a
+             '/', contains consecutive '/' delimiters, or contains a
+             '[' with no matching ']'
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int Glob_new(const char *pcPattern, Glob_T *poGResult);
+
+/* Frees all memory allocated for oGGlob. */
+void Glob_free(Glob_T oGGlob);
+
+/*
+  Returns the number of bytes in a state set of oGGlob, which is how
+  much space a client must provide for each one.
+*/
+size_t Glob_getSetSize(Glob_T oGGlob);
+
+/*
+  Stores in pucSet the state set of oGGlob before the first component
+  of a path, from which Glob_step gives the state set of the root.
+*/
+void Glob_start(Glob_T oGGlob, unsigned char *pucSet);
+
+/*
+  Stores in pucTo the state set of oGGlob for the child named pcName
+  of a node whose state set is pucFrom. Returns TRUE if that set is
+  not empty, so that the child or something below it may match, and
+  FALSE otherwise.
+*/
+boolean Glob_step(Glob_T oGGlob, const unsigned char *pucFrom,
+                  const char *pcName, unsigned char *pucTo);
+
+/*
+  Returns TRUE if a node with state set pucSet matches the whole of
+  oGGlob, and FALSE otherwise.
+*/
+boolean Glob_isMatch(Glob_T oGGlob, const unsigned char *pucSet);
+
+/*
+  Returns TRUE if a child of a node with state set pucSet may match
+  oGGlob or have descendants that do, and FALSE otherwise. If it may,
+  and only a child with one particular name can, sets *ppcOnly to
+  that name; otherwise sets *ppcOnly to NULL.
+*/
+boolean Glob_canDescend(Glob_T oGGlob, const unsigned char *pucSet,
+                        const char **ppcOnly);
+
+#endif
@@ -0,0 +1,727 @@
+/*-------------------------------------------------------------------*/
+/* journal.c                                                         */
+/* Author: Hugh Peterson                                             */
+/*-------------------------------------------------------------------*/
+
+#define _XOPEN_SOURCE 700
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "a4def.h"
+#include "journal.h"
+
+/*-------------------------------------------------------------------*/
+
+/* The magic string that every journal starts with */
+static const char acMagic[] = "FTJRNL1\n";
+
+/* The kind of the record that wraps a batch of records: its body is
+   this one byte followed by the batch's records, each encoded in full
+   as it would be on its own */
+enum {JOURNAL_BATCH = JOURNAL_COPY + 1};
+
+/*
+  The journal is an abstract object with 8 state variables:
+*/
+
+/* 1. the journal file's descriptor, or -1 if the journal is closed */
+static int iFd = -1;
+/* 2. the journal file's name */
+static char *pcName;
+/* 3. the checkpoint generation of the snapshot the journal follows */
+static size_t ulJournalGeneration;
+/* 4. the number of records per group commit */
+static size_t ulWindow;
+/* 5. the encoded records not yet written to the file, their total
+      length, and the number of bytes allocated for them */
+static unsigned char *pucBuffer;
+static size_t ulBuffered;
+static size_t ulBufferCap;
+/* 6. the number of records not yet written to the file */
+static size_t ulPending;
+/* 7. whether records are being held back as a batch, where in the
+      buffer the batch starts, and how many records it holds */
+static boolean isBatching;
+static size_t ulBatchStart;
+static size_t ulBatchRecords;
+/* 8. whether the record appended last is still buffered whole, and
+      where in the buffer it starts, so that it can be taken back */
+static boolean isRetractable;
+static size_t ulLastRecord;
+
+/*-------------------------------------------------------------------*/
+
+/* Returns the number of bytes in the LEB128 varint for ulValue. */
+static size_t Journal_varintSize(size_t ulValue) {
+   size_t size = 1;
+
+   while(ulValue >= 0x80) {
+      ulValue >>= 7;
+      size++;
+   }
+   return size;
+}
+
+/*
+  Writes ulValue as an unsigned LEB128 varint at *ppucNext, advancing
+  *ppucNext past it.
+*/
+static void Journal_putVarint(unsigned char **ppucNext,
+                              size_t ulValue) {
+   assert(ppucNext != NULL);
+
+   while(ulValue >= 0x80) {
+      *(*ppucNext)++ = (unsigned char) ((ulValue & 0x7F) | 0x80);
+      ulValue >>= 7;
+   }
+   *(*ppucNext)++ = (unsigned char) ulValue;
+}
+
+/*
+  Reads an unsigned LEB128 varint at *ppucNext, which must lie before
+  pucEnd, into *pulValue, advancing *ppucNext past it. Returns
+  SUCCESS, or IO_ERROR if pucEnd comes first or the value does not fit
+  in a size_t.
+*/
+static int Journal_getVarint(const unsigned char **ppucNext,
+                             const unsigned char *pucEnd,
+                             size_t *pulValue) {
+   size_t value = 0;
+   size_t shift = 0;
+   unsigned char c;
+
+   assert(ppucNext != NULL);
+   assert(pulValue != NULL);
+
+   do {
+      if(*ppucNext == pucEnd || shift >= sizeof(size_t) * 8)
+         return IO_ERROR;
+      c = *(*ppucNext)++;
+      value |= (size_t) (c & 0x7F) << shift;
+      shift += 7;
+   } while(c & 0x80);
+
+   *pulValue = value;
+   return SUCCESS;
+}
+
+/* Returns the 32-bit FNV-1a hash of the ulLength bytes at pucData. */
+static unsigned long Journal_checksum(const unsigned char *pucData,
+                                      size_t ulLength) {
+   unsigned long hash = 2166136261UL;
+   size_t i;
+
+   for(i = 0; i < ulLength; i++) {
+      hash ^= pucData[i];
+      hash = (hash * 16777619UL) & 0xFFFFFFFFUL;
+   }
+   return hash;
+}
+
+/* Returns TRUE if records of kind eOp carry data. */
+static boolean Journal_hasData(enum journalOp eOp) {
+   return (boolean) (eOp == JOURNAL_INSERT_FILE ||
+                     eOp == JOURNAL_REPLACE || eOp == JOURNAL_WRITE ||
+                     eOp == JOURNAL_MOVE || eOp == JOURNAL_COPY);
+}
+
+/*
+  Makes room for ulNeeded more bytes after the buffered records.
+  Returns SUCCESS, or MEMORY_ERROR if the buffer could not be grown.
+*/
+static int Journal_reserve(size_t ulNeeded) {
+   enum {MIN_CAPACITY = 4096, GROWTH_FACTOR = 2};
+   size_t newCap;
+   unsigned char *grown;
+
+   if(ulBuffered + ulNeeded <= ulBufferCap)
+      return SUCCESS;
+
+   newCap = ulBufferCap < MIN_CAPACITY ? MIN_CAPACITY : ulBufferCap;
+   while(newCap < ulBuffered + ulNeeded)
+      newCap *= GROWTH_FACTOR;
+   grown = realloc(pucBuffer, newCap);
+   if(grown == NULL)
+      return MEMORY_ERROR;
+   pucBuffer = grown;
+   ulBufferCap = newCap;
+   return SUCCESS;
+}
+
+/*
+  Writes the ulLength bytes at pvData to file descriptor iFile,
+  setting *pulWritten to the number of bytes written. Returns SUCCESS,
+  or IO_ERROR if the write failed.
+*/
+static int Journal_writeAll(int iFile, const void *pvData,
+                            size_t ulLength, size_t *pulWritten) {
+   const char *pcData = pvData;
+   ssize_t written;
+
+   assert(pulWritten != NULL);
+
+   *pulWritten = 0;
+   while(*pulWritten != ulLength) {
+      written = write(iFile, pcData + *pulWritten,
+                      ulLength - *pulWritten);
+      if(written <= 0)
+         return IO_ERROR;
+      *pulWritten += (size_t) written;
+   }
+   return SUCCESS;
+}
+
+/*
+  Creates a new, empty journal of checkpoint generation ulGeneration
+  in a temporary file, flushes it to disk, and moves it over pcName.
+  Returns SUCCESS and sets *piFile to a descriptor for appending to
+  it, or returns MEMORY_ERROR or IO_ERROR if it could not be created.
+*/
+static int Journal_create(size_t ulGeneration, int *piFile) {
+   unsigned char header[sizeof(acMagic) - 1 + sizeof(size_t) * 2];
+   unsigned char *next;
+   char *tempFile;
+   size_t written;
+   int file;
+   int status;
+
+   assert(pcName != NULL);
+   assert(piFile != NULL);
+
+   tempFile = malloc(strlen(pcName) + sizeof(".tmp"));
+   if(tempFile == NULL)
+      return MEMORY_ERROR;
+   strcpy(tempFile, pcName);
+   strcat(tempFile, ".tmp");
+
+   file = open(tempFile, O_RDWR | O_CREAT | O_TRUNC, 0600);
+   if(file == -1) {
+      free(tempFile);
+      return IO_ERROR;
+   }
+
+   memcpy(header, acMagic, sizeof(acMagic) - 1);
+   next = header + sizeof(acMagic) - 1;
+   Journal_putVarint(&next, ulGeneration);
+   status = Journal_writeAll(file, header, (size_t) (next - header),
+                             &written);
+   if(status == SUCCESS && fsync(file) != 0)
+      status = IO_ERROR;
+   if(status == SUCCESS && rename(tempFile, pcName) != 0)
+      status = IO_ERROR;
+
+   if(status != SUCCESS) {
+      (void) close(file);
+      (void) remove(tempFile);
+   }
+   else
+      *piFile = file;
+   free(tempFile);
+   return status;
+}
+
+/*
+  Passes each intact record of the journal in the ulLength bytes at
+  pucMap, starting at byte *pulGood (just past its header), to
+  pfApply, and sets *pulGood to the length of the intact prefix. The
+  records of an intact batch are passed on in turn; those of a torn
+  batch are never passed on at all. Returns SUCCESS, MEMORY_ERROR if
+  memory could not be allocated, or the first status other than
+  SUCCESS that pfApply returned.
+*/
+static int Journal_replay(const unsigned char *pucMap, size_t ulLength,
+                          int (*pfApply)(const struct journalRecord *),
+                          size_t *pulGood) {
+   const unsigned char *next;
+   const unsigned char *end = pucMap + ulLength;
+   const unsigned char *body;
+   const unsigned char *bodyEnd;
+   const unsigned char *sum;
+   size_t bodyLength, pathLength;
+   size_t innerGood;
+   char *path = NULL;
+   size_t pathCap = 0;
+   struct journalRecord record;
+   int status = SUCCESS;
+
+   assert(pucMap != NULL);
+   assert(pfApply != NULL);
+   assert(pulGood != NULL);
+
+   next = pucMap + *pulGood;
+   while(next != end) {
+      /* a record is intact if it is complete and its checksum holds */
+      if(Journal_getVarint(&next, end, &bodyLength) != SUCCESS ||
+         bodyLength == 0 || bodyLength > (size_t) (end - next) ||
+         (size_t) (end - next) - bodyLength < 4)
+         break;
+      body = next;
+      bodyEnd = body + bodyLength;
+      sum = bodyEnd;
+      if(Journal_checksum(body, bodyLength) !=
+         ((unsigned long) sum[0] | (unsigned long) sum[1] << 8 |
+          (unsigned long) sum[2] << 16 | (unsigned long) sum[3] << 24))
+         break;
+
+      /* the batch's own checksum covers all of its records */
+      if(*next == (unsigned char) JOURNAL_BATCH) {
+         innerGood = 0;
+         status = Journal_replay(next + 1, bodyLength - 1, pfApply,
+                                 &innerGood);
+         if(status != SUCCESS || innerGood != bodyLength - 1)
+            break;
+         next = bodyEnd + 4;
+         *pulGood = (size_t) (next - pucMap);
+         continue;
+      }
+
+      if(*next > (unsigned char) JOURNAL_COPY)
+         break;
+      record.eOp = (enum journalOp) *next++;
+      if(Journal_getVarint(&next, bodyEnd, &pathLength) != SUCCESS ||
+         pathLength > (size_t) (bodyEnd - next))
+         break;
+      if(pathLength + 1 > pathCap) {
+         char *grown = realloc(path, pathLength + 1);
+         if(grown == NULL) {
+            status = MEMORY_ERROR;
+            break;
+         }
+         path = grown;
+         pathCap = pathLength + 1;
+      }
+      memcpy(path, next, pathLength);
+      path[pathLength] = '\0';
+      next += pathLength;
+      record.pcPath = path;
+
+      record.ulOffset = 0;
+      record.pvData = NULL;
+      record.ulLength = 0;
+      if(record.eOp == JOURNAL_WRITE &&
+         Journal_getVarint(&next, bodyEnd, &record.ulOffset) != SUCCESS)
+         break;
+      if(Journal_hasData(record.eOp)) {
+         if(Journal_getVarint(&next, bodyEnd, &record.ulLength)
+            != SUCCESS ||
+            record.ulLength > (size_t) (bodyEnd - next))
+            break;
+         record.pvData = next;
+         next += record.ulLength;
+      }
+      if(next != bodyEnd)
+         break;
+
+      status = pfApply(&record);
+      if(status != SUCCESS)
+         break;
+      next = bodyEnd + 4;
+      *pulGood = (size_t) (next - pucMap);
+   }
+
+   free(path);
+   return status;
+}
+
+/*
+  Reads the journal already open on descriptor iFile, as described for
+  Journal_open, leaving it ready for appending. Returns the statuses
+  given there, closing iFile unless returning SUCCESS.
+*/
+static int Journal_recover(
+   int iFile, size_t ulGeneration,
+   int (*pfApply)(const struct journalRecord *)) {
+   struct stat info;
+   void *map;
+   size_t length;
+   size_t good;
+   size_t generation;
+   const unsigned char *next;
+   int status;
+
+   assert(pfApply != NULL);
+
+   if(fstat(iFile, &info) == -1 ||
+      (size_t) info.st_size < sizeof(acMagic) - 1) {
+      (void) close(iFile);
+      return IO_ERROR;
+   }
+   length = (size_t) info.st_size;
+   map = mmap(NULL, length, PROT_READ, MAP_PRIVATE, iFile, 0);
+   if(map == MAP_FAILED) {
+      (void) close(iFile);
+      return IO_ERROR;
+   }
+
+   next = (const unsigned char *) map + sizeof(acMagic) - 1;
+   if(memcmp(map, acMagic, sizeof(acMagic) - 1) != 0 ||
+      Journal_getVarint(&next, (const unsigned char *) map + length,
+                        &generation) != SUCCESS ||
+      generation > ulGeneration) {
+      (void) munmap(map, length);
+      (void) close(iFile);
+      return IO_ERROR;
+   }
+
+   /* a later snapshot already holds every change in an older journal */
+   if(generation < ulGeneration) {
+      (void) munmap(map, length);
+      (void) close(iFile);
+      return Journal_create(ulGeneration, &iFd);
+   }
+
+   good = (size_t) (next - (const unsigned char *) map);
+   status = Journal_replay(map, length, pfApply, &good);
+   (void) munmap(map, length);
+   if(status != SUCCESS) {
+      (void) close(iFile);
+      return status;
+   }
+
+   /* cut off a torn tail so that new records follow intact ones */
+   if((good != length && ftruncate(iFile, (off_t) good) != 0) ||
+      lseek(iFile, (off_t) good, SEEK_SET) == (off_t) -1) {
+      (void) close(iFile);
+      return IO_ERROR;
+   }
+   iFd = iFile;
+   return SUCCESS;
+}
+
+/*-------------------------------------------------------------------*/
+
+/*
+  Opens the journal in the file pcFile for the snapshot of checkpoint
+  generation ulGeneration, flushing records to disk once every
+  ulCommitWindow records (or every record if ulCommitWindow is 0).
+
+  If the file holds a journal of the same generation, first passes
+  each of its intact records, in order, to pfApply, stopping at the
+  first torn or corrupt record, which is cut off along with the rest
+  of the file. The record's path and data are only valid during the
+  call. If pfApply returns anything but SUCCESS, stops and returns
+  that status, leaving the journal closed. If the file does not exist
+  or holds an older journal (one that a later snapshot already
+  covers), starts a new, empty journal instead.
+
+  Returns SUCCESS, or:
+  * INITIALIZATION_ERROR if the journal is already open
+  * IO_ERROR if the file could not be read or written, or holds a
+             journal of a later generation or no journal at all
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int Journal_open(const char *pcFile, size_t ulGeneration,
+                 size_t ulCommitWindow,
+                 int (*pfApply)(const struct journalRecord *psRecord)) {
+   int file;
+   int status;
+
+   assert(pcFile != NULL);
+   assert(pfApply != NULL);
+
+   if(iFd != -1)
+      return INITIALIZATION_ERROR;
+
+   pcName = malloc(strlen(pcFile) + 1);
+   if(pcName == NULL)
+      return MEMORY_ERROR;
+   strcpy(pcName, pcFile);
+
+   file = open(pcFile, O_RDWR);
+   if(file != -1)
+      status = Journal_recover(file, ulGeneration, pfApply);
+   else if(errno == ENOENT) {
+      status = Journal_create(ulGeneration, &file);
+      if(status == SUCCESS)
+         iFd = file;
+   }
+   else
+      status = IO_ERROR;
+
+   if(status != SUCCESS) {
+      free(pcName);
+      pcName = NULL;
+      return status;
+   }
+
+   ulJournalGeneration = ulGeneration;
+   ulWindow = ulCommitWindow;
+   ulBuffered = 0;
+   ulPending = 0;
+   isBatching = FALSE;
+   isRetractable = FALSE;
+   return SUCCESS;
+}
+
+/*
+  Flushes any buffered records to disk and closes the journal, if it
+  is open, discarding the records of any open batch. Returns SUCCESS,
+  or IO_ERROR if the records could not be flushed (the journal is
+  closed anyway).
+*/
+int Journal_close(void) {
+   int status;
+
+   if(iFd == -1)
+      return SUCCESS;
+
+   if(isBatching)
+      Journal_abortBatch();
+   status = Journal_sync();
+   (void) close(iFd);
+   iFd = -1;
+   free(pcName);
+   pcName = NULL;
+   free(pucBuffer);
+   pucBuffer = NULL;
+   ulBuffered = 0;
+   ulBufferCap = 0;
+   ulPending = 0;
+   return status;
+}
+
+/* Returns TRUE if the journal is open and FALSE otherwise. */
+boolean Journal_isOpen(void) {
+   return (boolean) (iFd != -1);
+}
+
+/* Returns the checkpoint generation of the open journal. */
+size_t Journal_getGeneration(void) {
+   assert(iFd != -1);
+
+   return ulJournalGeneration;
+}
+
+/*
+  Appends a record of the change psRecord to the journal, which must
+  be open, before the change is made, by buffering it in memory; it
+  is written by the next group commit (see Journal_commit), or inside
+  a batch, held back until the batch ends. Returns SUCCESS, or
+  MEMORY_ERROR, appending nothing, if the record could not be
+  buffered.
+*/
+int Journal_append(const struct journalRecord *psRecord) {
+   size_t pathLength;
+   size_t bodyLength;
+   size_t needed;
+   unsigned char *next;
+   unsigned char *body;
+   unsigned long sum;
+
+   assert(iFd != -1);
+   assert(psRecord != NULL);
+   assert(psRecord->pcPath != NULL);
+   assert(psRecord->pvData != NULL || psRecord->ulLength == 0);
+
+   pathLength = strlen(psRecord->pcPath);
+   bodyLength = 1 + Journal_varintSize(pathLength) + pathLength;
+   if(psRecord->eOp == JOURNAL_WRITE)
+      bodyLength += Journal_varintSize(psRecord->ulOffset);
+   if(Journal_hasData(psRecord->eOp))
+      bodyLength += Journal_varintSize(psRecord->ulLength) +
+                    psRecord->ulLength;
+   needed = Journal_varintSize(bodyLength) + bodyLength + 4;
+
+   if(Journal_reserve(needed) != SUCCESS)
+      return MEMORY_ERROR;
+
+   ulLastRecord = ulBuffered;
+   isRetractable = TRUE;
+   next = pucBuffer + ulBuffered;
+   Journal_putVarint(&next, bodyLength);
+   body = next;
+   *next++ = (unsigned char) psRecord->eOp;
+   Journal_putVarint(&next, pathLength);
+   memcpy(next, psRecord->pcPath, pathLength);
+   next += pathLength;
+   if(psRecord->eOp == JOURNAL_WRITE)
+      Journal_putVarint(&next, psRecord->ulOffset);
+   if(Journal_hasData(psRecord->eOp)) {
+      Journal_putVarint(&next, psRecord->ulLength);
+      if(psRecord->ulLength != 0)
+         memcpy(next, psRecord->pvData, psRecord->ulLength);
+      next += psRecord->ulLength;
+   }
+   sum = Journal_checksum(body, bodyLength);
+   *next++ = (unsigned char) (sum & 0xFF);
+   *next++ = (unsigned char) ((sum >> 8) & 0xFF);
+   *next++ = (unsigned char) ((sum >> 16) & 0xFF);
+   *next++ = (unsigned char) ((sum >> 24) & 0xFF);
+   ulBuffered += needed;
+
+   if(isBatching)
+      ulBatchRecords++;
+   else
+      ulPending++;
+   return SUCCESS;
+}
+
+/*
+  Takes back the record appended last, for a change that could not be
+  made after all. No other journal function may have been called
+  since it was appended.
+*/
+void Journal_retract(void) {
+   assert(iFd != -1);
+   assert(isRetractable);
+
+   ulBuffered = ulLastRecord;
+   isRetractable = FALSE;
+   if(isBatching)
+      ulBatchRecords--;
+   else
+      ulPending--;
+}
+
+/*
+  Completes a group commit if the records appended since the last one
+  fill the commit window; inside a batch, does nothing, since
+  Journal_endBatch commits the batch's records. Returns SUCCESS, or
+  IO_ERROR if the group commit failed, in which case the records not
+  written stay buffered for the next one (or Journal_sync) to retry.
+*/
+int Journal_commit(void) {
+   assert(iFd != -1);
+
+   isRetractable = FALSE;
+   if(isBatching || ulPending == 0 || ulPending < ulWindow)
+      return SUCCESS;
+   return Journal_sync();
+}
+
+/*
+  Writes any buffered records, other than those of an open batch, to
+  the journal's file and flushes it to disk. Returns SUCCESS, or
+  IO_ERROR if that failed.
+*/
+int Journal_sync(void) {
+   size_t limit;
+   size_t written;
+   int status;
+
+   assert(iFd != -1);
+
+   isRetractable = FALSE;
+   limit = isBatching ? ulBatchStart : ulBuffered;
+   if(limit == 0)
+      return SUCCESS;
+
+   status = Journal_writeAll(iFd, pucBuffer, limit, &written);
+   /* keep whatever was not written for the next attempt */
+   memmove(pucBuffer, pucBuffer + written, ulBuffered - written);
+   ulBuffered -= written;
+   if(isBatching)
+      ulBatchStart -= written;
+   if(status == SUCCESS && fsync(iFd) != 0)
+      status = IO_ERROR;
+   if(status == SUCCESS)
+      ulPending = 0;
+   return status;
+}
+
+/*
+  Replaces the journal's file with a new, empty journal for the
+  snapshot of checkpoint generation ulGeneration, discarding any
+  buffered records. Returns SUCCESS, or MEMORY_ERROR or IO_ERROR if
+  the new journal could not be created (the old one is then kept).
+*/
+int Journal_reset(size_t ulGeneration) {
+   int file;
+   int status;
+
+   assert(iFd != -1);
+   assert(!isBatching);
+
+   status = Journal_create(ulGeneration, &file);
+   if(status != SUCCESS)
+      return status;
+
+   (void) close(iFd);
+   iFd = file;
+   ulJournalGeneration = ulGeneration;
+   ulBuffered = 0;
+   ulPending = 0;
+   isRetractable = FALSE;
+   return SUCCESS;
+}
+
+/*
+  Starts a batch in the journal, which must be open and not already in
+  one: the records appended from now on are held back in memory until
+  Journal_endBatch writes them as one record, or Journal_abortBatch
+  discards them.
+*/
+void Journal_beginBatch(void) {
+   assert(iFd != -1);
+   assert(!isBatching);
+
+   isBatching = TRUE;
+   isRetractable = FALSE;
+   ulBatchStart = ulBuffered;
+   ulBatchRecords = 0;
+}
+
+/*
+  Ends the open batch by wrapping its records into a single record
+  with one checksum, so that a crash keeps either all of them or none,
+  completing a group commit if they fill the commit window. Returns
+  SUCCESS, or MEMORY_ERROR or IO_ERROR if the batch could not be
+  wrapped (it is then still open) or the group commit failed.
+*/
+int Journal_endBatch(void) {
+   size_t innerLength;
+   size_t bodyLength;
+   size_t headerLength;
+   unsigned char *next;
+   unsigned long sum;
+
+   assert(iFd != -1);
+   assert(isBatching);
+
+   isRetractable = FALSE;
+   innerLength = ulBuffered - ulBatchStart;
+   if(innerLength != 0) {
+      bodyLength = 1 + innerLength;
+      headerLength = Journal_varintSize(bodyLength) + 1;
+      if(Journal_reserve(headerLength + 4) != SUCCESS)
+         return MEMORY_ERROR;
+
+      memmove(pucBuffer + ulBatchStart + headerLength,
+              pucBuffer + ulBatchStart, innerLength);
+      next = pucBuffer + ulBatchStart;
+      Journal_putVarint(&next, bodyLength);
+      *next = (unsigned char) JOURNAL_BATCH;
+      sum = Journal_checksum(next, bodyLength);
+      next += bodyLength;
+      *next++ = (unsigned char) (sum & 0xFF);
+      *next++ = (unsigned char) ((sum >> 8) & 0xFF);
+      *next++ = (unsigned char) ((sum >> 16) & 0xFF);
+      *next++ = (unsigned char) ((sum >> 24) & 0xFF);
+      ulBuffered += headerLength + 4;
+   }
+
+   isBatching = FALSE;
+   ulPending += ulBatchRecords;
+   if(ulBatchRecords != 0 && ulPending >= ulWindow)
+      return Journal_sync();
+   return SUCCESS;
+}
+
+/* Discards the records of the open batch and ends it. */
+void Journal_abortBatch(void) {
+   assert(iFd != -1);
+   assert(isBatching);
+
+   ulBuffered = ulBatchStart;
+   isBatching = FALSE;
+   isRetractable = FALSE;
+}
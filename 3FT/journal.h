@@ -0,0 +1,164 @@
+/*-------------------------------------------------------------------*/
+/* journal.h                                                         */
+/* Author: Hugh Peterson                                             */
+/*-------------------------------------------------------------------*/
+
+#ifndef JOURNAL_INCLUDED
+#define JOURNAL_INCLUDED
+
+#include <stddef.h>
+#include "a4def.h"
+
+/*
+  The journal is an append-only file of the changes made to a File
+  Tree since its last checkpoint snapshot. It starts with a magic
+  string and the checkpoint generation of that snapshot, followed by
+  one record per change. Each record holds the length of its body,
+  the body, and a 4-byte FNV-1a checksum of the body (least
+  significant byte first). A body holds:
+  * the kind of change, in one byte
+  * the length and bytes of the changed path
+  * for a ranged write, the offset of the write
+  * for a new file, new contents, or a ranged write, the length and
+    bytes of the data
+  * for a move or copy, the length and bytes of the destination path
+  All lengths and offsets are unsigned LEB128 varints.
+
+  Records are appended ahead of their changes, buffered in memory, and
+  written and flushed to disk together as a group commit, once every
+  commit window's worth of records, so that a change costs a memory
+  copy rather than a disk flush. A crash loses at most the records of
+  the last open window.
+
+  Records appended inside a batch are held back and then written as
+  one record whose body is a marker byte followed by the batch's
+  records, so that one checksum covers them all and replay applies
+  either every one of them or none.
+*/
+
+/*-------------------------------------------------------------------*/
+
+/* The kinds of change recorded in the journal */
+enum journalOp {
+   JOURNAL_INSERT_DIR, JOURNAL_INSERT_FILE,
+   JOURNAL_RM_DIR, JOURNAL_RM_FILE,
+   JOURNAL_REPLACE, JOURNAL_WRITE, JOURNAL_MOVE, JOURNAL_COPY
+};
+
+/* A change recorded in the journal */
+struct journalRecord {
+   /* the kind of change */
+   enum journalOp eOp;
+   /* the absolute path of the changed node */
+   const char *pcPath;
+   /* the byte offset of a JOURNAL_WRITE */
+   size_t ulOffset;
+   /* the new file's contents, the new contents, the written bytes, or
+      a move's or copy's destination path (not NUL-terminated), of
+      length ulLength, for the kinds of change that have them */
+   const void *pvData;
+   size_t ulLength;
+};
+
+/*-------------------------------------------------------------------*/
+
+/*
+  Opens the journal in the file pcFile for the snapshot of checkpoint
+  generation ulGeneration, flushing records to disk once every
+  ulCommitWindow records (or every record if ulCommitWindow is 0).
+
+  If the file holds a journal of the same generation, first passes
+  each of its intact records, in order, to pfApply, stopping at the
+  first torn or corrupt record, which is cut off along with the rest
+  of the file. The record's path and data are only valid during the
+  call. If pfApply returns anything but SUCCESS, stops and returns
+  that status, leaving the journal closed. If the file does not exist
+  or holds an older journal (one that a later snapshot already
+  covers), starts a new, empty journal instead.
+
+  Returns SUCCESS, or:
+  * INITIALIZATION_ERROR if the journal is already open
+  * IO_ERROR if the file could not be read or written, or holds a
+             journal of a later generation or no journal at all
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int Journal_open(const char *pcFile, size_t ulGeneration,
+                 size_t ulCommitWindow,
+                 int (*pfApply)(const struct journalRecord *psRecord));
+
+/*
+  Flushes any buffered records to disk and closes the journal, if it
+  is open, discarding the records of any open batch. Returns SUCCESS,
+  or IO_ERROR if the records could not be flushed (the journal is
+  closed anyway).
+*/
+int Journal_close(void);
+
+/* Returns TRUE if the journal is open and FALSE otherwise. */
+boolean Journal_isOpen(void);
+
+/* Returns the checkpoint generation of the open journal. */
+size_t Journal_getGeneration(void);
+
+/*
+  Appends a record of the change psRecord to the journal, which must
+  be open, before the change is made, by buffering it in memory; it
+  is written by the next group commit (see Journal_commit), or inside
+  a batch, held back until the batch ends. Returns SUCCESS, or
+  MEMORY_ERROR, appending nothing, if the record could not be
+  buffered.
+*/
+int Journal_append(const struct journalRecord *psRecord);
+
+/*
+  Takes back the record appended last, for a change that could not be
+  made after all. No other journal function may have been called
+  since it was appended.
+*/
+void Journal_retract(void);
+
+/*
+  Completes a group commit if the records appended since the last one
+  fill the commit window; inside a batch, does nothing, since
+  Journal_endBatch commits the batch's records. Returns SUCCESS, or
+  IO_ERROR if the group commit failed, in which case the records not
+  written stay buffered for the next one (or Journal_sync) to retry.
+*/
+int Journal_commit(void);
+
+/*
+  Writes any buffered records, other than those of an open batch, to
+  the journal's file and flushes it to disk. Returns SUCCESS, or
+  IO_ERROR if that failed.
+*/
+int Journal_sync(void);
+
+/*
+  Replaces the journal's file with a new, empty journal for the
+  snapshot of checkpoint generation ulGeneration, discarding any
+  buffered records. Returns SUCCESS, or MEMORY_ERROR or IO_ERROR if
+  the new journal could not be created (the old one is then kept).
+*/
+int Journal_reset(size_t ulGeneration);
+
+/*
+  Starts a batch in the journal, which must be open and not already in
+  one: the records appended from now on are held back in memory until
+  Journal_endBatch writes them as one record, or Journal_abortBatch
+  discards them.
+*/
+void Journal_beginBatch(void);
+
+/*
+  Ends the open batch by wrapping its records into a single record
+  with one checksum, so that a crash keeps either all of them or none,
+  completing a group commit if they fill the commit window. Returns
+  SUCCESS, or MEMORY_ERROR or IO_ERROR if the batch could not be
+  wrapped (it is then still open) or the group commit failed.
+*/
+int Journal_endBatch(void);
+
+/* Discards the records of the open batch and ends it. */
+void Journal_abortBatch(void);
+
+#endif
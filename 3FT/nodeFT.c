@@ -8,31 +8,202 @@
 #include <string.h>
 
 #include "a4def.h"
+#include "bloom.h"
+#include "dcache.h"
 #include "dynarray.h"
 #include "nodeFT.h"
+#include "spill.h"
+#include "traverse.h"
+#include "trigram.h"
 
 /*-------------------------------------------------------------------*/
 
+/* Where the contents of a file node are stored */
+enum storage {
+   /* in memory owned by the client */
+   STORED_BY_CLIENT,
+   /* in a heap buffer owned by the node */
+   STORED_ON_HEAP,
+   /* in a region of the spill store owned by the node */
+   STORED_IN_SPILL,
+   /* in a mapped snapshot that outlives the node */
+   STORED_IN_MAP,
+   /* in a heap buffer shared with copies of the node, which is copied
+      before it is changed */
+   STORED_SHARED
+};
+
 /* A node in a FT */
 struct node {
-   /* the object corresponding to the node's absolute path */
-   Path_T oPPath;
+   /* the node's name, the last component of its absolute path; no
+      node stores its ancestors' names, so moving a subtree only
+      relinks and renames its root */
+   char *pcName;
    /* this node's parent */
    Node_T oNParent;
    /* the object containing links to this node's children */
    DynArray_T oDChildren;
-   /* Flag to indicate whether this node is a file or a directory. 
+   /* Flag to indicate whether this node is a file or a directory.
       TRUE if it is a file. FALSE otherwise. */
    boolean isFile;
-   /* this string contains the contents of the node if it is a file */
-   const char *contents;
+   /* the contents of the node if it is a file; for spilled contents,
+      their mapping into memory, or NULL if they are not mapped */
+   void *pvContents;
+   /* the length in bytes of the contents */
+   size_t ulLength;
+   /* where the contents are stored */
+   enum storage storage;
+   /* the number of bytes allocated for the contents' heap buffer */
+   size_t ulCapacity;
+   /* the offset of the contents' spill region, which is kept while
+      the contents are faulted back onto the heap so they can be
+      evicted to it again */
+   size_t ulSpillOffset;
+   /* the number of bytes in the spill region, or 0 if there is none */
+   size_t ulSpillCapacity;
+   /* for contents STORED_SHARED or in a spill region shared with
+      copies of the node, the number of nodes sharing them; NULL if the
+      node does not share its contents */
+   size_t *pulShares;
+   /* Flag to indicate whether the node is in the content cache's
+      recency list, which holds exactly the nodes STORED_ON_HEAP */
+   boolean isCached;
+   /* the next more and less recently used nodes in the list */
+   Node_T oNNewer;
+   Node_T oNOlder;
+   /* the hash of the node's contents: for a file, of its bytes, and
+      for a directory, of its children's names, types, and hashes in
+      name order */
+   unsigned long ulHash;
+   /* Flag to indicate whether ulHash is out of date, in which case so
+      are the hashes of all of the node's ancestors */
+   boolean isHashStale;
+   /* Flag to indicate whether the node is in the name index */
+   boolean isIndexed;
+   /* the next and previous nodes in the name index with the same
+      name; the first of them heads the name's group */
+   Node_T oNNextNamed;
+   Node_T oNPrevNamed;
+   /* for the head of a group, the head of the next group in the same
+      bucket of the name index */
+   Node_T oNNextGroup;
+   /* for a file in the trigram index, the identifier of its document
+      there, or 0 if it is not in it */
+   size_t ulTextID;
+   /* the numbers of files and directories in the subtree rooted at
+      this node, itself included, and the total length of the files'
+      contents, kept up to date along the chain of ancestors of each
+      change */
+   size_t ulFiles;
+   size_t ulDirs;
+   size_t ulBytes;
+   /* for a directory, the most nodes and bytes of contents its
+      subtree may hold, each 0 if there is no limit */
+   size_t ulMaxNodes;
+   size_t ulMaxBytes;
+   /* the number of pins holding the node's memory (see Node_pin) */
+   size_t ulPins;
+   /* Flag to indicate whether Node_free has been called on the node
+      while it was pinned or seen by a view, so that dropping its last
+      pin or view reference frees it */
+   boolean isFreed;
+   /* the mark kept for the node's client (see Node_setMark) */
+   unsigned long ulMark;
+   /* the generation (see Node_getGeneration) in which the node was
+      last unlinked or moved, or 0 if it never was */
+   unsigned long ulUnlinked;
+   /* the lookup cache's entry for the node's path, or NULL */
+   void *pvCacheEntry;
+   /* for a copy of a node made for a view (see Node_openView), the
+      view, or NULL for a node of a tree */
+   struct nodeView *psView;
+   /* for a node of a tree, the number of views' roots and children of
+      views' copies that are the node, which keep it from being freed
+      with its tree */
+   size_t ulViewRefs;
+   /* for a node of a tree, the first of its copies in views, or NULL;
+      for a copy, the node it copies (or NULL once that is freed) and
+      the next and previous copies of that node */
+   Node_T oNCopies;
+   Node_T oNOriginal;
+   Node_T oNNextCopy;
+   Node_T oNPrevCopy;
+};
+
+/* A view of a tree as it was when the view was opened */
+struct nodeView {
+   /* the root of the view's tree: the root of the tree viewed, until
+      that is first copied into the view, or NULL if the view is
+      lost */
+   Node_T oNRoot;
+   /* the next and previous views open and not lost */
+   struct nodeView *psNext;
+   struct nodeView *psPrev;
 };
 
+/* The 64-bit FNV-1a offset basis and prime, from which hashes are
+   built */
+static const unsigned long ulHashBasis = 14695981039346656037UL;
+static const unsigned long ulHashPrime = 1099511628211UL;
+/* The prime's inverse modulo 2^64, with which a hash is carried back
+   over the bytes it was last carried on over */
+static const unsigned long ulHashInverse = 14886173955864302971UL;
+
+/*-------------------------------------------------------------------*/
+
+/*
+  The content cache accounts for the heap buffers owned by nodes and
+  keeps them within an optional memory budget by evicting the least
+  recently used ones to the spill store. It is represented with 6
+  state variables:
+*/
+
+/* 1. the budget in bytes, or 0 if there is none */
+static size_t ulBudget;
+/* 2. the total size of all heap buffers owned by nodes */
+static size_t ulResident;
+/* 3. the most and least recently used nodes with heap buffers */
+static Node_T oNMostRecent;
+static Node_T oNLeastRecent;
+/* 4. the number of accesses to contents that were on the heap */
+static size_t ulHits;
+/* 5. the number of accesses that faulted evicted contents back in */
+static size_t ulMisses;
+/* 6. the number of contents evicted to make room */
+static size_t ulEvictions;
+
+/*
+  The name index maps each name to the group of nodes with that name,
+  in the trees it has been asked to index, and is kept up to date as
+  nodes are linked into and out of them. It is a hash table of groups,
+  chained through their heads, represented with 2 state variables
+  (the files it holds are also in the trigram index, and the paths of
+  all the nodes it holds in the path filter, if those are kept):
+*/
+
+/* 1. the buckets, or NULL if the index is not kept, and their number */
+static Node_T *poNBuckets;
+static size_t ulBuckets;
+/* 2. the number of groups, one for each distinct name indexed */
+static size_t ulGroups;
+
+/* The number of directories with a quota, so that checks cost nothing
+   while there are none */
+static size_t ulQuotas;
+
+/* The number of times a node has been unlinked or moved, each of which
+   ends or changes the path of every node in its subtree */
+static unsigned long ulGeneration;
+
+/* The first of the views open and not lost, each of which a change to
+   a node it sees must first copy the node into, or NULL */
+static struct nodeView *psViews;
+
 /*-------------------------------------------------------------------*/
 
 /*
-  Compares the string representation of oNfirst with a string
-  pcSecond representing a node's path.
+  Compares the name of oNFirst with a string pcSecond representing a
+  node's name.
   Returns <0, 0, or >0 if oNFirst is "less than", "equal to", or
   "greater than" pcSecond, respectively.
 */
@@ -41,7 +212,479 @@ static int Node_compareString(const Node_T oNFirst,
    assert(oNFirst != NULL);
    assert(pcSecond != NULL);
 
-   return Path_compareString(oNFirst->oPPath, pcSecond);
+   return strcmp(oNFirst->pcName, pcSecond);
+}
+
+/*
+  Marks the hashes of oNNode and its ancestors out of date, stopping
+  at the first one already marked, whose ancestors are then too.
+*/
+static void Node_staleHash(Node_T oNNode) {
+   while(oNNode != NULL && !oNNode->isHashStale) {
+      oNNode->isHashStale = TRUE;
+      oNNode = oNNode->oNParent;
+   }
+}
+
+/*
+  Adds the totals of the subtree rooted at oNSubtree to those of
+  oNNode and each of its ancestors if isAdding is TRUE, or subtracts
+  them otherwise, in time proportional to oNNode's depth.
+*/
+static void Node_addTotals(Node_T oNNode, Node_T oNSubtree,
+                           boolean isAdding) {
+   assert(oNSubtree != NULL);
+
+   for(; oNNode != NULL; oNNode = oNNode->oNParent) {
+      if(isAdding) {
+         oNNode->ulFiles += oNSubtree->ulFiles;
+         oNNode->ulDirs += oNSubtree->ulDirs;
+         oNNode->ulBytes += oNSubtree->ulBytes;
+      }
+      else {
+         oNNode->ulFiles -= oNSubtree->ulFiles;
+         oNNode->ulDirs -= oNSubtree->ulDirs;
+         oNNode->ulBytes -= oNSubtree->ulBytes;
+      }
+   }
+}
+
+/*
+  Sets the length of file oNFile's contents to ulNewLength, carrying
+  the change into the byte totals of oNFile and its ancestors, in time
+  proportional to oNFile's depth, so a new file is best filled in
+  before it is linked.
+*/
+static void Node_setLength(Node_T oNFile, size_t ulNewLength) {
+   size_t oldLength;
+   Node_T node;
+
+   assert(oNFile != NULL);
+   assert(oNFile->isFile);
+
+   oldLength = oNFile->ulLength;
+   oNFile->ulLength = ulNewLength;
+   if(ulNewLength == oldLength)
+      return;
+   for(node = oNFile; node != NULL; node = node->oNParent) {
+      if(ulNewLength > oldLength)
+         node->ulBytes += ulNewLength - oldLength;
+      else
+         node->ulBytes -= oldLength - ulNewLength;
+   }
+}
+
+/*
+  Returns TRUE if adding ulNodes nodes and ulBytes bytes of contents
+  to the subtree rooted at oNNode would take it past its quota, and
+  FALSE otherwise. A subtree already past a quota, which was lowered
+  below what it held, may not grow at all.
+*/
+static boolean Node_exceedsQuota(Node_T oNNode, size_t ulNodes,
+                                 size_t ulBytes) {
+   size_t nodes;
+
+   assert(oNNode != NULL);
+
+   nodes = oNNode->ulFiles + oNNode->ulDirs;
+   if(ulNodes != 0 && oNNode->ulMaxNodes != 0 &&
+      (nodes > oNNode->ulMaxNodes ||
+       ulNodes > oNNode->ulMaxNodes - nodes))
+      return TRUE;
+   if(ulBytes != 0 && oNNode->ulMaxBytes != 0 &&
+      (oNNode->ulBytes > oNNode->ulMaxBytes ||
+       ulBytes > oNNode->ulMaxBytes - oNNode->ulBytes))
+      return TRUE;
+   return FALSE;
+}
+
+/*
+  Notes that the contents of file oNFile are about to change, marking
+  its hash out of date and its document in the trigram index, if it
+  has one, stale.
+*/
+static void Node_staleContents(Node_T oNFile) {
+   assert(oNFile != NULL);
+
+   Node_staleHash(oNFile);
+   if(oNFile->ulTextID != 0)
+      Trigram_markStale(oNFile->ulTextID);
+}
+
+/*
+  Returns the bucket of the name index for the name pcName, using the
+  FNV-1a hash of its characters.
+*/
+static Node_T *Node_indexBucket(const char *pcName) {
+   unsigned long hash = ulHashBasis;
+
+   assert(pcName != NULL);
+   assert(poNBuckets != NULL);
+
+   while(*pcName != '\0') {
+      hash ^= (unsigned char) *pcName++;
+      hash *= ulHashPrime;
+   }
+   return &poNBuckets[hash % ulBuckets];
+}
+
+/*
+  Doubles the number of buckets in the name index and moves each group
+  to its new bucket, if there is memory to; otherwise leaves the index
+  as it is, with longer chains.
+*/
+static void Node_indexGrow(void) {
+   enum {GROWTH_FACTOR = 2};
+   Node_T *oldBuckets = poNBuckets;
+   size_t oldCount = ulBuckets;
+   Node_T *bucket;
+   Node_T head;
+   size_t i;
+
+   poNBuckets = calloc(oldCount * GROWTH_FACTOR, sizeof(Node_T));
+   if(poNBuckets == NULL) {
+      poNBuckets = oldBuckets;
+      return;
+   }
+   ulBuckets = oldCount * GROWTH_FACTOR;
+
+   for(i = 0; i < oldCount; i++) {
+      while(oldBuckets[i] != NULL) {
+         head = oldBuckets[i];
+         oldBuckets[i] = head->oNNextGroup;
+         bucket = Node_indexBucket(head->pcName);
+         head->oNNextGroup = *bucket;
+         *bucket = head;
+      }
+   }
+   free(oldBuckets);
+}
+
+/*
+  Adds oNNode, which is not in the name index, to its name's group,
+  starting a new group if it is the first node with that name. Takes
+  no memory of its own, so it cannot fail.
+*/
+static void Node_indexAdd(Node_T oNNode) {
+   enum {MAX_LOAD = 2};
+   Node_T *bucket;
+   Node_T head;
+
+   assert(oNNode != NULL);
+   assert(!oNNode->isIndexed);
+
+   bucket = Node_indexBucket(oNNode->pcName);
+   for(head = *bucket; head != NULL; head = head->oNNextGroup)
+      if(!strcmp(head->pcName, oNNode->pcName))
+         break;
+
+   oNNode->isIndexed = TRUE;
+   oNNode->oNPrevNamed = head;
+   oNNode->oNNextGroup = NULL;
+   if(head != NULL) {
+      oNNode->oNNextNamed = head->oNNextNamed;
+      if(head->oNNextNamed != NULL)
+         head->oNNextNamed->oNPrevNamed = oNNode;
+      head->oNNextNamed = oNNode;
+      return;
+   }
+
+   oNNode->oNNextNamed = NULL;
+   oNNode->oNNextGroup = *bucket;
+   *bucket = oNNode;
+   ulGroups++;
+   if(ulGroups > ulBuckets * MAX_LOAD)
+      Node_indexGrow();
+}
+
+/*
+  Removes oNNode, which is in the name index, from its name's group,
+  handing the group to the next node with that name if oNNode heads
+  it, or dropping the group if oNNode is its last node.
+*/
+static void Node_indexRemove(Node_T oNNode) {
+   Node_T *link;
+   Node_T next;
+
+   assert(oNNode != NULL);
+   assert(oNNode->isIndexed);
+
+   next = oNNode->oNNextNamed;
+   if(next != NULL)
+      next->oNPrevNamed = oNNode->oNPrevNamed;
+   if(oNNode->oNPrevNamed != NULL)
+      oNNode->oNPrevNamed->oNNextNamed = next;
+   else {
+      link = Node_indexBucket(oNNode->pcName);
+      while(*link != oNNode)
+         link = &(*link)->oNNextGroup;
+      if(next != NULL) {
+         next->oNNextGroup = oNNode->oNNextGroup;
+         *link = next;
+      }
+      else {
+         *link = oNNode->oNNextGroup;
+         ulGroups--;
+      }
+   }
+
+   oNNode->isIndexed = FALSE;
+   oNNode->oNNextNamed = NULL;
+   oNNode->oNPrevNamed = NULL;
+   oNNode->oNNextGroup = NULL;
+}
+
+/*
+  Adds oNNode to the trigram index, as a stale document, if it is a
+  file not in it and the index is kept. If memory runs out, the index
+  only notes that it is no longer complete.
+*/
+static void Node_textJoin(Node_T oNNode) {
+   assert(oNNode != NULL);
+
+   if(oNNode->isFile && oNNode->ulTextID == 0 && Trigram_isStarted())
+      (void) Trigram_add(oNNode, &oNNode->ulTextID);
+}
+
+/* Removes oNNode from the trigram index, if it is in it. */
+static void Node_textLeave(Node_T oNNode) {
+   assert(oNNode != NULL);
+
+   if(oNNode->ulTextID != 0) {
+      Trigram_remove(oNNode->ulTextID);
+      oNNode->ulTextID = 0;
+   }
+}
+
+/*
+  Returns the FNV-1a hash of the path of a child named pcName of a
+  node whose path hashes to ulParentHash, by carrying that hash on
+  over the '/' delimiter and the name.
+*/
+static unsigned long Node_hashChild(unsigned long ulParentHash,
+                                    const char *pcName) {
+   unsigned long hash = ulParentHash;
+
+   assert(pcName != NULL);
+
+   hash ^= (unsigned char) '/';
+   hash *= ulHashPrime;
+   while(*pcName != '\0') {
+      hash ^= (unsigned char) *pcName++;
+      hash *= ulHashPrime;
+   }
+   return hash;
+}
+
+/*
+  Returns the FNV-1a hash of the path of the parent of a node named
+  pcName whose path hashes to ulChildHash, undoing Node_hashChild.
+*/
+static unsigned long Node_hashParent(unsigned long ulChildHash,
+                                     const char *pcName) {
+   unsigned long hash = ulChildHash;
+   size_t length;
+
+   assert(pcName != NULL);
+
+   for(length = strlen(pcName); length != 0; length--) {
+      hash *= ulHashInverse;
+      hash ^= (unsigned char) pcName[length - 1];
+   }
+   hash *= ulHashInverse;
+   hash ^= (unsigned char) '/';
+   return hash;
+}
+
+/*
+  Returns the FNV-1a hash of oNNode's absolute path, the same as that
+  of the path's string, from the names of oNNode and its ancestors.
+  The parent links up to the root are turned around to lead back down
+  to oNNode, in place of a stack, and put back on the way down.
+*/
+static unsigned long Node_hashPath(Node_T oNNode) {
+   unsigned long hash = ulHashBasis;
+   Node_T node = oNNode;
+   Node_T below = NULL;
+   Node_T next;
+   const char *name;
+
+   assert(oNNode != NULL);
+
+   while(node != NULL) {
+      next = node->oNParent;
+      node->oNParent = below;
+      below = node;
+      node = next;
+   }
+
+   /* below is now the root, whose name starts the path */
+   node = below;
+   below = NULL;
+   for(name = node->pcName; *name != '\0'; name++) {
+      hash ^= (unsigned char) *name;
+      hash *= ulHashPrime;
+   }
+   for(;;) {
+      next = node->oNParent;
+      node->oNParent = below;
+      if(next == NULL)
+         return hash;
+      hash = Node_hashChild(hash, next->pcName);
+      below = node;
+      node = next;
+   }
+}
+
+/*
+  Returns the index of oNNode, which must have a parent, among its
+  parent's children.
+*/
+static size_t Node_childIndex(Node_T oNNode) {
+   size_t index = 0;
+
+   assert(oNNode != NULL);
+   assert(oNNode->oNParent != NULL);
+
+   (void) DynArray_bsearch(oNNode->oNParent->oDChildren, oNNode, &index,
+            (int (*)(const void *, const void *)) Node_compare);
+   return index;
+}
+
+/*
+  Returns the node after oNNode in a pre-order walk of the subtree
+  rooted at oNTop, or NULL if oNNode is the last, following child,
+  parent, and sibling links instead of keeping a stack. Carries
+  *pulPathHash, the hash of oNNode's path, over to that of the node
+  returned, unless pulPathHash is NULL.
+*/
+static Node_T Node_nextInTree(Node_T oNNode, Node_T oNTop,
+                              unsigned long *pulPathHash) {
+   Node_T next;
+   size_t index;
+
+   assert(oNNode != NULL);
+   assert(oNTop != NULL);
+
+   if(!oNNode->isFile && DynArray_getLength(oNNode->oDChildren) != 0) {
+      next = DynArray_get(oNNode->oDChildren, 0);
+      if(pulPathHash != NULL)
+         *pulPathHash = Node_hashChild(*pulPathHash, next->pcName);
+      return next;
+   }
+
+   /* climb until a node on the way up has a next sibling */
+   for(; oNNode != oNTop; oNNode = oNNode->oNParent) {
+      if(pulPathHash != NULL)
+         *pulPathHash = Node_hashParent(*pulPathHash, oNNode->pcName);
+      index = Node_childIndex(oNNode) + 1;
+      if(index < DynArray_getLength(oNNode->oNParent->oDChildren)) {
+         next = DynArray_get(oNNode->oNParent->oDChildren, index);
+         if(pulPathHash != NULL)
+            *pulPathHash = Node_hashChild(*pulPathHash, next->pcName);
+         return next;
+      }
+   }
+   return NULL;
+}
+
+/*
+  Returns the hash of oNNode's path if the path filter is kept, and 0
+  otherwise, so that linking and unlinking nodes costs nothing more
+  while it is not.
+*/
+static unsigned long Node_filterHash(Node_T oNNode) {
+   assert(oNNode != NULL);
+
+   if(!Bloom_isStarted())
+      return 0;
+   return Node_hashPath(oNNode);
+}
+
+/*
+  Adds the path of every node in the subtree rooted at oNNode, whose
+  own path hashes to ulPathHash, to the path filter, which must be
+  kept, if isAdding is TRUE, or removes every one from it otherwise.
+*/
+static void Node_filterTree(Node_T oNNode, unsigned long ulPathHash,
+                            boolean isAdding) {
+   Node_T node = oNNode;
+
+   assert(oNNode != NULL);
+
+   do {
+      if(isAdding)
+         Bloom_add(ulPathHash);
+      else
+         Bloom_remove(ulPathHash);
+      node = Node_nextInTree(node, oNNode, &ulPathHash);
+   } while(node != NULL);
+}
+
+/*
+  Adds the path of every node in the name index to the path filter,
+  which must be kept and empty. The index holds whole subtrees, so
+  each is filled from its top, the one indexed node whose parent is
+  not, carrying the path hash down the walk: hashing every node's
+  path on its own would take time growing with the sum of the nodes'
+  depths rather than with their number.
+*/
+static void Node_filterFill(void) {
+   Node_T head;
+   Node_T node;
+   size_t i;
+
+   for(i = 0; i < ulBuckets; i++)
+      for(head = poNBuckets[i]; head != NULL; head = head->oNNextGroup)
+         for(node = head; node != NULL; node = node->oNNextNamed)
+            if(node->oNParent == NULL || !node->oNParent->isIndexed)
+               Node_filterTree(node, Node_hashPath(node), TRUE);
+}
+
+/*
+  Grows the path filter, if it is kept and holds more paths than it
+  was sized for, and fills it afresh. Leaves it crowded if there is
+  not the memory to grow it.
+*/
+static void Node_filterGrow(void) {
+   if(Bloom_isStarted() && Bloom_isCrowded() &&
+      Bloom_grow() == SUCCESS)
+      Node_filterFill();
+}
+
+/*
+  Adds every node in the subtree rooted at oNNode, whose path hashes
+  to ulPathHash, to the name index, every file in it to the trigram
+  index, and every path in it to the path filter, if isAdding is TRUE,
+  or removes every one from them otherwise, skipping nodes that are
+  already in or out of them. ulPathHash is ignored if the path filter
+  is not kept.
+*/
+static void Node_indexTree(Node_T oNNode, unsigned long ulPathHash,
+                           boolean isAdding) {
+   boolean isFiltered = Bloom_isStarted();
+   Node_T node = oNNode;
+
+   assert(oNNode != NULL);
+
+   do {
+      if(node->isIndexed != isAdding) {
+         if(isAdding) {
+            Node_indexAdd(node);
+            Node_textJoin(node);
+            if(isFiltered)
+               Bloom_add(ulPathHash);
+         }
+         else {
+            Node_indexRemove(node);
+            Node_textLeave(node);
+            if(isFiltered)
+               Bloom_remove(ulPathHash);
+         }
+      }
+      node = Node_nextInTree(node, oNNode,
+                             isFiltered ? &ulPathHash : NULL);
+   } while(node != NULL);
 }
 
 /*
@@ -59,106 +702,69 @@ static int Node_addChild(Node_T oNParent, Node_T oNChild,
       return NO_SUCH_PATH;
    }
 
-   if(DynArray_addAt(oNParent->oDChildren, ulIndex, oNChild))
-      return SUCCESS;
-   else
+   if(!DynArray_addAt(oNParent->oDChildren, ulIndex, oNChild))
       return MEMORY_ERROR;
+   Node_staleHash(oNParent);
+   return SUCCESS;
 }
 
-/* 
-   Tries to link a newly created node newNode to its parent oNParent, 
-   assuming its path has already been set. Returns SUCCESS if there 
-   are no issues. Otherwise, does nothing and returns status:
-   * CONFLICTING_PATH if oNParent's path is not an ancestor of oPPath
-   * NO_SUCH_PATH if oNParent's path is not oPPath's direct parent
+/*
+  Checks that oPPath could be the path of a new child of oNParent, or
+  of the root if oNParent is NULL, by comparing its components with
+  the names of oNParent and its ancestors. Returns SUCCESS if so.
+  Otherwise, returns status:
+  * CONFLICTING_PATH if oNParent's path is not an ancestor of oPPath
+  * NO_SUCH_PATH if oNParent's path is not oPPath's direct parent
                  or oNParent is NULL but oPPath is not of depth 1
                  or oNParent is a file
-   * ALREADY_IN_TREE if oNParent already has a child with this path
 */
-static int Node_linkToParent(Node_T newNode, Node_T oNParent) {
-   Path_T parentPath;
-   size_t parentDepth;
-   int status;
-   size_t index;
+static int Node_checkPath(Path_T oPPath, Node_T oNParent) {
+   Node_T ancestor;
+   size_t parentDepth = 0;
+   size_t level;
 
-   assert(newNode != NULL);
-   assert(newNode->oPPath != NULL);
+   assert(oPPath != NULL);
 
    /* ensure oNParent is not a file if it isn't NULL */
-   if(oNParent != NULL && Node_isFile(oNParent)) {
+   if(oNParent != NULL && Node_isFile(oNParent))
       return NO_SUCH_PATH;
-   }
-   
-   /* validate and set the new node's parent */
-   if(oNParent != NULL) {
-      size_t sharedDepth;
-
-      parentPath = oNParent->oPPath;
-      parentDepth = Path_getDepth(parentPath);
-      sharedDepth = Path_getSharedPrefixDepth(newNode->oPPath,
-                                                parentPath);
 
-      /* parent must be an ancestor of child */
-      if(sharedDepth < parentDepth) {
+   for(ancestor = oNParent; ancestor != NULL;
+       ancestor = ancestor->oNParent)
+      parentDepth++;
+
+   /* parent must be an ancestor of child */
+   if(parentDepth > Path_getDepth(oPPath))
+      return CONFLICTING_PATH;
+   level = parentDepth;
+   for(ancestor = oNParent; ancestor != NULL;
+       ancestor = ancestor->oNParent) {
+      level--;
+      if(strcmp(ancestor->pcName, Path_getComponent(oPPath, level)))
          return CONFLICTING_PATH;
-      }
-
-      /* parent must be exactly one level up from child */
-      if(Path_getDepth(newNode->oPPath) != parentDepth + 1) {
-         return NO_SUCH_PATH;
-      }
-
-      /* parent must not already have child with this path */
-      if(Node_hasChild(oNParent, newNode->oPPath, &index)) {
-         return ALREADY_IN_TREE;
-      }
-   }
-   else {
-      /* new node must be root */
-      /* can only create one "level" at a time */
-      if(Path_getDepth(newNode->oPPath) != 1) {
-         return NO_SUCH_PATH;
-      }
    }
-   newNode->oNParent = oNParent;
 
-   /* Link into parent's children list */
-   if(oNParent != NULL) {
-      status = Node_addChild(oNParent, newNode, index);
-      if(status != SUCCESS) {
-         return status;
-      }
-   }
-   
+   /* parent must be exactly one level up from child (or the child
+      must be the root) */
+   if(Path_getDepth(oPPath) != parentDepth + 1)
+      return NO_SUCH_PATH;
+
    return SUCCESS;
 }
 
-/*-------------------------------------------------------------------*/
-
 /*
-  Creates a new directory node in the File Tree, with path oPPath and
-  parent oNParent. Returns an int SUCCESS status and sets *poNResult 
-  to be the new node if successful. Otherwise, sets *poNResult to NULL 
-  and returns status:
+  Allocates a new unlinked node with a copy of name pcName, set up as
+  a file if isFile is TRUE and as a directory otherwise. Returns an int
+  SUCCESS status and sets *poNResult to be the new node if successful.
+  Otherwise, sets *poNResult to NULL and returns status:
   * MEMORY_ERROR if memory could not be allocated to complete request
-  * CONFLICTING_PATH if oNParent's path is not an ancestor of oPPath
-  * NO_SUCH_PATH if oPPath is of depth 0
-                 or oNParent's path is not oPPath's direct parent
-                 or oNParent is NULL but oPPath is not of depth 1
-                 or oNParent is a file
-  * ALREADY_IN_TREE if oNParent already has a child with this path
 */
-int Node_newDir(Path_T oPPath, Node_T oNParent, Node_T *poNResult) {
+static int Node_create(const char *pcName, boolean isFile,
+                       Node_T *poNResult) {
    struct node *newNode;
-   int status;
-   Path_T newPath;
-
-   assert(oPPath != NULL);
 
-   /* make sure parent isn't a file if it isn't NULL */
-   if(oNParent != NULL && Node_isFile(oNParent)) {
-      return NO_SUCH_PATH;
-   }
+   assert(pcName != NULL);
+   assert(poNResult != NULL);
 
    /* allocate space for a new node */
    newNode = malloc(sizeof(struct node));
@@ -167,294 +773,2477 @@ int Node_newDir(Path_T oPPath, Node_T oNParent, Node_T *poNResult) {
       return MEMORY_ERROR;
    }
 
-   /* set the new node's path */
-   status = Path_dup(oPPath, &newPath);
-   if(status != SUCCESS) {
+   /* set the new node's name */
+   newNode->pcName = malloc(strlen(pcName) + 1);
+   if(newNode->pcName == NULL) {
       free(newNode);
       *poNResult = NULL;
-      return status;
+      return MEMORY_ERROR;
    }
-   newNode->oPPath = newPath;
+   strcpy(newNode->pcName, pcName);
+   newNode->oNParent = NULL;
 
-   /* link node into tree */
-   status = Node_linkToParent(newNode, oNParent);
-   if(status != SUCCESS) {
-      free(newNode);
-      *poNResult = NULL;
-      return status;
+   /* only directories get a children array */
+   newNode->oDChildren = NULL;
+   if(!isFile) {
+      newNode->oDChildren = DynArray_new(0);
+      if(newNode->oDChildren == NULL) {
+         free(newNode->pcName);
+         free(newNode);
+         *poNResult = NULL;
+         return MEMORY_ERROR;
+      }
    }
 
-   /* set up the new node as a directory */
-   newNode->oDChildren = DynArray_new(0);
-   if(newNode->oDChildren == NULL) {
-      Path_free(newNode->oPPath);
-      free(newNode);
-      *poNResult = NULL;
-      return MEMORY_ERROR;
+   newNode->isFile = isFile;
+   newNode->pvContents = NULL;
+   newNode->ulLength = 0;
+   newNode->storage = STORED_BY_CLIENT;
+   newNode->ulCapacity = 0;
+   newNode->ulSpillOffset = 0;
+   newNode->ulSpillCapacity = 0;
+   newNode->pulShares = NULL;
+   newNode->isCached = FALSE;
+   newNode->oNNewer = NULL;
+   newNode->oNOlder = NULL;
+   newNode->ulHash = 0;
+   newNode->isHashStale = TRUE;
+   newNode->isIndexed = FALSE;
+   newNode->oNNextNamed = NULL;
+   newNode->oNPrevNamed = NULL;
+   newNode->oNNextGroup = NULL;
+   newNode->ulTextID = 0;
+   newNode->ulFiles = isFile ? 1 : 0;
+   newNode->ulDirs = isFile ? 0 : 1;
+   newNode->ulBytes = 0;
+   newNode->ulMaxNodes = 0;
+   newNode->ulMaxBytes = 0;
+   newNode->ulPins = 0;
+   newNode->isFreed = FALSE;
+   newNode->ulUnlinked = 0;
+   newNode->pvCacheEntry = NULL;
+   newNode->ulMark = 0;
+   newNode->psView = NULL;
+   newNode->ulViewRefs = 0;
+   newNode->oNCopies = NULL;
+   newNode->oNOriginal = NULL;
+   newNode->oNNextCopy = NULL;
+   newNode->oNPrevCopy = NULL;
+
+   *poNResult = newNode;
+   return SUCCESS;
+}
+
+/*
+  Removes oNNode from the content cache's recency list, if it is in
+  it, and stops accounting for its heap buffer.
+*/
+static void Node_cacheRemove(Node_T oNNode) {
+   assert(oNNode != NULL);
+
+   if(!oNNode->isCached)
+      return;
+
+   if(oNNode->oNNewer != NULL)
+      oNNode->oNNewer->oNOlder = oNNode->oNOlder;
+   else
+      oNMostRecent = oNNode->oNOlder;
+   if(oNNode->oNOlder != NULL)
+      oNNode->oNOlder->oNNewer = oNNode->oNNewer;
+   else
+      oNLeastRecent = oNNode->oNNewer;
+
+   oNNode->oNNewer = NULL;
+   oNNode->oNOlder = NULL;
+   oNNode->isCached = FALSE;
+   ulResident -= oNNode->ulCapacity;
+}
+
+/*
+  Makes oNNode, whose contents must be on the heap, the most recently
+  used node in the content cache, accounting for its heap buffer.
+  Must be called again whenever the buffer changes size.
+*/
+static void Node_cacheTouch(Node_T oNNode) {
+   assert(oNNode != NULL);
+   assert(oNNode->storage == STORED_ON_HEAP);
+
+   Node_cacheRemove(oNNode);
+
+   oNNode->oNOlder = oNMostRecent;
+   if(oNMostRecent != NULL)
+      oNMostRecent->oNNewer = oNNode;
+   else
+      oNLeastRecent = oNNode;
+   oNMostRecent = oNNode;
+   oNNode->isCached = TRUE;
+   ulResident += oNNode->ulCapacity;
+}
+
+/*
+  While the content cache is over budget, evicts the least recently
+  used contents other than oNKeep's to the spill store. Stops early if
+  an eviction fails, leaving the cache over budget.
+*/
+static void Node_cacheEvict(Node_T oNKeep) {
+   Node_T victim;
+
+   while(ulBudget != 0 && ulResident > ulBudget) {
+      victim = oNLeastRecent;
+      if(victim == oNKeep)
+         victim = victim->oNNewer;
+      if(victim == NULL || Node_spillContents(victim) != SUCCESS)
+         return;
+      ulEvictions++;
+   }
+}
+
+/*
+  Stops oNNode from sharing its contents with copies of it, without
+  touching the contents themselves. Returns TRUE if oNNode was the
+  last node sharing them, which then owns them, and FALSE otherwise.
+*/
+static boolean Node_dropShare(Node_T oNNode) {
+   assert(oNNode != NULL);
+   assert(oNNode->pulShares != NULL);
+
+   (*oNNode->pulShares)--;
+   if(*oNNode->pulShares == 0) {
+      free(oNNode->pulShares);
+      oNNode->pulShares = NULL;
+      return TRUE;
+   }
+   oNNode->pulShares = NULL;
+   return FALSE;
+}
+
+/*
+  If oNNode is the only node left sharing its contents, makes them its
+  own again, so that changing them does not copy them. Shared heap
+  buffers go back into the content cache.
+*/
+static void Node_claimShare(Node_T oNNode) {
+   assert(oNNode != NULL);
+
+   if(oNNode->pulShares == NULL || *oNNode->pulShares != 1)
+      return;
+
+   (void) Node_dropShare(oNNode);
+   if(oNNode->storage == STORED_SHARED) {
+      oNNode->storage = STORED_ON_HEAP;
+      Node_cacheTouch(oNNode);
+   }
+}
+
+/*
+  Makes oNCopy, a new file node with no contents, share file node
+  oNNode's contents. Client-owned and mapped contents are shared by
+  pointer; a heap buffer owned by oNNode leaves the content cache and
+  becomes STORED_SHARED; and a spill region is shared by offset,
+  with each node mapping it separately. Returns SUCCESS, or
+  MEMORY_ERROR if the count of sharers could not be allocated.
+*/
+static int Node_shareContents(Node_T oNNode, Node_T oNCopy) {
+   assert(oNNode != NULL);
+   assert(oNCopy != NULL);
+   assert(oNCopy->storage == STORED_BY_CLIENT);
+
+   if(oNNode->storage == STORED_ON_HEAP ||
+      oNNode->storage == STORED_SHARED ||
+      oNNode->storage == STORED_IN_SPILL) {
+      if(oNNode->pulShares == NULL) {
+         oNNode->pulShares = malloc(sizeof(size_t));
+         if(oNNode->pulShares == NULL)
+            return MEMORY_ERROR;
+         *oNNode->pulShares = 1;
+      }
+      if(oNNode->storage == STORED_ON_HEAP) {
+         Node_cacheRemove(oNNode);
+         oNNode->storage = STORED_SHARED;
+      }
+      (*oNNode->pulShares)++;
+      oNCopy->pulShares = oNNode->pulShares;
+   }
+
+   oNCopy->storage = oNNode->storage;
+   Node_setLength(oNCopy, oNNode->ulLength);
+   if(oNNode->storage == STORED_IN_SPILL) {
+      oNCopy->ulSpillOffset = oNNode->ulSpillOffset;
+      oNCopy->ulSpillCapacity = oNNode->ulSpillCapacity;
+   }
+   else {
+      oNCopy->pvContents = oNNode->pvContents;
+      oNCopy->ulCapacity = oNNode->ulCapacity;
+   }
+   return SUCCESS;
+}
+
+/*
+  Records an access to file node oNNode's contents. Contents on the
+  heap become the most recently used. When there is a budget,
+  contents that were evicted (those no longer than the spill
+  threshold) are first faulted back onto the heap, evicting others to
+  make room. Returns SUCCESS, or MEMORY_ERROR or IO_ERROR if evicted
+  contents could not be faulted in (in which case they stay spilled).
+*/
+static int Node_cacheAccess(Node_T oNNode) {
+   char *buffer;
+   int status;
+
+   assert(oNNode != NULL);
+
+   Node_claimShare(oNNode);
+   if(oNNode->storage == STORED_ON_HEAP) {
+      ulHits++;
+      Node_cacheTouch(oNNode);
+      return SUCCESS;
+   }
+
+   if(ulBudget == 0 || oNNode->storage != STORED_IN_SPILL ||
+      oNNode->ulLength > Spill_getThreshold())
+      return SUCCESS;
+
+   ulMisses++;
+   buffer = malloc(oNNode->ulSpillCapacity);
+   if(buffer == NULL)
+      return MEMORY_ERROR;
+   status = Spill_read(oNNode->ulSpillOffset, buffer, oNNode->ulLength);
+   if(status != SUCCESS) {
+      free(buffer);
+      return status;
+   }
+
+   if(oNNode->pvContents != NULL)
+      Spill_unmap(oNNode->pvContents, oNNode->ulSpillOffset,
+                  oNNode->ulSpillCapacity);
+   oNNode->pvContents = buffer;
+   oNNode->storage = STORED_ON_HEAP;
+   oNNode->ulCapacity = oNNode->ulSpillCapacity;
+   /* a region shared with copies cannot be reused for evicting */
+   if(oNNode->pulShares != NULL) {
+      (void) Node_dropShare(oNNode);
+      oNNode->ulSpillCapacity = 0;
+   }
+   Node_cacheTouch(oNNode);
+   Node_cacheEvict(oNNode);
+   return SUCCESS;
+}
+
+/*
+  Releases oNNode's contents if the node owns them: frees a heap
+  buffer (a shared one only once no other node shares it), or unmaps
+  a mapped spill region. (The region's space in the append-only spill
+  store is simply abandoned.) Afterward, the node holds NULL contents
+  of length 0.
+*/
+static void Node_releaseContents(Node_T oNNode) {
+   assert(oNNode != NULL);
+
+   if(oNNode->storage == STORED_ON_HEAP) {
+      Node_cacheRemove(oNNode);
+      free(oNNode->pvContents);
+   }
+   else if(oNNode->storage == STORED_SHARED) {
+      if(Node_dropShare(oNNode))
+         free(oNNode->pvContents);
+   }
+   else if(oNNode->storage == STORED_IN_SPILL &&
+           oNNode->pvContents != NULL) {
+      Spill_unmap(oNNode->pvContents, oNNode->ulSpillOffset,
+                  oNNode->ulSpillCapacity);
+   }
+
+   if(oNNode->pulShares != NULL)
+      (void) Node_dropShare(oNNode);
+
+   oNNode->pvContents = NULL;
+   if(oNNode->isFile)
+      Node_setLength(oNNode, 0);
+   oNNode->storage = STORED_BY_CLIENT;
+   oNNode->ulCapacity = 0;
+   oNNode->ulSpillCapacity = 0;
+}
+
+/*
+  Frees the memory of the single node oNNode, which must already be
+  unlinked from its parent and have no children.
+*/
+static void Node_destroy(Node_T oNNode) {
+   Node_T copy;
+
+   assert(oNNode != NULL);
+
+   /* a copy made for a view leaves the list of copies of the node it
+      copies, and the copies of a node forget it */
+   if(oNNode->psView != NULL) {
+      if(oNNode->oNPrevCopy != NULL)
+         oNNode->oNPrevCopy->oNNextCopy = oNNode->oNNextCopy;
+      else if(oNNode->oNOriginal != NULL)
+         oNNode->oNOriginal->oNCopies = oNNode->oNNextCopy;
+      if(oNNode->oNNextCopy != NULL)
+         oNNode->oNNextCopy->oNPrevCopy = oNNode->oNPrevCopy;
+   }
+   for(copy = oNNode->oNCopies; copy != NULL; copy = copy->oNNextCopy)
+      copy->oNOriginal = NULL;
+
+   if(oNNode->isIndexed)
+      Node_indexRemove(oNNode);
+   Node_textLeave(oNNode);
+   if(oNNode->pvCacheEntry != NULL)
+      Dcache_remove(oNNode->pvCacheEntry);
+   if(oNNode->ulMaxNodes != 0 || oNNode->ulMaxBytes != 0)
+      ulQuotas--;
+   if(oNNode->oDChildren != NULL)
+      DynArray_free(oNNode->oDChildren);
+   Node_releaseContents(oNNode);
+   free(oNNode->pcName);
+   free(oNNode);
+}
+
+/*
+  Returns the capacity to grow a buffer or region of ulCapacity bytes
+  to so that it holds ulNeeded: at least MIN_CAPACITY, and doubled as
+  often as needed, or just ulNeeded if doubling would overflow.
+*/
+static size_t Node_growCapacity(size_t ulCapacity, size_t ulNeeded) {
+   enum {MIN_CAPACITY = 16, GROWTH_FACTOR = 2};
+   const size_t maxDoubled = (size_t) -1 / GROWTH_FACTOR;
+
+   if(ulCapacity < MIN_CAPACITY)
+      ulCapacity = MIN_CAPACITY;
+   while(ulCapacity < ulNeeded) {
+      if(ulCapacity > maxDoubled)
+         return ulNeeded;
+      ulCapacity *= GROWTH_FACTOR;
+   }
+   return ulCapacity;
+}
+
+/*
+  Writes ulLength bytes from pvData at byte ulOffset of the spilled
+  contents of oNNode, giving the contents a new region at the end of
+  the spill store, grown as by Node_growCapacity, if they outgrow
+  their current one, or a new region of their own if they share it
+  with copies.
+  Returns SUCCESS, or MEMORY_ERROR or IO_ERROR (leaving the contents
+  unchanged) if the region could not be grown.
+*/
+static int Node_writeSpilled(Node_T oNNode, size_t ulOffset,
+                             const void *pvData, size_t ulLength,
+                             size_t ulNewLength) {
+   size_t newCapacity;
+   size_t newOffset;
+   int status;
+
+   assert(oNNode != NULL);
+   assert(oNNode->storage == STORED_IN_SPILL);
+
+   if(ulNewLength > oNNode->ulSpillCapacity ||
+      oNNode->pulShares != NULL) {
+      newCapacity = Node_growCapacity(oNNode->ulSpillCapacity,
+                                      ulNewLength);
+
+      status = Spill_alloc(newCapacity, &newOffset);
+      if(status != SUCCESS)
+         return status;
+      status = Spill_copy(oNNode->ulSpillOffset, newOffset,
+                          oNNode->ulLength);
+      if(status != SUCCESS)
+         return status;
+
+      if(oNNode->pvContents != NULL)
+         Spill_unmap(oNNode->pvContents, oNNode->ulSpillOffset,
+                     oNNode->ulSpillCapacity);
+      if(oNNode->pulShares != NULL)
+         (void) Node_dropShare(oNNode);
+      oNNode->pvContents = NULL;
+      oNNode->ulSpillOffset = newOffset;
+      oNNode->ulSpillCapacity = newCapacity;
+   }
+
+   /* a region is zero-filled past the contents' end, since contents
+      never shrink within a region, so any gap is already zeroed */
+   status = Spill_write(oNNode->ulSpillOffset + ulOffset, pvData,
+                        ulLength);
+   if(status != SUCCESS)
+      return status;
+
+   if(ulNewLength > oNNode->ulLength)
+      Node_setLength(oNNode, ulNewLength);
+   return SUCCESS;
+}
+
+/*
+  Unlinks and returns the last child of oNNode, or returns NULL if it
+  is a file or has no children left, for Traverse_dismantle. The
+  child's subtree must already be out of the name index. A child that
+  a view still sees is unlinked but not returned, and is kept with
+  its subtree as a tree of its own until no view sees it (see
+  Node_unref).
+*/
+static void *Node_popChild(void *pvNode) {
+   Node_T oNNode = pvNode;
+   Node_T child;
+   size_t length;
+
+   assert(oNNode != NULL);
+
+   if(oNNode->isFile)
+      return NULL;
+   for(length = DynArray_getLength(oNNode->oDChildren); length != 0;
+       length--) {
+      child = DynArray_removeAt(oNNode->oDChildren, length - 1);
+      if(child->ulViewRefs == 0)
+         return child;
+      child->oNParent = NULL;
+      child->isFreed = TRUE;
+   }
+   return NULL;
+}
+
+/* Returns the parent of pvNode, for Traverse_dismantle. */
+static void *Node_parentOf(void *pvNode) {
+   assert(pvNode != NULL);
+
+   return ((Node_T) pvNode)->oNParent;
+}
+
+/*
+  Frees pvNode, which has no children left, for Traverse_dismantle. A
+  pinned node is instead left as Node_detach would leave it, totalling
+  only itself, until its last pin is dropped.
+*/
+static void Node_freeOne(void *pvNode, void *pvExtra) {
+   Node_T oNNode = pvNode;
+
+   assert(oNNode != NULL);
+
+   if(oNNode->ulPins == 0) {
+      Node_destroy(oNNode);
+      return;
+   }
+   oNNode->isFreed = TRUE;
+   oNNode->oNParent = NULL;
+   oNNode->isHashStale = TRUE;
+   oNNode->ulFiles = oNNode->isFile ? 1 : 0;
+   oNNode->ulDirs = oNNode->isFile ? 0 : 1;
+   oNNode->ulBytes = oNNode->isFile ? oNNode->ulLength : 0;
+}
+
+/*
+  Drops a view's reference to oNNode, which must have one. If the node
+  was freed from its tree while views saw it, and this was the last
+  reference, frees it with what is left of its subtree.
+*/
+static void Node_unref(Node_T oNNode) {
+   assert(oNNode != NULL);
+   assert(oNNode->ulViewRefs != 0);
+
+   oNNode->ulViewRefs--;
+   if(oNNode->ulViewRefs == 0 && oNNode->isFreed)
+      Traverse_dismantle(oNNode, Node_popChild, Node_parentOf,
+                         Node_freeOne, NULL);
+}
+
+/*
+  Unlinks and returns the last child of view node pvNode that is a
+  copy made for its view, or returns NULL if none is left, for
+  Traverse_dismantle, dropping the view's references to the children
+  that are nodes of a tree on the way.
+*/
+static void *Node_popCopy(void *pvNode) {
+   Node_T oNNode = pvNode;
+   Node_T child;
+   size_t length;
+
+   assert(oNNode != NULL);
+   assert(oNNode->psView != NULL);
+
+   if(oNNode->isFile)
+      return NULL;
+   for(length = DynArray_getLength(oNNode->oDChildren); length != 0;
+       length--) {
+      child = DynArray_removeAt(oNNode->oDChildren, length - 1);
+      if(child->psView != NULL)
+         return child;
+      Node_unref(child);
+   }
+   return NULL;
+}
+
+/*
+  Frees oNTop, a copy made for a view, with the copies below it, and
+  drops the view's references to the nodes of the tree among their
+  children; or, if oNTop is itself a node of a tree, just drops the
+  view's reference to it.
+*/
+static void Node_dropCopies(Node_T oNTop) {
+   assert(oNTop != NULL);
+
+   if(oNTop->psView == NULL)
+      Node_unref(oNTop);
+   else
+      Traverse_dismantle(oNTop, Node_popCopy, Node_parentOf,
+                         Node_freeOne, NULL);
+}
+
+/*
+  Drops the tree of view psView, which must have one, and takes the
+  view out of the list of those that changes copy nodes into, leaving
+  it with no root.
+*/
+static void Node_emptyView(struct nodeView *psView) {
+   assert(psView != NULL);
+   assert(psView->oNRoot != NULL);
+
+   Node_dropCopies(psView->oNRoot);
+   psView->oNRoot = NULL;
+   if(psView->psPrev != NULL)
+      psView->psPrev->psNext = psView->psNext;
+   else
+      psViews = psView->psNext;
+   if(psView->psNext != NULL)
+      psView->psNext->psPrev = psView->psPrev;
+   psView->psNext = NULL;
+   psView->psPrev = NULL;
+}
+
+/* Returns the copy of oNNode made for view psView, or NULL. */
+static Node_T Node_copyIn(Node_T oNNode, struct nodeView *psView) {
+   Node_T copy;
+
+   assert(oNNode != NULL);
+   assert(psView != NULL);
+
+   for(copy = oNNode->oNCopies; copy != NULL; copy = copy->oNNextCopy)
+      if(copy->psView == psView)
+         return copy;
+   return NULL;
+}
+
+/*
+  Makes a copy of oNNode for view psView, with the same name, hash,
+  and totals, that shares oNNode's contents (see Node_shareContents)
+  or children, each of which the view then refers to. Returns SUCCESS
+  and sets *poNResult to the copy, which has no parent yet, or returns
+  MEMORY_ERROR if memory could not be allocated.
+*/
+static int Node_copyInto(Node_T oNNode, struct nodeView *psView,
+                         Node_T *poNResult) {
+   Node_T copy;
+   Node_T child;
+   size_t length;
+   size_t i;
+   int status;
+
+   assert(oNNode != NULL);
+   assert(psView != NULL);
+   assert(poNResult != NULL);
+
+   status = Node_create(oNNode->pcName, oNNode->isFile, &copy);
+   if(status != SUCCESS)
+      return status;
+   length = Node_getNumChildren(oNNode);
+   if(oNNode->isFile)
+      status = Node_shareContents(oNNode, copy);
+   for(i = 0; status == SUCCESS && i < length; i++)
+      if(!DynArray_add(copy->oDChildren,
+                       DynArray_get(oNNode->oDChildren, i)))
+         status = MEMORY_ERROR;
+   if(status != SUCCESS) {
+      Node_destroy(copy);
+      return status;
+   }
+
+   for(i = 0; i < length; i++) {
+      child = DynArray_get(oNNode->oDChildren, i);
+      child->ulViewRefs++;
+   }
+   copy->ulHash = oNNode->ulHash;
+   copy->isHashStale = oNNode->isHashStale;
+   copy->ulFiles = oNNode->ulFiles;
+   copy->ulDirs = oNNode->ulDirs;
+   copy->ulBytes = oNNode->ulBytes;
+   copy->psView = psView;
+   copy->oNOriginal = oNNode;
+   copy->oNNextCopy = oNNode->oNCopies;
+   if(oNNode->oNCopies != NULL)
+      oNNode->oNCopies->oNPrevCopy = copy;
+   oNNode->oNCopies = copy;
+   *poNResult = copy;
+   return SUCCESS;
+}
+
+/*
+  Copies oNNode, which view psView sees and which has no copy there,
+  into the view, along with each of its ancestors up to the nearest
+  one that has a copy there, or up to the view's root, so that the
+  view's tree leads down to the copies instead. Each copy takes the
+  place of the node it copies among the children of the copy above
+  it. Loses the view (see Node_emptyView) if memory runs out.
+*/
+static void Node_copyPath(Node_T oNNode, struct nodeView *psView) {
+   Node_T node = oNNode;
+   Node_T copy;
+   Node_T holder;
+   boolean isNew;
+   size_t index;
+
+   assert(oNNode != NULL);
+   assert(psView != NULL);
+
+   if(Node_copyInto(node, psView, &copy) != SUCCESS) {
+      Node_emptyView(psView);
+      return;
+   }
+   for(;;) {
+      if(node == psView->oNRoot) {
+         psView->oNRoot = copy;
+         Node_unref(node);
+         return;
+      }
+
+      holder = Node_copyIn(node->oNParent, psView);
+      isNew = (boolean) (holder == NULL);
+      if(isNew &&
+         Node_copyInto(node->oNParent, psView, &holder) != SUCCESS) {
+         Node_dropCopies(copy);
+         Node_emptyView(psView);
+         return;
+      }
+      (void) DynArray_bsearch(holder->oDChildren, node->pcName, &index,
+            (int (*)(const void *, const void *)) Node_compareString);
+      (void) DynArray_set(holder->oDChildren, index, copy);
+      copy->oNParent = holder;
+      Node_unref(node);
+      if(!isNew)
+         return;
+      node = node->oNParent;
+      copy = holder;
+   }
+}
+
+/*
+  Copies oNNode, which is about to change, into each view that sees it
+  and has no copy of it yet, as described for Node_copyPath, taking
+  time proportional to its depth for each view open, and none at all
+  while there are none. A view sees a node if the nodes from it up to
+  the view's root are the same as when the view was opened, or else up
+  to the nearest one copied into the view, whose copy then still holds
+  the node below it.
+*/
+static void Node_preserve(Node_T oNNode) {
+   struct nodeView *view;
+   struct nodeView *next;
+   Node_T node;
+   Node_T below;
+   Node_T holder = NULL;
+   size_t index;
+
+   assert(oNNode != NULL);
+   assert(oNNode->psView == NULL);
+
+   for(view = psViews; view != NULL; view = next) {
+      next = view->psNext;
+      below = NULL;
+      for(node = oNNode; node != NULL; node = node->oNParent) {
+         holder = Node_copyIn(node, view);
+         if(holder != NULL || node == view->oNRoot)
+            break;
+         below = node;
+      }
+      if(node == NULL || (holder != NULL && below == NULL))
+         continue;
+      if(holder != NULL &&
+         (!DynArray_bsearch(holder->oDChildren, below->pcName, &index,
+            (int (*)(const void *, const void *)) Node_compareString) ||
+          DynArray_get(holder->oDChildren, index) != below))
+         continue;
+      Node_copyPath(oNNode, view);
+   }
+}
+
+/*
+  Tries to link a newly created node newNode to its parent oNParent,
+  or to make it a root if oNParent is NULL. Returns SUCCESS if there
+  are no issues. Otherwise, does nothing and returns status:
+  * MEMORY_ERROR if allocation fails adding newNode to the children
+  * NO_SUCH_PATH if oNParent is a file
+  * ALREADY_IN_TREE if oNParent already has a child with this name
+*/
+static int Node_linkToParent(Node_T newNode, Node_T oNParent) {
+   size_t index;
+   int status;
+
+   assert(newNode != NULL);
+
+   if(oNParent == NULL)
+      return SUCCESS;
+
+   /* parent must not already have child with this name */
+   if(Node_hasChild(oNParent, newNode->pcName, &index))
+      return ALREADY_IN_TREE;
+
+   /* Link into parent's children list */
+   Node_preserve(oNParent);
+   status = Node_addChild(oNParent, newNode, index);
+   if(status != SUCCESS)
+      return status;
+   newNode->oNParent = oNParent;
+   Node_addTotals(oNParent, newNode, TRUE);
+   if(oNParent->isIndexed) {
+      Node_indexTree(newNode, Node_filterHash(newNode), TRUE);
+      Node_filterGrow();
+   }
+   return SUCCESS;
+}
+
+/*-------------------------------------------------------------------*/
+
+/*
+  Creates a new directory node in the File Tree, with path oPPath and
+  parent oNParent. Returns an int SUCCESS status and sets *poNResult
+  to be the new node if successful. Otherwise, sets *poNResult to NULL
+  and returns status:
+  * MEMORY_ERROR if memory could not be allocated to complete request
+  * CONFLICTING_PATH if oNParent's path is not an ancestor of oPPath
+  * NO_SUCH_PATH if oPPath is of depth 0
+                 or oNParent's path is not oPPath's direct parent
+                 or oNParent is NULL but oPPath is not of depth 1
+                 or oNParent is a file
+  * ALREADY_IN_TREE if oNParent already has a child with this path
+*/
+int Node_newDir(Path_T oPPath, Node_T oNParent, Node_T *poNResult) {
+   Node_T newNode;
+   int status;
+
+   assert(oPPath != NULL);
+   assert(poNResult != NULL);
+
+   status = Node_checkPath(oPPath, oNParent);
+   if(status == SUCCESS)
+      status = Node_create(Path_getComponent(oPPath,
+                                             Path_getDepth(oPPath) - 1),
+                          FALSE, &newNode);
+   if(status != SUCCESS) {
+      *poNResult = NULL;
+      return status;
+   }
+
+   /* link node into tree last, so a failure leaves the tree as is */
+   status = Node_linkToParent(newNode, oNParent);
+   if(status != SUCCESS) {
+      Node_destroy(newNode);
+      *poNResult = NULL;
+      return status;
+   }
+
+   *poNResult = newNode;
+   return SUCCESS;
+}
+
+/*
+  Creates a new file node in the File Tree, with path oPPath, parent
+  oNParent, and contents pvContents of size ulLength bytes. The node
+  stores the pvContents pointer itself; the memory it points to
+  remains owned by the caller. Returns an int SUCCESS status and
+  sets *poNResult to be the new node if successful. Otherwise, sets
+  *poNResult to NULL and returns status:
+  * MEMORY_ERROR if memory could not be allocated to complete request
+  * CONFLICTING_PATH if oNParent's path is not an ancestor of oPPath
+  * NO_SUCH_PATH if oPPath is of depth 0
+                 or oNParent's path is not oPPath's direct parent
+                 or oNParent is NULL but oPPath is not of depth 1
+                 or oNParent is a file
+  * ALREADY_IN_TREE if oNParent already has a child with this path
+*/
+int Node_newFile(Path_T oPPath, Node_T oNParent, void *pvContents,
+                 size_t ulLength, Node_T *poNResult) {
+   Node_T newNode;
+   int status;
+
+   assert(oPPath != NULL);
+   assert(poNResult != NULL);
+
+   status = Node_checkPath(oPPath, oNParent);
+   if(status == SUCCESS)
+      status = Node_create(Path_getComponent(oPPath,
+                                             Path_getDepth(oPPath) - 1),
+                          TRUE, &newNode);
+   if(status != SUCCESS) {
+      *poNResult = NULL;
+      return status;
+   }
+   newNode->pvContents = pvContents;
+   Node_setLength(newNode, ulLength);
+
+   /* link node into tree last, so a failure leaves the tree as is */
+   status = Node_linkToParent(newNode, oNParent);
+   if(status != SUCCESS) {
+      Node_destroy(newNode);
+      *poNResult = NULL;
+      return status;
+   }
+
+   *poNResult = newNode;
+   return SUCCESS;
+}
+
+/*
+  Creates a new node named pcName, a file with NULL contents if isFile
+  is TRUE and a directory otherwise, as a child of oNParent, or as the
+  root if oNParent is NULL. Children built in sorted order are linked
+  in at the end of their parent's children in O(log n) time. Returns an
+  int SUCCESS status and sets *poNResult to be the new node if
+  successful. Otherwise, sets *poNResult to NULL and returns status:
+  * BAD_PATH if pcName is empty or contains a '/'
+  * MEMORY_ERROR if memory could not be allocated to complete request
+  * NO_SUCH_PATH if oNParent is a file
+  * ALREADY_IN_TREE if oNParent already has a child named pcName
+*/
+int Node_newChild(Node_T oNParent, const char *pcName, boolean isFile,
+                  Node_T *poNResult) {
+   Node_T newNode;
+   int status;
+
+   assert(pcName != NULL);
+   assert(poNResult != NULL);
+
+   *poNResult = NULL;
+   if(*pcName == '\0' || strchr(pcName, '/') != NULL)
+      return BAD_PATH;
+   if(oNParent != NULL && Node_isFile(oNParent))
+      return NO_SUCH_PATH;
+
+   status = Node_create(pcName, isFile, &newNode);
+   if(status != SUCCESS)
+      return status;
+
+   status = Node_linkToParent(newNode, oNParent);
+   if(status != SUCCESS) {
+      Node_destroy(newNode);
+      return status;
+   }
+
+   *poNResult = newNode;
+   return SUCCESS;
+}
+
+/*
+  Destroys and frees all memory allocated for the subtree rooted at
+  oNNode, i.e., deletes this node and all its descendents. Returns the
+  number of nodes deleted. A pinned node is unlinked and loses its
+  children, but its memory is only freed when its last pin is dropped.
+  A node that an open view still sees is unlinked but kept, with its
+  subtree, until no view sees it. Runs without recursion, so the
+  subtree may be of any depth.
+*/
+size_t Node_free(Node_T oNNode) {
+   size_t count;
+   
+   assert(oNNode != NULL);
+   
+   count = Node_countNodes(oNNode);
+   /* remove from parent's list, and the whole subtree from the name
+      index, so its nodes can be unlinked from each other directly */
+   Node_detach(oNNode);
+   if(oNNode->ulViewRefs != 0) {
+      oNNode->isFreed = TRUE;
+      return count;
+   }
+
+   Traverse_dismantle(oNNode, Node_popChild, Node_parentOf,
+                      Node_freeOne, NULL);
+   return count;
+}
+
+/*
+  Pins oNNode, so that its memory outlives Node_free until the pin is
+  dropped with Node_unpin. A node may hold any number of pins.
+*/
+void Node_pin(Node_T oNNode) {
+   assert(oNNode != NULL);
+
+   oNNode->ulPins++;
+}
+
+/*
+  Drops a pin from oNNode, which must hold one, freeing the node if
+  Node_free has been called on it, this was its last pin, and no view
+  still sees it.
+*/
+void Node_unpin(Node_T oNNode) {
+   assert(oNNode != NULL);
+   assert(oNNode->ulPins != 0);
+
+   oNNode->ulPins--;
+   if(oNNode->ulPins == 0 && oNNode->isFreed &&
+      oNNode->ulViewRefs == 0)
+      Node_destroy(oNNode);
+}
+
+/*
+  Builds a new path object representing oNNode's absolute path, from
+  the names of oNNode and its ancestors, in time proportional to its
+  length. Returns an int SUCCESS status and sets *poPResult to the
+  path, which is then owned by the caller, if successful. Otherwise,
+  sets *poPResult to NULL and returns MEMORY_ERROR.
+*/
+int Node_getPath(Node_T oNNode, Path_T *poPResult) {
+   char *pathname;
+   int status;
+
+   assert(oNNode != NULL);
+   assert(poPResult != NULL);
+
+   pathname = Node_toString(oNNode);
+   if(pathname == NULL) {
+      *poPResult = NULL;
+      return MEMORY_ERROR;
+   }
+   status = Path_new(pathname, poPResult);
+   free(pathname);
+   return status;
+}
+
+/* Returns oNNode's name, the last component of its absolute path. */
+const char *Node_getName(Node_T oNNode) {
+   assert(oNNode != NULL);
+
+   return oNNode->pcName;
+}
+
+/*
+  Returns TRUE if oNParent has a child named pcName. Returns
+  FALSE if it does not, or if oNParent is a file.
+
+  If oNParent has such a child, stores in *pulChildID the child's
+  identifier (as used in Node_getChild). If oNParent does not have
+  such a child, stores in *pulChildID the identifier that such a
+  child _would_ have if inserted.
+*/
+boolean Node_hasChild(Node_T oNParent, const char *pcName,
+                         size_t *pulChildID) {
+   assert(oNParent != NULL);
+   assert(pcName != NULL);
+   assert(pulChildID != NULL);
+
+   if(Node_isFile(oNParent)) {
+      return FALSE;
+   }
+
+   /* *pulChildID is the index into oNParent->oDChildren */
+   return DynArray_bsearch(oNParent->oDChildren,
+            (char*) pcName, pulChildID,
+            (int (*)(const void*,const void*)) Node_compareString);
+}
+
+/* 
+  Returns the number of children that oNParent has 
+  (always 0 if oNParent is a file).
+*/
+size_t Node_getNumChildren(Node_T oNParent) {
+   assert(oNParent != NULL);
+
+   if(Node_isFile(oNParent)) {
+      return 0;
+   }
+   return DynArray_getLength(oNParent->oDChildren);
+}
+
+/*
+  Returns an int SUCCESS status and sets *poNResult to be the child
+  node of oNParent with identifier ulChildID, if one exists.
+  Otherwise, sets *poNResult to NULL and returns status:
+  * NO_SUCH_PATH if ulChildID is not a valid child for oNParent
+*/
+int Node_getChild(Node_T oNParent, size_t ulChildID,
+                  Node_T *poNResult) {
+   assert(oNParent != NULL);
+   assert(poNResult != NULL);
+
+   /* ensure oNParent is not a file */
+   if (Node_isFile(oNParent)) {
+      *poNResult = NULL;
+      return NO_SUCH_PATH;
+   }
+
+   /* ulChildID is the index into oNParent->oDChildren */
+   if(ulChildID >= Node_getNumChildren(oNParent)) {
+      *poNResult = NULL;
+      return NO_SUCH_PATH;
+   }
+   else {
+      *poNResult = DynArray_get(oNParent->oDChildren, ulChildID);
+      return SUCCESS;
+   }
+}
+
+/*
+  Returns a the parent node of oNNode.
+  Returns NULL if oNNode is the root and thus has no parent.
+*/
+Node_T Node_getParent(Node_T oNNode) {
+   assert(oNNode != NULL);
+
+   return oNNode->oNParent;
+}
+
+/*
+  Compares oNFirst and oNSecond lexicographically based on their names,
+  which orders siblings the same way as their paths.
+  Returns <0, 0, or >0 if onFirst is "less than", "equal to", or
+  "greater than" oNSecond, respectively.
+*/
+int Node_compare(Node_T oNFirst, Node_T oNSecond) {
+   assert(oNFirst != NULL);
+   assert(oNSecond != NULL);
+
+   return strcmp(oNFirst->pcName, oNSecond->pcName);
+}
+
+/*
+  Moves oNNode, with its whole subtree, to be the child of oNNewParent
+  named pcNewName. Since no node stores its ancestors' names, only
+  oNNode itself is relinked and renamed: finding its old and new
+  places takes O(log n) comparisons among n siblings, and no
+  descendant is touched. Returns SUCCESS if successful. Otherwise,
+  leaves the tree unchanged and returns status:
+  * BAD_PATH if pcNewName is empty or contains a '/'
+  * MEMORY_ERROR if memory could not be allocated to complete request
+  * NO_SUCH_PATH if oNNewParent is a file
+  * CONFLICTING_PATH if oNNode is the root, or oNNewParent is oNNode
+                     or one of its descendants
+  * ALREADY_IN_TREE if oNNewParent already has a child named
+                    pcNewName (which may be oNNode itself)
+*/
+int Node_move(Node_T oNNode, Node_T oNNewParent,
+              const char *pcNewName) {
+   Node_T oldParent;
+   Node_T ancestor;
+   char *newName;
+   char *oldName;
+   size_t oldIndex;
+   size_t newIndex;
+   boolean isIndexed;
+   unsigned long oldHash;
+
+   assert(oNNode != NULL);
+   assert(oNNewParent != NULL);
+   assert(pcNewName != NULL);
+
+   if(*pcNewName == '\0' || strchr(pcNewName, '/') != NULL)
+      return BAD_PATH;
+   if(Node_isFile(oNNewParent))
+      return NO_SUCH_PATH;
+   oldParent = oNNode->oNParent;
+   if(oldParent == NULL)
+      return CONFLICTING_PATH;
+   for(ancestor = oNNewParent; ancestor != NULL;
+       ancestor = ancestor->oNParent)
+      if(ancestor == oNNode)
+         return CONFLICTING_PATH;
+   if(Node_hasChild(oNNewParent, pcNewName, &newIndex))
+      return ALREADY_IN_TREE;
+
+   newName = malloc(strlen(pcNewName) + 1);
+   if(newName == NULL)
+      return MEMORY_ERROR;
+   strcpy(newName, pcNewName);
+   Node_preserve(oldParent);
+   Node_preserve(oNNode);
+   Node_preserve(oNNewParent);
+
+   /* unlink from the old parent, then link in under the new name;
+      relinking at the old index cannot fail, since removing oNNode
+      left room for it */
+   (void) DynArray_bsearch(oldParent->oDChildren, oNNode, &oldIndex,
+            (int (*)(const void *, const void *)) Node_compare);
+   (void) DynArray_removeAt(oldParent->oDChildren, oldIndex);
+   Node_staleHash(oldParent);
+   /* only oNNode is renamed, so only it changes groups in the name
+      index; its descendants keep theirs */
+   isIndexed = oNNode->isIndexed;
+   oldHash = isIndexed ? Node_filterHash(oNNode) : 0;
+   if(isIndexed)
+      Node_indexRemove(oNNode);
+   oldName = oNNode->pcName;
+   oNNode->pcName = newName;
+   (void) Node_hasChild(oNNewParent, newName, &newIndex);
+   if(Node_addChild(oNNewParent, oNNode, newIndex) != SUCCESS) {
+      oNNode->pcName = oldName;
+      (void) Node_addChild(oldParent, oNNode, oldIndex);
+      if(isIndexed)
+         Node_indexAdd(oNNode);
+      free(newName);
+      return MEMORY_ERROR;
+   }
+
+   free(oldName);
+   oNNode->oNParent = oNNewParent;
+   oNNode->ulUnlinked = ++ulGeneration;
+   Node_addTotals(oldParent, oNNode, FALSE);
+   Node_addTotals(oNNewParent, oNNode, TRUE);
+   if(isIndexed)
+      Node_indexAdd(oNNode);
+   /* but every path in the subtree changes, so the path filter must
+      trade each old one for its new one */
+   if(isIndexed && Bloom_isStarted()) {
+      Node_filterTree(oNNode, oldHash, FALSE);
+      Node_filterTree(oNNode, Node_hashPath(oNNode), TRUE);
+   }
+   return SUCCESS;
+}
+
+/*
+  Builds copies of the children of oNNode, and of their subtrees, as
+  the children of oNCopy, a new node with no children, sharing file
+  contents as described for Node_copy. Adds the number of nodes built
+  to *pulNodes. Returns SUCCESS, or MEMORY_ERROR if memory could not
+  be allocated, in which case the copies built so far are left linked
+  under oNCopy.
+*/
+static int Node_copyChildren(Node_T oNNode, Node_T oNCopy,
+                             size_t *pulNodes) {
+   Node_T node = oNNode;
+   Node_T copy = oNCopy;
+   Node_T child;
+   Node_T newNode;
+   size_t i;
+   int status;
+
+   assert(oNNode != NULL);
+   assert(oNCopy != NULL);
+   assert(pulNodes != NULL);
+
+   /* the two trees are walked in step; children are copied in sorted
+      order, so the number copied under copy so far is the index of
+      node's next child to copy, and no stack is needed */
+   for(;;) {
+      i = copy->isFile ? 0 : DynArray_getLength(copy->oDChildren);
+      if(i == Node_getNumChildren(node)) {
+         if(node == oNNode)
+            return SUCCESS;
+         node = node->oNParent;
+         copy = copy->oNParent;
+         continue;
+      }
+
+      child = DynArray_get(node->oDChildren, i);
+      status = Node_create(child->pcName, child->isFile, &newNode);
+      if(status != SUCCESS)
+         return status;
+      if(child->isFile)
+         status = Node_shareContents(child, newNode);
+      /* each copy goes last among its siblings */
+      if(status == SUCCESS)
+         status = Node_addChild(copy, newNode, i);
+      if(status != SUCCESS) {
+         Node_destroy(newNode);
+         return status;
+      }
+      newNode->oNParent = copy;
+      (*pulNodes)++;
+      /* the copy has the same contents, and so the same hash and
+         totals */
+      newNode->ulHash = child->ulHash;
+      newNode->isHashStale = child->isHashStale;
+      newNode->ulFiles = child->ulFiles;
+      newNode->ulDirs = child->ulDirs;
+      newNode->ulBytes = child->ulBytes;
+
+      node = child;
+      copy = newNode;
+   }
+}
+
+/*
+  Builds a copy of the subtree rooted at oNNode as the child of
+  oNNewParent named pcNewName, or as the root of a new tree of its own
+  if oNNewParent is NULL. Sets *poNResult to the copy of oNNode and
+  *pulNodes to the number of nodes built. The copies share their file
+  contents with the originals instead of copying them: client-owned
+  contents stay client-owned, and contents owned by a node are
+  reference counted and copied only when first changed through either
+  node (or simply taken over by the last node left sharing them).
+  Copying takes time proportional to the number of nodes, not to the
+  size of their contents: unlike a view's (see Node_openView), the
+  copies are nodes of the tree, each with its own parent, name,
+  totals, and index links, so none can be shared with its original.
+  Returns SUCCESS if successful. Otherwise,
+  leaves the tree unchanged, sets *poNResult to NULL and *pulNodes to
+  0, and returns status:
+  * BAD_PATH if pcNewName is empty or contains a '/'
+  * MEMORY_ERROR if memory could not be allocated to complete request
+  * NO_SUCH_PATH if oNNewParent is a file
+  * CONFLICTING_PATH if oNNewParent is oNNode or one of its
+                     descendants
+  * ALREADY_IN_TREE if oNNewParent already has a child named
+                    pcNewName
+*/
+int Node_copy(Node_T oNNode, Node_T oNNewParent, const char *pcNewName,
+              Node_T *poNResult, size_t *pulNodes) {
+   Node_T ancestor;
+   Node_T newNode;
+   size_t index;
+   int status;
+
+   assert(oNNode != NULL);
+   assert(pcNewName != NULL);
+   assert(poNResult != NULL);
+   assert(pulNodes != NULL);
+
+   *poNResult = NULL;
+   *pulNodes = 0;
+   if(*pcNewName == '\0' || strchr(pcNewName, '/') != NULL)
+      return BAD_PATH;
+   if(oNNewParent != NULL && Node_isFile(oNNewParent))
+      return NO_SUCH_PATH;
+   for(ancestor = oNNewParent; ancestor != NULL;
+       ancestor = ancestor->oNParent)
+      if(ancestor == oNNode)
+         return CONFLICTING_PATH;
+   if(oNNewParent != NULL &&
+      Node_hasChild(oNNewParent, pcNewName, &index))
+      return ALREADY_IN_TREE;
+
+   status = Node_create(pcNewName, oNNode->isFile, &newNode);
+   if(status != SUCCESS)
+      return status;
+   *pulNodes = 1;
+   if(oNNode->isFile)
+      status = Node_shareContents(oNNode, newNode);
+   else
+      status = Node_copyChildren(oNNode, newNode, pulNodes);
+   newNode->ulHash = oNNode->ulHash;
+   newNode->isHashStale = oNNode->isHashStale;
+   newNode->ulFiles = oNNode->ulFiles;
+   newNode->ulDirs = oNNode->ulDirs;
+   newNode->ulBytes = oNNode->ulBytes;
+
+   /* link the copy in last, so a failure leaves the tree as is */
+   if(status == SUCCESS)
+      status = Node_linkToParent(newNode, oNNewParent);
+   if(status != SUCCESS) {
+      (void) Node_free(newNode);
+      *pulNodes = 0;
+      return status;
+   }
+   *poNResult = newNode;
+   return SUCCESS;
+}
+
+/*
+  Unlinks oNNode, with its whole subtree, from its parent's children,
+  leaving it the root of a tree of its own, and removes the subtree
+  from the name index and advances the generation (see
+  Node_getGeneration), even if oNNode has no parent.
+*/
+void Node_detach(Node_T oNNode) {
+   size_t index;
+
+   assert(oNNode != NULL);
+
+   if(oNNode->oNParent != NULL)
+      Node_preserve(oNNode->oNParent);
+   /* a view that sees the subtree keeps a copy of its root, so that
+      later changes within it find the view still sees them */
+   Node_preserve(oNNode);
+   oNNode->ulUnlinked = ++ulGeneration;
+   if(oNNode->isIndexed)
+      Node_indexTree(oNNode, Node_filterHash(oNNode), FALSE);
+   if(oNNode->oNParent == NULL)
+      return;
+
+   if(DynArray_bsearch(oNNode->oNParent->oDChildren, oNNode, &index,
+         (int (*)(const void *, const void *)) Node_compare))
+      (void) DynArray_removeAt(oNNode->oNParent->oDChildren, index);
+   Node_staleHash(oNNode->oNParent);
+   Node_addTotals(oNNode->oNParent, oNNode, FALSE);
+   oNNode->oNParent = NULL;
+}
+
+/*
+  Links oNNode, which must have no parent, with its whole subtree in
+  as a child of oNParent, which must not lie in that subtree. Returns
+  SUCCESS if successful. Otherwise, leaves oNNode without a parent and
+  returns status:
+  * MEMORY_ERROR if memory could not be allocated to complete request
+  * NO_SUCH_PATH if oNParent is a file
+  * ALREADY_IN_TREE if oNParent already has a child with oNNode's name
+*/
+int Node_attach(Node_T oNNode, Node_T oNParent) {
+   assert(oNNode != NULL);
+   assert(oNNode->oNParent == NULL);
+   assert(oNParent != NULL);
+
+   return Node_linkToParent(oNNode, oNParent);
+}
+
+/*
+  Gives oNNode, which must have no parent, the name pcName, a string
+  allocated with malloc that the node takes over, and returns its old
+  name, which is then owned by the caller.
+*/
+char *Node_setName(Node_T oNNode, char *pcName) {
+   char *oldName;
+   boolean isIndexed;
+
+   assert(oNNode != NULL);
+   assert(oNNode->oNParent == NULL);
+   assert(pcName != NULL);
+
+   Node_preserve(oNNode);
+   isIndexed = oNNode->isIndexed;
+   if(isIndexed && Bloom_isStarted())
+      Node_filterTree(oNNode, Node_hashPath(oNNode), FALSE);
+   if(isIndexed)
+      Node_indexRemove(oNNode);
+   oldName = oNNode->pcName;
+   oNNode->pcName = pcName;
+   if(isIndexed)
+      Node_indexAdd(oNNode);
+   if(isIndexed && Bloom_isStarted())
+      Node_filterTree(oNNode, Node_hashPath(oNNode), TRUE);
+   return oldName;
+}
+
+/*
+  Swaps the contents of file nodes oNFirst and oNSecond, wherever and
+  however each is stored, along with their places in the content
+  cache.
+*/
+void Node_swapContents(Node_T oNFirst, Node_T oNSecond) {
+   struct node held;
+
+   assert(oNFirst != NULL);
+   assert(oNSecond != NULL);
+   assert(oNFirst->isFile);
+   assert(oNSecond->isFile);
+
+   Node_preserve(oNFirst);
+   Node_preserve(oNSecond);
+   Node_cacheRemove(oNFirst);
+   Node_cacheRemove(oNSecond);
+   Node_staleContents(oNFirst);
+   Node_staleContents(oNSecond);
+
+   held = *oNFirst;
+   oNFirst->pvContents = oNSecond->pvContents;
+   Node_setLength(oNFirst, oNSecond->ulLength);
+   oNFirst->storage = oNSecond->storage;
+   oNFirst->ulCapacity = oNSecond->ulCapacity;
+   oNFirst->ulSpillOffset = oNSecond->ulSpillOffset;
+   oNFirst->ulSpillCapacity = oNSecond->ulSpillCapacity;
+   oNFirst->pulShares = oNSecond->pulShares;
+   oNSecond->pvContents = held.pvContents;
+   Node_setLength(oNSecond, held.ulLength);
+   oNSecond->storage = held.storage;
+   oNSecond->ulCapacity = held.ulCapacity;
+   oNSecond->ulSpillOffset = held.ulSpillOffset;
+   oNSecond->ulSpillCapacity = held.ulSpillCapacity;
+   oNSecond->pulShares = held.pulShares;
+
+   if(oNFirst->storage == STORED_ON_HEAP)
+      Node_cacheTouch(oNFirst);
+   if(oNSecond->storage == STORED_ON_HEAP)
+      Node_cacheTouch(oNSecond);
+}
+
+/*
+  Opens a view of the tree rooted at oNRoot, which must have no
+  parent, as it is now, in constant time: the view shares the tree's
+  nodes, and a change to a node that the view sees first copies the
+  node into the view, with each of its ancestors not yet copied. The
+  copies share the nodes' contents and other children, so a change
+  costs time proportional to its depth, and to its ancestors' numbers
+  of children, for each view that sees it. A change never fails for
+  want of memory for a view; the view is lost instead (see
+  Node_getViewRoot). Returns SUCCESS and sets *poVResult to the view,
+  which must be closed with Node_closeView, or sets *poVResult to NULL
+  and returns MEMORY_ERROR if memory could not be allocated.
+*/
+int Node_openView(Node_T oNRoot, Node_View_T *poVResult) {
+   struct nodeView *view;
+
+   assert(oNRoot != NULL);
+   assert(oNRoot->oNParent == NULL);
+   assert(oNRoot->psView == NULL);
+   assert(poVResult != NULL);
+
+   view = malloc(sizeof(struct nodeView));
+   if(view == NULL) {
+      *poVResult = NULL;
+      return MEMORY_ERROR;
+   }
+   view->oNRoot = oNRoot;
+   oNRoot->ulViewRefs++;
+   view->psPrev = NULL;
+   view->psNext = psViews;
+   if(psViews != NULL)
+      psViews->psPrev = view;
+   psViews = view;
+
+   *poVResult = view;
+   return SUCCESS;
+}
+
+/*
+  Returns the root of view oVView's tree, or NULL if the view was lost
+  for want of memory to copy a node into it. The view's nodes may only
+  be read, from its root down: they may be shared with the tree
+  viewed, so their parents, and paths built from them, may not be the
+  view's.
+*/
+Node_T Node_getViewRoot(Node_View_T oVView) {
+   assert(oVView != NULL);
+
+   return oVView->oNRoot;
+}
+
+/*
+  Closes view oVView, freeing its copies of nodes, and the nodes freed
+  from the tree viewed that it was the last to see.
+*/
+void Node_closeView(Node_View_T oVView) {
+   assert(oVView != NULL);
+
+   if(oVView->oNRoot != NULL)
+      Node_emptyView(oVView);
+   free(oVView);
+}
+
+/*
+  Returns the number of nodes in the subtree rooted at oNNode, in
+  constant time.
+*/
+size_t Node_countNodes(Node_T oNNode) {
+   assert(oNNode != NULL);
+
+   return oNNode->ulFiles + oNNode->ulDirs;
+}
+
+/*
+  Sets *pulFiles and *pulDirs to the numbers of files and directories
+  in the subtree rooted at oNNode, itself included, and *pulBytes to
+  the total length of the files' contents, in constant time.
+*/
+void Node_getTotals(Node_T oNNode, size_t *pulFiles, size_t *pulDirs,
+                    size_t *pulBytes) {
+   assert(oNNode != NULL);
+   assert(pulFiles != NULL);
+   assert(pulDirs != NULL);
+   assert(pulBytes != NULL);
+
+   *pulFiles = oNNode->ulFiles;
+   *pulDirs = oNNode->ulDirs;
+   *pulBytes = oNNode->ulBytes;
+}
+
+/*
+  Sets the mark of oNNode, a number that the node keeps for its
+  client and that starts out 0, to ulMark.
+*/
+void Node_setMark(Node_T oNNode, unsigned long ulMark) {
+   assert(oNNode != NULL);
+
+   oNNode->ulMark = ulMark;
+}
+
+/* Returns the mark of oNNode (see Node_setMark). */
+unsigned long Node_getMark(Node_T oNNode) {
+   assert(oNNode != NULL);
+
+   return oNNode->ulMark;
+}
+
+/*
+  Returns the generation of the trees of nodes, which changes whenever
+  a node is unlinked (or freed) or moved, and so whenever a path may
+  have stopped naming the node it named.
+*/
+unsigned long Node_getGeneration(void) {
+   return ulGeneration;
+}
+
+/*
+  Returns TRUE if oNNode lies in the tree rooted at oNRoot and neither
+  it nor any of its ancestors has been unlinked or moved since
+  generation ulGeneration (see Node_getGeneration), so that its path
+  is still what it was then, and FALSE otherwise. Takes time
+  proportional to oNNode's depth.
+*/
+boolean Node_isLinkedSince(Node_T oNNode, Node_T oNRoot,
+                           unsigned long ulGeneration) {
+   Node_T node;
+
+   assert(oNNode != NULL);
+
+   for(node = oNNode; node->ulUnlinked <= ulGeneration;
+       node = node->oNParent) {
+      if(node->oNParent == NULL)
+         return (boolean) (node == oNRoot);
+   }
+   return FALSE;
+}
+
+/*
+  Records pvEntry as the lookup cache's entry for oNNode's path, or
+  that it has none if pvEntry is NULL. A node's entry is removed from
+  the lookup cache when the node is freed.
+*/
+void Node_setCacheEntry(Node_T oNNode, void *pvEntry) {
+   assert(oNNode != NULL);
+
+   oNNode->pvCacheEntry = pvEntry;
+}
+
+/*
+  Returns the lookup cache's entry for oNNode's path, or NULL if it
+  has none (see Node_setCacheEntry).
+*/
+void *Node_getCacheEntry(Node_T oNNode) {
+   assert(oNNode != NULL);
+
+   return oNNode->pvCacheEntry;
+}
+
+/*
+  Gives directory oNDir a quota of at most ulMaxNodes nodes and
+  ulMaxBytes bytes of contents in its subtree, itself included, with
+  0 meaning no limit; both 0 removes the quota. A quota below what the
+  subtree already holds is kept, and only stops it from growing.
+  Copies of a directory do not take its quota.
+*/
+void Node_setQuota(Node_T oNDir, size_t ulMaxNodes, size_t ulMaxBytes) {
+   assert(oNDir != NULL);
+   assert(!oNDir->isFile);
+
+   if(oNDir->ulMaxNodes != 0 || oNDir->ulMaxBytes != 0)
+      ulQuotas--;
+   oNDir->ulMaxNodes = ulMaxNodes;
+   oNDir->ulMaxBytes = ulMaxBytes;
+   if(ulMaxNodes != 0 || ulMaxBytes != 0)
+      ulQuotas++;
+}
+
+/*
+  Sets *pulMaxNodes and *pulMaxBytes to the quota of oNNode, each 0 if
+  there is no limit.
+*/
+void Node_getQuota(Node_T oNNode, size_t *pulMaxNodes,
+                   size_t *pulMaxBytes) {
+   assert(oNNode != NULL);
+   assert(pulMaxNodes != NULL);
+   assert(pulMaxBytes != NULL);
+
+   *pulMaxNodes = oNNode->ulMaxNodes;
+   *pulMaxBytes = oNNode->ulMaxBytes;
+}
+
+/*
+  Returns SUCCESS if ulNodes nodes and ulBytes bytes of contents may
+  be added to the subtree rooted at oNNode, or QUOTA_EXCEEDED if that
+  would take oNNode or one of its ancestors past its quota. Checks
+  the totals kept along the chain of ancestors, in time proportional
+  to oNNode's depth, or in constant time if there are no quotas.
+*/
+int Node_checkQuota(Node_T oNNode, size_t ulNodes, size_t ulBytes) {
+   assert(oNNode != NULL);
+
+   if(ulQuotas == 0)
+      return SUCCESS;
+   for(; oNNode != NULL; oNNode = oNNode->oNParent)
+      if(Node_exceedsQuota(oNNode, ulNodes, ulBytes))
+         return QUOTA_EXCEEDED;
+   return SUCCESS;
+}
+
+/*
+  Returns SUCCESS if oNNode, with its subtree, may be moved under
+  oNNewParent, or QUOTA_EXCEEDED if that would take an ancestor of
+  oNNewParent past its quota. Ancestors of both the old and the new
+  parent hold the subtree already, so only those below the lowest
+  such one are checked, in time proportional to the parents' depths.
+*/
+int Node_checkMove(Node_T oNNode, Node_T oNNewParent) {
+   Node_T oldSide;
+   Node_T newSide;
+   size_t oldDepth = 0;
+   size_t newDepth = 0;
+   size_t nodes;
+
+   assert(oNNode != NULL);
+   assert(oNNewParent != NULL);
+
+   if(ulQuotas == 0)
+      return SUCCESS;
+
+   for(oldSide = oNNode->oNParent; oldSide != NULL;
+       oldSide = oldSide->oNParent)
+      oldDepth++;
+   for(newSide = oNNewParent; newSide != NULL;
+       newSide = newSide->oNParent)
+      newDepth++;
+
+   /* climb to equal depths, then together to the common ancestor,
+      checking each node passed on the new side */
+   nodes = oNNode->ulFiles + oNNode->ulDirs;
+   oldSide = oNNode->oNParent;
+   newSide = oNNewParent;
+   for(; oldDepth > newDepth; oldDepth--)
+      oldSide = oldSide->oNParent;
+   for(; newDepth > oldDepth; newDepth--) {
+      if(Node_exceedsQuota(newSide, nodes, oNNode->ulBytes))
+         return QUOTA_EXCEEDED;
+      newSide = newSide->oNParent;
+   }
+   while(newSide != oldSide) {
+      if(Node_exceedsQuota(newSide, nodes, oNNode->ulBytes))
+         return QUOTA_EXCEEDED;
+      newSide = newSide->oNParent;
+      oldSide = oldSide->oNParent;
+   }
+   return SUCCESS;
+}
+
+/*
+  Continues the FNV-1a hash ulHash over the ulLength bytes at pvData
+  and returns the result.
+*/
+static unsigned long Node_hashBytes(unsigned long ulHash,
+                                    const void *pvData,
+                                    size_t ulLength) {
+   const unsigned char *data = pvData;
+   size_t i;
+
+   for(i = 0; i < ulLength; i++) {
+      ulHash ^= data[i];
+      ulHash *= ulHashPrime;
+   }
+   return ulHash;
+}
+
+/*
+  Continues the FNV-1a hash ulHash over the bytes of ulValue, least
+  significant first, and returns the result.
+*/
+static unsigned long Node_hashValue(unsigned long ulHash,
+                                    unsigned long ulValue) {
+   size_t i;
+
+   for(i = 0; i < sizeof(unsigned long); i++) {
+      ulHash ^= (ulValue >> (i * 8)) & 0xFF;
+      ulHash *= ulHashPrime;
+   }
+   return ulHash;
+}
+
+/*
+  Sets *pulHash to the hash of the contents of file node oNFile, read
+  in place, or in pieces from the spill store if they are not mapped,
+  so that hashing leaves the content cache alone. Returns SUCCESS, or
+  IO_ERROR if spilled contents could not be read.
+*/
+static int Node_hashContents(Node_T oNFile, unsigned long *pulHash) {
+   enum {PIECE_SIZE = 4096};
+   unsigned char piece[PIECE_SIZE];
+   unsigned long hash = ulHashBasis;
+   size_t offset;
+   size_t length;
+   int status;
+
+   assert(oNFile != NULL);
+   assert(pulHash != NULL);
+
+   if(oNFile->storage != STORED_IN_SPILL || oNFile->pvContents != NULL)
+      hash = Node_hashBytes(hash, oNFile->pvContents, oNFile->ulLength);
+   else {
+      for(offset = 0; offset < oNFile->ulLength; offset += length) {
+         length = oNFile->ulLength - offset;
+         if(length > PIECE_SIZE)
+            length = PIECE_SIZE;
+         status = Spill_read(oNFile->ulSpillOffset + offset, piece,
+                             length);
+         if(status != SUCCESS)
+            return status;
+         hash = Node_hashBytes(hash, piece, length);
+      }
+   }
+
+   *pulHash = hash;
+   return SUCCESS;
+}
+
+/*
+  Brings the out-of-date hash of oNNode up to date from its contents
+  or, for a directory, from its children's names, types, and hashes,
+  which must all be up to date. Returns SUCCESS, or IO_ERROR if
+  spilled contents could not be read.
+*/
+static int Node_rehash(Node_T oNNode) {
+   unsigned long hash = ulHashBasis;
+   Node_T child;
+   size_t i;
+   int status;
+
+   assert(oNNode != NULL);
+
+   if(oNNode->isFile) {
+      status = Node_hashContents(oNNode, &hash);
+      if(status != SUCCESS)
+         return status;
+   }
+   else {
+      for(i = 0; i < DynArray_getLength(oNNode->oDChildren); i++) {
+         child = DynArray_get(oNNode->oDChildren, i);
+         assert(!child->isHashStale);
+         /* the NUL ends the name, so names and types cannot run
+            into each other */
+         hash = Node_hashBytes(hash, child->pcName,
+                               strlen(child->pcName) + 1);
+         hash = Node_hashValue(hash, (unsigned long) child->isFile);
+         hash = Node_hashValue(hash, child->ulHash);
+      }
+   }
+
+   oNNode->ulHash = hash;
+   oNNode->isHashStale = FALSE;
+   return SUCCESS;
+}
+
+/*
+  Brings the out-of-date hashes in the subtree rooted at oNNode up to
+  date, visiting only the nodes whose hashes are out of date, children
+  before their parents, by following parent links back up instead of
+  keeping a stack. Below a view's copy, each node of a tree that the
+  view shares is brought up to date by a call of its own, within its
+  tree. Returns SUCCESS, or IO_ERROR if spilled contents could not be
+  read.
+*/
+static int Node_updateHash(Node_T oNNode) {
+   Node_T node = oNNode;
+   Node_T child;
+   size_t length;
+   size_t i = 0;
+   int status;
+
+   assert(oNNode != NULL);
+
+   if(!oNNode->isHashStale)
+      return SUCCESS;
+
+   for(;;) {
+      /* go down into node's next out-of-date child, if any */
+      length = Node_getNumChildren(node);
+      while(i < length && !((Node_T) DynArray_get(node->oDChildren,
+                                                  i))->isHashStale)
+         i++;
+      if(i < length) {
+         child = DynArray_get(node->oDChildren, i);
+         /* a view's copy shares nodes of a tree, whose parent links
+            lead back into the tree, so each is brought up to date on
+            its own */
+         if(node->psView != NULL && child->psView == NULL) {
+            status = Node_updateHash(child);
+            if(status != SUCCESS)
+               return status;
+            continue;
+         }
+         node = child;
+         i = 0;
+         continue;
+      }
+
+      /* its children are all up to date, so it can be rehashed, and
+         its parent's children checked on from the one after it */
+      status = Node_rehash(node);
+      if(status != SUCCESS || node == oNNode)
+         return status;
+      i = Node_childIndex(node) + 1;
+      node = node->oNParent;
+   }
+}
+
+/*
+  Sets *pulHash to the hash of the contents of oNNode: for a file, of
+  its bytes, and for a directory, of its children's names, types, and
+  hashes, in name order, so that two subtrees with equal hashes are
+  equal below their roots (barring a 64-bit collision). Hashes are
+  kept with the nodes and only marked out of date, along the chain of
+  ancestors, by a change; this call rehashes just the files and
+  directories changed since the last one. Contents that the client
+  changes in place, behind the FT's back, are not noticed. Returns
+  SUCCESS, or IO_ERROR if spilled contents could not be read.
+*/
+int Node_getHash(Node_T oNNode, unsigned long *pulHash) {
+   int status;
+
+   assert(oNNode != NULL);
+   assert(pulHash != NULL);
+
+   status = Node_updateHash(oNNode);
+   if(status == SUCCESS)
+      *pulHash = oNNode->ulHash;
+   return status;
+}
+
+/*
+  Returns a string representation for oNNode, its absolute path built
+  from the names of oNNode and its ancestors, or NULL if
+  there is an allocation error.
+
+  Allocates memory for the returned string, which is then owned by
+  the caller!
+*/
+char *Node_toString(Node_T oNNode) {
+   Node_T ancestor;
+   size_t length = 0;
+   size_t nameLength;
+   char *copyPath;
+   char *start;
+
+   assert(oNNode != NULL);
+
+   /* each name is followed by a '/' or, for oNNode, by the '\0' */
+   for(ancestor = oNNode; ancestor != NULL;
+       ancestor = ancestor->oNParent)
+      length += strlen(ancestor->pcName) + 1;
+   copyPath = malloc(length);
+   if(copyPath == NULL)
+      return NULL;
+
+   /* fill in the names from oNNode's back up to the root's */
+   start = copyPath + length - 1;
+   *start = '\0';
+   for(ancestor = oNNode; ancestor != NULL;
+       ancestor = ancestor->oNParent) {
+      nameLength = strlen(ancestor->pcName);
+      start -= nameLength;
+      memcpy(start, ancestor->pcName, nameLength);
+      if(ancestor->oNParent != NULL)
+         *--start = '/';
+   }
+   return copyPath;
+}
+
+/* 
+  Returns TRUE if oNNode is a file node and FALSE if it is a 
+  directory node.
+*/
+boolean Node_isFile(Node_T oNNode) {
+   assert(oNNode != NULL);
+
+   return oNNode->isFile;
+}
+
+/*
+  If oNNode is a file node, returns its contents. Otherwise, returns
+  NULL. (Note: a file's contents may also be NULL.) Spilled contents
+  are faulted back onto the heap or mapped into memory on demand, and
+  NULL is returned if they cannot be.
+*/
+void *Node_getContents(Node_T oNNode) {
+   assert(oNNode != NULL);
+
+   if(!Node_isFile(oNNode)) {
+      return NULL;
+   }
+
+   (void) Node_cacheAccess(oNNode);
+   if(oNNode->storage == STORED_IN_SPILL && oNNode->pvContents == NULL)
+      (void) Spill_map(oNNode->ulSpillOffset, oNNode->ulSpillCapacity,
+                       &oNNode->pvContents);
+   return oNNode->pvContents;
+}
+
+/*
+  Returns the length in bytes of oNNode's contents (always 0 if oNNode
+  is a directory).
+*/
+size_t Node_getLength(Node_T oNNode) {
+   assert(oNNode != NULL);
+
+   return oNNode->ulLength;
+}
+
+/*
+  Replaces the contents of file node oNNode with pvNewContents of size
+  ulNewLength bytes, which remain owned by the caller. Returns the old
+  contents. If the old contents were built by Node_writeRange, the
+  node gives up ownership of them and they are then owned by the
+  caller! (Spilled, mapped, or shared contents are first copied into
+  a new heap buffer; if that fails, the contents are left unchanged
+  and NULL is returned.)
+*/
+void *Node_replaceContents(Node_T oNNode, void *pvNewContents,
+                           size_t ulNewLength) {
+   void *oldContents;
+
+   assert(oNNode != NULL);
+   assert(Node_isFile(oNNode));
+
+   Node_preserve(oNNode);
+   Node_staleContents(oNNode);
+   if(oNNode->storage == STORED_IN_SPILL) {
+      oldContents = malloc(oNNode->ulLength);
+      if(oldContents == NULL)
+         return NULL;
+      if(Spill_read(oNNode->ulSpillOffset, oldContents,
+                    oNNode->ulLength) != SUCCESS) {
+         free(oldContents);
+         return NULL;
+      }
+   }
+   else if(oNNode->storage == STORED_IN_MAP ||
+           oNNode->storage == STORED_SHARED) {
+      oldContents = malloc(oNNode->ulLength);
+      if(oldContents == NULL)
+         return NULL;
+      memcpy(oldContents, oNNode->pvContents, oNNode->ulLength);
+   }
+   else {
+      oldContents = oNNode->pvContents;
+      /* the caller now owns any heap buffer, so do not free it */
+      if(oNNode->storage == STORED_ON_HEAP) {
+         Node_cacheRemove(oNNode);
+         oNNode->storage = STORED_BY_CLIENT;
+      }
+   }
+   Node_releaseContents(oNNode);
+
+   oNNode->pvContents = pvNewContents;
+   Node_setLength(oNNode, ulNewLength);
+   return oldContents;
+}
+
+/*
+  Copies up to ulLength bytes of file node oNNode's contents, starting
+  at byte ulOffset, into pvBuf, and sets *pulRead to the number of
+  bytes copied, which is less than ulLength if the contents end first
+  (and 0 if ulOffset is at or past the end). Returns SUCCESS, or
+  MEMORY_ERROR or IO_ERROR if spilled contents could not be read back.
+*/
+int Node_readRange(Node_T oNNode, size_t ulOffset, void *pvBuf,
+                   size_t ulLength, size_t *pulRead) {
+   int status;
+
+   assert(oNNode != NULL);
+   assert(Node_isFile(oNNode));
+   assert(pvBuf != NULL || ulLength == 0);
+   assert(pulRead != NULL);
+
+   status = Node_cacheAccess(oNNode);
+   if(status != SUCCESS)
+      return status;
+
+   if(ulOffset >= oNNode->ulLength)
+      ulLength = 0;
+   else if(ulLength > oNNode->ulLength - ulOffset)
+      ulLength = oNNode->ulLength - ulOffset;
+
+   /* unmapped spilled contents are read straight from the store */
+   if(ulLength != 0 && oNNode->storage == STORED_IN_SPILL &&
+      oNNode->pvContents == NULL) {
+      status = Spill_read(oNNode->ulSpillOffset + ulOffset, pvBuf,
+                          ulLength);
+      if(status != SUCCESS)
+         return status;
+   }
+   else if(ulLength != 0) {
+      memcpy(pvBuf, (char *)oNNode->pvContents + ulOffset, ulLength);
    }
-   newNode->isFile = FALSE;
-   newNode->contents = NULL;
 
-   *poNResult = newNode;
+   *pulRead = ulLength;
    return SUCCESS;
 }
 
 /*
-  Creates a new file node in the File Tree, with path oPPath, parent 
-  oNParent, and contents contents. Returns an int SUCCESS status and 
-  sets *poNResult to be the new node if successful. Otherwise, sets 
-  *poNResult to NULL and returns status:
-  * MEMORY_ERROR if memory could not be allocated to complete request
-  * CONFLICTING_PATH if oNParent's path is not an ancestor of oPPath
-  * NO_SUCH_PATH if oPPath is of depth 0
-                 or oNParent's path is not oPPath's direct parent
-                 or oNParent is NULL but oPPath is not of depth 1
-                 or oNParent is a file
-  * ALREADY_IN_TREE if oNParent already has a child with this path
+  Overwrites ulLength bytes of file node oNNode's contents, starting
+  at byte ulOffset, with the bytes at pvData, extending the contents
+  if the range runs past their end. A gap between the old end and
+  ulOffset is filled with zero bytes. Returns SUCCESS, or MEMORY_ERROR
+  or IO_ERROR (leaving the contents unchanged) if space for the
+  contents could not be allocated.
 */
-int Node_newFile(Path_T oPPath, Node_T oNParent, const char *contents,
-                 Node_T *poNResult) {
-   struct node *newNode;
+int Node_writeRange(Node_T oNNode, size_t ulOffset,
+                    const void *pvData, size_t ulLength) {
+   size_t newLength;
+   size_t newCapacity;
+   char *buffer;
    int status;
-   Path_T newPath;
 
-   assert(oPPath != NULL);
-
-   /* make sure parent isn't a file if it isn't NULL */
-   if(oNParent != NULL && Node_isFile(oNParent)) {
-      return NO_SUCH_PATH;
-   }
+   assert(oNNode != NULL);
+   assert(Node_isFile(oNNode));
+   assert(pvData != NULL || ulLength == 0);
 
-   /* allocate space for a new node */
-   newNode = malloc(sizeof(struct node));
-   if(newNode == NULL) {
-      *poNResult = NULL;
+   newLength = ulOffset + ulLength;
+   if(newLength < ulOffset)
       return MEMORY_ERROR;
-   }
-
-   /* set the new node's path */
-   status = Path_dup(oPPath, &newPath);
-   if(status != SUCCESS) {
-      free(newNode);
-      *poNResult = NULL;
-      return status;
-   }
-   newNode->oPPath = newPath;
+   Node_preserve(oNNode);
+   Node_staleContents(oNNode);
+   if(newLength < oNNode->ulLength)
+      newLength = oNNode->ulLength;
 
-   /* link node into tree */
-   status = Node_linkToParent(newNode, oNParent);
-   if(status != SUCCESS) {
-      Path_free(newNode->oPPath);
-      free(newNode);
-      *poNResult = NULL;
+   status = Node_cacheAccess(oNNode);
+   if(status != SUCCESS)
       return status;
-   }
 
-   /* set up the new node as a file, duplicating contents */
-   newNode->contents = malloc(strlen(contents) + 1);
-   if(newNode->contents == NULL) {
-      Path_free(newNode->oPPath);
-      free(newNode);
-      *poNResult = NULL;
-      return MEMORY_ERROR;
+   if(oNNode->storage == STORED_IN_SPILL)
+      return Node_writeSpilled(oNNode, ulOffset, pvData, ulLength,
+                               newLength);
+
+   /* take ownership of (or grow) the buffer only when needed, growing
+      geometrically so that repeated appends are amortized O(change) */
+   if(oNNode->storage != STORED_ON_HEAP ||
+      newLength > oNNode->ulCapacity) {
+      newCapacity = Node_growCapacity(oNNode->ulCapacity, newLength);
+
+      if(oNNode->storage == STORED_ON_HEAP) {
+         buffer = realloc(oNNode->pvContents, newCapacity);
+         if(buffer == NULL)
+            return MEMORY_ERROR;
+         Node_cacheRemove(oNNode);
+      }
+      else {
+         buffer = malloc(newCapacity);
+         if(buffer == NULL)
+            return MEMORY_ERROR;
+         if(oNNode->ulLength != 0)
+            memcpy(buffer, oNNode->pvContents, oNNode->ulLength);
+         /* copy on write: leave the shared buffer to the copies */
+         if(oNNode->storage == STORED_SHARED)
+            (void) Node_dropShare(oNNode);
+      }
+      oNNode->pvContents = buffer;
+      oNNode->storage = STORED_ON_HEAP;
+      oNNode->ulCapacity = newCapacity;
+      Node_cacheTouch(oNNode);
    }
-   strcpy((char *)newNode->contents, contents);
-   newNode->oDChildren = NULL;
-   newNode->isFile = TRUE;
 
-   *poNResult = newNode;
+   buffer = oNNode->pvContents;
+   if(ulOffset > oNNode->ulLength)
+      memset(buffer + oNNode->ulLength, 0, ulOffset - oNNode->ulLength);
+   if(ulLength != 0)
+      memcpy(buffer + ulOffset, pvData, ulLength);
+   Node_setLength(oNNode, newLength);
+
+   /* contents that have grown past the threshold leave the heap; if
+      that fails they simply stay where they are */
+   if(Spill_isOpen() && newLength > Spill_getThreshold())
+      (void) Node_spillContents(oNNode);
+   Node_cacheEvict(oNNode);
    return SUCCESS;
 }
 
 /*
-  Destroys and frees all memory allocated for the subtree rooted at
-  oNNode, i.e., deletes this node and all its descendents. Returns the
-  number of nodes deleted.
+  Replaces the contents of file node oNNode with the ulLength bytes at
+  pvContents, a buffer allocated with malloc of which the node takes
+  ownership (and which may be NULL if ulLength is 0). Old contents
+  owned by the node are released; old caller-owned contents are
+  simply dropped. If the spill store is open, contents longer than its
+  threshold are moved there.
 */
-size_t Node_free(Node_T oNNode) {
-   size_t index;
-   size_t count = 0;
-   
+void Node_adoptContents(Node_T oNNode, void *pvContents,
+                        size_t ulLength) {
    assert(oNNode != NULL);
-   
-   /* remove from parent's list */
-   if(oNNode->oNParent != NULL) {
-      if(DynArray_bsearch(
-            oNNode->oNParent->oDChildren,
-            oNNode, &index,
-            (int (*)(const void *, const void *)) Node_compare)
-        )
-         (void) DynArray_removeAt(oNNode->oNParent->oDChildren,
-                                  index);
-   }
-
-   /* recursively remove children if oNNode is a directory */
-   if (!Node_isFile(oNNode)) {
-      /* remove children */
-      while(DynArray_getLength(oNNode->oDChildren) != 0) {
-         count += Node_free(DynArray_get(oNNode->oDChildren, 0));
-      }
-      DynArray_free(oNNode->oDChildren);
-   }
-   else {
-      /* free contents if oNNode is a file */
-      free((char *)oNNode->contents);
-   }
-
-   /* remove path */
-   Path_free(oNNode->oPPath);
+   assert(Node_isFile(oNNode));
+   assert(pvContents != NULL || ulLength == 0);
+
+   Node_preserve(oNNode);
+   Node_staleContents(oNNode);
+   Node_releaseContents(oNNode);
+   if(pvContents == NULL)
+      return;
+
+   oNNode->pvContents = pvContents;
+   Node_setLength(oNNode, ulLength);
+   oNNode->storage = STORED_ON_HEAP;
+   oNNode->ulCapacity = ulLength;
+   Node_cacheTouch(oNNode);
+
+   if(Spill_isOpen() && ulLength > Spill_getThreshold())
+      (void) Node_spillContents(oNNode);
+   Node_cacheEvict(oNNode);
+}
 
-   /* finally, free the struct node */
-   free(oNNode);
-   count++;
-   return count;
+/*
+  Replaces the contents of file node oNNode with the ulLength bytes at
+  pvContents, which lie in a mapped snapshot that must stay mapped
+  until the node is freed or given other contents. The node reads the
+  contents in place, copying them to the heap on the first ranged
+  write, and never frees them. Old contents owned by the node are
+  released.
+*/
+void Node_mapContents(Node_T oNNode, void *pvContents,
+                      size_t ulLength) {
+   assert(oNNode != NULL);
+   assert(Node_isFile(oNNode));
+   assert(pvContents != NULL);
+
+   Node_preserve(oNNode);
+   Node_staleContents(oNNode);
+   Node_releaseContents(oNNode);
+   oNNode->pvContents = pvContents;
+   Node_setLength(oNNode, ulLength);
+   oNNode->storage = STORED_IN_MAP;
 }
 
-/* Returns the path object representing oNNode's absolute path. */
-Path_T Node_getPath(Node_T oNNode) {
+/*
+  If file node oNNode's contents are in a heap buffer owned by the
+  node, moves them into the spill store (reusing the node's old
+  region if they still fit in it) and frees the buffer. Returns
+  SUCCESS (also if there was nothing to move), or MEMORY_ERROR or
+  IO_ERROR (leaving the contents on the heap) if they could not be
+  moved. The spill store must be open.
+*/
+int Node_spillContents(Node_T oNNode) {
+   size_t offset;
+   int status;
+
    assert(oNNode != NULL);
+   assert(Spill_isOpen());
+
+   if(!Node_isFile(oNNode) || oNNode->storage != STORED_ON_HEAP)
+      return SUCCESS;
 
-   return oNNode->oPPath;
+   if(oNNode->ulSpillCapacity < oNNode->ulLength) {
+      status = Spill_alloc(oNNode->ulCapacity, &offset);
+      if(status != SUCCESS)
+         return status;
+      oNNode->ulSpillOffset = offset;
+      oNNode->ulSpillCapacity = oNNode->ulCapacity;
+   }
+   status = Spill_write(oNNode->ulSpillOffset, oNNode->pvContents,
+                        oNNode->ulLength);
+   if(status != SUCCESS)
+      return status;
+
+   Node_cacheRemove(oNNode);
+   free(oNNode->pvContents);
+   oNNode->pvContents = NULL;
+   oNNode->storage = STORED_IN_SPILL;
+   oNNode->ulCapacity = 0;
+   return SUCCESS;
 }
 
 /*
-  Returns TRUE if oNParent has a child with path oPPath. Returns
-  FALSE if it does not, or if oNParent is a file.
+  Sets the content cache's budget to ulNewBudget bytes of heap-owned
+  contents, or removes the budget if ulNewBudget is 0, and resets the
+  hit, miss, and eviction counters. If the cache is over the new
+  budget, evicts contents to the spill store, which must be open
+  unless there is no budget.
+*/
+void Node_setBudget(size_t ulNewBudget) {
+   assert(ulNewBudget == 0 || Spill_isOpen());
+
+   ulBudget = ulNewBudget;
+   ulHits = 0;
+   ulMisses = 0;
+   ulEvictions = 0;
+   Node_cacheEvict(NULL);
+}
 
-  If oNParent has such a child, stores in *pulChildID the child's
-  identifier (as used in Node_getChild). If oNParent does not have
-  such a child, stores in *pulChildID the identifier that such a
-  child _would_ have if inserted.
+/*
+  Sets *pulResident to the number of bytes of heap buffers owned by
+  nodes, and *pulHits, *pulMisses, and *pulEvictions to the content
+  cache's counters since the budget was last set.
 */
-boolean Node_hasChild(Node_T oNParent, Path_T oPPath,
-                         size_t *pulChildID) {
-   assert(oNParent != NULL);
-   assert(oPPath != NULL);
-   assert(pulChildID != NULL);
+void Node_getCacheStats(size_t *pulResident, size_t *pulHits,
+                        size_t *pulMisses, size_t *pulEvictions) {
+   assert(pulResident != NULL);
+   assert(pulHits != NULL);
+   assert(pulMisses != NULL);
+   assert(pulEvictions != NULL);
+
+   *pulResident = ulResident;
+   *pulHits = ulHits;
+   *pulMisses = ulMisses;
+   *pulEvictions = ulEvictions;
+}
 
-   if(Node_isFile(oNParent)) {
-      return FALSE;
+/*
+  Starts keeping the name index, empty, if it is not already kept.
+  Returns SUCCESS, or MEMORY_ERROR if memory could not be allocated.
+*/
+int Node_startIndex(void) {
+   enum {MIN_BUCKETS = 64};
+
+   if(poNBuckets != NULL)
+      return SUCCESS;
+
+   poNBuckets = calloc(MIN_BUCKETS, sizeof(Node_T));
+   if(poNBuckets == NULL)
+      return MEMORY_ERROR;
+   ulBuckets = MIN_BUCKETS;
+   ulGroups = 0;
+   return SUCCESS;
+}
+
+/* Returns TRUE if the name index is kept and FALSE otherwise. */
+boolean Node_hasIndex(void) {
+   return (boolean) (poNBuckets != NULL);
+}
+
+/*
+  Removes every node from the name index and stops keeping it, and
+  the trigram index and path filter too.
+*/
+void Node_stopIndex(void) {
+   Node_T head;
+   size_t i;
+
+   /* each bucket's first head is found at once, and hands its group
+      on to the next node with its name */
+   for(i = 0; i < ulBuckets; i++) {
+      while(poNBuckets[i] != NULL) {
+         head = poNBuckets[i];
+         Node_indexRemove(head);
+         Node_textLeave(head);
+      }
    }
 
-   /* *pulChildID is the index into oNParent->oDChildren */
-   return DynArray_bsearch(oNParent->oDChildren,
-            (char*) Path_getPathname(oPPath), pulChildID,
-            (int (*)(const void*,const void*)) Node_compareString);
+   free(poNBuckets);
+   poNBuckets = NULL;
+   ulBuckets = 0;
+   Trigram_stop();
+   Bloom_stop();
 }
 
-/* 
-  Returns the number of children that oNParent has 
-  (always 0 if oNParent is a file).
+/*
+  Adds the tree rooted at oNRoot, which must have no parent, to the
+  name index, if it is kept. From then on, nodes linked in below a
+  node in the index are added to it too, and nodes unlinked with
+  Node_detach or freed are removed from it.
 */
-size_t Node_getNumChildren(Node_T oNParent) {
-   assert(oNParent != NULL);
+void Node_indexRoot(Node_T oNRoot) {
+   assert(oNRoot != NULL);
+   assert(oNRoot->oNParent == NULL);
 
-   if(Node_isFile(oNParent)) {
-      return 0;
+   if(poNBuckets != NULL) {
+      Node_indexTree(oNRoot, Node_filterHash(oNRoot), TRUE);
+      Node_filterGrow();
    }
-   return DynArray_getLength(oNParent->oDChildren);
 }
 
 /*
-  Returns an int SUCCESS status and sets *poNResult to be the child
-  node of oNParent with identifier ulChildID, if one exists.
-  Otherwise, sets *poNResult to NULL and returns status:
-  * NO_SUCH_PATH if ulChildID is not a valid child for oNParent
+  Passes each node in the name index, which must be kept, named
+  pcName to pfVisit, along with pvExtra, in no particular order. Finds
+  the nodes' group with one hash lookup, so the time taken grows with
+  the number of nodes found rather than the number indexed. pfVisit
+  must not link or unlink nodes. Returns SUCCESS if every node was
+  visited, and otherwise stops and returns the first other status
+  that pfVisit returned.
 */
-int Node_getChild(Node_T oNParent, size_t ulChildID,
-                  Node_T *poNResult) {
-   assert(oNParent != NULL);
-   assert(poNResult != NULL);
+int Node_findByName(const char *pcName,
+                    int (*pfVisit)(Node_T oNNode, void *pvExtra),
+                    void *pvExtra) {
+   Node_T node;
+   int status = SUCCESS;
+
+   assert(pcName != NULL);
+   assert(pfVisit != NULL);
+   assert(poNBuckets != NULL);
+
+   for(node = *Node_indexBucket(pcName); node != NULL;
+       node = node->oNNextGroup)
+      if(!strcmp(node->pcName, pcName))
+         break;
+   for(; status == SUCCESS && node != NULL; node = node->oNNextNamed)
+      status = pfVisit(node, pvExtra);
+   return status;
+}
 
-   /* ensure oNParent is not a file */
-   if (Node_isFile(oNParent)) {
-      *poNResult = NULL;
-      return NO_SUCH_PATH;
-   }
+/*
+  Starts keeping the trigram index over the contents of the files in
+  the name index, which must be kept, if it is not already kept. From
+  then on, files that join or leave the name index join or leave it
+  too. Returns SUCCESS, or MEMORY_ERROR if memory could not be
+  allocated.
+*/
+int Node_startTextIndex(void) {
+   Node_T head;
+   Node_T node;
+   size_t i;
 
-   /* ulChildID is the index into oNParent->oDChildren */
-   if(ulChildID >= Node_getNumChildren(oNParent)) {
-      *poNResult = NULL;
-      return NO_SUCH_PATH;
-   }
-   else {
-      *poNResult = DynArray_get(oNParent->oDChildren, ulChildID);
+   assert(poNBuckets != NULL);
+
+   if(Trigram_isStarted())
       return SUCCESS;
+   if(Trigram_start() != SUCCESS)
+      return MEMORY_ERROR;
+
+   for(i = 0; i < ulBuckets; i++)
+      for(head = poNBuckets[i]; head != NULL; head = head->oNNextGroup)
+         for(node = head; node != NULL; node = node->oNNextNamed)
+            Node_textJoin(node);
+
+   if(!Trigram_isComplete()) {
+      Node_stopTextIndex();
+      return MEMORY_ERROR;
    }
+   return SUCCESS;
+}
+
+/* Stops keeping the trigram index, if it is kept, and frees it. */
+void Node_stopTextIndex(void) {
+   Node_T head;
+   Node_T node;
+   size_t i;
+
+   if(!Trigram_isStarted())
+      return;
+
+   for(i = 0; i < ulBuckets; i++)
+      for(head = poNBuckets[i]; head != NULL; head = head->oNNextGroup)
+         for(node = head; node != NULL; node = node->oNNextNamed)
+            node->ulTextID = 0;
+   Trigram_stop();
 }
 
 /*
-  Returns a the parent node of oNNode.
-  Returns NULL if oNNode is the root and thus has no parent.
+  Returns TRUE if the trigram index is kept and holds every file in
+  the name index, and FALSE otherwise: a file that could not be added
+  for want of memory leaves the index in use only for upkeep, until it
+  is stopped.
 */
-Node_T Node_getParent(Node_T oNNode) {
-   assert(oNNode != NULL);
-
-   return oNNode->oNParent;
+boolean Node_hasTextIndex(void) {
+   return (boolean) (Trigram_isStarted() && Trigram_isComplete());
 }
 
 /*
-  Compares oNFirst and oNSecond lexicographically based on their paths.
-  Returns <0, 0, or >0 if onFirst is "less than", "equal to", or
-  "greater than" oNSecond, respectively.
+  Sets *ppvBytes and *pulLength to the contents of file pvFile and
+  their length, for Trigram_refresh. Returns SUCCESS, or IO_ERROR if
+  spilled contents could not be brought back.
 */
-int Node_compare(Node_T oNFirst, Node_T oNSecond) {
-   assert(oNFirst != NULL);
-   assert(oNSecond != NULL);
+static int Node_readText(void *pvFile, const void **ppvBytes,
+                         size_t *pulLength) {
+   Node_T oNFile = pvFile;
+
+   assert(oNFile != NULL);
+   assert(ppvBytes != NULL);
+   assert(pulLength != NULL);
+
+   *ppvBytes = Node_getContents(oNFile);
+   *pulLength = oNFile->ulLength;
+   if(*ppvBytes == NULL && *pulLength != 0)
+      return IO_ERROR;
+   return SUCCESS;
+}
+
+/* A visit function and its extra argument, for Node_visitText */
+struct nodeTextSearch {
+   int (*pfVisit)(Node_T oNNode, void *pvExtra);
+   void *pvExtra;
+};
+
+/* Passes file pvFile on to the search at pvSearch. */
+static int Node_visitText(void *pvFile, void *pvSearch) {
+   struct nodeTextSearch *search = pvSearch;
+
+   assert(pvFile != NULL);
+   assert(search != NULL);
 
-   return Path_comparePath(oNFirst->oPPath, oNSecond->oPPath);
+   return search->pfVisit(pvFile, search->pvExtra);
 }
 
 /*
-  Returns a string representation for oNNode, or NULL if
-  there is an allocation error.
-
-  Allocates memory for the returned string, which is then owned by
-  the caller!
+  Passes each file in the trigram index, which must hold every file in
+  the name index, that may contain the ulLength bytes at pvPattern to
+  pfVisit, along with pvExtra, in no particular order. Every file that
+  contains them is passed, but so may be some that do not, so pfVisit
+  must check. Files changed since the last search are indexed afresh
+  first. pfVisit must not link, unlink, or change nodes. Returns
+  SUCCESS if every candidate was visited, and otherwise stops and
+  returns MEMORY_ERROR if memory could not be allocated, IO_ERROR if
+  spilled contents could not be brought back, or the first other
+  status that pfVisit returned.
 */
-char *Node_toString(Node_T oNNode) {
-   char *copyPath;
+int Node_searchText(const void *pvPattern, size_t ulLength,
+                    int (*pfVisit)(Node_T oNNode, void *pvExtra),
+                    void *pvExtra) {
+   struct nodeTextSearch search;
+   int status;
 
-   assert(oNNode != NULL);
+   assert(pvPattern != NULL || ulLength == 0);
+   assert(pfVisit != NULL);
+   assert(Node_hasTextIndex());
 
-   copyPath = malloc(Path_getStrLength(Node_getPath(oNNode))+1);
-   if(copyPath == NULL)
-      return NULL;
-   else
-      return strcpy(copyPath, Path_getPathname(Node_getPath(oNNode)));
+   status = Trigram_refresh(Node_readText);
+   if(status != SUCCESS)
+      return status;
+
+   search.pfVisit = pfVisit;
+   search.pvExtra = pvExtra;
+   return Trigram_search(pvPattern, ulLength, Node_visitText,
+                         &search);
 }
 
-/* 
-  Returns TRUE if oNNode is a file node and FALSE if it is a 
-  directory node.
+/*
+  Starts keeping the path filter over the absolute paths of the nodes
+  in the name index, which must be kept, sized for ulPaths paths
+  (at least 1) and grown as more are added, restarting it if it is
+  already kept. From then on, nodes that join or leave the name index
+  add or remove their paths, and a move trades each path in the moved
+  subtree for its new one. Returns SUCCESS, or MEMORY_ERROR if memory
+  could not be allocated.
 */
-boolean Node_isFile(Node_T oNNode) {
-   assert(oNNode != NULL);
+int Node_startPathFilter(size_t ulPaths) {
+   assert(ulPaths != 0);
+   assert(poNBuckets != NULL);
 
-   return oNNode->isFile;
+   if(Bloom_start(ulPaths) != SUCCESS)
+      return MEMORY_ERROR;
+   Node_filterFill();
+   Node_filterGrow();
+   return SUCCESS;
 }
 
-/* 
-  If oNNode is a file node, returns its contents as a string.
-  Otherwise, returns NULL.
+/* Stops keeping the path filter, if it is kept, and frees it. */
+void Node_stopPathFilter(void) {
+   Bloom_stop();
+}
 
-  Allocates mmory for the returned string, which is then owned by 
-  the caller!
- */
-char *Node_getContents(Node_T oNNode) {
-   char *extracted;
-   
-   assert(oNNode != NULL);
+/* Returns TRUE if the path filter is kept and FALSE otherwise. */
+boolean Node_hasPathFilter(void) {
+   return Bloom_isStarted();
+}
 
-   if (!Node_isFile(oNNode)) {
-      return NULL;
-   }
+/*
+  Returns FALSE if no node in the name index has the absolute path
+  pcPath, and TRUE if one may, or if the path filter is not kept. The
+  answer costs one hash of pcPath, which need not be well-formed.
+*/
+boolean Node_mayHavePath(const char *pcPath) {
+   unsigned long hash = ulHashBasis;
 
-   extracted = malloc(strlen(oNNode->contents) + 1);
-   if (extracted == NULL) {
-      return NULL;
+   assert(pcPath != NULL);
+
+   if(!Bloom_isStarted())
+      return TRUE;
+   while(*pcPath != '\0') {
+      hash ^= (unsigned char) *pcPath++;
+      hash *= ulHashPrime;
    }
-   return strcpy(extracted, oNNode->contents);
+   return Bloom_mayContain(hash);
+}
+
+/*
+  Sets *pulPaths to the number of paths in the path filter, which must
+  be kept, *pulCounters to its number of counters, and *pulQueries and
+  *pulRejections to the numbers of paths asked about and of those it
+  found absent since it was started.
+*/
+void Node_getPathFilterStats(size_t *pulPaths, size_t *pulCounters,
+                             size_t *pulQueries,
+                             size_t *pulRejections) {
+   assert(pulPaths != NULL);
+   assert(pulCounters != NULL);
+   assert(pulQueries != NULL);
+   assert(pulRejections != NULL);
+   assert(Bloom_isStarted());
+
+   Bloom_getStats(pulPaths, pulCounters, pulQueries, pulRejections);
 }
 
 /*-------------------------------------------------------------------*/
@@ -462,57 +3251,72 @@ char *Node_getContents(Node_T oNNode) {
 
 #include <stdio.h>
 
+/* Counts node oNNode in the count at pvCount, for Node_findByName. */
+static int countNode(Node_T oNNode, void *pvCount) {
+   (*(size_t *) pvCount)++;
+   return SUCCESS;
+}
+
 int main(void) {
    Node_T rootNode = NULL;
    Node_T childDir = NULL;
    Node_T helloWorldFile = NULL;
    Node_T current = NULL;
+   Node_T other = NULL;
    Path_T path = NULL;
+   Node_View_T view = NULL;
    int status;
    size_t index;
+   size_t files, dirs, bytes;
+   size_t moreFiles, moreDirs, moreBytes;
    const char *temp;
+   unsigned long hash, otherHash;
+   unsigned long generation;
    const char *helloWorld = "Hello World!";
+   char buffer[32];
    
    /* test creation of a root directory */
    Path_new("~", &path);
    status = Node_newDir(path, NULL, &rootNode);
    assert(status == SUCCESS);
    assert(rootNode != NULL);
-   assert(rootNode->contents == NULL);
+   assert(rootNode->pvContents == NULL);
    assert(!Node_isFile(rootNode));
-   assert(!strcmp("~", Path_getPathname(Node_getPath(rootNode))));
+   assert(!strcmp("~", Node_getName(rootNode)));
 
    /* test addition of a child directory */
    Path_new("~/COS217_A4", &path);
    status = Node_newDir(path, rootNode, &childDir);
    assert(status == SUCCESS);
    assert(childDir != NULL);
-   assert(!strcmp("~/COS217_A4",
-                  Path_getPathname(Node_getPath(childDir))));
+   assert(!strcmp("COS217_A4", Node_getName(childDir)));
 
    /* test addition of a file with contents */
    Path_new("~/COS217_A4/hello_world.txt", &path);
-   status = Node_newFile(path, childDir, helloWorld, &helloWorldFile);
+   status = Node_newFile(path, childDir, (void *) helloWorld,
+                         strlen(helloWorld) + 1, &helloWorldFile);
    assert(status == SUCCESS);
    assert(helloWorldFile != NULL);
    assert(helloWorldFile->oDChildren == NULL);
+   assert(!strcmp("hello_world.txt", Node_getName(helloWorldFile)));
+   status = Node_getPath(helloWorldFile, &path);
+   assert(status == SUCCESS);
    assert(!strcmp("~/COS217_A4/hello_world.txt",
-                  Path_getPathname(Node_getPath(helloWorldFile))));
-   assert(!strcmp(helloWorldFile->contents, helloWorld));
+                  Path_getPathname(path)));
+   Path_free(path);
+   assert(helloWorldFile->pvContents == helloWorld);
+   assert(helloWorldFile->storage == STORED_BY_CLIENT);
 
    /* test has child (existing child) */
-   Path_new("~/COS217_A4", &path);
-   status = Node_hasChild(rootNode, path, &index);
+   status = Node_hasChild(rootNode, "COS217_A4", &index);
    assert(status == TRUE);
    assert(index == 0);
 
    /* test has child (nonexisting child) */
-   Path_new("~/A", &path);
-   status = Node_hasChild(rootNode, path, &index);
+   status = Node_hasChild(rootNode, "A", &index);
    assert(status == FALSE);
    assert(index == 0);
-   Path_new("~/D", &path);
-   status = Node_hasChild(rootNode, path, &index);
+   status = Node_hasChild(rootNode, "D", &index);
    assert(status == FALSE);
    assert(index == 1);
 
@@ -526,6 +3330,27 @@ int main(void) {
    assert(status == NO_SUCH_PATH);
    assert(current == NULL);
 
+   /* test moving a file up a level and back, and bad moves */
+   status = Node_move(helloWorldFile, rootNode, "hello.txt");
+   assert(status == SUCCESS);
+   assert(Node_getParent(helloWorldFile) == rootNode);
+   assert(Node_getNumChildren(childDir) == 0);
+   status = Node_getChild(rootNode, 1, &current);
+   assert(status == SUCCESS);
+   assert(current == helloWorldFile);
+   temp = Node_toString(helloWorldFile);
+   assert(!strcmp(temp, "~/hello.txt"));
+   free((char *) temp);
+   assert(Node_move(rootNode, childDir, "x") == CONFLICTING_PATH);
+   assert(Node_move(childDir, childDir, "x") == CONFLICTING_PATH);
+   assert(Node_move(childDir, helloWorldFile, "x") == NO_SUCH_PATH);
+   assert(Node_move(childDir, rootNode, "hello.txt") ==
+          ALREADY_IN_TREE);
+   assert(Node_move(childDir, rootNode, "a/b") == BAD_PATH);
+   status = Node_move(helloWorldFile, childDir, "hello_world.txt");
+   assert(status == SUCCESS);
+   assert(Node_getNumChildren(rootNode) == 1);
+
    /* test toString */
    printf("%s\n", temp = Node_toString(rootNode));
    free((char *) temp);
@@ -535,8 +3360,320 @@ int main(void) {
    free((char *) temp);
 
    /* test get contents of a file */
-   printf("%s\n", temp = Node_getContents(helloWorldFile));
+   printf("%s\n", (char *) Node_getContents(helloWorldFile));
+
+   /* test ranged read, in-place write, and append */
+   status = Node_readRange(helloWorldFile, 6, buffer, sizeof(buffer),
+                           &index);
+   assert(status == SUCCESS);
+   assert(index == 7);
+   assert(!strcmp(buffer, "World!"));
+   status = Node_readRange(helloWorldFile, 13, buffer, 1, &index);
+   assert(status == SUCCESS);
+   assert(index == 0);
+   status = Node_writeRange(helloWorldFile, 6, "There", 5);
+   assert(status == SUCCESS);
+   assert(helloWorldFile->storage == STORED_ON_HEAP);
+   assert(!strcmp(Node_getContents(helloWorldFile), "Hello There!"));
+   assert(!strcmp(helloWorld, "Hello World!"));
+   status = Node_writeRange(helloWorldFile, 12, "!!", 3);
+   assert(status == SUCCESS);
+   assert(Node_getLength(helloWorldFile) == 15);
+   assert(!strcmp(Node_getContents(helloWorldFile), "Hello There!!!"));
+   status = Node_writeRange(helloWorldFile, 17, "x", 1);
+   assert(status == SUCCESS);
+   assert(Node_getLength(helloWorldFile) == 18);
+   assert(((char *) Node_getContents(helloWorldFile))[16] == '\0');
+   /* capacities double from a floor, but never past what a size_t
+      holds */
+   assert(Node_growCapacity(0, 1) == 16);
+   assert(Node_growCapacity(16, 33) == 64);
+   assert(Node_growCapacity(16, (size_t) -1 / 2 + 2) ==
+          (size_t) -1 / 2 + 2);
+
+   /* test copying a file with heap contents, which it shares until
+      one of them is written */
+   status = Node_copy(helloWorldFile, rootNode, "copy.txt", &current,
+                      &index);
+   assert(status == SUCCESS);
+   assert(index == 1);
+   assert(helloWorldFile->storage == STORED_SHARED);
+   assert(Node_getParent(current) == rootNode);
+   assert(current->pvContents == helloWorldFile->pvContents);
+   assert(*current->pulShares == 2);
+   status = Node_writeRange(current, 0, "J", 1);
+   assert(status == SUCCESS);
+   assert(current->storage == STORED_ON_HEAP);
+   assert(!strcmp(Node_getContents(current), "Jello There!!!"));
+   assert(!strcmp(Node_getContents(helloWorldFile), "Hello There!!!"));
+   assert(helloWorldFile->storage == STORED_ON_HEAP);
+   assert(helloWorldFile->pulShares == NULL);
+   assert(Node_free(current) == 1);
+
+   /* test detaching, renaming, and reattaching a node, and swapping
+      contents with a detached copy */
+   status = Node_copy(helloWorldFile, NULL, "saved", &current, &index);
+   assert(status == SUCCESS);
+   assert(Node_getHash(current, &hash) == SUCCESS);
+   assert(Node_getHash(helloWorldFile, &otherHash) == SUCCESS);
+   assert(hash == otherHash);
+   assert(Node_getHash(rootNode, &hash) == SUCCESS);
+   status = Node_writeRange(helloWorldFile, 0, "J", 1);
+   assert(status == SUCCESS);
+   assert(Node_getHash(rootNode, &otherHash) == SUCCESS);
+   assert(hash != otherHash);
+   generation = Node_getGeneration();
+   Node_detach(helloWorldFile);
+   assert(Node_getParent(helloWorldFile) == NULL);
+   assert(Node_getGeneration() != generation);
+   assert(Node_getNumChildren(rootNode) == 1);
+   temp = malloc(4);
+   assert(temp != NULL);
+   strcpy((char *) temp, "new");
+   free(Node_setName(helloWorldFile, (char *) temp));
+   status = Node_attach(helloWorldFile, rootNode);
+   assert(status == SUCCESS);
+   assert(Node_hasChild(rootNode, "new", &index));
+   assert(Node_countNodes(rootNode) == 3);
+   Node_swapContents(helloWorldFile, current);
+   assert(!strcmp(Node_getContents(helloWorldFile), "Hello There!!!"));
+   assert(!strcmp(Node_getContents(current), "Jello There!!!"));
+   assert(Node_free(current) == 1);
+   assert(Node_getMark(helloWorldFile) == 0);
+   Node_setMark(helloWorldFile, 7);
+   assert(Node_getMark(helloWorldFile) == 7);
+   Node_setMark(helloWorldFile, 0);
+
+   /* test spilling contents to the spill store and writing there */
+   status = Spill_open("nodeDebug.spill", 8);
+   assert(status == SUCCESS);
+   status = Node_spillContents(helloWorldFile);
+   assert(status == SUCCESS);
+   assert(helloWorldFile->storage == STORED_IN_SPILL);
+   assert(helloWorldFile->pvContents == NULL);
+   status = Node_readRange(helloWorldFile, 0, buffer, 5, &index);
+   assert(status == SUCCESS);
+   assert(index == 5);
+   assert(!strncmp(buffer, "Hello", 5));
+   assert(!strcmp(Node_getContents(helloWorldFile), "Hello There!!!"));
+   status = Node_writeRange(helloWorldFile, 0, "J", 1);
+   assert(status == SUCCESS);
+   assert(!strcmp(Node_getContents(helloWorldFile), "Jello There!!!"));
+   for(index = 0; index < 100; index++) {
+      status = Node_writeRange(helloWorldFile,
+                               Node_getLength(helloWorldFile), "ab", 2);
+      assert(status == SUCCESS);
+   }
+   assert(Node_getLength(helloWorldFile) == 218);
+   assert(!strncmp((char *) Node_getContents(helloWorldFile) + 216,
+                   "ab", 2));
+   assert(!strcmp(Node_getContents(helloWorldFile), "Jello There!!!"));
+   temp = Node_replaceContents(helloWorldFile, NULL, 0);
+   assert(!strcmp(temp, "Jello There!!!"));
+   free((char *) temp);
+   assert(helloWorldFile->storage == STORED_BY_CLIENT);
+
+   /* test the name index, which linked nodes join and detached or
+      freed ones leave, and in which a moved node changes groups */
+   index = 0;
+   assert(!Node_hasIndex());
+   assert(Node_startIndex() == SUCCESS);
+   assert(Node_hasIndex());
+   Node_indexRoot(rootNode);
+   assert(Node_findByName("new", countNode, &index) == SUCCESS);
+   assert(index == 1);
+   status = Node_newChild(childDir, "new", FALSE, &current);
+   assert(status == SUCCESS);
+   index = 0;
+   assert(Node_findByName("new", countNode, &index) == SUCCESS);
+   assert(index == 2);
+   status = Node_move(current, childDir, "old");
+   assert(status == SUCCESS);
+   index = 0;
+   assert(Node_findByName("new", countNode, &index) == SUCCESS);
+   assert(Node_findByName("old", countNode, &index) == SUCCESS);
+   assert(index == 2);
+   Node_detach(current);
+   index = 0;
+   assert(Node_findByName("old", countNode, &index) == SUCCESS);
+   assert(index == 0);
+   assert(Node_free(current) == 1);
+   for(index = 0; index < 300; index++) {
+      sprintf(buffer, "n%lu", (unsigned long) index);
+      status = Node_newChild(childDir, buffer, TRUE, &current);
+      assert(status == SUCCESS);
+   }
+   index = 0;
+   assert(Node_findByName("n271", countNode, &index) == SUCCESS);
+   assert(index == 1);
+   while(Node_getNumChildren(childDir) != 0) {
+      (void) Node_getChild(childDir, 0, &current);
+      assert(Node_free(current) == 1);
+   }
+   assert(Node_findByName("n271", countNode, &index) == SUCCESS);
+   assert(index == 1);
+
+   /* test the trigram index, which changed files are reindexed in
+      before a search, and in which short patterns match every file */
+   assert(!Node_hasTextIndex());
+   assert(Node_startTextIndex() == SUCCESS);
+   assert(Node_hasTextIndex());
+   (void) Node_replaceContents(helloWorldFile, (void *) helloWorld,
+                               strlen(helloWorld));
+   index = 0;
+   assert(Node_searchText("World", 5, countNode, &index) == SUCCESS);
+   assert(index == 1);
+   temp = Node_replaceContents(helloWorldFile, NULL, 0);
+   assert(temp == helloWorld);
+   index = 0;
+   assert(Node_searchText("World", 5, countNode, &index) == SUCCESS);
+   assert(index == 0);
+   status = Node_newChild(childDir, "text", TRUE, &current);
+   assert(status == SUCCESS);
+   assert(Node_searchText("Wo", 2, countNode, &index) == SUCCESS);
+   assert(index == 2);
+   assert(Node_free(current) == 1);
+   Node_stopTextIndex();
+   assert(!Node_hasTextIndex());
+   assert(helloWorldFile->ulTextID == 0);
+
+   /* test the path filter, which holds the path of every node in the
+      name index, grows past its size, and follows moves */
+   assert(!Node_hasPathFilter());
+   assert(Node_mayHavePath("nowhere"));
+   assert(Node_startPathFilter(1) == SUCCESS);
+   assert(Node_hasPathFilter());
+   Node_getPathFilterStats(&files, &dirs, &moreFiles, &moreDirs);
+   assert(files == Node_countNodes(rootNode) && dirs >= 64);
+   status = Node_newChild(childDir, "moved", FALSE, &current);
+   assert(status == SUCCESS);
+   status = Node_newChild(current, "f", TRUE, &other);
+   assert(status == SUCCESS);
+   temp = Node_toString(other);
+   assert(Node_mayHavePath(temp));
+   free((char *) temp);
+   status = Node_move(current, rootNode, "moved");
+   assert(status == SUCCESS);
+   temp = Node_toString(other);
+   assert(Node_mayHavePath(temp));
    free((char *) temp);
+   assert(!Node_mayHavePath("nowhere") || !Node_mayHavePath("x/y") ||
+          !Node_mayHavePath("1root/x"));
+   Node_getPathFilterStats(&files, &dirs, &moreFiles, &moreDirs);
+   assert(files == Node_countNodes(rootNode));
+   assert(moreFiles >= 3 && moreDirs >= 1);
+   assert(Node_free(current) == 2);
+   Node_getPathFilterStats(&files, &dirs, &moreFiles, &moreDirs);
+   assert(files == Node_countNodes(rootNode));
+   Node_stopIndex();
+   assert(!Node_hasPathFilter());
+
+   /* test pins, which keep a freed node's memory, unlinked and
+      childless, until the last one is dropped */
+   status = Node_newChild(childDir, "pinned", FALSE, &current);
+   assert(status == SUCCESS);
+   status = Node_newChild(current, "f", TRUE, &other);
+   assert(status == SUCCESS);
+   Node_pin(current);
+   Node_pin(current);
+   assert(Node_free(current) == 2);
+   assert(current->isFreed);
+   assert(Node_getParent(current) == NULL);
+   assert(Node_getNumChildren(current) == 0);
+   assert(!strcmp(Node_getName(current), "pinned"));
+   Node_unpin(current);
+   assert(!strcmp(Node_getName(current), "pinned"));
+   Node_unpin(current);
+   assert(!Node_hasIndex());
+   assert(!helloWorldFile->isIndexed);
+
+   /* test the subtree totals, which follow links, moves, and
+      changes of length up the chain of ancestors */
+   Node_getTotals(rootNode, &files, &dirs, &bytes);
+   assert(files + dirs == Node_countNodes(rootNode));
+   status = Node_newChild(childDir, "sum", FALSE, &current);
+   assert(status == SUCCESS);
+   status = Node_newChild(current, "f", TRUE, &other);
+   assert(status == SUCCESS);
+   status = Node_writeRange(other, 0, "abcd", 4);
+   assert(status == SUCCESS);
+   Node_adoptContents(other, NULL, 0);
+   status = Node_writeRange(other, 0, "abc", 3);
+   assert(status == SUCCESS);
+   Node_getTotals(rootNode, &moreFiles, &moreDirs, &moreBytes);
+   assert(moreFiles == files + 1 && moreDirs == dirs + 1);
+   assert(moreBytes == bytes + 3);
+   Node_getTotals(childDir, &files, &dirs, &bytes);
+   status = Node_move(current, rootNode, "sum");
+   assert(status == SUCCESS);
+   Node_getTotals(childDir, &moreFiles, &moreDirs, &moreBytes);
+   assert(moreFiles == files - 1 && moreDirs == dirs - 1);
+   assert(moreBytes == bytes - 3);
+   Node_getTotals(current, &moreFiles, &moreDirs, &moreBytes);
+   assert(moreFiles == 1 && moreDirs == 1 && moreBytes == 3);
+   assert(Node_free(current) == 2);
+   Node_getTotals(rootNode, &moreFiles, &moreDirs, &moreBytes);
+   assert(moreFiles + moreDirs == Node_countNodes(rootNode));
+
+   /* test quotas, which are checked along the chain of ancestors but
+      not above the common ancestor of a move */
+   Node_setQuota(rootNode, Node_countNodes(rootNode) + 1, 0);
+   assert(Node_checkQuota(childDir, 1, 100) == SUCCESS);
+   assert(Node_checkQuota(childDir, 2, 0) == QUOTA_EXCEEDED);
+   status = Node_newChild(childDir, "q", FALSE, &current);
+   assert(status == SUCCESS);
+   assert(Node_checkQuota(childDir, 1, 0) == QUOTA_EXCEEDED);
+   assert(Node_checkMove(current, rootNode) == SUCCESS);
+   Node_setQuota(rootNode, 0, 0);
+   assert(Node_checkQuota(childDir, 1, 0) == SUCCESS);
+   assert(Node_free(current) == 1);
+
+   /* test freeing a chain of directories far deeper than the call
+      stack could follow, built from the bottom up so that each link
+      is made in constant time, with a pinned node partway down */
+   status = Node_newChild(NULL, "deep", FALSE, &current);
+   assert(status == SUCCESS);
+   for(index = 1; index < 200000; index++) {
+      status = Node_newChild(NULL, "deep", FALSE, &other);
+      assert(status == SUCCESS);
+      status = Node_attach(current, other);
+      assert(status == SUCCESS);
+      if(index == 1000)
+         Node_pin(current);
+      current = other;
+   }
+   for(other = current, index = 0; index < 200000 - 1000; index++)
+      (void) Node_getChild(other, 0, &other);
+   assert(other->ulPins == 1);
+   assert(Node_free(current) == 200000);
+   assert(other->isFreed);
+   assert(Node_getParent(other) == NULL);
+   assert(Node_getNumChildren(other) == 0);
+   assert(Node_countNodes(other) == 1);
+   Node_unpin(other);
+
+   /* test views, into which a change first copies the path down to
+      the changed node, and which keep a node freed from the tree
+      until they no longer see it */
+   status = Node_newChild(childDir, "v", FALSE, &current);
+   assert(status == SUCCESS);
+   status = Node_newChild(current, "w", FALSE, &other);
+   assert(status == SUCCESS);
+   assert(Node_getHash(rootNode, &hash) == SUCCESS);
+   status = Node_openView(rootNode, &view);
+   assert(status == SUCCESS);
+   assert(Node_getViewRoot(view) == rootNode);
+   assert(Node_free(current) == 2);
+   assert(other->isFreed && other->ulViewRefs == 1);
+   assert(Node_getViewRoot(view) != rootNode);
+   assert(Node_countNodes(Node_getViewRoot(view)) ==
+          Node_countNodes(rootNode) + 2);
+   assert(Node_getHash(Node_getViewRoot(view), &otherHash) ==
+          SUCCESS);
+   assert(hash == otherHash);
+   assert(Node_getHash(rootNode, &otherHash) == SUCCESS);
+   assert(hash != otherHash);
+   Node_closeView(view);
 
    /* test get contents from a directory */
    assert(Node_getContents(rootNode) == NULL);
@@ -544,6 +3681,7 @@ int main(void) {
    /* test free */
    status = Node_free(rootNode);
    assert(status == 3);
+   Spill_close();
    
    return SUCCESS;
 }
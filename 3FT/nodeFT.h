@@ -15,12 +15,16 @@
 /* A Node_T is a node in a File Tree */
 typedef struct node *Node_T;
 
+/* A Node_View_T is a read-only view of a tree of nodes as it was when
+   the view was opened */
+typedef struct nodeView *Node_View_T;
+
 /*-------------------------------------------------------------------*/
 
 /*
   Creates a new directory node in the File Tree, with path oPPath and
-  parent oNParent. Returns an int SUCCESS status and sets *poNResult 
-  to be the new node if successful. Otherwise, sets *poNResult to NULL 
+  parent oNParent. Returns an int SUCCESS status and sets *poNResult
+  to be the new node if successful. Otherwise, sets *poNResult to NULL
   and returns status:
   * MEMORY_ERROR if memory could not be allocated to complete request
   * CONFLICTING_PATH if oNParent's path is not an ancestor of oPPath
@@ -33,9 +37,11 @@ typedef struct node *Node_T;
 int Node_newDir(Path_T oPPath, Node_T oNParent, Node_T *poNResult);
 
 /*
-  Creates a new file node in the File Tree, with path oPPath, parent 
-  oNParent, and contents contents. Returns an int SUCCESS status and 
-  sets *poNResult to be the new node if successful. Otherwise, sets 
+  Creates a new file node in the File Tree, with path oPPath, parent
+  oNParent, and contents pvContents of size ulLength bytes. The node
+  stores the pvContents pointer itself; the memory it points to
+  remains owned by the caller. Returns an int SUCCESS status and
+  sets *poNResult to be the new node if successful. Otherwise, sets
   *poNResult to NULL and returns status:
   * MEMORY_ERROR if memory could not be allocated to complete request
   * CONFLICTING_PATH if oNParent's path is not an ancestor of oPPath
@@ -45,21 +51,61 @@ int Node_newDir(Path_T oPPath, Node_T oNParent, Node_T *poNResult);
                  or oNParent is a file
   * ALREADY_IN_TREE if oNParent already has a child with this path
 */
-int Node_newFile(Path_T oPPath, Node_T oNParent, const char *contents,
-                Node_T *poNResult);
+int Node_newFile(Path_T oPPath, Node_T oNParent, void *pvContents,
+                 size_t ulLength, Node_T *poNResult);
+
+/*
+  Creates a new node named pcName, a file with NULL contents if isFile
+  is TRUE and a directory otherwise, as a child of oNParent, or as the
+  root if oNParent is NULL. Children built in sorted order are linked
+  in at the end of their parent's children in O(log n) time. Returns an
+  int SUCCESS status and sets *poNResult to be the new node if
+  successful. Otherwise, sets *poNResult to NULL and returns status:
+  * BAD_PATH if pcName is empty or contains a '/'
+  * MEMORY_ERROR if memory could not be allocated to complete request
+  * NO_SUCH_PATH if oNParent is a file
+  * ALREADY_IN_TREE if oNParent already has a child named pcName
+*/
+int Node_newChild(Node_T oNParent, const char *pcName, boolean isFile,
+                  Node_T *poNResult);
 
 /*
   Destroys and frees all memory allocated for the subtree rooted at
   oNNode, i.e., deletes this node and all its descendents. Returns the
-  number of nodes deleted.
+  number of nodes deleted. A pinned node is unlinked and loses its
+  children, but its memory is only freed when its last pin is dropped.
+  A node that an open view still sees is unlinked but kept, with its
+  subtree, until no view sees it.
 */
 size_t Node_free(Node_T oNNode);
 
-/* Returns the path object representing oNNode's absolute path. */
-Path_T Node_getPath(Node_T oNNode);
+/*
+  Pins oNNode, so that its memory outlives Node_free until the pin is
+  dropped with Node_unpin. A node may hold any number of pins.
+*/
+void Node_pin(Node_T oNNode);
 
 /*
-  Returns TRUE if oNParent has a child with path oPPath. Returns
+  Drops a pin from oNNode, which must hold one, freeing the node if
+  Node_free has been called on it, this was its last pin, and no view
+  still sees it.
+*/
+void Node_unpin(Node_T oNNode);
+
+/*
+  Builds a new path object representing oNNode's absolute path, from
+  the names of oNNode and its ancestors, in time proportional to its
+  length. Returns an int SUCCESS status and sets *poPResult to the
+  path, which is then owned by the caller, if successful. Otherwise,
+  sets *poPResult to NULL and returns MEMORY_ERROR.
+*/
+int Node_getPath(Node_T oNNode, Path_T *poPResult);
+
+/* Returns oNNode's name, the last component of its absolute path. */
+const char *Node_getName(Node_T oNNode);
+
+/*
+  Returns TRUE if oNParent has a child named pcName. Returns
   FALSE if it does not, or if oNParent is a file.
 
   If oNParent has such a child, stores in *pulChildID the child's
@@ -67,11 +113,11 @@ Path_T Node_getPath(Node_T oNNode);
   such a child, stores in *pulChildID the identifier that such a
   child _would_ have if inserted.
 */
-boolean Node_hasChild(Node_T oNParent, Path_T oPPath,
+boolean Node_hasChild(Node_T oNParent, const char *pcName,
                          size_t *pulChildID);
 
-/* 
-  Returns the number of children that oNParent has 
+/*
+  Returns the number of children that oNParent has
   (always 0 if oNParent is a file).
 */
 size_t Node_getNumChildren(Node_T oNParent);
@@ -92,14 +138,224 @@ int Node_getChild(Node_T oNParent, size_t ulChildID,
 Node_T Node_getParent(Node_T oNNode);
 
 /*
-  Compares oNFirst and oNSecond lexicographically based on their paths.
+  Compares oNFirst and oNSecond lexicographically based on their names,
+  which orders siblings the same way as their paths.
   Returns <0, 0, or >0 if onFirst is "less than", "equal to", or
   "greater than" oNSecond, respectively.
 */
 int Node_compare(Node_T oNFirst, Node_T oNSecond);
 
 /*
-  Returns a string representation for oNNode, or NULL if
+  Moves oNNode, with its whole subtree, to be the child of oNNewParent
+  named pcNewName. Since no node stores its ancestors' names, only
+  oNNode itself is relinked and renamed: finding its old and new
+  places takes O(log n) comparisons among n siblings, and no
+  descendant is touched. Returns SUCCESS if successful. Otherwise,
+  leaves the tree unchanged and returns status:
+  * BAD_PATH if pcNewName is empty or contains a '/'
+  * MEMORY_ERROR if memory could not be allocated to complete request
+  * NO_SUCH_PATH if oNNewParent is a file
+  * CONFLICTING_PATH if oNNode is the root, or oNNewParent is oNNode
+                     or one of its descendants
+  * ALREADY_IN_TREE if oNNewParent already has a child named
+                    pcNewName (which may be oNNode itself)
+*/
+int Node_move(Node_T oNNode, Node_T oNNewParent,
+              const char *pcNewName);
+
+/*
+  Builds a copy of the subtree rooted at oNNode as the child of
+  oNNewParent named pcNewName, or as the root of a new tree of its own
+  if oNNewParent is NULL. Sets *poNResult to the copy of oNNode and
+  *pulNodes to the number of nodes built. The copies share their file
+  contents with the originals instead of copying them: client-owned
+  contents stay client-owned, and contents owned by a node are
+  reference counted and copied only when first changed through either
+  node (or simply taken over by the last node left sharing them).
+  Copying takes time proportional to the number of nodes, not to the
+  size of their contents: unlike a view's (see Node_openView), the
+  copies are nodes of the tree, each with its own parent, name,
+  totals, and index links, so none can be shared with its original.
+  Returns SUCCESS if successful. Otherwise,
+  leaves the tree unchanged, sets *poNResult to NULL and *pulNodes to
+  0, and returns status:
+  * BAD_PATH if pcNewName is empty or contains a '/'
+  * MEMORY_ERROR if memory could not be allocated to complete request
+  * NO_SUCH_PATH if oNNewParent is a file
+  * CONFLICTING_PATH if oNNewParent is oNNode or one of its
+                     descendants
+  * ALREADY_IN_TREE if oNNewParent already has a child named
+                    pcNewName
+*/
+int Node_copy(Node_T oNNode, Node_T oNNewParent, const char *pcNewName,
+              Node_T *poNResult, size_t *pulNodes);
+
+/*
+  Unlinks oNNode, with its whole subtree, from its parent's children,
+  leaving it the root of a tree of its own, and removes the subtree
+  from the name index and advances the generation (see
+  Node_getGeneration), even if oNNode has no parent.
+*/
+void Node_detach(Node_T oNNode);
+
+/*
+  Links oNNode, which must have no parent, with its whole subtree in
+  as a child of oNParent, which must not lie in that subtree. Returns
+  SUCCESS if successful. Otherwise, leaves oNNode without a parent and
+  returns status:
+  * MEMORY_ERROR if memory could not be allocated to complete request
+  * NO_SUCH_PATH if oNParent is a file
+  * ALREADY_IN_TREE if oNParent already has a child with oNNode's name
+*/
+int Node_attach(Node_T oNNode, Node_T oNParent);
+
+/*
+  Gives oNNode, which must have no parent, the name pcName, a string
+  allocated with malloc that the node takes over, and returns its old
+  name, which is then owned by the caller.
+*/
+char *Node_setName(Node_T oNNode, char *pcName);
+
+/*
+  Swaps the contents of file nodes oNFirst and oNSecond, wherever and
+  however each is stored, along with their places in the content
+  cache.
+*/
+void Node_swapContents(Node_T oNFirst, Node_T oNSecond);
+
+/*
+  Opens a view of the tree rooted at oNRoot, which must have no
+  parent, as it is now, in constant time: the view shares the tree's
+  nodes, and a change to a node that the view sees first copies the
+  node into the view, with each of its ancestors not yet copied. The
+  copies share the nodes' contents and other children, so a change
+  costs time proportional to its depth, and to its ancestors' numbers
+  of children, for each view that sees it. A change never fails for
+  want of memory for a view; the view is lost instead (see
+  Node_getViewRoot). Returns SUCCESS and sets *poVResult to the view,
+  which must be closed with Node_closeView, or sets *poVResult to NULL
+  and returns MEMORY_ERROR if memory could not be allocated.
+*/
+int Node_openView(Node_T oNRoot, Node_View_T *poVResult);
+
+/*
+  Returns the root of view oVView's tree, or NULL if the view was lost
+  for want of memory to copy a node into it. The view's nodes may only
+  be read, from its root down: they may be shared with the tree
+  viewed, so their parents, and paths built from them, may not be the
+  view's.
+*/
+Node_T Node_getViewRoot(Node_View_T oVView);
+
+/*
+  Closes view oVView, freeing its copies of nodes, and the nodes freed
+  from the tree viewed that it was the last to see.
+*/
+void Node_closeView(Node_View_T oVView);
+
+/*
+  Returns the number of nodes in the subtree rooted at oNNode, in
+  constant time.
+*/
+size_t Node_countNodes(Node_T oNNode);
+
+/*
+  Sets *pulFiles and *pulDirs to the numbers of files and directories
+  in the subtree rooted at oNNode, itself included, and *pulBytes to
+  the total length of the files' contents, in constant time.
+*/
+void Node_getTotals(Node_T oNNode, size_t *pulFiles, size_t *pulDirs,
+                    size_t *pulBytes);
+
+/*
+  Sets the mark of oNNode, a number that the node keeps for its
+  client and that starts out 0, to ulMark.
+*/
+void Node_setMark(Node_T oNNode, unsigned long ulMark);
+
+/* Returns the mark of oNNode (see Node_setMark). */
+unsigned long Node_getMark(Node_T oNNode);
+
+/*
+  Returns the generation of the trees of nodes, which changes whenever
+  a node is unlinked (or freed) or moved, and so whenever a path may
+  have stopped naming the node it named.
+*/
+unsigned long Node_getGeneration(void);
+
+/*
+  Returns TRUE if oNNode lies in the tree rooted at oNRoot and neither
+  it nor any of its ancestors has been unlinked or moved since
+  generation ulGeneration (see Node_getGeneration), so that its path
+  is still what it was then, and FALSE otherwise. Takes time
+  proportional to oNNode's depth.
+*/
+boolean Node_isLinkedSince(Node_T oNNode, Node_T oNRoot,
+                           unsigned long ulGeneration);
+
+/*
+  Records pvEntry as the lookup cache's entry for oNNode's path, or
+  that it has none if pvEntry is NULL. A node's entry is removed from
+  the lookup cache when the node is freed.
+*/
+void Node_setCacheEntry(Node_T oNNode, void *pvEntry);
+
+/*
+  Returns the lookup cache's entry for oNNode's path, or NULL if it
+  has none (see Node_setCacheEntry).
+*/
+void *Node_getCacheEntry(Node_T oNNode);
+
+/*
+  Gives directory oNDir a quota of at most ulMaxNodes nodes and
+  ulMaxBytes bytes of contents in its subtree, itself included, with
+  0 meaning no limit; both 0 removes the quota. A quota below what the
+  subtree already holds is kept, and only stops it from growing.
+  Copies of a directory do not take its quota.
+*/
+void Node_setQuota(Node_T oNDir, size_t ulMaxNodes, size_t ulMaxBytes);
+
+/*
+  Sets *pulMaxNodes and *pulMaxBytes to the quota of oNNode, each 0 if
+  there is no limit.
+*/
+void Node_getQuota(Node_T oNNode, size_t *pulMaxNodes,
+                   size_t *pulMaxBytes);
+
+/*
+  Returns SUCCESS if ulNodes nodes and ulBytes bytes of contents may
+  be added to the subtree rooted at oNNode, or QUOTA_EXCEEDED if that
+  would take oNNode or one of its ancestors past its quota. Checks
+  the totals kept along the chain of ancestors, in time proportional
+  to oNNode's depth, or in constant time if there are no quotas.
+*/
+int Node_checkQuota(Node_T oNNode, size_t ulNodes, size_t ulBytes);
+
+/*
+  Returns SUCCESS if oNNode, with its subtree, may be moved under
+  oNNewParent, or QUOTA_EXCEEDED if that would take an ancestor of
+  oNNewParent past its quota. Ancestors of both the old and the new
+  parent hold the subtree already, so only those below the lowest
+  such one are checked, in time proportional to the parents' depths.
+*/
+int Node_checkMove(Node_T oNNode, Node_T oNNewParent);
+
+/*
+  Sets *pulHash to the hash of the contents of oNNode: for a file, of
+  its bytes, and for a directory, of its children's names, types, and
+  hashes, in name order, so that two subtrees with equal hashes are
+  equal below their roots (barring a 64-bit collision). Hashes are
+  kept with the nodes and only marked out of date, along the chain of
+  ancestors, by a change; this call rehashes just the files and
+  directories changed since the last one. Contents that the client
+  changes in place, behind the FT's back, are not noticed. Returns
+  SUCCESS, or IO_ERROR if spilled contents could not be read.
+*/
+int Node_getHash(Node_T oNNode, unsigned long *pulHash);
+
+/*
+  Returns a string representation for oNNode, its absolute path built
+  from the names of oNNode and its ancestors, or NULL if
   there is an allocation error.
 
   Allocates memory for the returned string, which is then owned by
@@ -107,19 +363,225 @@ int Node_compare(Node_T oNFirst, Node_T oNSecond);
 */
 char *Node_toString(Node_T oNNode);
 
-/* 
-  Returns TRUE if oNNode is a file node and FALSE if it is a 
+/*
+  Returns TRUE if oNNode is a file node and FALSE if it is a
   directory node.
 */
 boolean Node_isFile(Node_T oNNode);
 
-/* 
-  If oNNode is a file node, returns its contents as a string.
+/*
+  If oNNode is a file node, returns its contents. Otherwise, returns
+  NULL. (Note: a file's contents may also be NULL.) Spilled contents
+  are faulted back onto the heap or mapped into memory on demand, and
+  NULL is returned if they cannot be.
+*/
+void *Node_getContents(Node_T oNNode);
 
-  Allocates mmory for the returned string, which is then owned by 
-  the caller!
- */
-char *Node_getContents(Node_T oNNode);
+/*
+  Returns the length in bytes of oNNode's contents (always 0 if oNNode
+  is a directory).
+*/
+size_t Node_getLength(Node_T oNNode);
+
+/*
+  Replaces the contents of file node oNNode with pvNewContents of size
+  ulNewLength bytes, which remain owned by the caller. Returns the old
+  contents. If the old contents were built by Node_writeRange, the
+  node gives up ownership of them and they are then owned by the
+  caller! (Spilled, mapped, or shared contents are first copied into
+  a new heap buffer; if that fails, the contents are left unchanged
+  and NULL is returned.)
+*/
+void *Node_replaceContents(Node_T oNNode, void *pvNewContents,
+                           size_t ulNewLength);
+
+/*
+  Copies up to ulLength bytes of file node oNNode's contents, starting
+  at byte ulOffset, into pvBuf, and sets *pulRead to the number of
+  bytes copied, which is less than ulLength if the contents end first
+  (and 0 if ulOffset is at or past the end). Returns SUCCESS, or
+  MEMORY_ERROR or IO_ERROR if spilled contents could not be read back.
+*/
+int Node_readRange(Node_T oNNode, size_t ulOffset, void *pvBuf,
+                   size_t ulLength, size_t *pulRead);
+
+/*
+  Overwrites ulLength bytes of file node oNNode's contents, starting
+  at byte ulOffset, with the bytes at pvData, extending the contents
+  if the range runs past their end. A gap between the old end and
+  ulOffset is filled with zero bytes. Returns SUCCESS, or MEMORY_ERROR
+  or IO_ERROR (leaving the contents unchanged) if space for the
+  contents could not be allocated.
+
+  The first ranged write copies caller-owned contents into a buffer
+  owned by the node; from then on a write costs time proportional to
+  ulLength (amortized over the buffer's growth), not to the size of
+  the contents. If the spill store is open, contents that grow past
+  its threshold are moved there.
+*/
+int Node_writeRange(Node_T oNNode, size_t ulOffset,
+                    const void *pvData, size_t ulLength);
+
+/*
+  Replaces the contents of file node oNNode with the ulLength bytes at
+  pvContents, a buffer allocated with malloc of which the node takes
+  ownership (and which may be NULL if ulLength is 0). Old contents
+  owned by the node are released; old caller-owned contents are
+  simply dropped. If the spill store is open, contents longer than its
+  threshold are moved there.
+*/
+void Node_adoptContents(Node_T oNNode, void *pvContents,
+                        size_t ulLength);
+
+/*
+  Replaces the contents of file node oNNode with the ulLength bytes at
+  pvContents, which lie in a mapped snapshot that must stay mapped
+  until the node is freed or given other contents. The node reads the
+  contents in place, copying them to the heap on the first ranged
+  write, and never frees them. Old contents owned by the node are
+  released.
+*/
+void Node_mapContents(Node_T oNNode, void *pvContents,
+                      size_t ulLength);
+
+/*
+  If file node oNNode's contents are in a heap buffer owned by the
+  node, moves them into the spill store (reusing the node's old
+  region if they still fit in it) and frees the buffer. Returns
+  SUCCESS (also if there was nothing to move), or MEMORY_ERROR or
+  IO_ERROR (leaving the contents on the heap) if they could not be
+  moved. The spill store must be open.
+*/
+int Node_spillContents(Node_T oNNode);
+
+/*
+  Sets the content cache's budget to ulNewBudget bytes of heap-owned
+  contents, or removes the budget if ulNewBudget is 0, and resets the
+  hit, miss, and eviction counters. If the cache is over the new
+  budget, evicts contents to the spill store, which must be open
+  unless there is no budget.
+
+  The cache tracks the heap buffers of all nodes in least recently
+  used order. While there is a budget, accessing or growing contents
+  evicts the least recently used ones to the spill store until the
+  total is back under budget, and accessing evicted contents faults
+  them back onto the heap.
+*/
+void Node_setBudget(size_t ulNewBudget);
+
+/*
+  Sets *pulResident to the number of bytes of heap buffers owned by
+  nodes, and *pulHits, *pulMisses, and *pulEvictions to the content
+  cache's counters since the budget was last set.
+*/
+void Node_getCacheStats(size_t *pulResident, size_t *pulHits,
+                        size_t *pulMisses, size_t *pulEvictions);
+
+/*
+  Starts keeping the name index, empty, if it is not already kept.
+  Returns SUCCESS, or MEMORY_ERROR if memory could not be allocated.
+*/
+int Node_startIndex(void);
+
+/* Returns TRUE if the name index is kept and FALSE otherwise. */
+boolean Node_hasIndex(void);
+
+/*
+  Removes every node from the name index and stops keeping it, and
+  the trigram index and path filter too.
+*/
+void Node_stopIndex(void);
+
+/*
+  Adds the tree rooted at oNRoot, which must have no parent, to the
+  name index, if it is kept. From then on, nodes linked in below a
+  node in the index are added to it too, and nodes unlinked with
+  Node_detach or freed are removed from it.
+*/
+void Node_indexRoot(Node_T oNRoot);
+
+/*
+  Passes each node in the name index, which must be kept, named
+  pcName to pfVisit, along with pvExtra, in no particular order. Finds
+  the nodes' group with one hash lookup, so the time taken grows with
+  the number of nodes found rather than the number indexed. pfVisit
+  must not link or unlink nodes. Returns SUCCESS if every node was
+  visited, and otherwise stops and returns the first other status
+  that pfVisit returned.
+*/
+int Node_findByName(const char *pcName,
+                    int (*pfVisit)(Node_T oNNode, void *pvExtra),
+                    void *pvExtra);
+
+/*
+  Starts keeping the trigram index over the contents of the files in
+  the name index, which must be kept, if it is not already kept. From
+  then on, files that join or leave the name index join or leave it
+  too. Returns SUCCESS, or MEMORY_ERROR if memory could not be
+  allocated.
+*/
+int Node_startTextIndex(void);
+
+/* Stops keeping the trigram index, if it is kept, and frees it. */
+void Node_stopTextIndex(void);
+
+/*
+  Returns TRUE if the trigram index is kept and holds every file in
+  the name index, and FALSE otherwise: a file that could not be added
+  for want of memory leaves the index in use only for upkeep, until it
+  is stopped.
+*/
+boolean Node_hasTextIndex(void);
+
+/*
+  Passes each file in the trigram index, which must hold every file in
+  the name index, that may contain the ulLength bytes at pvPattern to
+  pfVisit, along with pvExtra, in no particular order. Every file that
+  contains them is passed, but so may be some that do not, so pfVisit
+  must check. Files changed since the last search are indexed afresh
+  first. pfVisit must not link, unlink, or change nodes. Returns
+  SUCCESS if every candidate was visited, and otherwise stops and
+  returns MEMORY_ERROR if memory could not be allocated, IO_ERROR if
+  spilled contents could not be brought back, or the first other
+  status that pfVisit returned.
+*/
+int Node_searchText(const void *pvPattern, size_t ulLength,
+                    int (*pfVisit)(Node_T oNNode, void *pvExtra),
+                    void *pvExtra);
+
+/*
+  Starts keeping the path filter over the absolute paths of the nodes
+  in the name index, which must be kept, sized for ulPaths paths
+  (at least 1) and grown as more are added, restarting it if it is
+  already kept. From then on, nodes that join or leave the name index
+  add or remove their paths, and a move trades each path in the moved
+  subtree for its new one. Returns SUCCESS, or MEMORY_ERROR if memory
+  could not be allocated.
+*/
+int Node_startPathFilter(size_t ulPaths);
+
+/* Stops keeping the path filter, if it is kept, and frees it. */
+void Node_stopPathFilter(void);
+
+/* Returns TRUE if the path filter is kept and FALSE otherwise. */
+boolean Node_hasPathFilter(void);
+
+/*
+  Returns FALSE if no node in the name index has the absolute path
+  pcPath, and TRUE if one may, or if the path filter is not kept. The
+  answer costs one hash of pcPath, which need not be well-formed.
+*/
+boolean Node_mayHavePath(const char *pcPath);
+
+/*
+  Sets *pulPaths to the number of paths in the path filter, which must
+  be kept, *pulCounters to its number of counters, and *pulQueries and
+  *pulRejections to the numbers of paths asked about and of those it
+  found absent since it was started.
+*/
+void Node_getPathFilterStats(size_t *pulPaths, size_t *pulCounters,
+                             size_t *pulQueries,
+                             size_t *pulRejections);
 
 /*-------------------------------------------------------------------*/
 
@@ -0,0 +1,653 @@
+/*-------------------------------------------------------------------*/
+/* snapshot.c                                                        */
+/* Author: Hugh Peterson                                             */
+/*-------------------------------------------------------------------*/
+
+#define _XOPEN_SOURCE 700
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "a4def.h"
+#include "path.h"
+#include "nodeFT.h"
+#include "traverse.h"
+#include "snapshot.h"
+
+/*-------------------------------------------------------------------*/
+
+/* The magic string that every snapshot starts with */
+static const char acMagic[] = "FTSNAP2\n";
+
+/* The state of a snapshot being written */
+struct saver {
+   /* the file being written */
+   FILE *psFile;
+   /* the name in the previous record, for front coding */
+   const char *pcPrev;
+   /* FALSE once some contents could not be brought into memory */
+   boolean isOk;
+};
+
+/* A file whose contents have yet to be read from a snapshot */
+struct pending {
+   /* the file node */
+   Node_T oNFile;
+   /* the length of its contents */
+   size_t ulLength;
+};
+
+/* A directory whose children are still being read from a snapshot */
+struct open {
+   /* the directory, not yet linked to its parent */
+   Node_T oNDir;
+   /* the number of its children still to be read */
+   size_t ulLeft;
+};
+
+/* The state of a snapshot being read */
+struct loader {
+   /* the next unread byte of the snapshot's mapping, and the end of
+      the mapping */
+   unsigned char *pucNext;
+   unsigned char *pucEnd;
+   /* the name in the previous record, for front coding, with its
+      length and the number of bytes allocated for it */
+   char *pcName;
+   size_t ulNameLength;
+   size_t ulNameCap;
+   /* the files whose contents are still to be read, in preorder */
+   struct pending *psBodies;
+   size_t ulBodies;
+   size_t ulBodyCap;
+   /* the directories on the path to the node being read whose
+      children are not all read yet, from the root down, their
+      number, and the number allocated */
+   struct open *psOpen;
+   size_t ulDepth;
+   size_t ulOpenCap;
+   /* the number of nodes the snapshot declares and has built so far */
+   size_t ulExpected;
+   size_t ulCount;
+};
+
+/*-------------------------------------------------------------------*/
+
+/* Writes ulValue to psFile as an unsigned LEB128 varint. */
+static void Snapshot_putVarint(FILE *psFile, size_t ulValue) {
+   assert(psFile != NULL);
+
+   while(ulValue >= 0x80) {
+      (void) putc((int) ((ulValue & 0x7F) | 0x80), psFile);
+      ulValue >>= 7;
+   }
+   (void) putc((int) ulValue, psFile);
+}
+
+/*
+  Reads an unsigned LEB128 varint from psLoader's snapshot into
+  *pulValue. Returns SUCCESS, or IO_ERROR if the snapshot ends first
+  or the value does not fit in a size_t.
+*/
+static int Snapshot_getVarint(struct loader *psLoader,
+                              size_t *pulValue) {
+   size_t value = 0;
+   size_t shift = 0;
+   unsigned char c;
+
+   assert(psLoader != NULL);
+   assert(pulValue != NULL);
+
+   do {
+      if(psLoader->pucNext == psLoader->pucEnd ||
+         shift >= sizeof(size_t) * 8)
+         return IO_ERROR;
+      c = *psLoader->pucNext++;
+      value |= (size_t) (c & 0x7F) << shift;
+      shift += 7;
+   } while(c & 0x80);
+
+   *pulValue = value;
+   return SUCCESS;
+}
+
+/* Returns the number of children of pvNode, for Traverse_walk. */
+static size_t Snapshot_getNumChildren(void *pvNode) {
+   return Node_getNumChildren(pvNode);
+}
+
+/*
+  Sets *ppvChild to the child of pvNode with index ulIndex, for
+  Traverse_walk, and returns Node_getChild's status.
+*/
+static int Snapshot_getChild(void *pvNode, size_t ulIndex,
+                             void **ppvChild) {
+   Node_T child = NULL;
+   int status;
+
+   assert(ppvChild != NULL);
+
+   status = Node_getChild(pvNode, ulIndex, &child);
+   *ppvChild = child;
+   return status;
+}
+
+/*
+  Writes the record for node pvNode with saver pvSaver, for a
+  pre-order Traverse_walk. Returns SUCCESS.
+*/
+static int Snapshot_saveNode(void *pvNode, void *pvSaver) {
+   struct saver *saver = pvSaver;
+   const char *name;
+   size_t shared = 0;
+   size_t nameLength;
+
+   assert(pvNode != NULL);
+   assert(saver != NULL);
+
+   name = Node_getName(pvNode);
+   nameLength = strlen(name);
+   if(saver->pcPrev != NULL) {
+      while(name[shared] != '\0' &&
+            name[shared] == saver->pcPrev[shared])
+         shared++;
+   }
+   saver->pcPrev = name;
+
+   Snapshot_putVarint(saver->psFile,
+                      (Node_getNumChildren(pvNode) << 1) |
+                      (Node_isFile(pvNode) ? 1 : 0));
+   Snapshot_putVarint(saver->psFile, shared);
+   Snapshot_putVarint(saver->psFile, nameLength - shared);
+   (void) fwrite(name + shared, 1, nameLength - shared, saver->psFile);
+   if(Node_isFile(pvNode))
+      Snapshot_putVarint(saver->psFile, Node_getLength(pvNode));
+   return SUCCESS;
+}
+
+/*
+  Writes the contents of node pvNode, if it is a file, with saver
+  pvSaver, for a pre-order Traverse_walk. Returns SUCCESS.
+*/
+static int Snapshot_saveContents(void *pvNode, void *pvSaver) {
+   struct saver *saver = pvSaver;
+   void *contents;
+
+   assert(pvNode != NULL);
+   assert(saver != NULL);
+
+   if(!Node_isFile(pvNode) || Node_getLength(pvNode) == 0)
+      return SUCCESS;
+
+   contents = Node_getContents(pvNode);
+   if(contents == NULL)
+      saver->isOk = FALSE;
+   else
+      (void) fwrite(contents, 1, Node_getLength(pvNode), saver->psFile);
+   return SUCCESS;
+}
+
+/*
+  Writes a snapshot of the tree rooted at oNRoot (which may be NULL
+  for an empty tree) of ulCount nodes to the file pcFile, labeled with
+  checkpoint generation ulGeneration. The snapshot is written and
+  flushed to disk in a temporary file that then replaces pcFile, so
+  pcFile is never left half written, and mappings of the old pcFile
+  stay valid. Returns SUCCESS, or IO_ERROR if the file could not be
+  written (or MEMORY_ERROR if memory could not be allocated).
+*/
+int Snapshot_save(const char *pcFile, Node_T oNRoot, size_t ulCount,
+                  size_t ulGeneration) {
+   struct saver saver;
+   char *tempFile;
+   boolean isOk;
+   int status;
+
+   assert(pcFile != NULL);
+
+   tempFile = malloc(strlen(pcFile) + sizeof(".tmp"));
+   if(tempFile == NULL)
+      return MEMORY_ERROR;
+   strcpy(tempFile, pcFile);
+   strcat(tempFile, ".tmp");
+
+   saver.psFile = fopen(tempFile, "wb");
+   if(saver.psFile == NULL) {
+      free(tempFile);
+      return IO_ERROR;
+   }
+   saver.pcPrev = NULL;
+   saver.isOk = TRUE;
+
+   (void) fwrite(acMagic, 1, sizeof(acMagic) - 1, saver.psFile);
+   Snapshot_putVarint(saver.psFile, ulGeneration);
+   Snapshot_putVarint(saver.psFile, ulCount);
+   /* the records, and then the contents, are written in preorder by
+      walks that keep their own stacks, so that a deep tree cannot
+      overflow the call stack */
+   status = Traverse_walk(oNRoot, TRAVERSE_PRE_ORDER,
+                          Snapshot_getNumChildren, Snapshot_getChild,
+                          Snapshot_saveNode, &saver);
+   if(status == SUCCESS)
+      status = Traverse_walk(oNRoot, TRAVERSE_PRE_ORDER,
+                             Snapshot_getNumChildren, Snapshot_getChild,
+                             Snapshot_saveContents, &saver);
+
+   isOk = (boolean) (status == SUCCESS && saver.isOk &&
+                     fflush(saver.psFile) == 0 &&
+                     fsync(fileno(saver.psFile)) == 0);
+   if(fclose(saver.psFile) != 0)
+      isOk = FALSE;
+   if(isOk && rename(tempFile, pcFile) != 0)
+      isOk = FALSE;
+   if(!isOk)
+      (void) remove(tempFile);
+   free(tempFile);
+   if(status != SUCCESS)
+      return status;
+   return isOk ? SUCCESS : IO_ERROR;
+}
+
+/*-------------------------------------------------------------------*/
+
+/*
+  Reads the next record into a new node that is not yet linked to any
+  parent. Sets *poNResult to the new node as soon as it is built, or
+  to NULL if it is not, and *pulChildren to the number of children it
+  declares. Returns SUCCESS, or:
+  * IO_ERROR if the snapshot ends early or its records are invalid
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+static int Snapshot_loadNode(struct loader *psLoader,
+                             Node_T *poNResult, size_t *pulChildren) {
+   size_t header, shared, suffix;
+   Node_T node = NULL;
+   struct pending *pending;
+   int status;
+
+   assert(psLoader != NULL);
+   assert(poNResult != NULL);
+   assert(pulChildren != NULL);
+
+   *poNResult = NULL;
+   if(Snapshot_getVarint(psLoader, &header) != SUCCESS ||
+      Snapshot_getVarint(psLoader, &shared) != SUCCESS ||
+      Snapshot_getVarint(psLoader, &suffix) != SUCCESS)
+      return IO_ERROR;
+   if(shared > psLoader->ulNameLength || (header & 1 && header > 1) ||
+      suffix > (size_t) (psLoader->pucEnd - psLoader->pucNext) ||
+      psLoader->ulCount == psLoader->ulExpected)
+      return IO_ERROR;
+
+   /* rebuild the name from the previous one */
+   if(shared + suffix + 1 > psLoader->ulNameCap) {
+      char *grown = realloc(psLoader->pcName, shared + suffix + 1);
+      if(grown == NULL)
+         return MEMORY_ERROR;
+      psLoader->pcName = grown;
+      psLoader->ulNameCap = shared + suffix + 1;
+   }
+   memcpy(psLoader->pcName + shared, psLoader->pucNext, suffix);
+   psLoader->pucNext += suffix;
+   psLoader->pcName[shared + suffix] = '\0';
+   psLoader->ulNameLength = shared + suffix;
+   if(strlen(psLoader->pcName) != psLoader->ulNameLength)
+      return IO_ERROR;
+
+   status = Node_newChild(NULL, psLoader->pcName,
+                          (boolean) (header & 1), &node);
+   if(status != SUCCESS)
+      return status == MEMORY_ERROR ? MEMORY_ERROR : IO_ERROR;
+   psLoader->ulCount++;
+   *poNResult = node;
+
+   /* remember the file so its contents can be found afterward */
+   if(header & 1) {
+      if(psLoader->ulBodies == psLoader->ulBodyCap) {
+         size_t newCap = psLoader->ulBodyCap * 2 + 16;
+         struct pending *grown = realloc(psLoader->psBodies,
+                                         newCap * sizeof(*grown));
+         if(grown == NULL)
+            return MEMORY_ERROR;
+         psLoader->psBodies = grown;
+         psLoader->ulBodyCap = newCap;
+      }
+      pending = &psLoader->psBodies[psLoader->ulBodies];
+      pending->oNFile = node;
+      if(Snapshot_getVarint(psLoader, &pending->ulLength) != SUCCESS)
+         return IO_ERROR;
+      psLoader->ulBodies++;
+   }
+
+   *pulChildren = header >> 1;
+   return SUCCESS;
+}
+
+/*
+  Reads the records of the whole tree, in preorder. Instead of
+  recursing, keeps the directories whose children are still being
+  read on a stack of its own, so that a snapshot of a deep tree, or
+  one crafted to look deep, cannot overflow the call stack. Each node
+  is linked to its parent only once its own subtree is complete, while
+  the parent itself is still unlinked, so that no node's totals are
+  carried further up than one level. Sets *poNRoot to the root if
+  successful. Otherwise, frees every node built, sets *poNRoot to
+  NULL, and returns the statuses of Snapshot_loadNode.
+*/
+static int Snapshot_loadTree(struct loader *psLoader, Node_T *poNRoot) {
+   Node_T node = NULL;
+   size_t children;
+   struct open *top;
+   struct open *grown;
+   size_t newCap;
+   int status;
+
+   assert(psLoader != NULL);
+   assert(poNRoot != NULL);
+
+   *poNRoot = NULL;
+   for(;;) {
+      status = Snapshot_loadNode(psLoader, &node, &children);
+      if(status != SUCCESS)
+         break;
+
+      if(children != 0) {
+         /* read node's children next */
+         if(psLoader->ulDepth == psLoader->ulOpenCap) {
+            newCap = psLoader->ulOpenCap * 2 + 16;
+            grown = realloc(psLoader->psOpen, newCap * sizeof(*grown));
+            if(grown == NULL) {
+               status = MEMORY_ERROR;
+               break;
+            }
+            psLoader->psOpen = grown;
+            psLoader->ulOpenCap = newCap;
+         }
+         psLoader->psOpen[psLoader->ulDepth].oNDir = node;
+         psLoader->psOpen[psLoader->ulDepth].ulLeft = children;
+         psLoader->ulDepth++;
+         node = NULL;
+         continue;
+      }
+
+      /* node is complete: link it, and then every directory that it
+         completes in turn, to its parent */
+      while(psLoader->ulDepth != 0) {
+         top = &psLoader->psOpen[psLoader->ulDepth - 1];
+         status = Node_attach(node, top->oNDir);
+         if(status != SUCCESS)
+            break;
+         node = NULL;
+         if(--top->ulLeft != 0)
+            break;
+         node = top->oNDir;
+         psLoader->ulDepth--;
+      }
+      if(status != SUCCESS || psLoader->ulDepth == 0)
+         break;
+   }
+
+   if(status == SUCCESS) {
+      *poNRoot = node;
+      return SUCCESS;
+   }
+
+   if(status != MEMORY_ERROR)
+      status = IO_ERROR;
+   if(node != NULL)
+      (void) Node_free(node);
+   while(psLoader->ulDepth != 0)
+      (void) Node_free(psLoader->psOpen[--psLoader->ulDepth].oNDir);
+   return status;
+}
+
+/*
+  Gives the pending files their contents from the contents section of
+  the snapshot: if isMapped, the contents are left in place in the
+  mapping; otherwise, they are copied into heap buffers owned by the
+  nodes. Returns SUCCESS, or:
+  * IO_ERROR if the snapshot ends early
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+static int Snapshot_loadContents(struct loader *psLoader,
+                                 boolean isMapped) {
+   size_t i;
+   size_t length;
+   void *contents;
+
+   assert(psLoader != NULL);
+
+   for(i = 0; i < psLoader->ulBodies; i++) {
+      length = psLoader->psBodies[i].ulLength;
+      if(length > (size_t) (psLoader->pucEnd - psLoader->pucNext))
+         return IO_ERROR;
+      if(length == 0)
+         continue;
+
+      if(isMapped) {
+         Node_mapContents(psLoader->psBodies[i].oNFile,
+                          psLoader->pucNext, length);
+      }
+      else {
+         contents = malloc(length);
+         if(contents == NULL)
+            return MEMORY_ERROR;
+         memcpy(contents, psLoader->pucNext, length);
+         Node_adoptContents(psLoader->psBodies[i].oNFile, contents,
+                            length);
+      }
+      psLoader->pucNext += length;
+   }
+   return SUCCESS;
+}
+
+/*
+  Maps the whole file pcFile privately into memory, setting *ppvMap
+  to the mapping and *pulMapLength to its length. Pages are read in
+  on demand and stay shared with every other mapping of the file until
+  they are written to. Returns SUCCESS, or IO_ERROR if the file could
+  not be mapped (or is empty).
+*/
+static int Snapshot_mapFile(const char *pcFile, void **ppvMap,
+                            size_t *pulMapLength) {
+   int fd;
+   struct stat info;
+   void *map;
+
+   assert(pcFile != NULL);
+   assert(ppvMap != NULL);
+   assert(pulMapLength != NULL);
+
+   fd = open(pcFile, O_RDONLY);
+   if(fd == -1)
+      return IO_ERROR;
+   if(fstat(fd, &info) == -1 || info.st_size <= 0) {
+      (void) close(fd);
+      return IO_ERROR;
+   }
+
+   map = mmap(NULL, (size_t) info.st_size, PROT_READ | PROT_WRITE,
+              MAP_PRIVATE, fd, 0);
+   (void) close(fd);
+   if(map == MAP_FAILED)
+      return IO_ERROR;
+
+   *ppvMap = map;
+   *pulMapLength = (size_t) info.st_size;
+   return SUCCESS;
+}
+
+/*
+  Builds a tree from the snapshot in the file pcFile, leaving file
+  contents in the file's mapping if isMapped, or copying them to the
+  heap otherwise. On success, sets *poNRoot, *pulCount, *ppvMap, and
+  *pulMapLength as for Snapshot_map; the mapping must be released with
+  Snapshot_unmap. On failure, builds and maps nothing. Returns the
+  same statuses as Snapshot_load.
+*/
+static int Snapshot_build(const char *pcFile, boolean isMapped,
+                          Node_T *poNRoot, size_t *pulCount,
+                          void **ppvMap, size_t *pulMapLength) {
+   struct loader loader;
+   void *map;
+   size_t mapLength;
+   size_t generation;
+   Node_T newRoot = NULL;
+   int status;
+
+   assert(pcFile != NULL);
+   assert(poNRoot != NULL);
+   assert(pulCount != NULL);
+   assert(ppvMap != NULL);
+   assert(pulMapLength != NULL);
+
+   status = Snapshot_mapFile(pcFile, &map, &mapLength);
+   if(status != SUCCESS)
+      return status;
+   /* the snapshot is read once, front to back */
+   (void) posix_madvise(map, mapLength, POSIX_MADV_SEQUENTIAL);
+
+   loader.pucNext = map;
+   loader.pucEnd = loader.pucNext + mapLength;
+   loader.pcName = NULL;
+   loader.ulNameLength = 0;
+   loader.ulNameCap = 0;
+   loader.psBodies = NULL;
+   loader.ulBodies = 0;
+   loader.ulBodyCap = 0;
+   loader.psOpen = NULL;
+   loader.ulDepth = 0;
+   loader.ulOpenCap = 0;
+   loader.ulCount = 0;
+
+   if(mapLength < sizeof(acMagic) - 1 ||
+      memcmp(map, acMagic, sizeof(acMagic) - 1) != 0)
+      status = IO_ERROR;
+   else {
+      loader.pucNext += sizeof(acMagic) - 1;
+      status = Snapshot_getVarint(&loader, &generation);
+      if(status == SUCCESS)
+         status = Snapshot_getVarint(&loader, &loader.ulExpected);
+   }
+
+   if(status == SUCCESS && loader.ulExpected != 0)
+      status = Snapshot_loadTree(&loader, &newRoot);
+   if(status == SUCCESS && loader.ulCount != loader.ulExpected)
+      status = IO_ERROR;
+   if(status == SUCCESS)
+      status = Snapshot_loadContents(&loader, isMapped);
+
+   free(loader.pcName);
+   free(loader.psBodies);
+   free(loader.psOpen);
+
+   if(status != SUCCESS) {
+      if(newRoot != NULL)
+         (void) Node_free(newRoot);
+      (void) munmap(map, mapLength);
+      return status;
+   }
+
+   *poNRoot = newRoot;
+   *pulCount = loader.ulCount;
+   *ppvMap = map;
+   *pulMapLength = mapLength;
+   return SUCCESS;
+}
+
+/*
+  Reads the snapshot in the file pcFile, building its nodes directly
+  under their parents. File contents are copied into heap buffers
+  owned by the nodes. Returns SUCCESS and sets *poNRoot to the root of
+  the new tree (NULL if it is empty) and *pulCount to its number of
+  nodes. Otherwise, builds nothing and returns:
+  * IO_ERROR if the file could not be read or is not a valid snapshot
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int Snapshot_load(const char *pcFile, Node_T *poNRoot,
+                  size_t *pulCount) {
+   void *map;
+   size_t mapLength;
+   int status;
+
+   status = Snapshot_build(pcFile, FALSE, poNRoot, pulCount, &map,
+                           &mapLength);
+   if(status == SUCCESS)
+      Snapshot_unmap(map, mapLength);
+   return status;
+}
+
+/*
+  Like Snapshot_load, but leaves file contents in place in a private
+  mapping of pcFile instead of copying them, so that only the node
+  records are built up front and contents are paged in from the file
+  when first touched. Also sets *ppvMap to the mapping and
+  *pulMapLength to its length. The mapping must outlive every node of
+  the tree that still refers to it, and is then released with
+  Snapshot_unmap. Each node is still built on the heap from its
+  record, since a node's parent link, totals, hash, and index and
+  cache links change with the tree and so cannot live in the mapping.
+*/
+int Snapshot_map(const char *pcFile, Node_T *poNRoot, size_t *pulCount,
+                 void **ppvMap, size_t *pulMapLength) {
+   return Snapshot_build(pcFile, TRUE, poNRoot, pulCount, ppvMap,
+                         pulMapLength);
+}
+
+/*
+  Releases the mapping pvMap of length ulMapLength made by
+  Snapshot_map.
+*/
+void Snapshot_unmap(void *pvMap, size_t ulMapLength) {
+   assert(pvMap != NULL);
+
+   (void) munmap(pvMap, ulMapLength);
+}
+
+/*
+  Sets *pulGeneration to the checkpoint generation of the snapshot in
+  the file pcFile. Returns SUCCESS, or:
+  * NO_SUCH_PATH if there is no file pcFile
+  * IO_ERROR if the file could not be read or is not a valid snapshot
+*/
+int Snapshot_getGeneration(const char *pcFile, size_t *pulGeneration) {
+   FILE *psFile;
+   char magic[sizeof(acMagic) - 1];
+   size_t value = 0;
+   size_t shift = 0;
+   int c;
+
+   assert(pcFile != NULL);
+   assert(pulGeneration != NULL);
+
+   psFile = fopen(pcFile, "rb");
+   if(psFile == NULL)
+      return errno == ENOENT ? NO_SUCH_PATH : IO_ERROR;
+
+   if(fread(magic, 1, sizeof(magic), psFile) != sizeof(magic) ||
+      memcmp(magic, acMagic, sizeof(magic)) != 0) {
+      (void) fclose(psFile);
+      return IO_ERROR;
+   }
+   do {
+      c = getc(psFile);
+      if(c == EOF || shift >= sizeof(size_t) * 8) {
+         (void) fclose(psFile);
+         return IO_ERROR;
+      }
+      value |= (size_t) (c & 0x7F) << shift;
+      shift += 7;
+   } while(c & 0x80);
+
+   (void) fclose(psFile);
+   *pulGeneration = value;
+   return SUCCESS;
+}
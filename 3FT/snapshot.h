@@ -0,0 +1,81 @@
+/*-------------------------------------------------------------------*/
+/* snapshot.h                                                        */
+/* Author: Hugh Peterson                                             */
+/*-------------------------------------------------------------------*/
+
+#ifndef SNAPSHOT_INCLUDED
+#define SNAPSHOT_INCLUDED
+
+#include <stddef.h>
+#include "a4def.h"
+#include "nodeFT.h"
+
+/*
+  A snapshot is a compact binary image of a File Tree. It starts with
+  a magic string, the checkpoint generation of the journal it was
+  taken for (0 if none), and the number of nodes, followed by one
+  record per node in preorder (children in sorted order), followed by
+  the contents of every file in the same order. Each record holds:
+  * a header, (number of children << 1) | (1 if a file, else 0)
+  * the node's name, front-coded against the previous record's name:
+    the length of the shared prefix, then the length and bytes of the
+    rest of the name
+  * for a file, the length of its contents
+  All numbers are unsigned LEB128 varints.
+*/
+
+/*-------------------------------------------------------------------*/
+
+/*
+  Writes a snapshot of the tree rooted at oNRoot (which may be NULL
+  for an empty tree) of ulCount nodes to the file pcFile, labeled with
+  checkpoint generation ulGeneration. The snapshot is written and
+  flushed to disk in a temporary file that then replaces pcFile, so
+  pcFile is never left half written, and mappings of the old pcFile
+  stay valid. Returns SUCCESS, or IO_ERROR if the file could not be
+  written (or MEMORY_ERROR if memory could not be allocated).
+*/
+int Snapshot_save(const char *pcFile, Node_T oNRoot, size_t ulCount,
+                  size_t ulGeneration);
+
+/*
+  Reads the snapshot in the file pcFile, building its nodes directly
+  under their parents. File contents are copied into heap buffers
+  owned by the nodes. Returns SUCCESS and sets *poNRoot to the root of
+  the new tree (NULL if it is empty) and *pulCount to its number of
+  nodes. Otherwise, builds nothing and returns:
+  * IO_ERROR if the file could not be read or is not a valid snapshot
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int Snapshot_load(const char *pcFile, Node_T *poNRoot,
+                  size_t *pulCount);
+
+/*
+  Like Snapshot_load, but leaves file contents in place in a private
+  mapping of pcFile instead of copying them, so that only the node
+  records are built up front and contents are paged in from the file
+  when first touched. Also sets *ppvMap to the mapping and
+  *pulMapLength to its length. The mapping must outlive every node of
+  the tree that still refers to it, and is then released with
+  Snapshot_unmap. Each node is still built on the heap from its
+  record, since a node's parent link, totals, hash, and index and
+  cache links change with the tree and so cannot live in the mapping.
+*/
+int Snapshot_map(const char *pcFile, Node_T *poNRoot, size_t *pulCount,
+                 void **ppvMap, size_t *pulMapLength);
+
+/*
+  Releases the mapping pvMap of length ulMapLength made by
+  Snapshot_map.
+*/
+void Snapshot_unmap(void *pvMap, size_t ulMapLength);
+
+/*
+  Sets *pulGeneration to the checkpoint generation of the snapshot in
+  the file pcFile. Returns SUCCESS, or:
+  * NO_SUCH_PATH if there is no file pcFile
+  * IO_ERROR if the file could not be read or is not a valid snapshot
+*/
+int Snapshot_getGeneration(const char *pcFile, size_t *pulGeneration);
+
+#endif
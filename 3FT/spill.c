@@ -0,0 +1,214 @@
+/*-------------------------------------------------------------------*/
+/* spill.c                                                           */
+/* Author: Hugh Peterson                                             */
+/*-------------------------------------------------------------------*/
+
+#define _XOPEN_SOURCE 700
+
+#include <assert.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "a4def.h"
+#include "spill.h"
+
+/*-------------------------------------------------------------------*/
+
+/*
+  The spill store is an abstract object with 4 state variables:
+*/
+
+/* 1. the backing file's descriptor, or -1 if the store is closed */
+static int iFd = -1;
+/* 2. the offset just past the last reserved region */
+static size_t ulEnd;
+/* 3. the body length above which bodies belong in the store */
+static size_t ulSpillThreshold;
+/* 4. the size of a memory page, which mappings must be aligned to */
+static size_t ulPageSize;
+
+/*-------------------------------------------------------------------*/
+
+/*
+  Creates the backing file pcFile (truncating it if it exists) and
+  opens the spill store on it. Bodies longer than ulThreshold bytes
+  should be kept in the store. The file is unlinked right away, so it
+  never outlives the process. Returns SUCCESS, or:
+  * INITIALIZATION_ERROR if the store is already open
+  * IO_ERROR if the backing file could not be created
+*/
+int Spill_open(const char *pcFile, size_t ulThreshold) {
+   assert(pcFile != NULL);
+
+   if(iFd != -1)
+      return INITIALIZATION_ERROR;
+
+   iFd = open(pcFile, O_RDWR | O_CREAT | O_TRUNC, 0600);
+   if(iFd == -1)
+      return IO_ERROR;
+   (void) unlink(pcFile);
+
+   ulEnd = 0;
+   ulSpillThreshold = ulThreshold;
+   ulPageSize = (size_t) sysconf(_SC_PAGESIZE);
+   return SUCCESS;
+}
+
+/*
+  Closes the spill store, releasing its backing file. Every region
+  must already be unmapped.
+*/
+void Spill_close(void) {
+   if(iFd != -1) {
+      (void) close(iFd);
+      iFd = -1;
+   }
+   ulEnd = 0;
+}
+
+/* Returns TRUE if the spill store is open and FALSE otherwise. */
+boolean Spill_isOpen(void) {
+   return (boolean) (iFd != -1);
+}
+
+/* Returns the threshold given to Spill_open. */
+size_t Spill_getThreshold(void) {
+   return ulSpillThreshold;
+}
+
+/*
+  Reserves a new zero-filled region of ulCapacity bytes at the end of
+  the backing file and sets *pulOffset to its offset. Returns SUCCESS,
+  or IO_ERROR if the file could not be extended.
+*/
+int Spill_alloc(size_t ulCapacity, size_t *pulOffset) {
+   assert(iFd != -1);
+   assert(pulOffset != NULL);
+
+   if(ftruncate(iFd, (off_t) (ulEnd + ulCapacity)) == -1)
+      return IO_ERROR;
+
+   *pulOffset = ulEnd;
+   ulEnd += ulCapacity;
+   return SUCCESS;
+}
+
+/*
+  Writes the ulLength bytes at pvData into the backing file at byte
+  ulOffset. Returns SUCCESS, or IO_ERROR if the write failed.
+*/
+int Spill_write(size_t ulOffset, const void *pvData, size_t ulLength) {
+   const char *pcData = pvData;
+   ssize_t written;
+
+   assert(iFd != -1);
+   assert(pvData != NULL || ulLength == 0);
+
+   while(ulLength != 0) {
+      written = pwrite(iFd, pcData, ulLength, (off_t) ulOffset);
+      if(written <= 0)
+         return IO_ERROR;
+      pcData += written;
+      ulOffset += (size_t) written;
+      ulLength -= (size_t) written;
+   }
+   return SUCCESS;
+}
+
+/*
+  Reads ulLength bytes of the backing file at byte ulOffset into
+  pvBuf. Returns SUCCESS, or IO_ERROR if the read failed.
+*/
+int Spill_read(size_t ulOffset, void *pvBuf, size_t ulLength) {
+   char *pcBuf = pvBuf;
+   ssize_t nRead;
+
+   assert(iFd != -1);
+   assert(pvBuf != NULL || ulLength == 0);
+
+   while(ulLength != 0) {
+      nRead = pread(iFd, pcBuf, ulLength, (off_t) ulOffset);
+      if(nRead <= 0)
+         return IO_ERROR;
+      pcBuf += nRead;
+      ulOffset += (size_t) nRead;
+      ulLength -= (size_t) nRead;
+   }
+   return SUCCESS;
+}
+
+/*
+  Copies ulLength bytes of the backing file from byte ulFrom to byte
+  ulTo, without staging the whole range on the heap. Returns SUCCESS,
+  MEMORY_ERROR if no staging chunk could be allocated, or IO_ERROR if
+  the copy failed.
+*/
+int Spill_copy(size_t ulFrom, size_t ulTo, size_t ulLength) {
+   enum {CHUNK_SIZE = 65536};
+   char *pcChunk;
+   size_t chunk;
+   int status = SUCCESS;
+
+   assert(iFd != -1);
+
+   pcChunk = malloc(CHUNK_SIZE);
+   if(pcChunk == NULL)
+      return MEMORY_ERROR;
+
+   while(ulLength != 0 && status == SUCCESS) {
+      chunk = ulLength < CHUNK_SIZE ? ulLength : CHUNK_SIZE;
+      status = Spill_read(ulFrom, pcChunk, chunk);
+      if(status == SUCCESS)
+         status = Spill_write(ulTo, pcChunk, chunk);
+      ulFrom += chunk;
+      ulTo += chunk;
+      ulLength -= chunk;
+   }
+
+   free(pcChunk);
+   return status;
+}
+
+/*
+  Maps the ulLength bytes of the backing file at byte ulOffset into
+  memory and sets *ppvData to the first of them. Writes through the
+  mapping and through Spill_write are visible to each other. Returns
+  SUCCESS, or IO_ERROR (setting *ppvData to NULL) if the mapping
+  failed.
+*/
+int Spill_map(size_t ulOffset, size_t ulLength, void **ppvData) {
+   size_t delta;
+   void *pvBase;
+
+   assert(iFd != -1);
+   assert(ulLength != 0);
+   assert(ppvData != NULL);
+
+   /* mappings must start on a page boundary */
+   delta = ulOffset % ulPageSize;
+   pvBase = mmap(NULL, ulLength + delta, PROT_READ | PROT_WRITE,
+                 MAP_SHARED, iFd, (off_t) (ulOffset - delta));
+   if(pvBase == MAP_FAILED) {
+      *ppvData = NULL;
+      return IO_ERROR;
+   }
+
+   *ppvData = (char *) pvBase + delta;
+   return SUCCESS;
+}
+
+/*
+  Unmaps a mapping made by Spill_map with the same ulOffset and
+  ulLength that returned pvData.
+*/
+void Spill_unmap(void *pvData, size_t ulOffset, size_t ulLength) {
+   size_t delta;
+
+   assert(pvData != NULL);
+
+   delta = ulOffset % ulPageSize;
+   (void) munmap((char *) pvData - delta, ulLength + delta);
+}
@@ -0,0 +1,86 @@
+/*-------------------------------------------------------------------*/
+/* spill.h                                                           */
+/* Author: Hugh Peterson                                             */
+/*-------------------------------------------------------------------*/
+
+#ifndef SPILL_INCLUDED
+#define SPILL_INCLUDED
+
+#include <stddef.h>
+#include "a4def.h"
+
+/*
+  The spill store is an append-only local backing file that holds
+  large file bodies outside of the heap. A body in the store is
+  identified by the byte offset of its region, and is either read
+  and written in place or mapped into memory on demand, so that the
+  kernel's page cache decides which bodies stay resident.
+*/
+
+/*-------------------------------------------------------------------*/
+
+/*
+  Creates the backing file pcFile (truncating it if it exists) and
+  opens the spill store on it. Bodies longer than ulThreshold bytes
+  should be kept in the store. The file is unlinked right away, so it
+  never outlives the process. Returns SUCCESS, or:
+  * INITIALIZATION_ERROR if the store is already open
+  * IO_ERROR if the backing file could not be created
+*/
+int Spill_open(const char *pcFile, size_t ulThreshold);
+
+/*
+  Closes the spill store, releasing its backing file. Every region
+  must already be unmapped.
+*/
+void Spill_close(void);
+
+/* Returns TRUE if the spill store is open and FALSE otherwise. */
+boolean Spill_isOpen(void);
+
+/* Returns the threshold given to Spill_open. */
+size_t Spill_getThreshold(void);
+
+/*
+  Reserves a new zero-filled region of ulCapacity bytes at the end of
+  the backing file and sets *pulOffset to its offset. Returns SUCCESS,
+  or IO_ERROR if the file could not be extended.
+*/
+int Spill_alloc(size_t ulCapacity, size_t *pulOffset);
+
+/*
+  Writes the ulLength bytes at pvData into the backing file at byte
+  ulOffset. Returns SUCCESS, or IO_ERROR if the write failed.
+*/
+int Spill_write(size_t ulOffset, const void *pvData, size_t ulLength);
+
+/*
+  Reads ulLength bytes of the backing file at byte ulOffset into
+  pvBuf. Returns SUCCESS, or IO_ERROR if the read failed.
+*/
+int Spill_read(size_t ulOffset, void *pvBuf, size_t ulLength);
+
+/*
+  Copies ulLength bytes of the backing file from byte ulFrom to byte
+  ulTo, without staging the whole range on the heap. Returns SUCCESS,
+  MEMORY_ERROR if no staging chunk could be allocated, or IO_ERROR if
+  the copy failed.
+*/
+int Spill_copy(size_t ulFrom, size_t ulTo, size_t ulLength);
+
+/*
+  Maps the ulLength bytes of the backing file at byte ulOffset into
+  memory and sets *ppvData to the first of them. Writes through the
+  mapping and through Spill_write are visible to each other. Returns
+  SUCCESS, or IO_ERROR (setting *ppvData to NULL) if the mapping
+  failed.
+*/
+int Spill_map(size_t ulOffset, size_t ulLength, void **ppvData);
+
+/*
+  Unmaps a mapping made by Spill_map with the same ulOffset and
+  ulLength that returned pvData.
+*/
+void Spill_unmap(void *pvData, size_t ulOffset, size_t ulLength);
+
+#endif
@@ -0,0 +1,503 @@
+/*-------------------------------------------------------------------*/
+/* trigram.c                                                         */
+/* Author: Hugh Peterson                                             */
+/*-------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "a4def.h"
+#include "trigram.h"
+
+/*-------------------------------------------------------------------*/
+
+/* The number of posting lists that trigrams are hashed to */
+enum {LIST_COUNT = 65536};
+
+/* A posting list */
+struct trigramList {
+   /* the identifiers of the documents in the list, in increasing
+      order, their number, and the number of slots allocated */
+   size_t *pulIDs;
+   size_t ulCount;
+   size_t ulCapacity;
+   /* the mark of the latest collection of trigrams that reached the
+      list */
+   size_t ulMark;
+};
+
+/* A slot for a document */
+struct trigramDoc {
+   /* the document, or NULL if the slot is free */
+   void *pvDoc;
+   /* the numbers of the posting lists the document is in, in
+      increasing order, and their number */
+   unsigned int *puiLists;
+   size_t ulLists;
+   /* Flag to indicate whether the document has changed since it was
+      last indexed */
+   boolean isStale;
+   /* Flag to indicate whether the slot is in the stale list, where it
+      stays even if it is freed until the next refresh */
+   boolean isListed;
+   /* for a free slot, the identifier of the next free slot, or 0 */
+   size_t ulNextFree;
+};
+
+/*
+  The trigram index is an abstract object with 5 state variables:
+*/
+
+/* 1. the posting lists, or NULL if the index is not kept */
+static struct trigramList *psLists;
+/* 2. the document slots (the slot for identifier n at index n - 1),
+      their number, and the identifier of the first free one, or 0 */
+static struct trigramDoc *psDocs;
+static size_t ulSlots;
+static size_t ulFreeSlot;
+/* 3. the identifiers of the slots in the stale list, and their
+      number; room is kept for every slot */
+static size_t *pulStale;
+static size_t ulStale;
+/* 4. the mark of the latest collection of trigrams */
+static size_t ulMark;
+/* 5. whether every document meant to be in the index is in it */
+static boolean isComplete;
+
+/*-------------------------------------------------------------------*/
+
+/*
+  Returns the number of the posting list for the trigram at pucBytes,
+  by Fibonacci hashing of its three bytes.
+*/
+static unsigned int Trigram_listOf(const unsigned char *pucBytes) {
+   unsigned long gram;
+
+   assert(pucBytes != NULL);
+
+   gram = (unsigned long) pucBytes[0] << 16 |
+          (unsigned long) pucBytes[1] << 8 | pucBytes[2];
+   return (unsigned int) ((gram * 2654435761UL >> 16) % LIST_COUNT);
+}
+
+/* Compares list numbers pvFirst and pvSecond, for qsort. */
+static int Trigram_compareLists(const void *pvFirst,
+                                const void *pvSecond) {
+   unsigned int first = *(const unsigned int *) pvFirst;
+   unsigned int second = *(const unsigned int *) pvSecond;
+
+   return first < second ? -1 : first > second;
+}
+
+/*
+  Sets *ppuiLists to a new array of the numbers of the posting lists
+  of the trigrams in the ulLength bytes at pvBytes, each once and in
+  increasing order, and *pulCount to their number (with *ppuiLists
+  NULL if there are none). Returns SUCCESS, or MEMORY_ERROR if the
+  array could not be allocated.
+*/
+static int Trigram_collect(const void *pvBytes, size_t ulLength,
+                           unsigned int **ppuiLists, size_t *pulCount) {
+   const unsigned char *bytes = pvBytes;
+   unsigned int *lists;
+   unsigned int list;
+   size_t most;
+   size_t i;
+
+   assert(pvBytes != NULL || ulLength == 0);
+   assert(ppuiLists != NULL);
+   assert(pulCount != NULL);
+
+   *ppuiLists = NULL;
+   *pulCount = 0;
+   if(ulLength < 3)
+      return SUCCESS;
+
+   most = ulLength - 2 < LIST_COUNT ? ulLength - 2 : LIST_COUNT;
+   lists = malloc(most * sizeof(unsigned int));
+   if(lists == NULL)
+      return MEMORY_ERROR;
+
+   /* each list is marked when first reached, so that it is taken only
+      once */
+   ulMark++;
+   for(i = 0; i + 2 < ulLength; i++) {
+      list = Trigram_listOf(bytes + i);
+      if(psLists[list].ulMark != ulMark) {
+         psLists[list].ulMark = ulMark;
+         lists[(*pulCount)++] = list;
+      }
+   }
+   qsort(lists, *pulCount, sizeof(unsigned int), Trigram_compareLists);
+
+   *ppuiLists = lists;
+   return SUCCESS;
+}
+
+/*
+  Returns TRUE if posting list psList holds identifier ulID, and FALSE
+  otherwise, setting *pulIndex to its index there, or to the index it
+  would be inserted at.
+*/
+static boolean Trigram_findID(const struct trigramList *psList,
+                              size_t ulID, size_t *pulIndex) {
+   size_t low = 0;
+   size_t high;
+   size_t middle;
+
+   assert(psList != NULL);
+   assert(pulIndex != NULL);
+
+   high = psList->ulCount;
+   while(low < high) {
+      middle = low + (high - low) / 2;
+      if(psList->pulIDs[middle] < ulID)
+         low = middle + 1;
+      else
+         high = middle;
+   }
+   *pulIndex = low;
+   return (boolean) (low < psList->ulCount &&
+                     psList->pulIDs[low] == ulID);
+}
+
+/*
+  Makes room in posting list psList for one more identifier. Returns
+  TRUE if successful, or FALSE if memory could not be allocated.
+*/
+static boolean Trigram_reserve(struct trigramList *psList) {
+   enum {MIN_CAPACITY = 4, GROWTH_FACTOR = 2};
+   size_t *grown;
+   size_t newCapacity;
+
+   assert(psList != NULL);
+
+   if(psList->ulCount < psList->ulCapacity)
+      return TRUE;
+   newCapacity = psList->ulCapacity == 0 ?
+                 MIN_CAPACITY : psList->ulCapacity * GROWTH_FACTOR;
+   grown = realloc(psList->pulIDs, newCapacity * sizeof(size_t));
+   if(grown == NULL)
+      return FALSE;
+   psList->pulIDs = grown;
+   psList->ulCapacity = newCapacity;
+   return TRUE;
+}
+
+/*
+  Inserts identifier ulID, which it does not hold, into posting list
+  psList, which must have room for it.
+*/
+static void Trigram_insertID(struct trigramList *psList, size_t ulID) {
+   size_t index;
+
+   assert(psList != NULL);
+   assert(psList->ulCount < psList->ulCapacity);
+
+   (void) Trigram_findID(psList, ulID, &index);
+   memmove(psList->pulIDs + index + 1, psList->pulIDs + index,
+           (psList->ulCount - index) * sizeof(size_t));
+   psList->pulIDs[index] = ulID;
+   psList->ulCount++;
+}
+
+/* Removes identifier ulID, which it holds, from posting list psList. */
+static void Trigram_removeID(struct trigramList *psList, size_t ulID) {
+   size_t index;
+
+   assert(psList != NULL);
+
+   if(!Trigram_findID(psList, ulID, &index))
+      return;
+   psList->ulCount--;
+   memmove(psList->pulIDs + index, psList->pulIDs + index + 1,
+           (psList->ulCount - index) * sizeof(size_t));
+}
+
+/*
+  Indexes the document with identifier ulID afresh, with the ulLength
+  bytes at pvBytes, moving it out of the posting lists of trigrams it
+  no longer has and into those of trigrams it now has. Returns
+  SUCCESS, or MEMORY_ERROR if memory could not be allocated, in which
+  case the document is left indexed as it was.
+*/
+static int Trigram_index(size_t ulID, const void *pvBytes,
+                         size_t ulLength) {
+   struct trigramDoc *doc;
+   unsigned int *lists;
+   size_t count;
+   size_t i = 0;
+   size_t j = 0;
+   int status;
+
+   doc = &psDocs[ulID - 1];
+   status = Trigram_collect(pvBytes, ulLength, &lists, &count);
+   if(status != SUCCESS)
+      return status;
+
+   /* make room first, so that a failure changes nothing */
+   for(j = 0; j < count; j++) {
+      if(!Trigram_reserve(&psLists[lists[j]])) {
+         free(lists);
+         return MEMORY_ERROR;
+      }
+   }
+
+   /* both arrays are in increasing order, so they are merged in one
+      pass, skipping the lists the document stays in */
+   j = 0;
+   while(i < doc->ulLists || j < count) {
+      if(j == count ||
+         (i < doc->ulLists && doc->puiLists[i] < lists[j]))
+         Trigram_removeID(&psLists[doc->puiLists[i++]], ulID);
+      else if(i == doc->ulLists || lists[j] < doc->puiLists[i])
+         Trigram_insertID(&psLists[lists[j++]], ulID);
+      else {
+         i++;
+         j++;
+      }
+   }
+
+   free(doc->puiLists);
+   doc->puiLists = lists;
+   doc->ulLists = count;
+   return SUCCESS;
+}
+
+/*-------------------------------------------------------------------*/
+
+/*
+  Starts keeping the index, empty, if it is not already kept. Returns
+  SUCCESS, or MEMORY_ERROR if memory could not be allocated.
+*/
+int Trigram_start(void) {
+   if(psLists != NULL)
+      return SUCCESS;
+
+   psLists = calloc(LIST_COUNT, sizeof(struct trigramList));
+   if(psLists == NULL)
+      return MEMORY_ERROR;
+   isComplete = TRUE;
+   return SUCCESS;
+}
+
+/* Stops keeping the index and frees it. */
+void Trigram_stop(void) {
+   size_t i;
+
+   if(psLists == NULL)
+      return;
+
+   for(i = 0; i < LIST_COUNT; i++)
+      free(psLists[i].pulIDs);
+   for(i = 0; i < ulSlots; i++)
+      free(psDocs[i].puiLists);
+   free(psLists);
+   free(psDocs);
+   free(pulStale);
+   psLists = NULL;
+   psDocs = NULL;
+   ulSlots = 0;
+   ulFreeSlot = 0;
+   pulStale = NULL;
+   ulStale = 0;
+}
+
+/* Returns TRUE if the index is kept and FALSE otherwise. */
+boolean Trigram_isStarted(void) {
+   return (boolean) (psLists != NULL);
+}
+
+/*
+  Returns TRUE if every document meant to be in the index, which must
+  be kept, is in it, and FALSE if Trigram_add failed for one since the
+  index was started.
+*/
+boolean Trigram_isComplete(void) {
+   assert(psLists != NULL);
+
+   return isComplete;
+}
+
+/*
+  Registers pvDoc as a new, stale document in the index, which must be
+  kept, and sets *pulID to its identifier, which is never 0. Returns
+  SUCCESS, or MEMORY_ERROR if memory could not be allocated, in which
+  case the index is no longer complete.
+*/
+int Trigram_add(void *pvDoc, size_t *pulID) {
+   enum {MIN_SLOTS = 16, GROWTH_FACTOR = 2};
+   struct trigramDoc *grownDocs;
+   size_t *grownStale;
+   size_t newSlots;
+   size_t i;
+
+   assert(psLists != NULL);
+   assert(pvDoc != NULL);
+   assert(pulID != NULL);
+
+   if(ulFreeSlot == 0) {
+      newSlots = ulSlots == 0 ? MIN_SLOTS : ulSlots * GROWTH_FACTOR;
+      grownDocs = realloc(psDocs, newSlots * sizeof(struct trigramDoc));
+      if(grownDocs != NULL)
+         psDocs = grownDocs;
+      grownStale = grownDocs == NULL ? NULL :
+                   realloc(pulStale, newSlots * sizeof(size_t));
+      if(grownStale == NULL) {
+         isComplete = FALSE;
+         return MEMORY_ERROR;
+      }
+      pulStale = grownStale;
+
+      /* the new slots are chained onto the free list in order */
+      for(i = newSlots; i > ulSlots; i--) {
+         psDocs[i - 1].pvDoc = NULL;
+         psDocs[i - 1].puiLists = NULL;
+         psDocs[i - 1].ulLists = 0;
+         psDocs[i - 1].isStale = FALSE;
+         psDocs[i - 1].isListed = FALSE;
+         psDocs[i - 1].ulNextFree = ulFreeSlot;
+         ulFreeSlot = i;
+      }
+      ulSlots = newSlots;
+   }
+
+   *pulID = ulFreeSlot;
+   ulFreeSlot = psDocs[*pulID - 1].ulNextFree;
+   psDocs[*pulID - 1].pvDoc = pvDoc;
+   Trigram_markStale(*pulID);
+   return SUCCESS;
+}
+
+/*
+  Removes the document with identifier ulID from the index, whose
+  identifier may then be given to a new document.
+*/
+void Trigram_remove(size_t ulID) {
+   struct trigramDoc *doc;
+   size_t i;
+
+   assert(psLists != NULL);
+   assert(ulID != 0 && ulID <= ulSlots);
+
+   doc = &psDocs[ulID - 1];
+   for(i = 0; i < doc->ulLists; i++)
+      Trigram_removeID(&psLists[doc->puiLists[i]], ulID);
+   free(doc->puiLists);
+
+   doc->pvDoc = NULL;
+   doc->puiLists = NULL;
+   doc->ulLists = 0;
+   doc->isStale = FALSE;
+   doc->ulNextFree = ulFreeSlot;
+   ulFreeSlot = ulID;
+}
+
+/* Marks the document with identifier ulID stale. */
+void Trigram_markStale(size_t ulID) {
+   struct trigramDoc *doc;
+
+   assert(psLists != NULL);
+   assert(ulID != 0 && ulID <= ulSlots);
+
+   doc = &psDocs[ulID - 1];
+   doc->isStale = TRUE;
+   if(!doc->isListed) {
+      doc->isListed = TRUE;
+      pulStale[ulStale++] = ulID;
+   }
+}
+
+/*
+  Indexes each stale document afresh, reading its bytes with pfRead,
+  which sets *ppvBytes and *pulLength to those of document pvDoc and
+  returns SUCCESS or an error status. Returns SUCCESS if every stale
+  document was indexed. Otherwise, stops, leaving the document it
+  stopped at and those after it stale, and returns MEMORY_ERROR if
+  memory could not be allocated or the first status other than
+  SUCCESS that pfRead returned.
+*/
+int Trigram_refresh(int (*pfRead)(void *pvDoc, const void **ppvBytes,
+                                  size_t *pulLength)) {
+   struct trigramDoc *doc;
+   const void *bytes;
+   size_t length;
+   size_t id;
+   int status;
+
+   assert(psLists != NULL);
+   assert(pfRead != NULL);
+
+   while(ulStale != 0) {
+      id = pulStale[ulStale - 1];
+      doc = &psDocs[id - 1];
+      if(doc->pvDoc != NULL && doc->isStale) {
+         status = pfRead(doc->pvDoc, &bytes, &length);
+         if(status == SUCCESS)
+            status = Trigram_index(id, bytes, length);
+         if(status != SUCCESS)
+            return status;
+         doc->isStale = FALSE;
+      }
+      doc->isListed = FALSE;
+      ulStale--;
+   }
+   return SUCCESS;
+}
+
+/*
+  Passes each document in the index that may hold the ulLength bytes
+  at pvPattern, as of its last refresh, to pfVisit along with
+  pvExtra, in order of identifier; a pattern shorter than a trigram
+  makes every document a candidate. pfVisit must not change the
+  index. Returns SUCCESS if every candidate was visited. Otherwise,
+  stops and returns MEMORY_ERROR if memory could not be allocated, or
+  the first status other than SUCCESS that pfVisit returned.
+*/
+int Trigram_search(const void *pvPattern, size_t ulLength,
+                   int (*pfVisit)(void *pvDoc, void *pvExtra),
+                   void *pvExtra) {
+   unsigned int *lists;
+   size_t count;
+   size_t shortest = 0;
+   size_t index;
+   size_t i, j;
+   int status;
+
+   assert(psLists != NULL);
+   assert(pvPattern != NULL || ulLength == 0);
+   assert(pfVisit != NULL);
+
+   status = Trigram_collect(pvPattern, ulLength, &lists, &count);
+   if(status != SUCCESS)
+      return status;
+
+   if(count == 0) {
+      for(i = 0; status == SUCCESS && i < ulSlots; i++)
+         if(psDocs[i].pvDoc != NULL)
+            status = pfVisit(psDocs[i].pvDoc, pvExtra);
+      return status;
+   }
+
+   /* a candidate must be in every list, so the shortest is walked
+      and the others searched */
+   for(j = 1; j < count; j++)
+      if(psLists[lists[j]].ulCount < psLists[lists[shortest]].ulCount)
+         shortest = j;
+   for(i = 0; status == SUCCESS && i < psLists[lists[shortest]].ulCount;
+       i++) {
+      for(j = 0; j < count; j++)
+         if(j != shortest &&
+            !Trigram_findID(&psLists[lists[j]],
+                            psLists[lists[shortest]].pulIDs[i], &index))
+            break;
+      if(j == count)
+         status = pfVisit(
+            psDocs[psLists[lists[shortest]].pulIDs[i] - 1].pvDoc,
+            pvExtra);
+   }
+
+   free(lists);
+   return status;
+}
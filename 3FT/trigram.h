@@ -0,0 +1,92 @@
+/*-------------------------------------------------------------------*/
+/* trigram.h                                                         */
+/* Author: Hugh Peterson                                             */
+/*-------------------------------------------------------------------*/
+
+#ifndef TRIGRAM_INCLUDED
+#define TRIGRAM_INCLUDED
+
+#include <stddef.h>
+#include "a4def.h"
+
+/*
+  The trigram index is an inverted index over the bytes of a set of
+  documents, each registered with an identifier. Every trigram (run of
+  three consecutive bytes) of a document is hashed to one of a fixed
+  number of posting lists, each a sorted array of the identifiers of
+  the documents with a trigram hashed to it. A search for a pattern of
+  three or more bytes intersects the lists of the pattern's trigrams,
+  shortest first, leaving the candidates that may hold the pattern:
+  every document that holds it is among them, but hash collisions and
+  trigrams out of order let others in too, so callers must check each
+  one.
+
+  Documents are indexed lazily: a new or changed document is only
+  marked stale, and Trigram_refresh reads and indexes each stale one,
+  so a document changed many times between searches is indexed once.
+*/
+
+/*-------------------------------------------------------------------*/
+
+/*
+  Starts keeping the index, empty, if it is not already kept. Returns
+  SUCCESS, or MEMORY_ERROR if memory could not be allocated.
+*/
+int Trigram_start(void);
+
+/* Stops keeping the index and frees it. */
+void Trigram_stop(void);
+
+/* Returns TRUE if the index is kept and FALSE otherwise. */
+boolean Trigram_isStarted(void);
+
+/*
+  Returns TRUE if every document meant to be in the index, which must
+  be kept, is in it, and FALSE if Trigram_add failed for one since the
+  index was started.
+*/
+boolean Trigram_isComplete(void);
+
+/*
+  Registers pvDoc as a new, stale document in the index, which must be
+  kept, and sets *pulID to its identifier, which is never 0. Returns
+  SUCCESS, or MEMORY_ERROR if memory could not be allocated, in which
+  case the index is no longer complete.
+*/
+int Trigram_add(void *pvDoc, size_t *pulID);
+
+/*
+  Removes the document with identifier ulID from the index, whose
+  identifier may then be given to a new document.
+*/
+void Trigram_remove(size_t ulID);
+
+/* Marks the document with identifier ulID stale. */
+void Trigram_markStale(size_t ulID);
+
+/*
+  Indexes each stale document afresh, reading its bytes with pfRead,
+  which sets *ppvBytes and *pulLength to those of document pvDoc and
+  returns SUCCESS or an error status. Returns SUCCESS if every stale
+  document was indexed. Otherwise, stops, leaving the document it
+  stopped at and those after it stale, and returns MEMORY_ERROR if
+  memory could not be allocated or the first status other than
+  SUCCESS that pfRead returned.
+*/
+int Trigram_refresh(int (*pfRead)(void *pvDoc, const void **ppvBytes,
+                                  size_t *pulLength));
+
+/*
+  Passes each document in the index that may hold the ulLength bytes
+  at pvPattern, as of its last refresh, to pfVisit along with
+  pvExtra, in order of identifier; a pattern shorter than a trigram
+  makes every document a candidate. pfVisit must not change the
+  index. Returns SUCCESS if every candidate was visited. Otherwise,
+  stops and returns MEMORY_ERROR if memory could not be allocated, or
+  the first status other than SUCCESS that pfVisit returned.
+*/
+int Trigram_search(const void *pvPattern, size_t ulLength,
+                   int (*pfVisit)(void *pvDoc, void *pvExtra),
+                   void *pvExtra);
+
+#endif
@@ -0,0 +1,250 @@
+/*-------------------------------------------------------------------*/
+/* watch.c                                                           */
+/* Author: Hugh Peterson                                             */
+/*-------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "a4def.h"
+#include "dynarray.h"
+#include "watch.h"
+
+/*-------------------------------------------------------------------*/
+
+/* A watched subtree */
+struct watch {
+   /* the watch's identifier */
+   size_t ulID;
+   /* the kinds of change watched, as bit flags */
+   unsigned int uiKinds;
+   /* the absolute path of the subtree's root */
+   char *pcPath;
+};
+
+/* The number of events the ring can hold */
+enum {RING_CAPACITY = 1024};
+
+/*
+  The watch registry is an abstract object with 4 state variables:
+*/
+
+/* 1. the watches, or NULL if nothing has been watched yet, and their
+      number */
+static DynArray_T oDWatches;
+static size_t ulWatches;
+/* 2. the identifier to give the next watch */
+static size_t ulNextID = 1;
+/* 3. the ring of queued events, the index of the oldest, and their
+      number */
+static struct watchEvent asRing[RING_CAPACITY];
+static size_t ulOldest;
+static size_t ulQueued;
+/* 4. whether events were dropped since the last drain */
+static boolean isOverflowed;
+
+/*-------------------------------------------------------------------*/
+
+/*
+  Returns TRUE if absolute paths pcFirst and pcSecond are the same or
+  one is an ancestor of the other, and FALSE otherwise.
+*/
+static boolean Watch_isRelated(const char *pcFirst,
+                               const char *pcSecond) {
+   size_t i = 0;
+
+   assert(pcFirst != NULL);
+   assert(pcSecond != NULL);
+
+   while(pcFirst[i] != '\0' && pcFirst[i] == pcSecond[i])
+      i++;
+   if(pcFirst[i] == '\0')
+      return (boolean) (pcSecond[i] == '\0' || pcSecond[i] == '/');
+   return (boolean) (pcSecond[i] == '\0' && pcFirst[i] == '/');
+}
+
+/*
+  Queues an event of kind uiKind at pcPath for watch ulWatch, folding
+  it into the newest queued event if that is for the same watch and
+  path, and flagging an overflow if it has to be dropped.
+*/
+static void Watch_queue(size_t ulWatch, unsigned int uiKind,
+                        const char *pcPath) {
+   struct watchEvent *event;
+   char *path;
+
+   assert(pcPath != NULL);
+
+   if(ulQueued != 0) {
+      event = &asRing[(ulOldest + ulQueued - 1) % RING_CAPACITY];
+      if(event->ulWatch == ulWatch && !strcmp(event->pcPath, pcPath)) {
+         event->uiKinds |= uiKind;
+         return;
+      }
+   }
+
+   if(ulQueued == RING_CAPACITY) {
+      isOverflowed = TRUE;
+      return;
+   }
+   path = malloc(strlen(pcPath) + 1);
+   if(path == NULL) {
+      isOverflowed = TRUE;
+      return;
+   }
+   strcpy(path, pcPath);
+
+   event = &asRing[(ulOldest + ulQueued) % RING_CAPACITY];
+   event->ulWatch = ulWatch;
+   event->uiKinds = uiKind;
+   event->pcPath = path;
+   ulQueued++;
+}
+
+/*-------------------------------------------------------------------*/
+
+/*
+  Starts watching the subtree at absolute path pcPath, which need not
+  exist yet, for the kinds of change in bit flags uiKinds. Sets
+  *pulWatch to the new watch's identifier, which is never 0. Returns
+  SUCCESS, or MEMORY_ERROR if memory could not be allocated.
+*/
+int Watch_add(const char *pcPath, unsigned int uiKinds,
+              size_t *pulWatch) {
+   struct watch *watch;
+
+   assert(pcPath != NULL);
+   assert(pulWatch != NULL);
+
+   if(oDWatches == NULL) {
+      oDWatches = DynArray_new(0);
+      if(oDWatches == NULL)
+         return MEMORY_ERROR;
+   }
+
+   watch = malloc(sizeof(struct watch));
+   if(watch == NULL)
+      return MEMORY_ERROR;
+   watch->pcPath = malloc(strlen(pcPath) + 1);
+   if(watch->pcPath == NULL || !DynArray_add(oDWatches, watch)) {
+      free(watch->pcPath);
+      free(watch);
+      return MEMORY_ERROR;
+   }
+   strcpy(watch->pcPath, pcPath);
+   watch->uiKinds = uiKinds;
+   watch->ulID = ulNextID++;
+
+   ulWatches++;
+   *pulWatch = watch->ulID;
+   return SUCCESS;
+}
+
+/*
+  Stops the watch with identifier ulWatch. Its events already queued
+  stay queued. Returns SUCCESS, or NO_SUCH_PATH if there is no such
+  watch.
+*/
+int Watch_remove(size_t ulWatch) {
+   struct watch *watch;
+   size_t i;
+
+   for(i = 0; i < ulWatches; i++) {
+      watch = DynArray_get(oDWatches, i);
+      if(watch->ulID == ulWatch) {
+         (void) DynArray_removeAt(oDWatches, i);
+         ulWatches--;
+         free(watch->pcPath);
+         free(watch);
+         return SUCCESS;
+      }
+   }
+   return NO_SUCH_PATH;
+}
+
+/* Returns TRUE if anything is being watched and FALSE otherwise. */
+boolean Watch_isActive(void) {
+   return (boolean) (ulWatches != 0);
+}
+
+/*
+  Queues an event of kind uiKind (a single bit flag) at absolute path
+  pcPath for every watch that covers it, or that it is an ancestor of,
+  and that watches that kind of change. Costs only a test when
+  nothing is being watched.
+*/
+void Watch_notify(unsigned int uiKind, const char *pcPath) {
+   struct watch *watch;
+   size_t i;
+
+   assert(pcPath != NULL);
+
+   if(ulWatches == 0)
+      return;
+
+   for(i = 0; i < ulWatches; i++) {
+      watch = DynArray_get(oDWatches, i);
+      if((watch->uiKinds & uiKind) &&
+         Watch_isRelated(watch->pcPath, pcPath))
+         Watch_queue(watch->ulID, uiKind, pcPath);
+   }
+}
+
+/*
+  Flags an overflow, as if an event had been dropped, for a change
+  whose path could not be worked out.
+*/
+void Watch_lose(void) {
+   if(ulWatches != 0)
+      isOverflowed = TRUE;
+}
+
+/*
+  Moves up to ulMax of the oldest queued events into psEvents, in the
+  order they were queued, and sets *pulCount to the number moved. The
+  events' paths are then owned by the caller. Sets *pbOverflowed to
+  TRUE if events were dropped since the last drain, and to FALSE
+  otherwise, clearing the flag.
+*/
+void Watch_drain(struct watchEvent *psEvents, size_t ulMax,
+                 size_t *pulCount, boolean *pbOverflowed) {
+   size_t count = 0;
+
+   assert(psEvents != NULL || ulMax == 0);
+   assert(pulCount != NULL);
+   assert(pbOverflowed != NULL);
+
+   while(count < ulMax && ulQueued != 0) {
+      psEvents[count++] = asRing[ulOldest];
+      ulOldest = (ulOldest + 1) % RING_CAPACITY;
+      ulQueued--;
+   }
+
+   *pulCount = count;
+   *pbOverflowed = isOverflowed;
+   isOverflowed = FALSE;
+}
+
+/* Stops every watch and frees every queued event. */
+void Watch_clear(void) {
+   struct watch *watch;
+
+   while(ulWatches != 0) {
+      watch = DynArray_removeAt(oDWatches, --ulWatches);
+      free(watch->pcPath);
+      free(watch);
+   }
+   if(oDWatches != NULL) {
+      DynArray_free(oDWatches);
+      oDWatches = NULL;
+   }
+
+   while(ulQueued != 0) {
+      free(asRing[ulOldest].pcPath);
+      ulOldest = (ulOldest + 1) % RING_CAPACITY;
+      ulQueued--;
+   }
+   ulOldest = 0;
+   isOverflowed = FALSE;
+}
@@ -0,0 +1,85 @@
+/*-------------------------------------------------------------------*/
+/* watch.h                                                           */
+/* Author: Hugh Peterson                                             */
+/*-------------------------------------------------------------------*/
+
+#ifndef WATCH_INCLUDED
+#define WATCH_INCLUDED
+
+#include <stddef.h>
+#include "a4def.h"
+
+/*
+  The watch registry keeps the subtrees of a File Tree that clients
+  watch, and queues an event for each change to one of them in a
+  bounded ring, from which the client drains them in batches. A watch
+  covers the directory or file at its path and everything below it,
+  and is also told when that path is created or removed along with an
+  ancestor. A change to the same path for the same watch as the
+  newest queued event is folded into that event. When the ring is
+  full, further events are dropped and the overflow is flagged, so the
+  client knows to look at its watched subtrees afresh.
+*/
+
+/*-------------------------------------------------------------------*/
+
+/* A change queued for a watch */
+struct watchEvent {
+   /* the identifier of the watch */
+   size_t ulWatch;
+   /* the kinds of change, as bit flags, OR-ed together for changes
+      that were folded into one event */
+   unsigned int uiKinds;
+   /* the absolute path of the changed directory or file */
+   char *pcPath;
+};
+
+/*-------------------------------------------------------------------*/
+
+/*
+  Starts watching the subtree at absolute path pcPath, which need not
+  exist yet, for the kinds of change in bit flags uiKinds. Sets
+  *pulWatch to the new watch's identifier, which is never 0. Returns
+  SUCCESS, or MEMORY_ERROR if memory could not be allocated.
+*/
+int Watch_add(const char *pcPath, unsigned int uiKinds,
+              size_t *pulWatch);
+
+/*
+  Stops the watch with identifier ulWatch. Its events already queued
+  stay queued. Returns SUCCESS, or NO_SUCH_PATH if there is no such
+  watch.
+*/
+int Watch_remove(size_t ulWatch);
+
+/* Returns TRUE if anything is being watched and FALSE otherwise. */
+boolean Watch_isActive(void);
+
+/*
+  Queues an event of kind uiKind (a single bit flag) at absolute path
+  pcPath for every watch that covers it, or that it is an ancestor of,
+  and that watches that kind of change. Costs only a test when
+  nothing is being watched.
+*/
+void Watch_notify(unsigned int uiKind, const char *pcPath);
+
+/*
+  Flags an overflow, as if an event had been dropped, for a change
+  whose path could not be worked out.
+*/
+void Watch_lose(void);
+
+/*
+  Moves up to ulMax of the oldest queued events into psEvents, in the
+  order they were queued, and sets *pulCount to the number moved. The
+  events' paths are then owned by the caller. Sets *pbOverflowed to
+  TRUE if events were dropped since the last drain, and to FALSE
+  otherwise, clearing the flag.
+*/
+void Watch_drain(struct watchEvent *psEvents, size_t ulMax,
+                 size_t *pulCount, boolean *pbOverflowed);
+
+/* Stops every watch and frees every queued event. */
+void Watch_clear(void);
+
+#endif